@@ -68,6 +68,13 @@
 #define DEBUG_INTERRUPTS				KDEBUG_LEVEL_1
 
 
+// locks
+
+// Collects contention statistics for mutexes and rw_locks per lock name.
+// Enables the "lock_contention" debugger command.
+#define DEBUG_LOCK_CONTENTION			KDEBUG_LEVEL_2
+
+
 // semaphores
 
 // Enables tracking of the last threads that acquired/released a semaphore.
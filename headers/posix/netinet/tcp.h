@@ -79,5 +79,10 @@ struct tcphdr {
 	/* don't use TH_PUSH */
 #define TCP_NOOPT				0x08
 	/* don't use any TCP options */
+#define TCP_CONGESTION			0x40
+	/* get/set the congestion control algorithm by name */
+
+#define TCP_CA_NAME_MAX			16
+	/* maximum length of a congestion control algorithm name */
 
 #endif	/* NETINET_TCP_H */
@@ -20,6 +20,8 @@
 #define PTHREAD_PROCESS_PRIVATE		0
 #define PTHREAD_PROCESS_SHARED		1
 
+#define PTHREAD_BARRIER_SERIAL_THREAD	-1
+
 /*
  * Flags for threads and thread attributes.
  */
@@ -158,6 +160,20 @@ extern int pthread_rwlockattr_getpshared(const pthread_rwlockattr_t *attr,
 extern int pthread_rwlockattr_setpshared(pthread_rwlockattr_t *attr,
 	int shared);
 
+/* barrier functions */
+extern int pthread_barrier_init(pthread_barrier_t *barrier,
+	const pthread_barrierattr_t *attr, unsigned count);
+extern int pthread_barrier_destroy(pthread_barrier_t *barrier);
+extern int pthread_barrier_wait(pthread_barrier_t *barrier);
+
+/* barrier attribute functions */
+extern int pthread_barrierattr_init(pthread_barrierattr_t *attr);
+extern int pthread_barrierattr_destroy(pthread_barrierattr_t *attr);
+extern int pthread_barrierattr_getpshared(const pthread_barrierattr_t *attr,
+	int *shared);
+extern int pthread_barrierattr_setpshared(pthread_barrierattr_t *attr,
+	int shared);
+
 /* spinlock functions */
 extern int pthread_spin_init(pthread_spinlock_t* spinlock, int pshared);
 extern int pthread_spin_destroy(pthread_spinlock_t* spinlock);
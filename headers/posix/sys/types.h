@@ -69,10 +69,8 @@ typedef struct  _pthread_once		pthread_once_t;
 typedef struct  _pthread_rwlock		pthread_rwlock_t;
 typedef struct  _pthread_rwlockattr	*pthread_rwlockattr_t;
 typedef struct  _pthread_spinlock	pthread_spinlock_t;
-/*
-typedef struct  _pthread_barrier	*pthread_barrier_t;
+typedef struct  _pthread_barrier	pthread_barrier_t;
 typedef struct  _pthread_barrierattr *pthread_barrierattr_t;
-*/
 
 struct _pthread_mutex {
 	__haiku_std_uint32	flags;
@@ -115,6 +113,13 @@ struct _pthread_spinlock {
 	__haiku_std_int32		lock;
 };
 
+struct _pthread_barrier {
+	__haiku_std_uint32	flags;
+	__haiku_std_int32	sequence;
+	__haiku_std_int32	waiter_count;
+	__haiku_std_int32	waiter_max;
+};
+
 
 #include <null.h>
 #include <size_t.h>
@@ -35,6 +35,9 @@ int64 arch_restore_signal_frame(struct signal_frame_data* signalFrameData);
 void arch_store_fork_frame(struct arch_fork_arg *arg);
 void arch_restore_fork_frame(struct arch_fork_arg *arg);
 
+bool arch_thread_abort_user_sequence(addr_t start, addr_t end,
+	addr_t abortAddress);
+
 #define arch_syscall_64_bit_return_value()
 	// overridden by architectures that need special handling
 
@@ -206,6 +206,9 @@
 #define IA32_FEATURE_APERFMPERF	(1 << 0) //IA32_APERF, IA32_MPERF
 #define IA32_FEATURE_EPB	(1 << 3) //IA32_ENERGY_PERF_BIAS
 
+// x86 defined features from cpuid eax 7, ebx register
+#define IA32_FEATURE_ERMS	(1 << 9) //Enhanced REP MOVSB/STOSB
+
 // x86 defined features from cpuid eax 0x80000007, edx register
 #define IA32_FEATURE_INVARIANT_TSC		(1 << 8)
 
@@ -294,6 +297,7 @@ enum x86_feature_type {
 	FEATURE_5_ECX,			// cpuid eax=5, ecx register
 	FEATURE_6_EAX,          // cpuid eax=6, eax registers
 	FEATURE_6_ECX,          // cpuid eax=6, ecx registers
+	FEATURE_7_EBX,			// cpuid eax=7, ebx register
 	FEATURE_EXT_7_EDX,		// cpuid eax=0x80000007, edx register
 
 	FEATURE_NUM
@@ -438,6 +442,9 @@ typedef struct arch_cpu_info {
 
 
 extern void (*gCpuIdleFunc)(void);
+#ifdef __x86_64__
+extern void (*gX86ClearPageFunc)(void* page);
+#endif
 
 
 #ifdef __cplusplus
@@ -457,6 +464,12 @@ void __x86_setup_system_time(uint32 conversionFactor,
 void x86_userspace_thread_exit(void);
 void x86_end_userspace_thread_exit(void);
 
+#ifdef __x86_64__
+void x86_clear_page_repstosb(void* page);
+void x86_clear_page_repstosq(void* page);
+void x86_clear_page_nontemporal(void* page);
+#endif
+
 addr_t x86_get_stack_frame();
 uint32 x86_count_mtrrs(void);
 void x86_set_mtrr(uint32 index, uint64 base, uint64 length, uint8 type);
@@ -100,6 +100,7 @@ status_t cpu_preboot_init_percpu(struct kernel_args *args, int curr_cpu);
 status_t cpu_init(struct kernel_args *args);
 status_t cpu_init_percpu(struct kernel_args *ka, int curr_cpu);
 status_t cpu_init_post_vm(struct kernel_args *args);
+status_t cpu_init_post_smp(struct kernel_args *args);
 status_t cpu_init_post_modules(struct kernel_args *args);
 bigtime_t cpu_get_active_time(int32 cpu);
 
@@ -45,6 +45,11 @@ extern void cache_node_launched(size_t argCount, char * const *args);
 extern void cache_prefetch_vnode(struct vnode *vnode, off_t offset, size_t size);
 extern void cache_prefetch(dev_t mountID, ino_t vnodeID, off_t offset, size_t size);
 
+extern status_t file_cache_wire_pages(struct vnode *vnode, void *cookie,
+				off_t offset, size_t *_size, struct vm_page **pages,
+				uint32 maxPages, VMCache **_cache);
+extern void file_cache_unwire_page(VMCache *cache, struct vm_page *page);
+
 extern status_t file_map_init(void);
 extern status_t file_cache_init_post_boot_device(void);
 extern status_t file_cache_init(void);
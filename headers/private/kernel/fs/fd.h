@@ -67,7 +67,9 @@ enum fd_types {
 	FDTYPE_INDEX,
 	FDTYPE_INDEX_DIR,
 	FDTYPE_QUERY,
-	FDTYPE_SOCKET
+	FDTYPE_SOCKET,
+	FDTYPE_EVENT_QUEUE,
+	FDTYPE_IO_RING
 };
 
 // additional open mode - kernel special
@@ -86,8 +88,13 @@ extern void put_fd(struct file_descriptor *descriptor);
 extern void disconnect_fd(struct file_descriptor *descriptor);
 extern void inc_fd_ref_count(struct file_descriptor *descriptor);
 extern int dup_foreign_fd(team_id fromTeam, int fd, bool kernel);
+extern int dup2_fd(int oldfd, int newfd, bool kernel);
 extern status_t select_fd(int32 fd, struct select_info *info, bool kernel);
 extern status_t deselect_fd(int32 fd, struct select_info *info, bool kernel);
+extern status_t reselect_fd(int32 fd, struct select_info *info,
+	uint16 events, bool kernel);
+extern void deselect_select_infos(struct file_descriptor *descriptor,
+	struct select_info *infos, bool putSyncObjects);
 extern bool fd_is_valid(int fd, bool kernel);
 extern struct vnode *fd_vnode(struct file_descriptor *descriptor);
 
@@ -97,6 +104,10 @@ extern void fd_set_close_on_exec(struct io_context *context, int fd, bool closeF
 static struct io_context *get_current_io_context(bool kernel);
 
 extern status_t user_fd_kernel_ioctl(int fd, ulong op, void *buffer, size_t length);
+extern ssize_t user_fd_kernel_io(int fd, off_t pos, void *buffer,
+	size_t length, bool write);
+extern ssize_t user_fd_kernel_vector_io(int fd, off_t pos,
+	const struct iovec *vecs, size_t count, bool write);
 
 /* The prototypes of the (sys|user)_ functions are currently defined in vfs.h */
 
@@ -114,6 +125,26 @@ get_current_io_context(bool kernel)
 
 #ifdef __cplusplus
 }
+
+
+/*!	Puts a file descriptor reference obtained via get_fd() when going out of
+	scope.
+*/
+struct FileDescriptorPutter {
+	FileDescriptorPutter(struct file_descriptor* descriptor)
+		: descriptor(descriptor)
+	{
+	}
+
+	~FileDescriptorPutter()
+	{
+		if (descriptor != NULL)
+			put_fd(descriptor);
+	}
+
+	struct file_descriptor*	descriptor;
+};
+
 #endif
 
 #endif /* _FD_H */
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _KERNEL_IO_RING_H
+#define _KERNEL_IO_RING_H
+
+
+#include <io_ring_defs.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int			_user_io_ring_create(uint32 entries, uint32 flags,
+				io_ring_info** _userInfo);
+ssize_t		_user_io_ring_enter(int ring, uint32 toSubmit,
+				uint32 minComplete, uint32 flags, bigtime_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/* _KERNEL_IO_RING_H */
@@ -42,6 +42,11 @@ using BKernel::Thread;
 	// Continue a thread. Used by resume_thread(). Non-blockable, prevents
 	// syscall restart.
 
+#define BLOCKABLE_SIGNALS	\
+	(~(KILL_SIGNALS | SIGNAL_TO_MASK(SIGSTOP)	\
+	| SIGNAL_TO_MASK(SIGNAL_CONTINUE_THREAD)	\
+	| SIGNAL_TO_MASK(SIGNAL_CANCEL_THREAD)))
+
 
 struct signal_frame_data {
 	siginfo_t	info;
@@ -29,6 +29,10 @@ typedef struct mutex {
 	uint16					ignore_unlock_count;
 #endif
 	uint8					flags;
+	int16					spin_estimate;
+								// Running average of how long contending
+								// threads had to spin before the lock was
+								// released to them.
 } mutex;
 
 #define MUTEX_FLAG_CLONE_NAME	0x1
@@ -94,11 +98,11 @@ typedef struct rw_lock {
 // static initializers
 #if KDEBUG
 #	define MUTEX_INITIALIZER(name) \
-	{ name, NULL, B_SPINLOCK_INITIALIZER, -1, 0 }
+	{ name, NULL, B_SPINLOCK_INITIALIZER, -1, 0, 0 }
 #	define RECURSIVE_LOCK_INITIALIZER(name)	{ MUTEX_INITIALIZER(name), 0 }
 #else
 #	define MUTEX_INITIALIZER(name) \
-	{ name, NULL, B_SPINLOCK_INITIALIZER, 0, 0, 0 }
+	{ name, NULL, B_SPINLOCK_INITIALIZER, 0, 0, 0, 0 }
 #	define RECURSIVE_LOCK_INITIALIZER(name)	{ MUTEX_INITIALIZER(name), -1, 0 }
 #endif
 
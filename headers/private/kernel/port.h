@@ -10,6 +10,7 @@
 #include <iovec.h>
 
 struct kernel_args;
+struct port_batch_message;
 struct select_info;
 
 
@@ -70,6 +71,12 @@ status_t	_user_writev_port_etc(port_id id, int32 msgCode,
 status_t	_user_get_port_message_info_etc(port_id port,
 				port_message_info *info, size_t infoSize, uint32 flags,
 				bigtime_t timeout);
+ssize_t		_user_read_port_batch(port_id port,
+				struct port_batch_message *messages, size_t count,
+				uint32 flags, bigtime_t timeout);
+ssize_t		_user_write_port_batch(port_id port,
+				const struct port_batch_message *messages, size_t count,
+				uint32 flags, bigtime_t timeout);
 
 #ifdef __cplusplus
 }
@@ -58,6 +58,9 @@ status_t stop_watching_team(team_id team, void (*hook)(team_id, void *),
 
 struct user_thread* team_allocate_user_thread(Team* team);
 void team_free_user_thread(Team* team, struct user_thread* userThread);
+area_id team_get_cached_user_stack(Team* team, size_t size,
+			void** _address);
+bool team_cache_user_stack(Team* team, area_id area);
 
 bool team_associate_data(AssociatedData* data);
 bool team_dissociate_data(AssociatedData* data);
@@ -66,6 +69,9 @@ bool team_dissociate_data(AssociatedData* data);
 thread_id _user_load_image(const char* const* flatArgs, size_t flatArgsSize,
 			int32 argCount, int32 envCount, int32 priority, uint32 flags,
 			port_id errorPort, uint32 errorToken);
+thread_id _user_spawn(const char* path, const char* const* flatArgs,
+			size_t flatArgsSize, int32 argCount, int32 envCount,
+			const struct spawn_attributes* attributes);
 status_t _user_wait_for_team(team_id id, status_t *_returnCode);
 void _user_exit_team(status_t returnValue);
 status_t _user_kill_team(thread_id thread);
@@ -73,6 +79,7 @@ pid_t _user_wait_for_child(thread_id child, uint32 flags, siginfo_t* info);
 status_t _user_exec(const char *path, const char* const* flatArgs,
 			size_t flatArgsSize, int32 argCount, int32 envCount, mode_t umask);
 thread_id _user_fork(void);
+thread_id _user_vfork(void);
 team_id _user_get_current_team(void);
 pid_t _user_process_info(pid_t process, int32 which);
 pid_t _user_setpgid(pid_t process, pid_t group);
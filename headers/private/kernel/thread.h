@@ -33,6 +33,11 @@ struct thread_creation_attributes;
 #define THREAD_REMOVED		0x02
 #define THREAD_NAME_CHANGED	0x04
 
+// Timeout flag for thread_block_with_timeout() and the functions using it,
+// like snooze_etc(): the thread doesn't mind waking up a little late, so
+// that its timer can be coalesced with others. Kernel use only.
+#define B_TIMEOUT_ALLOW_SLACK	0x10000
+
 
 namespace BKernel {
 
@@ -164,6 +169,7 @@ status_t _user_block_thread(uint32 flags, bigtime_t timeout);
 status_t _user_unblock_thread(thread_id thread, status_t status);
 status_t _user_unblock_threads(thread_id* threads, uint32 count,
 	status_t status);
+status_t _user_register_rseq(void);
 
 // ToDo: these don't belong here
 struct rlimit;
@@ -96,6 +96,8 @@ struct team_watcher {
 	// this is a soft limit for the number of child death entries in a team
 #define MAX_DEAD_THREADS	32
 	// this is a soft limit for the number of thread death entries in a team
+#define MAX_CACHED_USER_STACKS	8
+	// the number of default sized stacks of exited threads a team keeps
 
 
 struct job_control_entry : DoublyLinkedListLinkImpl<job_control_entry> {
@@ -250,6 +252,7 @@ struct Team : TeamThreadIteratorEntry<team_id>, KernelReferenceable,
 	Thread			*thread_list;	// protected by fLock, signal_lock and
 									// gThreadCreationLock
 	struct team_loading_info *loading_info;	// protected by fLock
+	ConditionVariable *vfork_condition;	// protected by fLock
 	struct list		image_list;		// protected by sImageMutex
 	struct list		watcher_list;
 	struct list		sem_list;		// protected by sSemsSpinlock
@@ -261,6 +264,8 @@ struct Team : TeamThreadIteratorEntry<team_id>, KernelReferenceable,
 	size_t			user_data_size;
 	size_t			used_user_data;
 	struct free_user_thread* free_user_threads;
+	area_id			cached_user_stacks[MAX_CACHED_USER_STACKS];
+	int32			cached_user_stack_count;	// protected by fLock
 
 	void*			commpage_address;
 
@@ -821,6 +826,11 @@ using BKernel::ProcessGroupList;
 	// the thread is currently in a syscall; set/reset only for certain
 	// functions (e.g. ioctl()) to allow inner functions to discriminate
 	// whether e.g. parameters were passed from userland or kernel
+#define	THREAD_FLAGS_RSEQ					0x1000
+	// the thread uses restartable sequences (_kern_register_rseq())
+#define	THREAD_FLAGS_RSEQ_PENDING			0x2000
+	// the thread has been scheduled since it last left the kernel; its
+	// restartable sequence has to be checked and its CPU number updated
 
 
 #endif	/* _KERNEL_THREAD_TYPES_H */
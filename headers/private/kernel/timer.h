@@ -23,8 +23,13 @@ struct kernel_args;
 #define B_TIMER_USE_TIMER_STRUCT_TIMES	0x4000
 	// For add_timer(): Use the timer::schedule_time (absolute time) and
 	// timer::period values instead of the period parameter.
+#define B_TIMER_ALLOW_SLACK			0x1000
+	// For one-shot timers: The timer may expire a little later than
+	// requested (at most a small fraction of its delay), so that it can be
+	// coalesced with other timers.
 #define B_TIMER_FLAGS	\
-	(B_TIMER_USE_TIMER_STRUCT_TIMES | B_TIMER_REAL_TIME_BASE)
+	(B_TIMER_USE_TIMER_STRUCT_TIMES | B_TIMER_REAL_TIME_BASE \
+		| B_TIMER_ALLOW_SLACK)
 
 /* Timer info structure */
 struct timer_info {
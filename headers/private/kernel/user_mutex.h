@@ -20,9 +20,12 @@ status_t	_user_mutex_lock(int32* mutex, const char* name, uint32 flags,
 status_t	_user_mutex_unlock(int32* mutex, uint32 flags);
 status_t	_user_mutex_switch_lock(int32* fromMutex, int32* toMutex,
 				const char* name, uint32 flags, bigtime_t timeout);
-status_t	_user_mutex_sem_acquire(int32* sem, const char* name, uint32 flags,
+
+status_t	_user_futex_wait(int32* address, int32 value, uint32 flags,
 				bigtime_t timeout);
-status_t	_user_mutex_sem_release(int32* sem);
+int32		_user_futex_wake(int32* address, int32 count);
+int32		_user_futex_requeue(int32* address, int32 value, int32 wakeCount,
+				int32* target, int32 requeueCount);
 
 #ifdef __cplusplus
 }
@@ -91,6 +91,7 @@ void		vfs_vnode_to_node_ref(struct vnode *vnode, dev_t *_mountID,
 struct fs_vnode* vfs_fsnode_for_vnode(struct vnode* vnode);
 
 int			vfs_open_vnode(struct vnode* vnode, int openMode, bool kernel);
+int			vfs_open(const char* path, int openMode, int perms, bool kernel);
 status_t	vfs_lookup_vnode(dev_t mountID, ino_t vnodeID,
 				struct vnode **_vnode);
 void		vfs_put_vnode(struct vnode *vnode);
@@ -265,6 +266,7 @@ ssize_t		_user_send(int socket, const void *data, size_t length, int flags);
 ssize_t		_user_sendto(int socket, const void *data, size_t length, int flags,
 				const struct sockaddr *address, socklen_t addressLength);
 ssize_t		_user_sendmsg(int socket, const struct msghdr *message, int flags);
+ssize_t		_user_sendfile(int socket, int fd, off_t *offset, size_t length);
 status_t	_user_getsockopt(int socket, int level, int option, void *value,
 				socklen_t *_length);
 status_t	_user_setsockopt(int socket, int level, int option,
@@ -279,6 +281,14 @@ status_t	_user_socketpair(int family, int type, int protocol,
 status_t	_user_get_next_socket_stat(int family, uint32 *cookie,
 				struct net_stat *stat);
 
+/* userland sockets for kernel threads (implementation in socket.cpp) */
+int			user_socket_kernel_accept(int socket, struct sockaddr *address,
+				socklen_t *_addressLength);
+ssize_t		user_socket_kernel_recv(int socket, void *data, size_t length,
+				int flags);
+ssize_t		user_socket_kernel_send(int socket, const void *data,
+				size_t length, int flags);
+
 #ifdef __cplusplus
 }
 #endif
@@ -369,7 +369,7 @@ vm_page::DecrementWiredCount()
 {
 	ASSERT(fWiredCount > 0);
 
-	if (--fWiredCount == 0)
+	if (--fWiredCount == 0 && cache_ref != NULL)
 		cache_ref->cache->DecrementWiredPagesCount();
 }
 
@@ -382,6 +382,7 @@ status_t vm_cache_init(struct kernel_args *args);
 void vm_cache_init_post_heap();
 struct VMCache *vm_cache_acquire_locked_page_cache(struct vm_page *page,
 	bool dontWait);
+void vm_cache_unwire_removed_page(struct vm_page *page);
 
 #ifdef __cplusplus
 }
@@ -139,6 +139,10 @@ struct VMPhysicalPageMapper {
 									bool user) = 0;
 	virtual	void				MemcpyPhysicalPage(phys_addr_t to,
 									phys_addr_t from) = 0;
+	virtual	void				ClearPhysicalPage(phys_addr_t address,
+									bool nonTemporal);
+										// nonTemporal: the page won't be used
+										// soon, so caches may be bypassed
 };
 
 
@@ -83,6 +83,7 @@ area_id create_area_etc(team_id team, const char *name, uint32 size,
 			void **_address);
 area_id transfer_area(area_id id, void** _address, uint32 addressSpec,
 			team_id target, bool kernel);
+area_id vm_transfer_area_to_kernel(area_id id, size_t size, void** _address);
 
 const char* vm_cache_type_to_string(int32 type);
 
@@ -113,7 +114,8 @@ void vm_area_put_locked_cache(struct VMCache *cache);
 area_id vm_create_null_area(team_id team, const char *name, void **address,
 			uint32 addressSpec, addr_t size, uint32 flags);
 area_id vm_copy_area(team_id team, const char *name, void **_address,
-			uint32 addressSpec, uint32 protection, area_id sourceID);
+			uint32 addressSpec, uint32 protection, area_id sourceID,
+			bool protectSource);
 area_id vm_clone_area(team_id team, const char *name, void **address,
 			uint32 addressSpec, uint32 protection, uint32 mapping,
 			area_id sourceArea, bool kernel);
@@ -155,6 +157,7 @@ status_t vm_memcpy_from_physical(void* to, phys_addr_t from, size_t length,
 status_t vm_memcpy_to_physical(phys_addr_t to, const void* from, size_t length,
 			bool user);
 void vm_memcpy_physical_page(phys_addr_t to, phys_addr_t from);
+void vm_clear_physical_page(phys_addr_t address, bool nonTemporal);
 
 status_t vm_debug_copy_page_memory(team_id teamID, void* unsafeMemory,
 			void* buffer, size_t size, bool copyToUnsafe);
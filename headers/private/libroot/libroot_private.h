@@ -12,6 +12,7 @@
 
 struct user_space_program_args;
 struct real_time_data;
+struct _pthread_mutex;
 
 
 #ifdef __cplusplus
@@ -36,11 +37,15 @@ void __init_env(const struct user_space_program_args *args);
 status_t __init_heap(void);
 void __init_heap_post_env(void);
 void __heap_terminate_after(void);
+void __heap_thread_exit(void);
+void __heap_after_fork_child(void);
 
 void __init_time(addr_t commPageTable);
 void __arch_init_time(struct real_time_data *data, bool setDefaults);
 bigtime_t __arch_get_system_time_offset(struct real_time_data *data);
 bigtime_t __get_system_time_offset();
+void __init_cpu_data(addr_t commPageTable);
+int32 __get_cpu_count(bool enabledOnly);
 void __init_pwd_backend(void);
 void __reinit_pwd_backend_after_fork(void);
 void* __arch_get_caller(void);
@@ -49,6 +54,9 @@ int32 __arch_get_stack_trace(addr_t* returnAddresses, int32 maxCount,
 
 void __set_stack_protection(void);
 
+void __pthread_mutex_lock_single_threaded(struct _pthread_mutex *mutex);
+void __pthread_mutex_unlock_single_threaded(struct _pthread_mutex *mutex);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef MALLOC_STATS_H
+#define MALLOC_STATS_H
+
+
+#include <OS.h>
+
+
+/* These functions are only provided by the slab allocator, see the
+ * HAIKU_LIBROOT_MALLOC build variable, and are therefore private to the
+ * system: programs using them only link against a libroot built with it.
+ */
+
+typedef struct malloc_statistics {
+	size_t	mapped_bytes;
+		/* memory the allocator currently got from the system */
+	size_t	used_bytes;
+		/* memory in allocations the application has not freed yet */
+	size_t	cached_bytes;
+		/* freed memory that is held in the per-thread caches */
+	size_t	free_bytes;
+		/* the rest of the mapped memory, including fragmentation */
+	uint64	returned_bytes;
+		/* memory given back to the system so far */
+	uint32	size_class_count;
+} malloc_statistics;
+
+typedef struct malloc_size_class_statistics {
+	size_t	object_size;
+	uint32	slab_count;
+	uint32	used_objects;
+	uint32	cached_objects;
+	uint32	free_objects;
+} malloc_size_class_statistics;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+status_t malloc_get_statistics(malloc_statistics *stats);
+status_t malloc_get_size_class_statistics(uint32 index,
+	malloc_size_class_statistics *stats);
+void malloc_dump_statistics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MALLOC_STATS_H */
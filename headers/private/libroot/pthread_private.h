@@ -48,6 +48,10 @@ typedef struct _pthread_rwlockattr {
 	uint32_t	flags;
 } pthread_rwlockattr;
 
+typedef struct _pthread_barrierattr {
+	bool		process_shared;
+} pthread_barrierattr;
+
 typedef void (*pthread_key_destructor)(void *data);
 
 struct pthread_key {
@@ -87,6 +91,10 @@ status_t __pthread_init_creation_attributes(
 	void* argument2, const char* name,
 	struct thread_creation_attributes* attributes);
 
+int32 __pthread_mutex_unlock_for_wait(pthread_mutex_t* mutex);
+void __pthread_mutex_lock_after_wait(pthread_mutex_t* mutex,
+	int32 ownerCount);
+
 #ifdef __cplusplus
 }
 #endif
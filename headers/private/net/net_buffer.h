@@ -15,6 +15,20 @@
 
 #define NET_BUFFER_MODULE_NAME "network/stack/buffer/v1"
 
+// net_buffer::flags, in addition to the MSG_* flags
+#define NET_BUFFER_IP_CHECKSUM_PENDING		0x00010000
+	// outgoing: the IP header checksum is left to the device
+#define NET_BUFFER_DATA_CHECKSUM_PENDING	0x00020000
+	// outgoing: the TCP checksum is left to the device
+#define NET_BUFFER_IP_CHECKSUM_VALID		0x00040000
+	// incoming: the IP header checksum has already been verified
+#define NET_BUFFER_DATA_CHECKSUM_VALID		0x00080000
+	// incoming: the TCP/UDP checksum has already been verified
+
+#define NET_BUFFER_CHECKSUM_FLAGS \
+	(NET_BUFFER_IP_CHECKSUM_PENDING | NET_BUFFER_DATA_CHECKSUM_PENDING \
+		| NET_BUFFER_IP_CHECKSUM_VALID | NET_BUFFER_DATA_CHECKSUM_VALID)
+
 
 typedef struct net_buffer {
 	struct list_link		link;
@@ -39,6 +53,9 @@ typedef struct net_buffer {
 
 struct ancillary_data_container;
 
+typedef void (*net_buffer_free_func)(void* cookie);
+	// called when the external data of a buffer is no longer referenced
+
 struct net_buffer_module_info {
 	module_info info;
 
@@ -67,6 +84,9 @@ struct net_buffer_module_info {
 	status_t		(*trim)(net_buffer* buffer, size_t newSize);
 	status_t		(*append_cloned)(net_buffer* buffer, net_buffer* source,
 						uint32 offset, size_t bytes);
+	status_t		(*append_external)(net_buffer* buffer, void* data,
+						size_t bytes, net_buffer_free_func freeFunc,
+						void* cookie);
 
 	status_t		(*associate_data)(net_buffer* buffer, void* data);
 
@@ -7,8 +7,10 @@
 
 
 #include <net/if.h>
+#include <net/route.h>
 
 #include <net_buffer.h>
+#include <net_device.h>
 #include <net_routing_info.h>
 
 #include <util/list.h>
@@ -178,4 +180,20 @@ struct net_address_module_info {
 };
 
 
+/*!	Returns the offload capabilities (NET_DEVICE_*) of the device buffers
+	sent via \a route go out through. Buffers on a local route never leave
+	the machine, and need neither checksums, nor segmentation.
+*/
+static inline uint32
+route_capabilities(const net_route* route)
+{
+	if ((route->flags & RTF_LOCAL) != 0) {
+		return NET_DEVICE_TX_IP_CHECKSUM | NET_DEVICE_TX_DATA_CHECKSUM
+			| NET_DEVICE_TCP_SEGMENTATION;
+	}
+
+	return route->interface_address->interface->device->capabilities;
+}
+
+
 #endif	// NET_DATALINK_H
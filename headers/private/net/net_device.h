@@ -14,6 +14,19 @@
 typedef struct net_buffer net_buffer;
 
 
+// net_device::capabilities
+#define NET_DEVICE_RX_IP_CHECKSUM		0x0001
+	// verifies the IP header checksum of incoming packets
+#define NET_DEVICE_RX_DATA_CHECKSUM		0x0002
+	// verifies the TCP/UDP checksum of incoming packets
+#define NET_DEVICE_TX_IP_CHECKSUM		0x0004
+	// computes the IP header checksum of outgoing packets
+#define NET_DEVICE_TX_DATA_CHECKSUM		0x0008
+	// computes the TCP checksum of outgoing packets
+#define NET_DEVICE_TCP_SEGMENTATION		0x0010
+	// splits outgoing TCP segments larger than the MTU (TSO)
+
+
 struct net_hardware_address {
 	uint8	data[64];
 	uint8	length;
@@ -31,6 +44,9 @@ typedef struct net_device {
 	uint64	link_speed;
 	uint32	link_quality;
 	size_t	header_length;
+	uint32	capabilities;	// NET_DEVICE_*
+	uint32	receive_queue_count;
+		// for receive_queue_data(), if the device has more than one
 
 	struct net_hardware_address address;
 
@@ -61,6 +77,11 @@ struct net_device_module_info {
 					const struct sockaddr* address);
 	status_t	(*remove_multicast)(net_device* device,
 					const struct sockaddr* address);
+
+	status_t	(*receive_queue_data)(net_device* device, uint32 queue,
+					net_buffer** _buffer);
+		// optional, for devices that distribute incoming packets among
+		// several receive queues by flow (RSS)
 };
 
 
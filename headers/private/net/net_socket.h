@@ -112,6 +112,9 @@ struct net_socket_module_info {
 					size_t length, int flags);
 	ssize_t		(*send)(net_socket* socket, struct msghdr* , const void* data,
 					size_t length, int flags);
+	ssize_t		(*send_external)(net_socket* socket, const iovec* vecs,
+					void* const* cookies, uint32 count,
+					net_buffer_free_func freeFunc, int flags);
 	int			(*setsockopt)(net_socket* socket, int level, int option,
 					const void* optionValue, int optionLength);
 	int			(*shutdown)(net_socket* socket, int direction);
@@ -134,6 +134,7 @@ struct net_stack_module_info {
 
 	status_t	(*device_enqueue_buffer)(net_device* device,
 					net_buffer* buffer);
+	uint32		(*device_flow_hash)(net_buffer* buffer);
 
 	// Utility Functions
 
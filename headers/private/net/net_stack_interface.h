@@ -50,6 +50,9 @@ struct net_stack_interface_module_info {
 					socklen_t addressLength);
 	ssize_t (*sendmsg)(net_socket* socket, const struct msghdr* message,
 					int flags);
+	ssize_t (*send_external)(net_socket* socket, const struct iovec* vecs,
+					void* const* cookies, uint32 count,
+					void (*freeFunc)(void* cookie), int flags);
 
 	status_t (*getsockopt)(net_socket* socket, int level, int option,
 					void* value, socklen_t* _length);
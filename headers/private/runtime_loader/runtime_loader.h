@@ -100,6 +100,11 @@ typedef struct image_t {
 	uint32				api_version;
 	uint32				abi;
 
+	// identity of the image file, as found when registering the image
+	dev_t				device;
+	ino_t				node;
+	bigtime_t			modification_time;
+
 	addr_t 				entry_point;
 	addr_t				init_routine;
 	addr_t				term_routine;
@@ -115,6 +120,16 @@ typedef struct image_t {
 	int					rela_len;
 	elf_rel				*pltrel;
 	int					pltrel_len;
+	addr_t				*pltgot;
+
+	// DT_GNU_HASH table -- gnu_hash_buckets is NULL, if there is none
+	uint32				gnu_hash_bucket_count;
+	uint32				gnu_hash_symbol_offset;
+	uint32				gnu_hash_bloom_mask;
+	uint32				gnu_hash_bloom_shift;
+	addr_t				*gnu_hash_bloom;
+	uint32				*gnu_hash_buckets;
+	uint32				*gnu_hash_chains;
 
 	unsigned			dso_tls_id;
 
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PER_CPU_H_
+#define _PER_CPU_H_
+
+#include <OS.h>
+
+#include <locks.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Each CPU gets its own cache line, so that threads on different CPUs never
+ * touch the same one. Where the kernel supports restartable sequences, the
+ * operations use neither atomic instructions nor locks.
+ */
+
+typedef struct per_cpu_counter {
+	int64*		slots;
+} per_cpu_counter;
+
+typedef struct per_cpu_list {
+	void**		heads;
+	mutex		lock;
+		// only used when restartable sequences are not available
+} per_cpu_list;
+
+#define per_cpu_counter_init(counter)		__per_cpu_counter_init(counter)
+#define per_cpu_counter_destroy(counter)	__per_cpu_counter_destroy(counter)
+#define per_cpu_counter_add(counter, value) \
+	__per_cpu_counter_add(counter, value)
+#define per_cpu_counter_sum(counter)		__per_cpu_counter_sum(counter)
+
+#define per_cpu_list_init(list)				__per_cpu_list_init(list)
+#define per_cpu_list_destroy(list)			__per_cpu_list_destroy(list)
+#define per_cpu_list_push(list, element)	__per_cpu_list_push(list, element)
+#define per_cpu_list_pop(list)				__per_cpu_list_pop(list)
+
+status_t	__per_cpu_counter_init(per_cpu_counter *counter);
+void		__per_cpu_counter_destroy(per_cpu_counter *counter);
+void		__per_cpu_counter_add(per_cpu_counter *counter, int64 value);
+int64		__per_cpu_counter_sum(const per_cpu_counter *counter);
+
+/* The first word of a list element is used to link it. Elements are pushed
+ * to and popped from the list of the CPU the calling thread runs on; pop
+ * returns NULL, if that one is empty. Destroying a list doesn't touch the
+ * elements still in it.
+ */
+status_t	__per_cpu_list_init(per_cpu_list *list);
+void		__per_cpu_list_destroy(per_cpu_list *list);
+void		__per_cpu_list_push(per_cpu_list *list, void *element);
+void*		__per_cpu_list_pop(per_cpu_list *list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PER_CPU_H_
@@ -12,6 +12,8 @@
 struct arch_real_time_data {
 	bigtime_t	system_time_offset;
 	uint32		system_time_conversion_factor;
+	int32		version;
+		// odd while the kernel is changing system_time_offset
 };
 
 #endif	/* _KERNEL_ARCH_REAL_TIME_DATA_H */
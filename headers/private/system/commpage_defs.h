@@ -11,13 +11,14 @@
 #define COMMPAGE_ENTRY_MAGIC				0
 #define COMMPAGE_ENTRY_VERSION				1
 #define COMMPAGE_ENTRY_REAL_TIME_DATA		2
-#define COMMPAGE_ENTRY_FIRST_ARCH_SPECIFIC	3
+#define COMMPAGE_ENTRY_CPU_DATA				3
+#define COMMPAGE_ENTRY_FIRST_ARCH_SPECIFIC	4
 
 #define COMMPAGE_SIZE (0x8000)
 #define COMMPAGE_TABLE_ENTRIES 64
 
 #define COMMPAGE_SIGNATURE 'COMM'
-#define COMMPAGE_VERSION 1
+#define COMMPAGE_VERSION 2
 
 #include <arch_commpage_defs.h>
 
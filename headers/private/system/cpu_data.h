@@ -0,0 +1,21 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_CPU_DATA_H
+#define _SYSTEM_CPU_DATA_H
+
+
+#include <SupportDefs.h>
+
+
+/*!	CPU information the kernel publishes in the commpage, so that userland
+	can query it without a syscall. Each field is updated atomically.
+*/
+struct cpu_data {
+	int32	cpu_count;
+	int32	enabled_cpu_count;
+};
+
+
+#endif	/* _SYSTEM_CPU_DATA_H */
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_EVENT_QUEUE_DEFS_H
+#define _SYSTEM_EVENT_QUEUE_DEFS_H
+
+
+#include <OS.h>
+
+
+// flags for event_wait_info::events passed to _kern_event_queue_select()
+#define B_EVENT_LEVEL_TRIGGERED		0x01000000
+	// The event is reported by every _kern_event_queue_wait() as long as the
+	// condition persists, rather than only once when it occurs.
+#define B_EVENT_ONE_SHOT			0x02000000
+	// The object is disabled after the event has been reported once. It can
+	// be re-enabled by selecting it again.
+
+#define B_EVENT_QUEUE_FLAGS_MASK \
+	(B_EVENT_LEVEL_TRIGGERED | B_EVENT_ONE_SHOT)
+
+
+typedef struct event_wait_info {
+	int32		object;				/* ID of the object */
+	uint16		type;				/* type of the object */
+	int32		events;				/* events mask and flags, or error code */
+	void*		user_data;			/* returned with the events */
+} event_wait_info;
+
+/* _kern_event_queue_select() adds the objects to the queue, or changes the
+   events and user data of objects that already are in it. Objects whose
+   events field is 0 are removed from the queue. When an object could not be
+   selected, its events field is set to the error code.
+   _kern_event_queue_wait() returns the objects for which events have
+   occurred, with the events field containing just those events. Like for
+   wait_for_objects(), B_EVENT_INVALID, B_EVENT_ERROR, and
+   B_EVENT_DISCONNECTED are always reported. Objects that became invalid are
+   removed from the queue automatically. */
+
+
+#endif	/* _SYSTEM_EVENT_QUEUE_DEFS_H */
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_IO_RING_DEFS_H
+#define _SYSTEM_IO_RING_DEFS_H
+
+
+#include <SupportDefs.h>
+
+
+/* An I/O ring is an area shared between the kernel and a team, containing a
+   submission queue (SQ) and a completion queue (CQ). The team fills in
+   io_ring_sqe entries at sq_tail and advances it, then calls
+   _kern_io_ring_enter() to make the kernel consume them. Results are posted
+   as io_ring_cqe entries at cq_tail, which the team can poll for without
+   entering the kernel; it advances cq_head when it has handled them.
+
+   Requests are executed asynchronously and may complete in any order. The
+   kernel never has more requests in flight than there is free space in the
+   CQ, so it cannot overflow as long as the team only advances cq_head over
+   entries it has consumed. */
+
+
+#define B_IO_RING_MAX_ENTRIES		4096
+
+enum {
+	B_IO_RING_OP_NOP	= 0,
+	B_IO_RING_OP_READ,			/* read()/pread() */
+	B_IO_RING_OP_WRITE,			/* write()/pwrite() */
+	B_IO_RING_OP_READV,			/* readv()/preadv() */
+	B_IO_RING_OP_WRITEV,		/* writev()/pwritev() */
+	B_IO_RING_OP_FSYNC,			/* fsync() */
+	B_IO_RING_OP_ACCEPT,		/* accept() */
+	B_IO_RING_OP_RECV,			/* recv() */
+	B_IO_RING_OP_SEND,			/* send() */
+
+	B_IO_RING_OP_COUNT
+};
+
+
+typedef struct io_ring_sqe {
+	uint8		opcode;
+	uint8		reserved[3];
+	int32		fd;
+	int64		offset;		/* file position, -1 for the current one; for
+							   accept(), the socklen_t* address length */
+	uint64		address;	/* buffer, iovec array, or sockaddr */
+	uint32		length;		/* buffer size, or number of iovecs */
+	uint32		op_flags;	/* recv()/send() flags */
+	uint64		user_data;	/* passed back in the completion */
+} io_ring_sqe;
+
+typedef struct io_ring_cqe {
+	uint64		user_data;
+	int64		result;		/* bytes transferred, new FD, or error code */
+} io_ring_cqe;
+
+typedef struct io_ring_info {
+	uint32		sq_head;	/* advanced by the kernel */
+	uint32		sq_tail;	/* advanced by the team */
+	uint32		sq_mask;
+	uint32		sq_entries;
+	uint32		cq_head;	/* advanced by the team */
+	uint32		cq_tail;	/* advanced by the kernel */
+	uint32		cq_mask;
+	uint32		cq_entries;
+	uint32		sqes_offset;	/* from the start of the area */
+	uint32		cqes_offset;
+	uint32		reserved[2];
+} io_ring_info;
+
+
+#endif	/* _SYSTEM_IO_RING_DEFS_H */
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_PORT_DEFS_H
+#define _SYSTEM_PORT_DEFS_H
+
+
+#include <OS.h>
+
+
+#define B_PORT_MAX_BATCH_COUNT		64
+	// maximum number of messages per _kern_{read,write}_port_batch() call
+
+// flags for port_batch_message::flags
+#define B_PORT_MESSAGE_AREA			0x01
+	// The message payload is an area rather than a buffer.
+
+
+typedef struct port_batch_message {
+	int32		code;
+	uint32		flags;
+	void*		buffer;
+	size_t		size;
+	area_id		area;
+} port_batch_message;
+
+/* _kern_write_port_batch() writes the messages in order. A message with
+   B_PORT_MESSAGE_AREA set transfers the ownership of its area (which the
+   calling team must own) to the port, and the first size bytes of the area
+   form the payload; buffer is ignored. Such a message is not subject to the
+   port message size limit, but the whole area counts towards the space the
+   kernel allows all port messages to take up, and it must not be larger than
+   16 MB, nor be shared with other areas.
+
+   _kern_read_port_batch() reads messages into the given buffers, setting
+   code and size (the number of bytes read). If B_PORT_MESSAGE_AREA is set in
+   flags, the caller accepts area messages: for those, the area is
+   transferred to the calling team and returned in area and buffer, with size
+   being the payload size, and B_PORT_MESSAGE_AREA stays set. Otherwise area
+   messages are copied like any other, and B_PORT_MESSAGE_AREA is cleared.
+
+   Both calls only wait (as specified by flags and timeout) for the first
+   message, and return the number of messages transferred, or an error, if
+   that was none. */
+
+
+#endif	/* _SYSTEM_PORT_DEFS_H */
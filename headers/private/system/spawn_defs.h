@@ -0,0 +1,54 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SYSTEM_SPAWN_DEFS_H
+#define _SYSTEM_SPAWN_DEFS_H
+
+
+#include <signal.h>
+
+#include <OS.h>
+
+
+#define B_SPAWN_MAX_FILE_ACTIONS	1024
+	// maximum number of file actions per _kern_spawn() call
+
+// spawn_file_action::type
+enum {
+	B_SPAWN_FILE_ACTION_OPEN	= 0,
+	B_SPAWN_FILE_ACTION_CLOSE,
+	B_SPAWN_FILE_ACTION_DUP2
+};
+
+
+typedef struct spawn_file_action {
+	uint32		type;
+	int			fd;
+	int			source_fd;		// B_SPAWN_FILE_ACTION_DUP2
+	int			open_flags;		// B_SPAWN_FILE_ACTION_OPEN
+	mode_t		open_mode;		// B_SPAWN_FILE_ACTION_OPEN
+	char*		path;			// B_SPAWN_FILE_ACTION_OPEN
+} spawn_file_action;
+
+typedef struct spawn_attributes {
+	uint32		flags;			// POSIX_SPAWN_* flags
+	pid_t		process_group;
+	sigset_t	signal_mask;
+	sigset_t	default_signals;
+	mode_t		umask;
+	int32		file_action_count;
+	spawn_file_action* file_actions;
+} spawn_attributes;
+
+/* _kern_spawn() creates a new team like _kern_load_image() with
+   B_WAIT_TILL_LOADED, as a child of the calling team. Before the runtime
+   loader starts, the new team's main thread performs the file actions in
+   order in the new team's I/O context, and applies the POSIX_SPAWN_* flags
+   given. The new team's signal mask is always set to signal_mask, and it
+   inherits the signal actions set to SIG_IGN of the calling team, except
+   for those in default_signals if POSIX_SPAWN_SETSIGDEF is given. Errors
+   of either step are returned by _kern_spawn(). */
+
+
+#endif	/* _SYSTEM_SPAWN_DEFS_H */
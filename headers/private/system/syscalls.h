@@ -22,13 +22,16 @@ extern "C" {
 
 struct attr_info;
 struct dirent;
+struct event_wait_info;
 struct fd_info;
 struct fd_set;
 struct fs_info;
 struct iovec;
+struct io_ring_info;
 struct msqid_ds;
 struct net_stat;
 struct pollfd;
+struct port_batch_message;
 struct rlimit;
 struct scheduling_analysis;
 struct _sem_t;
@@ -36,6 +39,7 @@ struct sembuf;
 union semun;
 struct sigaction;
 struct signal_frame_data;
+struct spawn_attributes;
 struct stat;
 struct system_profiler_parameters;
 struct user_timer_info;
@@ -73,15 +77,27 @@ extern status_t		_kern_get_safemode_option(const char *parameter,
 extern ssize_t		_kern_wait_for_objects(object_wait_info* infos, int numInfos,
 						uint32 flags, bigtime_t timeout);
 
+/* event queues */
+extern int			_kern_event_queue_create(int openFlags);
+extern status_t		_kern_event_queue_select(int queue,
+						struct event_wait_info* infos, int numInfos);
+extern ssize_t		_kern_event_queue_wait(int queue,
+						struct event_wait_info* infos, int numInfos,
+						uint32 flags, bigtime_t timeout);
+
 /* user mutex functions */
 extern status_t		_kern_mutex_lock(int32* mutex, const char* name,
 						uint32 flags, bigtime_t timeout);
 extern status_t		_kern_mutex_unlock(int32* mutex, uint32 flags);
 extern status_t		_kern_mutex_switch_lock(int32* fromMutex, int32* toMutex,
 						const char* name, uint32 flags, bigtime_t timeout);
-extern status_t		_kern_mutex_sem_acquire(int32* sem, const char* name,
+
+/* futex functions */
+extern status_t		_kern_futex_wait(int32* address, int32 value,
 						uint32 flags, bigtime_t timeout);
-extern status_t		_kern_mutex_sem_release(int32* sem);
+extern int32		_kern_futex_wake(int32* address, int32 count);
+extern int32		_kern_futex_requeue(int32* address, int32 value,
+						int32 wakeCount, int32* target, int32 requeueCount);
 
 /* sem functions */
 extern sem_id		_kern_create_sem(int count, const char *name);
@@ -135,6 +151,9 @@ extern thread_id	_kern_load_image(const char* const* flatArgs,
 						size_t flatArgsSize, int32 argCount, int32 envCount,
 						int32 priority, uint32 flags, port_id errorPort,
 						uint32 errorToken);
+extern thread_id	_kern_spawn(const char* path, const char* const* flatArgs,
+						size_t flatArgsSize, int32 argCount, int32 envCount,
+						const struct spawn_attributes* attributes);
 extern void __NO_RETURN _kern_exit_team(status_t returnValue);
 extern status_t		_kern_kill_team(team_id team);
 extern team_id		_kern_get_current_team();
@@ -145,6 +164,7 @@ extern status_t		_kern_exec(const char *path, const char* const* flatArgs,
 						size_t flatArgsSize, int32 argCount, int32 envCount,
 						mode_t umask);
 extern thread_id	_kern_fork(void);
+extern thread_id	_kern_vfork(void);
 extern pid_t		_kern_process_info(pid_t process, int32 which);
 extern pid_t		_kern_setpgid(pid_t process, pid_t group);
 extern pid_t		_kern_setsid(void);
@@ -195,6 +215,8 @@ extern status_t		_kern_unblock_threads(thread_id* threads, uint32 count,
 
 extern bigtime_t	_kern_estimate_max_scheduling_latency(thread_id thread);
 
+extern status_t		_kern_register_rseq(void);
+
 extern status_t		_kern_set_scheduler_mode(int32 mode);
 extern int32		_kern_get_scheduler_mode(void);
 
@@ -320,6 +342,10 @@ extern ssize_t		_kern_write(int fd, off_t pos, const void *buffer,
 						size_t bufferSize);
 extern ssize_t		_kern_writev(int fd, off_t pos, const struct iovec *vecs,
 						size_t count);
+extern int			_kern_io_ring_create(uint32 entries, uint32 flags,
+						struct io_ring_info **_info);
+extern ssize_t		_kern_io_ring_enter(int ring, uint32 toSubmit,
+						uint32 minComplete, uint32 flags, bigtime_t timeout);
 extern status_t		_kern_ioctl(int fd, uint32 cmd, void *data, size_t length);
 extern ssize_t		_kern_read_dir(int fd, struct dirent *buffer,
 						size_t bufferSize, uint32 maxCount);
@@ -361,6 +387,8 @@ extern ssize_t		_kern_sendto(int socket, const void *data, size_t length,
 						socklen_t addressLength);
 extern ssize_t		_kern_sendmsg(int socket, const struct msghdr *message,
 						int flags);
+extern ssize_t		_kern_sendfile(int socket, int fd, off_t *offset,
+						size_t length);
 extern status_t		_kern_getsockopt(int socket, int level, int option,
 						void *value, socklen_t *_length);
 extern status_t		_kern_setsockopt(int socket, int level, int option,
@@ -469,6 +497,12 @@ extern status_t		_kern_writev_port_etc(port_id id, int32 msgCode,
 extern status_t		_kern_get_port_message_info_etc(port_id port,
 						port_message_info *info, size_t infoSize, uint32 flags,
 						bigtime_t timeout);
+extern ssize_t		_kern_read_port_batch(port_id port,
+						struct port_batch_message *messages, size_t count,
+						uint32 flags, bigtime_t timeout);
+extern ssize_t		_kern_write_port_batch(port_id port,
+						const struct port_batch_message *messages,
+						size_t count, uint32 flags, bigtime_t timeout);
 
 // debug support functions
 extern status_t		_kern_kernel_debugger(const char *message);
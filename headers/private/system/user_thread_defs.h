@@ -12,6 +12,15 @@
 #include <SupportDefs.h>
 
 
+// Describes a restartable sequence: a piece of code that ends with a single
+// committing store. If the thread is preempted, migrated, or interrupted by a
+// signal while executing it, the kernel continues it at the abort address.
+struct user_rseq {
+	addr_t			start;				// first instruction
+	addr_t			end;				// instruction after the commit
+	addr_t			abort;				// where to continue when aborted
+};
+
 struct user_thread {
 	pthread_t		pthread;			// pthread pointer
 	uint32			flags;
@@ -19,6 +28,9 @@ struct user_thread {
 	int32			defer_signals;		// counter; 0 == signals allowed
 	sigset_t		pending_signals;	// signals that are pending, when
 										// signals are deferred
+	int32			cpu;				// current CPU, -1 until
+										// _kern_register_rseq() was called
+	const struct user_rseq* rseq;		// the sequence the thread is in
 };
 
 
@@ -34,6 +34,7 @@
 #include "PackagesDirectory.h"
 #include "PackageSettings.h"
 #include "PackageSymlink.h"
+#include "PackageTOCCache.h"
 #include "Version.h"
 #include "Volume.h"
 
@@ -1023,13 +1024,41 @@ Package::_Load(const PackageSettings& settings)
 		status_t error = packageReader.Init(fd, false,
 			BHPKG::B_HPKG_READER_DONT_PRINT_VERSION_MISMATCH_MESSAGE);
 		if (error == B_OK) {
+			// If the TOC cache has a valid record for the package, replay it
+			// instead of parsing the package content.
+			PackageTOCCache& tocCache = fVolume->TOCCache();
+			PackageTOCCache::Key tocCacheKey;
+			bool useTOCCache = tocCache.IsEnabled()
+				&& PackageTOCCache::GetKey(fd, tocCacheKey) == B_OK;
+			if (useTOCCache) {
+				LoaderContentHandler handler(this, settings);
+				error = handler.Init();
+				if (error != B_OK)
+					RETURN_ERROR(error);
+
+				error = tocCache.Replay(fFileName, tocCacheKey, &handler);
+				if (error == B_OK) {
+					fHeapReader = packageReader.DetachCachedHeapReader();
+					return B_OK;
+				}
+
+				// replaying may have added partial content
+				_ResetContent();
+			}
+
 			// parse content
 			LoaderContentHandler handler(this, settings);
 			error = handler.Init();
 			if (error != B_OK)
 				RETURN_ERROR(error);
 
-			error = packageReader.ParseContent(&handler);
+			if (useTOCCache) {
+				PackageTOCCache::Recorder recorder(&handler);
+				error = packageReader.ParseContent(&recorder);
+				if (error == B_OK)
+					tocCache.AddRecord(fFileName, tocCacheKey, recorder);
+			} else
+				error = packageReader.ParseContent(&handler);
 			if (error != B_OK)
 				RETURN_ERROR(error);
 
@@ -1067,6 +1096,25 @@ Package::_Load(const PackageSettings& settings)
 }
 
 
+void
+Package::_ResetContent()
+{
+	while (PackageNode* node = fNodes.RemoveHead())
+		node->ReleaseReference();
+
+	while (Resolvable* resolvable = fResolvables.RemoveHead())
+		delete resolvable;
+
+	while (Dependency* dependency = fDependencies.RemoveHead())
+		delete dependency;
+
+	SetVersion(NULL);
+	fName = String();
+	fInstallPath = String();
+	fArchitecture = B_PACKAGE_ARCHITECTURE_ENUM_COUNT;
+}
+
+
 bool
 Package::_InitVersionedName()
 {
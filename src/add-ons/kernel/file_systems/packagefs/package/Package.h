@@ -112,6 +112,7 @@ private:
 
 private:
 			status_t			_Load(const PackageSettings& settings);
+			void				_ResetContent();
 			bool				_InitVersionedName();
 
 private:
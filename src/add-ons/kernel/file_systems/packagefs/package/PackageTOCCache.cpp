@@ -0,0 +1,1153 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "PackageTOCCache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <new>
+
+#include <package/hpkg/PackageEntry.h>
+#include <package/hpkg/PackageEntryAttribute.h>
+#include <package/hpkg/PackageInfoAttributeValue.h>
+
+#include <AutoDeleter.h>
+#include <kernel.h>
+#include <PackagesDirectoryDefs.h>
+#include <package/hpkg/HPKGDefsPrivate.h>
+#include <syscalls.h>
+#include <util/AutoLock.h>
+
+#include "DebugSupport.h"
+
+
+using namespace BPackageKit;
+
+using BPackageKit::BHPKG::B_HPKG_MAX_INLINE_DATA_SIZE;
+using BPackageKit::BHPKG::BPackageData;
+using BPackageKit::BHPKG::BPackageVersionData;
+using BPackageKit::BHPKG::BPrivate::hpkg_header;
+
+
+static const char* const kCacheFilePath
+	= PACKAGES_DIRECTORY_ADMIN_DIRECTORY "/packagefs_toc_cache";
+static const char* const kTemporaryCacheFilePath
+	= PACKAGES_DIRECTORY_ADMIN_DIRECTORY "/packagefs_toc_cache.tmp";
+
+static const uint32 kCacheFileMagic = 'pTOC';
+static const uint32 kCacheFileVersion = 2;
+
+// sanity limits
+static const size_t kMaxCacheFileSize = 128 * 1024 * 1024;
+static const size_t kMaxEntryDepth = 1024;
+
+// record opcodes
+enum {
+	OP_PACKAGE_ATTRIBUTE	= 1,
+	OP_ENTRY				= 2,
+	OP_ENTRY_ATTRIBUTE		= 3,
+	OP_ENTRY_DONE			= 4
+};
+
+static const uint16 kNullStringLength = 0xffff;
+
+
+struct cache_file_header {
+	uint32	magic;
+	uint32	version;
+	uint32	entry_count;
+	uint32	reserved;
+	uint64	file_size;
+};
+
+
+struct cache_entry_header {
+	uint32	record_size;		// including this header, 8 byte aligned
+	uint32	data_size;
+	uint32	data_checksum;
+	uint16	file_name_length;	// including the terminating null
+	uint16	reserved;
+	int64	node_id;
+	int64	file_size;
+	int64	modified_time;
+	int32	modified_time_nanos;
+	uint32	header_checksum;
+};
+
+
+static uint32
+compute_checksum(const void* _buffer, size_t size)
+{
+	// FNV-1a -- fast and good enough to detect stale or damaged records
+	const uint8* buffer = (const uint8*)_buffer;
+	uint32 hash = 2166136261U;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= buffer[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+
+// #pragma mark - Entry
+
+
+struct PackageTOCCache::Entry {
+	char*			fileName;
+	Key				key;
+	const uint8*	data;
+	size_t			dataSize;
+	bool			ownsData;
+	Entry*			hashNext;
+
+	Entry()
+		:
+		fileName(NULL),
+		data(NULL),
+		dataSize(0),
+		ownsData(false),
+		hashNext(NULL)
+	{
+	}
+
+	~Entry()
+	{
+		free(fileName);
+		if (ownsData)
+			free((void*)data);
+	}
+};
+
+
+struct PackageTOCCache::EntryHashDefinition {
+	typedef const char*		KeyType;
+	typedef	Entry			ValueType;
+
+	size_t HashKey(const char* key) const
+	{
+		return hash_hash_string(key);
+	}
+
+	size_t Hash(const Entry* value) const
+	{
+		return HashKey(value->fileName);
+	}
+
+	bool Compare(const char* key, const Entry* value) const
+	{
+		return strcmp(value->fileName, key) == 0;
+	}
+
+	Entry*& GetLink(Entry* value) const
+	{
+		return value->hashNext;
+	}
+};
+
+
+// #pragma mark - Writer
+
+
+struct PackageTOCCache::Writer {
+	Writer()
+		:
+		fBuffer(NULL),
+		fSize(0),
+		fCapacity(0),
+		fError(false)
+	{
+	}
+
+	~Writer()
+	{
+		free(fBuffer);
+	}
+
+	bool HasError() const
+	{
+		return fError;
+	}
+
+	uint8* DetachBuffer(size_t& _size)
+	{
+		uint8* buffer = fBuffer;
+		_size = fSize;
+		fBuffer = NULL;
+		fSize = fCapacity = 0;
+		return buffer;
+	}
+
+	void Write(const void* data, size_t size)
+	{
+		if (fError)
+			return;
+
+		if (fSize + size > fCapacity) {
+			size_t capacity = fCapacity == 0 ? 4096 : fCapacity;
+			while (capacity < fSize + size)
+				capacity *= 2;
+			if (capacity > kMaxCacheFileSize) {
+				fError = true;
+				return;
+			}
+
+			uint8* buffer = (uint8*)realloc(fBuffer, capacity);
+			if (buffer == NULL) {
+				fError = true;
+				return;
+			}
+
+			fBuffer = buffer;
+			fCapacity = capacity;
+		}
+
+		memcpy(fBuffer + fSize, data, size);
+		fSize += size;
+	}
+
+	void WriteUInt8(uint8 value)
+	{
+		Write(&value, sizeof(value));
+	}
+
+	void WriteUInt32(uint32 value)
+	{
+		Write(&value, sizeof(value));
+	}
+
+	void WriteUInt64(uint64 value)
+	{
+		Write(&value, sizeof(value));
+	}
+
+	void WriteString(const char* string)
+	{
+		if (string == NULL) {
+			uint16 length = kNullStringLength;
+			Write(&length, sizeof(length));
+			return;
+		}
+
+		size_t length = strlen(string);
+		if (length >= kNullStringLength) {
+			fError = true;
+			return;
+		}
+
+		uint16 length16 = length;
+		Write(&length16, sizeof(length16));
+		Write(string, length + 1);
+	}
+
+	void WriteData(const BPackageData& data)
+	{
+		if (data.IsEncodedInline()) {
+			WriteUInt8(1);
+			WriteUInt8(data.Size());
+			Write(data.InlineData(), data.Size());
+		} else {
+			WriteUInt8(0);
+			WriteUInt64(data.Size());
+			WriteUInt64(data.Offset());
+		}
+	}
+
+	void WriteVersion(const BPackageVersionData& version)
+	{
+		WriteString(version.major);
+		WriteString(version.minor);
+		WriteString(version.micro);
+		WriteString(version.preRelease);
+		WriteUInt32(version.revision);
+	}
+
+private:
+	uint8*	fBuffer;
+	size_t	fSize;
+	size_t	fCapacity;
+	bool	fError;
+};
+
+
+// #pragma mark - Reader
+
+
+struct PackageTOCCache::Reader {
+	Reader(const uint8* data, size_t size)
+		:
+		fData(data),
+		fEnd(data + size)
+	{
+	}
+
+	bool IsAtEnd() const
+	{
+		return fData == fEnd;
+	}
+
+	status_t Read(void* buffer, size_t size)
+	{
+		if ((size_t)(fEnd - fData) < size)
+			RETURN_ERROR(B_BAD_DATA);
+
+		memcpy(buffer, fData, size);
+		fData += size;
+		return B_OK;
+	}
+
+	status_t ReadUInt8(uint8& _value)
+	{
+		return Read(&_value, sizeof(_value));
+	}
+
+	status_t ReadUInt32(uint32& _value)
+	{
+		return Read(&_value, sizeof(_value));
+	}
+
+	status_t ReadUInt64(uint64& _value)
+	{
+		return Read(&_value, sizeof(_value));
+	}
+
+	status_t ReadString(const char*& _string)
+	{
+		uint16 length;
+		status_t error = Read(&length, sizeof(length));
+		if (error != B_OK)
+			return error;
+
+		if (length == kNullStringLength) {
+			_string = NULL;
+			return B_OK;
+		}
+
+		// The string is stored null-terminated, so we can return a pointer
+		// into the buffer.
+		if ((size_t)(fEnd - fData) < (size_t)length + 1
+			|| fData[length] != '\0') {
+			RETURN_ERROR(B_BAD_DATA);
+		}
+
+		_string = (const char*)fData;
+		fData += length + 1;
+		return B_OK;
+	}
+
+	status_t ReadData(BPackageData& data)
+	{
+		uint8 inlineData;
+		status_t error = ReadUInt8(inlineData);
+		if (error != B_OK)
+			return error;
+
+		if (inlineData != 0) {
+			uint8 size;
+			uint8 buffer[B_HPKG_MAX_INLINE_DATA_SIZE];
+			error = ReadUInt8(size);
+			if (error == B_OK && size > B_HPKG_MAX_INLINE_DATA_SIZE)
+				error = B_BAD_DATA;
+			if (error == B_OK)
+				error = Read(buffer, size);
+			if (error != B_OK)
+				return error;
+
+			data.SetData(size, buffer);
+			return B_OK;
+		}
+
+		uint64 size;
+		uint64 offset;
+		error = ReadUInt64(size);
+		if (error == B_OK)
+			error = ReadUInt64(offset);
+		if (error != B_OK)
+			return error;
+
+		data.SetData(size, offset);
+		return B_OK;
+	}
+
+	status_t ReadVersion(BPackageVersionData& version)
+	{
+		status_t error = ReadString(version.major);
+		if (error == B_OK)
+			error = ReadString(version.minor);
+		if (error == B_OK)
+			error = ReadString(version.micro);
+		if (error == B_OK)
+			error = ReadString(version.preRelease);
+		if (error == B_OK)
+			error = ReadUInt32(version.revision);
+		return error;
+	}
+
+private:
+	const uint8*	fData;
+	const uint8*	fEnd;
+};
+
+
+// #pragma mark - Key
+
+
+bool
+PackageTOCCache::Key::operator==(const Key& other) const
+{
+	return nodeID == other.nodeID && fileSize == other.fileSize
+		&& modifiedTime.tv_sec == other.modifiedTime.tv_sec
+		&& modifiedTime.tv_nsec == other.modifiedTime.tv_nsec
+		&& headerChecksum == other.headerChecksum;
+}
+
+
+// #pragma mark - Recorder
+
+
+PackageTOCCache::Recorder::Recorder(BPackageContentHandler* target)
+	:
+	fTarget(target),
+	fWriter(new(std::nothrow) Writer),
+	fErrorOccurred(false)
+{
+}
+
+
+PackageTOCCache::Recorder::~Recorder()
+{
+	delete fWriter;
+}
+
+
+bool
+PackageTOCCache::Recorder::IsValid() const
+{
+	return fWriter != NULL && !fWriter->HasError() && !fErrorOccurred;
+}
+
+
+uint8*
+PackageTOCCache::Recorder::DetachData(size_t& _size)
+{
+	if (!IsValid())
+		return NULL;
+
+	return fWriter->DetachBuffer(_size);
+}
+
+
+status_t
+PackageTOCCache::Recorder::HandleEntry(BPackageEntry* entry)
+{
+	if (fWriter != NULL) {
+		fWriter->WriteUInt8(OP_ENTRY);
+		fWriter->WriteString(entry->Name());
+		fWriter->WriteUInt32(entry->Mode());
+		fWriter->WriteUInt64(entry->ModifiedTime().tv_sec);
+		fWriter->WriteUInt32(entry->ModifiedTime().tv_nsec);
+		fWriter->WriteData(entry->Data());
+		fWriter->WriteString(entry->SymlinkPath());
+	}
+
+	return fTarget->HandleEntry(entry);
+}
+
+
+status_t
+PackageTOCCache::Recorder::HandleEntryAttribute(BPackageEntry* entry,
+	BPackageEntryAttribute* attribute)
+{
+	if (fWriter != NULL) {
+		fWriter->WriteUInt8(OP_ENTRY_ATTRIBUTE);
+		fWriter->WriteString(attribute->Name());
+		fWriter->WriteUInt32(attribute->Type());
+		fWriter->WriteData(attribute->Data());
+	}
+
+	return fTarget->HandleEntryAttribute(entry, attribute);
+}
+
+
+status_t
+PackageTOCCache::Recorder::HandleEntryDone(BPackageEntry* entry)
+{
+	if (fWriter != NULL)
+		fWriter->WriteUInt8(OP_ENTRY_DONE);
+
+	return fTarget->HandleEntryDone(entry);
+}
+
+
+status_t
+PackageTOCCache::Recorder::HandlePackageAttribute(
+	const BPackageInfoAttributeValue& value)
+{
+	// Only record the attributes the loader is interested in.
+	if (fWriter != NULL) {
+		switch (value.attributeID) {
+			case B_PACKAGE_INFO_NAME:
+			case B_PACKAGE_INFO_INSTALL_PATH:
+				fWriter->WriteUInt8(OP_PACKAGE_ATTRIBUTE);
+				fWriter->WriteUInt8(value.attributeID);
+				fWriter->WriteString(value.string);
+				break;
+
+			case B_PACKAGE_INFO_VERSION:
+				fWriter->WriteUInt8(OP_PACKAGE_ATTRIBUTE);
+				fWriter->WriteUInt8(value.attributeID);
+				fWriter->WriteVersion(value.version);
+				break;
+
+			case B_PACKAGE_INFO_ARCHITECTURE:
+				fWriter->WriteUInt8(OP_PACKAGE_ATTRIBUTE);
+				fWriter->WriteUInt8(value.attributeID);
+				fWriter->WriteUInt64(value.unsignedInt);
+				break;
+
+			case B_PACKAGE_INFO_PROVIDES:
+				fWriter->WriteUInt8(OP_PACKAGE_ATTRIBUTE);
+				fWriter->WriteUInt8(value.attributeID);
+				fWriter->WriteString(value.resolvable.name);
+				fWriter->WriteUInt8(value.resolvable.haveVersion);
+				fWriter->WriteUInt8(value.resolvable.haveCompatibleVersion);
+				if (value.resolvable.haveVersion)
+					fWriter->WriteVersion(value.resolvable.version);
+				if (value.resolvable.haveCompatibleVersion)
+					fWriter->WriteVersion(value.resolvable.compatibleVersion);
+				break;
+
+			case B_PACKAGE_INFO_REQUIRES:
+				fWriter->WriteUInt8(OP_PACKAGE_ATTRIBUTE);
+				fWriter->WriteUInt8(value.attributeID);
+				fWriter->WriteString(value.resolvableExpression.name);
+				fWriter->WriteUInt8(
+					value.resolvableExpression.haveOpAndVersion);
+				if (value.resolvableExpression.haveOpAndVersion) {
+					fWriter->WriteUInt32(value.resolvableExpression.op);
+					fWriter->WriteVersion(value.resolvableExpression.version);
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return fTarget->HandlePackageAttribute(value);
+}
+
+
+void
+PackageTOCCache::Recorder::HandleErrorOccurred()
+{
+	fErrorOccurred = true;
+	fTarget->HandleErrorOccurred();
+}
+
+
+// #pragma mark - PackageTOCCache
+
+
+PackageTOCCache::PackageTOCCache()
+	:
+	fDirectoryFD(-1),
+	fEntries(NULL),
+	fFileBuffer(NULL),
+	fLoaded(false),
+	fDirty(false)
+{
+	mutex_init(&fLock, "packagefs toc cache");
+}
+
+
+PackageTOCCache::~PackageTOCCache()
+{
+	_Unload();
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+PackageTOCCache::Init(int packagesDirectoryFD)
+{
+	// The FD remains owned by the packages directory.
+	fDirectoryFD = packagesDirectoryFD;
+	return B_OK;
+}
+
+
+/*static*/ status_t
+PackageTOCCache::GetKey(int fd, Key& _key)
+{
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+		RETURN_ERROR(errno);
+
+	hpkg_header header;
+	ssize_t bytesRead = pread(fd, &header, sizeof(header), 0);
+	if (bytesRead < 0)
+		RETURN_ERROR(errno);
+	if ((size_t)bytesRead != sizeof(header))
+		RETURN_ERROR(B_BAD_DATA);
+
+	_key.nodeID = st.st_ino;
+	_key.fileSize = st.st_size;
+	_key.modifiedTime = st.st_mtim;
+	_key.headerChecksum = compute_checksum(&header, sizeof(header));
+	return B_OK;
+}
+
+
+status_t
+PackageTOCCache::Replay(const char* fileName, const Key& key,
+	BPackageContentHandler* handler)
+{
+	MutexLocker locker(fLock);
+
+	status_t error = _Load();
+	if (error != B_OK)
+		return error;
+
+	Entry* entry = fEntries->Lookup(fileName);
+	if (entry == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	if (entry->key != key) {
+		// stale -- the package file has been replaced
+		fEntries->Remove(entry);
+		delete entry;
+		fDirty = true;
+		return B_ENTRY_NOT_FOUND;
+	}
+
+	return _ReplayData(entry, handler);
+}
+
+
+void
+PackageTOCCache::AddRecord(const char* fileName, const Key& key,
+	Recorder& recorder)
+{
+	MutexLocker locker(fLock);
+
+	if (_Load() != B_OK)
+		return;
+
+	size_t dataSize;
+	uint8* data = recorder.DetachData(dataSize);
+	if (data == NULL)
+		return;
+
+	Entry* entry = new(std::nothrow) Entry;
+	if (entry == NULL) {
+		free(data);
+		return;
+	}
+
+	entry->data = data;
+	entry->dataSize = dataSize;
+	entry->ownsData = true;
+	entry->key = key;
+	entry->fileName = strdup(fileName);
+	if (entry->fileName == NULL) {
+		delete entry;
+		return;
+	}
+
+	if (Entry* oldEntry = fEntries->Lookup(fileName)) {
+		fEntries->Remove(oldEntry);
+		delete oldEntry;
+	}
+
+	fEntries->Insert(entry);
+	fDirty = true;
+}
+
+
+void
+PackageTOCCache::Update(const PackageFileNameHashTable& packages)
+{
+	MutexLocker locker(fLock);
+
+	if (!fLoaded)
+		return;
+
+	// drop the records of packages that are no longer active
+	for (EntryTable::Iterator it = fEntries->GetIterator();
+			Entry* entry = it.Next();) {
+		if (packages.Lookup(entry->fileName) == NULL) {
+			fEntries->RemoveUnchecked(entry);
+			delete entry;
+			fDirty = true;
+		}
+	}
+
+	_Flush();
+}
+
+
+/*!	Writes the cache file, if records have been added or removed, and
+	releases the memory of the records.
+*/
+void
+PackageTOCCache::Flush()
+{
+	MutexLocker locker(fLock);
+
+	if (fLoaded)
+		_Flush();
+}
+
+
+void
+PackageTOCCache::_Flush()
+{
+	if (fDirty) {
+		status_t error = _Write();
+		if (error != B_OK) {
+			INFORM("Failed to write package TOC cache: %s\n",
+				strerror(error));
+		}
+	}
+
+	_Unload();
+}
+
+
+status_t
+PackageTOCCache::_Load()
+{
+	if (fLoaded)
+		return B_OK;
+
+	if (fDirectoryFD < 0)
+		return B_NO_INIT;
+
+	fEntries = new(std::nothrow) EntryTable;
+	if (fEntries == NULL || fEntries->Init() != B_OK) {
+		delete fEntries;
+		fEntries = NULL;
+		RETURN_ERROR(B_NO_MEMORY);
+	}
+
+	fLoaded = true;
+	fDirty = false;
+
+	// A missing or broken cache file is not an error -- we just start with
+	// an empty cache and write a new one in Update().
+	int fd = openat(fDirectoryFD, kCacheFilePath, O_RDONLY);
+	if (fd < 0)
+		return B_OK;
+	FileDescriptorCloser fdCloser(fd);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(cache_file_header)
+		|| st.st_size > (off_t)kMaxCacheFileSize) {
+		fDirty = true;
+		return B_OK;
+	}
+
+	size_t fileSize = st.st_size;
+	fFileBuffer = (uint8*)malloc(fileSize);
+	if (fFileBuffer == NULL)
+		return B_OK;
+
+	ssize_t bytesRead = read(fd, fFileBuffer, fileSize);
+	const cache_file_header* header = (const cache_file_header*)fFileBuffer;
+	if (bytesRead != (ssize_t)fileSize || header->magic != kCacheFileMagic
+		|| header->version != kCacheFileVersion
+		|| header->file_size != fileSize) {
+		INFORM("Ignoring invalid package TOC cache\n");
+		free(fFileBuffer);
+		fFileBuffer = NULL;
+		fDirty = true;
+		return B_OK;
+	}
+
+	size_t offset = sizeof(cache_file_header);
+	for (uint32 i = 0; i < header->entry_count; i++) {
+		if (fileSize - offset < sizeof(cache_entry_header))
+			break;
+
+		const cache_entry_header* entryHeader
+			= (const cache_entry_header*)(fFileBuffer + offset);
+		size_t recordSize = entryHeader->record_size;
+		size_t nameLength = entryHeader->file_name_length;
+		if (recordSize > fileSize - offset || recordSize % 8 != 0
+			|| nameLength == 0
+			|| sizeof(cache_entry_header) + nameLength
+				+ entryHeader->data_size > recordSize) {
+			break;
+		}
+
+		const char* fileName
+			= (const char*)(fFileBuffer + offset + sizeof(cache_entry_header));
+		const uint8* data = (const uint8*)fileName + nameLength;
+		offset += recordSize;
+
+		if (fileName[nameLength - 1] != '\0'
+			|| compute_checksum(data, entryHeader->data_size)
+				!= entryHeader->data_checksum) {
+			fDirty = true;
+			continue;
+		}
+
+		Entry* entry = new(std::nothrow) Entry;
+		if (entry == NULL)
+			break;
+
+		entry->fileName = strdup(fileName);
+		if (entry->fileName == NULL) {
+			delete entry;
+			break;
+		}
+
+		entry->key.nodeID = entryHeader->node_id;
+		entry->key.fileSize = entryHeader->file_size;
+		entry->key.modifiedTime.tv_sec = entryHeader->modified_time;
+		entry->key.modifiedTime.tv_nsec = entryHeader->modified_time_nanos;
+		entry->key.headerChecksum = entryHeader->header_checksum;
+		entry->data = data;
+		entry->dataSize = entryHeader->data_size;
+		entry->ownsData = false;
+
+		if (Entry* oldEntry = fEntries->Lookup(fileName)) {
+			fEntries->Remove(oldEntry);
+			delete oldEntry;
+		}
+		fEntries->Insert(entry);
+	}
+
+	return B_OK;
+}
+
+
+void
+PackageTOCCache::_Unload()
+{
+	if (fEntries != NULL) {
+		Entry* entry = fEntries->Clear(true);
+		while (entry != NULL) {
+			Entry* next = entry->hashNext;
+			delete entry;
+			entry = next;
+		}
+
+		delete fEntries;
+		fEntries = NULL;
+	}
+
+	free(fFileBuffer);
+	fFileBuffer = NULL;
+
+	fLoaded = false;
+	fDirty = false;
+}
+
+
+static status_t
+write_fully(int fd, const void* buffer, size_t size)
+{
+	ssize_t bytesWritten = write(fd, buffer, size);
+	if (bytesWritten < 0)
+		return errno;
+	return (size_t)bytesWritten == size ? B_OK : B_ERROR;
+}
+
+
+status_t
+PackageTOCCache::_Write()
+{
+	// compute the file size
+	uint64 fileSize = sizeof(cache_file_header);
+	for (EntryTable::Iterator it = fEntries->GetIterator();
+			Entry* entry = it.Next();) {
+		fileSize += ROUNDUP(sizeof(cache_entry_header)
+			+ strlen(entry->fileName) + 1 + entry->dataSize, 8);
+	}
+
+	if (fileSize > kMaxCacheFileSize)
+		RETURN_ERROR(B_BUFFER_OVERFLOW);
+
+	int fd = openat(fDirectoryFD, kTemporaryCacheFilePath,
+		O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		RETURN_ERROR(errno);
+	FileDescriptorCloser fdCloser(fd);
+
+	cache_file_header header;
+	header.magic = kCacheFileMagic;
+	header.version = kCacheFileVersion;
+	header.entry_count = fEntries->CountElements();
+	header.reserved = 0;
+	header.file_size = fileSize;
+
+	status_t error = write_fully(fd, &header, sizeof(header));
+
+	for (EntryTable::Iterator it = fEntries->GetIterator();
+			error == B_OK && it.HasNext();) {
+		Entry* entry = it.Next();
+		size_t nameLength = strlen(entry->fileName) + 1;
+		size_t unpaddedSize = sizeof(cache_entry_header) + nameLength
+			+ entry->dataSize;
+
+		cache_entry_header entryHeader;
+		entryHeader.record_size = ROUNDUP(unpaddedSize, 8);
+		entryHeader.data_size = entry->dataSize;
+		entryHeader.data_checksum = compute_checksum(entry->data,
+			entry->dataSize);
+		entryHeader.file_name_length = nameLength;
+		entryHeader.reserved = 0;
+		entryHeader.node_id = entry->key.nodeID;
+		entryHeader.file_size = entry->key.fileSize;
+		entryHeader.modified_time = entry->key.modifiedTime.tv_sec;
+		entryHeader.modified_time_nanos = entry->key.modifiedTime.tv_nsec;
+		entryHeader.header_checksum = entry->key.headerChecksum;
+
+		static const uint8 kPadding[8] = {};
+		error = write_fully(fd, &entryHeader, sizeof(entryHeader));
+		if (error == B_OK)
+			error = write_fully(fd, entry->fileName, nameLength);
+		if (error == B_OK)
+			error = write_fully(fd, entry->data, entry->dataSize);
+		if (error == B_OK && entryHeader.record_size != unpaddedSize) {
+			error = write_fully(fd, kPadding,
+				entryHeader.record_size - unpaddedSize);
+		}
+	}
+
+	fdCloser.Unset();
+
+	if (error == B_OK) {
+		error = _kern_rename(fDirectoryFD, kTemporaryCacheFilePath,
+			fDirectoryFD, kCacheFilePath);
+	}
+
+	if (error != B_OK)
+		_kern_unlink(fDirectoryFD, kTemporaryCacheFilePath);
+
+	return error;
+}
+
+
+status_t
+PackageTOCCache::_ReplayData(const Entry* cacheEntry,
+	BPackageContentHandler* handler)
+{
+	Reader reader(cacheEntry->data, cacheEntry->dataSize);
+
+	BPackageEntry** entryStack = NULL;
+	size_t entryStackCapacity = 0;
+	size_t depth = 0;
+	status_t error = B_OK;
+
+	while (error == B_OK && !reader.IsAtEnd()) {
+		uint8 opcode;
+		error = reader.ReadUInt8(opcode);
+		if (error != B_OK)
+			break;
+
+		switch (opcode) {
+			case OP_PACKAGE_ATTRIBUTE:
+			{
+				uint8 id;
+				error = reader.ReadUInt8(id);
+				if (error != B_OK)
+					break;
+
+				BPackageInfoAttributeValue value;
+				value.attributeID = (BPackageInfoAttributeID)id;
+
+				switch (id) {
+					case B_PACKAGE_INFO_NAME:
+					case B_PACKAGE_INFO_INSTALL_PATH:
+						error = reader.ReadString(value.string);
+						break;
+
+					case B_PACKAGE_INFO_VERSION:
+						error = reader.ReadVersion(value.version);
+						break;
+
+					case B_PACKAGE_INFO_ARCHITECTURE:
+						error = reader.ReadUInt64(value.unsignedInt);
+						break;
+
+					case B_PACKAGE_INFO_PROVIDES:
+					{
+						uint8 haveVersion;
+						uint8 haveCompatibleVersion;
+						error = reader.ReadString(value.resolvable.name);
+						if (error == B_OK)
+							error = reader.ReadUInt8(haveVersion);
+						if (error == B_OK)
+							error = reader.ReadUInt8(haveCompatibleVersion);
+						if (error != B_OK)
+							break;
+
+						value.resolvable.haveVersion = haveVersion != 0;
+						value.resolvable.haveCompatibleVersion
+							= haveCompatibleVersion != 0;
+						if (haveVersion) {
+							error = reader.ReadVersion(
+								value.resolvable.version);
+						}
+						if (error == B_OK && haveCompatibleVersion) {
+							error = reader.ReadVersion(
+								value.resolvable.compatibleVersion);
+						}
+						break;
+					}
+
+					case B_PACKAGE_INFO_REQUIRES:
+					{
+						uint8 haveOpAndVersion;
+						error = reader.ReadString(
+							value.resolvableExpression.name);
+						if (error == B_OK)
+							error = reader.ReadUInt8(haveOpAndVersion);
+						if (error != B_OK || !haveOpAndVersion)
+							break;
+
+						uint32 op;
+						value.resolvableExpression.haveOpAndVersion = true;
+						error = reader.ReadUInt32(op);
+						if (error == B_OK) {
+							value.resolvableExpression.op
+								= (BPackageResolvableOperator)op;
+							error = reader.ReadVersion(
+								value.resolvableExpression.version);
+						}
+						break;
+					}
+
+					default:
+						error = B_BAD_DATA;
+						break;
+				}
+
+				if (error == B_OK)
+					error = handler->HandlePackageAttribute(value);
+				break;
+			}
+
+			case OP_ENTRY:
+			{
+				const char* name;
+				const char* symlinkPath;
+				uint32 mode;
+				uint64 modifiedTime;
+				uint32 modifiedTimeNanos;
+				BPackageData data;
+				error = reader.ReadString(name);
+				if (error == B_OK)
+					error = reader.ReadUInt32(mode);
+				if (error == B_OK)
+					error = reader.ReadUInt64(modifiedTime);
+				if (error == B_OK)
+					error = reader.ReadUInt32(modifiedTimeNanos);
+				if (error == B_OK)
+					error = reader.ReadData(data);
+				if (error == B_OK)
+					error = reader.ReadString(symlinkPath);
+				if (error == B_OK && name == NULL)
+					error = B_BAD_DATA;
+				if (error != B_OK)
+					break;
+
+				if (depth == entryStackCapacity) {
+					size_t capacity = entryStackCapacity == 0
+						? 16 : entryStackCapacity * 2;
+					if (capacity > kMaxEntryDepth) {
+						error = B_BAD_DATA;
+						break;
+					}
+
+					BPackageEntry** stack = (BPackageEntry**)realloc(
+						entryStack, capacity * sizeof(BPackageEntry*));
+					if (stack == NULL) {
+						error = B_NO_MEMORY;
+						break;
+					}
+					entryStack = stack;
+					entryStackCapacity = capacity;
+				}
+
+				BPackageEntry* entry = new(std::nothrow) BPackageEntry(
+					depth > 0 ? entryStack[depth - 1] : NULL, name);
+				if (entry == NULL) {
+					error = B_NO_MEMORY;
+					break;
+				}
+				entryStack[depth++] = entry;
+
+				entry->SetType(mode);
+				entry->SetPermissions(mode);
+				entry->SetModifiedTime(modifiedTime);
+				entry->SetModifiedTimeNanos(modifiedTimeNanos);
+				entry->Data() = data;
+				entry->SetSymlinkPath(symlinkPath);
+
+				error = handler->HandleEntry(entry);
+				break;
+			}
+
+			case OP_ENTRY_ATTRIBUTE:
+			{
+				const char* name;
+				uint32 type;
+				error = reader.ReadString(name);
+				if (error == B_OK)
+					error = reader.ReadUInt32(type);
+				if (error == B_OK && (name == NULL || depth == 0))
+					error = B_BAD_DATA;
+				if (error != B_OK)
+					break;
+
+				BPackageEntryAttribute attribute(name);
+				attribute.SetType(type);
+				error = reader.ReadData(attribute.Data());
+				if (error == B_OK) {
+					error = handler->HandleEntryAttribute(
+						entryStack[depth - 1], &attribute);
+				}
+				break;
+			}
+
+			case OP_ENTRY_DONE:
+			{
+				if (depth == 0) {
+					error = B_BAD_DATA;
+					break;
+				}
+
+				BPackageEntry* entry = entryStack[--depth];
+				error = handler->HandleEntryDone(entry);
+				delete entry;
+				break;
+			}
+
+			default:
+				error = B_BAD_DATA;
+				break;
+		}
+	}
+
+	if (error == B_OK && depth != 0)
+		error = B_BAD_DATA;
+
+	while (depth > 0)
+		delete entryStack[--depth];
+	free(entryStack);
+
+	if (error != B_OK)
+		handler->HandleErrorOccurred();
+
+	return error;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef PACKAGE_TOC_CACHE_H
+#define PACKAGE_TOC_CACHE_H
+
+
+#include <package/hpkg/PackageContentHandler.h>
+
+#include <lock.h>
+#include <util/OpenHashTable.h>
+
+#include "Package.h"
+
+
+using BPackageKit::BHPKG::BPackageContentHandler;
+using BPackageKit::BHPKG::BPackageEntry;
+using BPackageKit::BHPKG::BPackageEntryAttribute;
+using BPackageKit::BHPKG::BPackageInfoAttributeValue;
+
+
+/*!	Persistent cache of the parsed package attributes and TOCs of the
+	packages in a packages directory.
+
+	The cache file lives in the administrative directory and contains one
+	record per activated package. A record is a recording of the content
+	handler callbacks the package reader made when parsing the package and
+	is validated against the package file's node ID, size, modification time
+	and a checksum of its header. Replaying a record feeds the exact same
+	callbacks into the loader content handler, so package settings
+	(blacklisting) are still applied, but decompressing and parsing the TOC
+	is skipped.
+
+	The cache file is only kept in memory while packages are being loaded.
+	Update() writes the records of the currently active packages back and
+	releases the memory again.
+
+	The records are per package rather than a snapshot of the merged node
+	tree that could be mapped directly: the tree's nodes reference the
+	volume's string pool, the package objects, and the package settings,
+	all of which only exist at runtime. Replaying still avoids the
+	decompression and parsing, which is where loading spends its time.
+*/
+class PackageTOCCache {
+public:
+			struct Key {
+				ino_t			nodeID;
+				off_t			fileSize;
+				timespec		modifiedTime;
+				uint32			headerChecksum;
+
+				bool operator==(const Key& other) const;
+				bool operator!=(const Key& other) const
+					{ return !(*this == other); }
+			};
+
+			class Recorder;
+
+public:
+								PackageTOCCache();
+								~PackageTOCCache();
+
+			status_t			Init(int packagesDirectoryFD);
+			bool				IsEnabled() const
+									{ return fDirectoryFD >= 0; }
+
+	static	status_t			GetKey(int fd, Key& _key);
+
+			status_t			Replay(const char* fileName, const Key& key,
+									BPackageContentHandler* handler);
+			void				AddRecord(const char* fileName, const Key& key,
+									Recorder& recorder);
+
+			void				Update(const PackageFileNameHashTable&
+									packages);
+			void				Flush();
+
+private:
+			struct Entry;
+			struct EntryHashDefinition;
+			struct Reader;
+			struct Writer;
+
+			typedef BOpenHashTable<EntryHashDefinition> EntryTable;
+
+private:
+			status_t			_Load();
+			void				_Unload();
+			void				_Flush();
+			status_t			_Write();
+			status_t			_ReplayData(const Entry* entry,
+									BPackageContentHandler* handler);
+
+private:
+			mutex				fLock;
+			int					fDirectoryFD;
+			EntryTable*			fEntries;
+			uint8*				fFileBuffer;
+			bool				fLoaded;
+			bool				fDirty;
+};
+
+
+class PackageTOCCache::Recorder : public BPackageContentHandler {
+public:
+								Recorder(BPackageContentHandler* target);
+	virtual						~Recorder();
+
+			bool				IsValid() const;
+			uint8*				DetachData(size_t& _size);
+
+	virtual	status_t			HandleEntry(BPackageEntry* entry);
+	virtual	status_t			HandleEntryAttribute(BPackageEntry* entry,
+									BPackageEntryAttribute* attribute);
+	virtual	status_t			HandleEntryDone(BPackageEntry* entry);
+
+	virtual	status_t			HandlePackageAttribute(
+									const BPackageInfoAttributeValue& value);
+
+	virtual	void				HandleErrorOccurred();
+
+private:
+			BPackageContentHandler* fTarget;
+			Writer*				fWriter;
+			bool				fErrorOccurred;
+};
+
+
+#endif	// PACKAGE_TOC_CACHE_H
@@ -171,6 +171,7 @@ Volume::Volume(fs_volume* fsVolume)
 	fPackagesDirectories(),
 	fPackagesDirectoriesByNodeRef(),
 	fPackageSettings(),
+	fTOCCache(),
 	fNextNodeID(kRootDirectoryID + 1)
 {
 	rw_lock_init(&fLock, "packagefs volume");
@@ -369,6 +370,9 @@ Volume::Mount(const char* parameterString)
 	if (error != B_OK)
 		RETURN_ERROR(error);
 
+	// init the TOC cache -- it will be read lazily when loading packages
+	fTOCCache.Init(fPackagesDirectory->DirectoryFD());
+
 	// If a packages state has been specified, load the needed states.
 	if (packagesState != NULL) {
 		error = _LoadOldPackagesStates(packagesState);
@@ -427,6 +431,8 @@ Volume::Mount(const char* parameterString)
 	if (error != B_OK)
 		RETURN_ERROR(error);
 
+	_UpdateTOCCache();
+
 	// publish the root node
 	fRootDirectory->AcquireReference();
 	error = PublishVNode(fRootDirectory);
@@ -555,7 +561,9 @@ Volume::IOCtl(Node* node, uint32 operation, void* buffer, size_t size)
 			if (error != B_OK)
 				RETURN_ERROR(B_BAD_VALUE);
 
-			return _ChangeActivation(request);
+			error = _ChangeActivation(request);
+			_UpdateTOCCache();
+			return error;
 		}
 
 		default:
@@ -1652,6 +1660,17 @@ INFORM("package \"%s\" activated\n", package->FileName().Data());
 }
 
 
+void
+Volume::_UpdateTOCCache()
+{
+	// Records of packages loaded by a concurrent activation change are not
+	// in the table yet and will be dropped. That's harmless, they will just
+	// be parsed again the next time.
+	VolumeReadLocker volumeLocker(this);
+	fTOCCache.Update(fPackages);
+}
+
+
 status_t
 Volume::_InitMountType(const char* mountType)
 {
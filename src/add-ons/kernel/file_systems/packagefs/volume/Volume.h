@@ -23,6 +23,7 @@
 #include "PackageLinksListener.h"
 #include "PackagesDirectory.h"
 #include "PackageSettings.h"
+#include "PackageTOCCache.h"
 #include "Query.h"
 
 
@@ -67,6 +68,9 @@ public:
 			status_t			Mount(const char* parameterString);
 			void				Unmount();
 
+			PackageTOCCache&	TOCCache()
+									{ return fTOCCache; }
+
 			Node*				FindNode(ino_t nodeID) const
 									{ return fNodes.Lookup(nodeID); }
 
@@ -158,6 +162,7 @@ private:
 
 			status_t			_ChangeActivation(
 									ActivationChangeRequest& request);
+			void				_UpdateTOCCache();
 
 			status_t			_InitMountType(const char* mountType);
 			status_t			_CreateShineThroughDirectory(Directory* parent,
@@ -189,6 +194,7 @@ private:
 			PackagesDirectoryList fPackagesDirectories;
 			PackagesDirectoryHashTable fPackagesDirectoriesByNodeRef;
 			PackageSettings		fPackageSettings;
+			PackageTOCCache		fTOCCache;
 
 			struct {
 				dev_t			deviceID;
@@ -12,6 +12,11 @@
 #include <net_stack.h>
 
 #include <KernelExport.h>
+#include <condition_variable.h>
+#include <lock.h>
+#include <smp.h>
+#include <util/AutoLock.h>
+#include <util/list.h>
 
 #include <net/if.h>
 #include <net/if_types.h>
@@ -21,7 +26,22 @@
 #include <string.h>
 
 
+static const uint32 kMaxReceiveQueues = 4;
+static const uint32 kMaxQueuedBuffers = 512;
+
+
+/*!	If there is more than one CPU, the loopback device emulates a device
+	with several receive queues, among which the packets are distributed by
+	flow, like a device that supports receive side scaling (RSS) would. */
+struct loopback_queue {
+	mutex				lock;
+	ConditionVariable	condition;
+	struct list			buffers;
+	uint32				count;
+};
+
 struct loopback_device : net_device {
+	loopback_queue		queues[kMaxReceiveQueues];
 };
 
 
@@ -54,13 +74,29 @@ loopback_init(const char *name, net_device **_device)
 		goto err2;
 	}
 
-	memset(device, 0, sizeof(loopback_device));
+	memset((net_device *)device, 0, sizeof(net_device));
 
 	strcpy(device->name, name);
 	device->flags = IFF_LOOPBACK | IFF_LINK;
 	device->type = IFT_LOOP;
 	device->mtu = 16384;
 	device->media = IFM_ACTIVE;
+	device->capabilities = NET_DEVICE_RX_IP_CHECKSUM
+		| NET_DEVICE_RX_DATA_CHECKSUM | NET_DEVICE_TX_IP_CHECKSUM
+		| NET_DEVICE_TX_DATA_CHECKSUM | NET_DEVICE_TCP_SEGMENTATION;
+
+	if (smp_get_num_cpus() > 1) {
+		device->receive_queue_count = min_c((uint32)smp_get_num_cpus(),
+			kMaxReceiveQueues);
+
+		for (uint32 i = 0; i < device->receive_queue_count; i++) {
+			loopback_queue& queue = device->queues[i];
+			mutex_init(&queue.lock, "loopback receive queue");
+			queue.condition.Init(&queue, "loopback receive queue");
+			list_init(&queue.buffers);
+			queue.count = 0;
+		}
+	}
 
 	*_device = device;
 	return B_OK;
@@ -78,6 +114,9 @@ loopback_uninit(net_device *_device)
 {
 	loopback_device *device = (loopback_device *)_device;
 
+	for (uint32 i = 0; i < device->receive_queue_count; i++)
+		mutex_destroy(&device->queues[i].lock);
+
 	put_module(NET_STACK_MODULE_NAME);
 	put_module(NET_BUFFER_MODULE_NAME);
 	delete device;
@@ -94,8 +133,22 @@ loopback_up(net_device *device)
 
 
 void
-loopback_down(net_device *device)
+loopback_down(net_device *_device)
 {
+	loopback_device *device = (loopback_device *)_device;
+
+	// wake up the reader threads, and drop everything still queued
+	for (uint32 i = 0; i < device->receive_queue_count; i++) {
+		loopback_queue& queue = device->queues[i];
+		MutexLocker locker(queue.lock);
+
+		while (net_buffer *buffer
+				= (net_buffer *)list_remove_head_item(&queue.buffers))
+			gBufferModule->free(buffer);
+
+		queue.count = 0;
+		queue.condition.NotifyAll();
+	}
 }
 
 
@@ -110,7 +163,81 @@ loopback_control(net_device *device, int32 op, void *argument,
 status_t
 loopback_send_data(net_device *device, net_buffer *buffer)
 {
-	return sStackModule->device_enqueue_buffer(device, buffer);
+	// The data never leaves the machine, so there is no need to compute
+	// the checksums that were left to us, nor to verify them later.
+	if ((buffer->flags & NET_BUFFER_IP_CHECKSUM_PENDING) != 0)
+		buffer->flags |= NET_BUFFER_IP_CHECKSUM_VALID;
+	if ((buffer->flags & NET_BUFFER_DATA_CHECKSUM_PENDING) != 0)
+		buffer->flags |= NET_BUFFER_DATA_CHECKSUM_VALID;
+	buffer->flags &= ~(NET_BUFFER_IP_CHECKSUM_PENDING
+		| NET_BUFFER_DATA_CHECKSUM_PENDING);
+
+	if (device->receive_queue_count <= 1)
+		return sStackModule->device_enqueue_buffer(device, buffer);
+
+	// determine the frame type from the IP version, so that the stack can
+	// compute the flow hash
+	uint8 version;
+	if (gBufferModule->read(buffer, 0, &version, 1) != B_OK)
+		return B_BAD_DATA;
+
+	if ((version >> 4) == 4)
+		buffer->type = B_NET_FRAME_TYPE_IPV4;
+	else if ((version >> 4) == 6)
+		buffer->type = B_NET_FRAME_TYPE_IPV6;
+	else
+		buffer->type = 0;
+
+	uint32 index = sStackModule->device_flow_hash(buffer)
+		% device->receive_queue_count;
+	loopback_queue& queue = ((loopback_device *)device)->queues[index];
+
+	MutexLocker locker(queue.lock);
+
+	if ((device->flags & IFF_UP) == 0)
+		return ENETDOWN;
+	if (queue.count >= kMaxQueuedBuffers)
+		return ENOBUFS;
+
+	list_add_item(&queue.buffers, buffer);
+	queue.count++;
+	queue.condition.NotifyOne();
+
+	return B_OK;
+}
+
+
+status_t
+loopback_receive_queue_data(net_device *_device, uint32 index,
+	net_buffer **_buffer)
+{
+	loopback_device *device = (loopback_device *)_device;
+	loopback_queue& queue = device->queues[index];
+
+	MutexLocker locker(queue.lock);
+
+	while (true) {
+		if ((device->flags & IFF_UP) == 0)
+			return B_INTERRUPTED;
+
+		net_buffer *buffer = (net_buffer *)list_remove_head_item(
+			&queue.buffers);
+		if (buffer != NULL) {
+			queue.count--;
+			*_buffer = buffer;
+			return B_OK;
+		}
+
+		ConditionVariableEntry entry;
+		queue.condition.Add(&entry);
+		locker.Unlock();
+
+		status_t status = entry.Wait(B_CAN_INTERRUPT);
+		if (status != B_OK)
+			return status;
+
+		locker.Lock();
+	}
 }
 
 
@@ -185,6 +312,7 @@ net_device_module_info sLoopbackModule = {
 	loopback_set_media,
 	loopback_add_multicast,
 	loopback_remove_multicast,
+	loopback_receive_queue_data,
 };
 
 module_info *modules[] = {
@@ -17,6 +17,7 @@
 #include <net_protocol.h>
 #include <net_stack.h>
 #include <NetBufferUtilities.h>
+#include <NetUtilities.h>
 #include <ProtocolUtilities.h>
 
 #include <KernelExport.h>
@@ -27,6 +28,7 @@
 
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <netinet/tcp.h>
 #include <new>
 #include <stdlib.h>
 #include <stdio.h>
@@ -595,6 +597,33 @@ reassemble_fragments(const ipv4_header &header, net_buffer** _buffer)
 }
 
 
+/*!	Computes the TCP checksum the protocol left to the device, as the device
+	cannot do so anymore once the segment has been fragmented.
+*/
+static status_t
+finish_tcp_checksum(net_buffer* buffer)
+{
+	NetBufferHeaderReader<ipv4_header> header(buffer);
+	if (header.Status() != B_OK)
+		return header.Status();
+
+	uint16 headerLength = header->HeaderLength();
+	uint16 length = buffer->size - headerLength;
+
+	Checksum checksum;
+	checksum << (uint32)header->source << (uint32)header->destination
+		<< (uint16)htons(IPPROTO_TCP) << (uint16)htons(length)
+		<< (uint16)gBufferModule->checksum(buffer, headerLength, length,
+			false);
+
+	uint16 sum = checksum;
+	buffer->flags &= ~NET_BUFFER_DATA_CHECKSUM_PENDING;
+
+	return gBufferModule->write(buffer, headerLength
+		+ offsetof(tcphdr, th_sum), &sum, sizeof(sum));
+}
+
+
 /*!	Fragments the incoming buffer and send all fragments via the specified
 	\a route.
 */
@@ -1373,6 +1402,7 @@ ipv4_send_routed_data(net_protocol* _protocol, struct net_route* route,
 	sockaddr_in& destination = *(sockaddr_in*)buffer->destination;
 	sockaddr_in* broadcastAddress = (sockaddr_in*)interfaceAddress->destination;
 
+	uint32 capabilities = route_capabilities(route);
 	bool checksumNeeded = true;
 	bool headerIncluded = false;
 	if (protocol != NULL)
@@ -1441,9 +1471,21 @@ ipv4_send_routed_data(net_protocol* _protocol, struct net_route* route,
 	if (buffer->size > 0xffff)
 		return EMSGSIZE;
 
+	uint32 mtu = route->mtu ? route->mtu : interface->mtu;
+	bool fragment = buffer->size > mtu;
+	if (fragment && buffer->protocol == IPPROTO_TCP && !headerIncluded
+		&& (capabilities & NET_DEVICE_TCP_SEGMENTATION) != 0) {
+		// the device will split the segment into smaller ones itself
+		fragment = false;
+	}
+
 	if (checksumNeeded) {
-		*IPChecksumField(buffer) = gBufferModule->checksum(buffer, 0,
-			sizeof(ipv4_header), true);
+		if (!fragment && (capabilities & NET_DEVICE_TX_IP_CHECKSUM) != 0)
+			buffer->flags |= NET_BUFFER_IP_CHECKSUM_PENDING;
+		else {
+			*IPChecksumField(buffer) = gBufferModule->checksum(buffer, 0,
+				sizeof(ipv4_header), true);
+		}
 	}
 
 	TRACE_SK(protocol, "  SendRoutedData(): header chksum: %ld, buffer "
@@ -1454,9 +1496,14 @@ ipv4_send_routed_data(net_protocol* _protocol, struct net_route* route,
 	TRACE_SK(protocol, "  SendRoutedData(): destination: %08x",
 		ntohl(destination.sin_addr.s_addr));
 
-	uint32 mtu = route->mtu ? route->mtu : interface->mtu;
-	if (buffer->size > mtu) {
+	if (fragment) {
 		// we need to fragment the packet
+		if ((buffer->flags & NET_BUFFER_DATA_CHECKSUM_PENDING) != 0) {
+			status_t status = finish_tcp_checksum(buffer);
+			if (status != B_OK)
+				return status;
+		}
+
 		return send_fragments(protocol, route, buffer, mtu);
 	}
 
@@ -1591,7 +1638,8 @@ ipv4_receive_data(net_buffer* buffer)
 		return B_BAD_DATA;
 
 	// TODO: would be nice to have a direct checksum function somewhere
-	if (gBufferModule->checksum(buffer, 0, headerLength, true) != 0)
+	if ((buffer->flags & NET_BUFFER_IP_CHECKSUM_VALID) == 0
+		&& gBufferModule->checksum(buffer, 0, headerLength, true) != 0)
 		return B_BAD_DATA;
 
 	// lower layers notion of broadcast or multicast have no relevance to us
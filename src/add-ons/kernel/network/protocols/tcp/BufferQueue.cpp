@@ -436,6 +436,46 @@ BufferQueue::SetPushPointer()
 		fPushPointer = fList.Tail()->sequence + fList.Tail()->size;
 }
 
+/*!	Fills \a sacks with up to \a maxSackCount blocks describing the data
+	in the queue that lies beyond \a sequence, for use in a SACK option
+	(RFC 2018). Adjacent buffers are merged into a single block.
+	The blocks are reported from the highest sequence down, as the most
+	recently received segment is usually found at the end of the queue.
+	Returns the number of blocks that were filled in.
+*/
+int
+BufferQueue::PopulateSackInfo(tcp_sequence sequence, int maxSackCount,
+	tcp_sack* sacks) const
+{
+	SegmentList::ConstReverseIterator iterator = fList.GetReverseIterator();
+	int sackCount = 0;
+
+	while (net_buffer* buffer = iterator.Next()) {
+		tcp_sequence start = buffer->sequence;
+		tcp_sequence end = start + buffer->size;
+		if (end <= sequence)
+			break;
+		if (start < sequence)
+			start = sequence;
+
+		if (sackCount > 0 && sacks[sackCount - 1].left_edge == end.Number()) {
+			// this buffer directly precedes the current block
+			sacks[sackCount - 1].left_edge = start.Number();
+			continue;
+		}
+
+		if (sackCount == maxSackCount)
+			break;
+
+		sacks[sackCount].left_edge = start.Number();
+		sacks[sackCount].right_edge = end.Number();
+		sackCount++;
+	}
+
+	return sackCount;
+}
+
+
 #if DEBUG_BUFFER_QUEUE
 
 /*!	Perform a sanity check of the whole queue.
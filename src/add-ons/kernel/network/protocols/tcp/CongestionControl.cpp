@@ -0,0 +1,339 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "CongestionControl.h"
+
+#include <new>
+#include <string.h>
+
+#include <KernelExport.h>
+
+
+// References:
+//	- RFC 5681 - TCP Congestion Control
+//	- RFC 8312 - CUBIC for Fast Long-Distance Networks
+
+
+const char* const kDefaultCongestionControl = "cubic";
+
+
+/*!	Returns the integer cube root of \a value. */
+static uint32
+cube_root(uint64 value)
+{
+	uint64 root = 0;
+
+	for (int32 shift = 63; shift >= 0; shift -= 3) {
+		root <<= 1;
+		uint64 bit = 3 * root * (root + 1) + 1;
+		if ((value >> shift) >= bit) {
+			value -= bit << shift;
+			root++;
+		}
+	}
+
+	return (uint32)root;
+}
+
+
+TCPCongestionControl::TCPCongestionControl()
+	:
+	fMaxSegmentSize(0),
+	fWindow(0),
+	fSlowStartThreshold(0)
+{
+}
+
+
+TCPCongestionControl::~TCPCongestionControl()
+{
+}
+
+
+void
+TCPCongestionControl::Init(uint32 maxSegmentSize, uint32 window,
+	uint32 slowStartThreshold)
+{
+	fMaxSegmentSize = maxSegmentSize;
+	fWindow = window;
+	fSlowStartThreshold = slowStartThreshold;
+}
+
+
+/*!	Called when loss has been detected by duplicate acknowledgements or SACK
+	information, and the endpoint enters fast recovery.
+*/
+void
+TCPCongestionControl::EnterRecovery(uint32 flightSize)
+{
+	fSlowStartThreshold = max_c(flightSize / 2, 2 * fMaxSegmentSize);
+	fWindow = fSlowStartThreshold;
+}
+
+
+/*!	Called once all data outstanding at the time recovery was entered has
+	been acknowledged.
+*/
+void
+TCPCongestionControl::ExitRecovery()
+{
+	fWindow = fSlowStartThreshold;
+}
+
+
+void
+TCPCongestionControl::RetransmitTimeout(uint32 flightSize)
+{
+	fSlowStartThreshold = max_c(flightSize / 2, 2 * fMaxSegmentSize);
+	fWindow = fMaxSegmentSize;
+}
+
+
+/*!	Artificially inflates the congestion window during NewReno fast
+	recovery (RFC 6582), to account for segments that have left the network.
+*/
+void
+TCPCongestionControl::InflateWindow(uint32 bytes)
+{
+	fWindow += bytes;
+}
+
+
+void
+TCPCongestionControl::DeflateWindow(uint32 bytes)
+{
+	if (fWindow > bytes + fMaxSegmentSize)
+		fWindow -= bytes;
+	else
+		fWindow = fMaxSegmentSize;
+}
+
+
+void
+TCPCongestionControl::_SlowStart(uint32 bytes)
+{
+	fWindow += bytes < fMaxSegmentSize ? bytes : fMaxSegmentSize;
+}
+
+
+//	#pragma mark - Reno
+
+
+RenoCongestionControl::RenoCongestionControl()
+{
+}
+
+
+const char*
+RenoCongestionControl::Name() const
+{
+	return "reno";
+}
+
+
+void
+RenoCongestionControl::Acknowledged(uint32 bytes, uint32 flightSize,
+	bigtime_t roundTripTime)
+{
+	if (InSlowStart()) {
+		_SlowStart(bytes);
+		return;
+	}
+
+	uint32 increment = fMaxSegmentSize * fMaxSegmentSize;
+	if (increment < fWindow)
+		increment = 1;
+	else
+		increment /= fWindow;
+
+	fWindow += increment;
+}
+
+
+//	#pragma mark - CUBIC
+
+
+// All window computations are done in bytes, the times in milliseconds.
+// C is 0.4, and the multiplicative decrease factor (beta) is 0.7.
+
+static const bigtime_t kMaxCubicTime = 1 << 19;
+	// ~9 minutes, keeps the cube from overflowing
+
+
+CubicCongestionControl::CubicCongestionControl()
+{
+	Init(0, 0, 0);
+}
+
+
+const char*
+CubicCongestionControl::Name() const
+{
+	return "cubic";
+}
+
+
+void
+CubicCongestionControl::Init(uint32 maxSegmentSize, uint32 window,
+	uint32 slowStartThreshold)
+{
+	TCPCongestionControl::Init(maxSegmentSize, window, slowStartThreshold);
+
+	fMaxWindow = 0;
+	fLastMaxWindow = 0;
+	fOriginPoint = 0;
+	fEpochStart = 0;
+	fTimeToOrigin = 0;
+	fIncrement = 0;
+}
+
+
+void
+CubicCongestionControl::Acknowledged(uint32 bytes, uint32 flightSize,
+	bigtime_t roundTripTime)
+{
+	if (InSlowStart()) {
+		_SlowStart(bytes);
+		return;
+	}
+
+	bigtime_t now = system_time();
+	if (fEpochStart == 0) {
+		// start a new congestion avoidance epoch
+		fEpochStart = now;
+		fIncrement = 0;
+
+		if (fWindow < fMaxWindow) {
+			// K = cubic_root((W_max - cwnd) / C), in segments and seconds
+			fTimeToOrigin = cube_root((uint64)(fMaxWindow - fWindow)
+				* 2500000000ULL / fMaxSegmentSize);
+			fOriginPoint = fMaxWindow;
+		} else {
+			fTimeToOrigin = 0;
+			fOriginPoint = fWindow;
+		}
+	}
+
+	bigtime_t elapsed = (now - fEpochStart) / 1000;
+	bigtime_t rtt = max_c(roundTripTime / 1000, 1);
+
+	// The window should reach W_cubic(t + RTT) within the next round trip,
+	// but should never be smaller than what standard TCP would achieve.
+	uint32 target = _CubicWindow(elapsed + rtt);
+	uint32 friendly = _FriendlyWindow(elapsed, rtt);
+	if (target < friendly)
+		target = friendly;
+
+	// do not grow faster than 50% per round trip
+	if (target > fWindow + fWindow / 2)
+		target = fWindow + fWindow / 2;
+
+	if (target > fWindow)
+		fIncrement += (uint64)(target - fWindow) * bytes;
+	else
+		fIncrement += (uint64)fMaxSegmentSize * bytes / 100;
+
+	if (fIncrement >= fWindow) {
+		uint32 window = fWindow;
+		fWindow += fIncrement / window;
+		fIncrement %= window;
+	}
+}
+
+
+void
+CubicCongestionControl::EnterRecovery(uint32 flightSize)
+{
+	_Reduce();
+	fWindow = fSlowStartThreshold;
+}
+
+
+void
+CubicCongestionControl::RetransmitTimeout(uint32 flightSize)
+{
+	_Reduce();
+	fWindow = fMaxSegmentSize;
+}
+
+
+void
+CubicCongestionControl::_Reduce()
+{
+	fEpochStart = 0;
+
+	if (fWindow < fLastMaxWindow) {
+		// fast convergence: release bandwidth for new flows
+		fLastMaxWindow = fWindow;
+		fMaxWindow = (uint32)((uint64)fWindow * 17 / 20);
+	} else {
+		fLastMaxWindow = fWindow;
+		fMaxWindow = fWindow;
+	}
+
+	fSlowStartThreshold = max_c((uint32)((uint64)fWindow * 7 / 10),
+		2 * fMaxSegmentSize);
+}
+
+
+/*!	Returns W_cubic(t) = C * (t - K)^3 + W_max, for \a time in
+	milliseconds since the start of the epoch.
+*/
+uint32
+CubicCongestionControl::_CubicWindow(bigtime_t time) const
+{
+	int64 offset = time - fTimeToOrigin;
+	if (offset > kMaxCubicTime)
+		offset = kMaxCubicTime;
+	else if (offset < -kMaxCubicTime)
+		offset = -kMaxCubicTime;
+
+	// 0.4 * (offset / 1000)^3 segments, in units of 1/1024 segments
+	int64 delta = 4 * offset * offset * offset / 9765625;
+	int64 window = fOriginPoint + delta * fMaxSegmentSize / 1024;
+
+	if (window < (int64)fMaxSegmentSize)
+		return fMaxSegmentSize;
+	if (window > (int64)0x7fffffff)
+		return 0x7fffffff;
+
+	return (uint32)window;
+}
+
+
+/*!	Returns the window standard TCP would have reached after \a time
+	milliseconds, W_est(t) = W_max * beta + 3 * (1 - beta) / (1 + beta) * t/RTT.
+*/
+uint32
+CubicCongestionControl::_FriendlyWindow(bigtime_t time,
+	bigtime_t roundTripTime) const
+{
+	uint64 window = (uint64)fMaxWindow * 7 / 10
+		+ (uint64)fMaxSegmentSize * 529 * time / (1000 * roundTripTime);
+
+	if (window > 0x7fffffff)
+		return 0x7fffffff;
+
+	return (uint32)window;
+}
+
+
+//	#pragma mark -
+
+
+/*!	Creates the congestion control algorithm with the specified \a name, or
+	returns \c NULL if there is no such algorithm, or not enough memory.
+*/
+TCPCongestionControl*
+create_congestion_control(const char* name)
+{
+	if (strcmp(name, "cubic") == 0)
+		return new(std::nothrow) CubicCongestionControl;
+	if (strcmp(name, "reno") == 0 || strcmp(name, "newreno") == 0)
+		return new(std::nothrow) RenoCongestionControl;
+
+	return NULL;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef CONGESTION_CONTROL_H
+#define CONGESTION_CONTROL_H
+
+
+#include <OS.h>
+
+
+/*!	Base class for the congestion control algorithms of a TCP endpoint.
+	The endpoint reports acknowledged data and congestion events, and the
+	algorithm maintains the congestion window and slow start threshold
+	(all in bytes) accordingly.
+	Loss detection and recovery itself (fast retransmit, SACK) is handled by
+	the endpoint.
+*/
+class TCPCongestionControl {
+public:
+								TCPCongestionControl();
+	virtual						~TCPCongestionControl();
+
+	virtual	const char*			Name() const = 0;
+
+	virtual	void				Init(uint32 maxSegmentSize, uint32 window,
+									uint32 slowStartThreshold);
+			void				SetMaxSegmentSize(uint32 maxSegmentSize)
+									{ fMaxSegmentSize = maxSegmentSize; }
+
+	virtual	void				Acknowledged(uint32 bytes, uint32 flightSize,
+									bigtime_t roundTripTime) = 0;
+	virtual	void				EnterRecovery(uint32 flightSize);
+	virtual	void				ExitRecovery();
+	virtual	void				RetransmitTimeout(uint32 flightSize);
+
+			void				InflateWindow(uint32 bytes);
+			void				DeflateWindow(uint32 bytes);
+
+			uint32				Window() const { return fWindow; }
+			uint32				SlowStartThreshold() const
+									{ return fSlowStartThreshold; }
+			bool				InSlowStart() const
+									{ return fWindow < fSlowStartThreshold; }
+
+protected:
+			void				_SlowStart(uint32 bytes);
+
+protected:
+			uint32				fMaxSegmentSize;
+			uint32				fWindow;
+			uint32				fSlowStartThreshold;
+};
+
+
+/*!	The classic AIMD algorithm of RFC 5681 */
+class RenoCongestionControl : public TCPCongestionControl {
+public:
+								RenoCongestionControl();
+
+	virtual	const char*			Name() const;
+
+	virtual	void				Acknowledged(uint32 bytes, uint32 flightSize,
+									bigtime_t roundTripTime);
+};
+
+
+/*!	CUBIC as described in RFC 8312 */
+class CubicCongestionControl : public TCPCongestionControl {
+public:
+								CubicCongestionControl();
+
+	virtual	const char*			Name() const;
+
+	virtual	void				Init(uint32 maxSegmentSize, uint32 window,
+									uint32 slowStartThreshold);
+
+	virtual	void				Acknowledged(uint32 bytes, uint32 flightSize,
+									bigtime_t roundTripTime);
+	virtual	void				EnterRecovery(uint32 flightSize);
+	virtual	void				RetransmitTimeout(uint32 flightSize);
+
+private:
+			void				_Reduce();
+			uint32				_CubicWindow(bigtime_t time) const;
+			uint32				_FriendlyWindow(bigtime_t time,
+									bigtime_t roundTripTime) const;
+
+private:
+			uint32				fMaxWindow;
+			uint32				fLastMaxWindow;
+			uint32				fOriginPoint;
+			bigtime_t			fEpochStart;
+			bigtime_t			fTimeToOrigin;
+			uint64				fIncrement;
+};
+
+
+TCPCongestionControl* create_congestion_control(const char* name);
+
+extern const char* const kDefaultCongestionControl;
+
+
+#endif	// CONGESTION_CONTROL_H
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "SackScoreboard.h"
+
+#include <KernelExport.h>
+
+
+// RFC 6675 - the number of duplicate acknowledgements, or the number of
+// segments SACKed above a sequence, that indicates the sequence was lost
+static const int32 kDuplicateThreshold = 3;
+
+
+SackScoreboard::SackScoreboard()
+{
+	Reset();
+}
+
+
+void
+SackScoreboard::Reset()
+{
+	fCount = 0;
+	fSackedBytes = 0;
+}
+
+
+/*!	Adds the SACK block [\a left, \a right) to the scoreboard, merging it
+	with any blocks it overlaps or touches.
+	If the scoreboard is full, the highest block is forgotten. This is
+	harmless, as it can only cause data to be retransmitted needlessly.
+*/
+void
+SackScoreboard::Add(tcp_sequence left, tcp_sequence right)
+{
+	if (left >= right)
+		return;
+
+	int32 index = 0;
+	while (index < fCount && fBlocks[index].right < left)
+		index++;
+
+	while (index < fCount && fBlocks[index].left <= right) {
+		if (fBlocks[index].left < left)
+			left = fBlocks[index].left;
+		if (fBlocks[index].right > right)
+			right = fBlocks[index].right;
+
+		_Remove(index);
+	}
+
+	if (fCount == TCP_SACK_SCOREBOARD_SIZE) {
+		if (index == fCount)
+			return;
+
+		_Remove(fCount - 1);
+	}
+
+	for (int32 i = fCount; i > index; i--)
+		fBlocks[i] = fBlocks[i - 1];
+
+	fBlocks[index].left = left;
+	fBlocks[index].right = right;
+	fCount++;
+
+	fSackedBytes += (right - left).Number();
+}
+
+
+/*!	Forgets about everything below \a sequence, ie. data that has been
+	cumulatively acknowledged.
+*/
+void
+SackScoreboard::RemoveUntil(tcp_sequence sequence)
+{
+	while (fCount > 0 && fBlocks[0].right <= sequence)
+		_Remove(0);
+
+	if (fCount > 0 && fBlocks[0].left < sequence) {
+		fSackedBytes -= (sequence - fBlocks[0].left).Number();
+		fBlocks[0].left = sequence;
+	}
+}
+
+
+uint32
+SackScoreboard::SackedBytesAbove(tcp_sequence sequence) const
+{
+	uint32 bytes = 0;
+
+	for (int32 i = fCount - 1; i >= 0; i--) {
+		if (fBlocks[i].right <= sequence)
+			break;
+
+		if (fBlocks[i].left > sequence)
+			bytes += (fBlocks[i].right - fBlocks[i].left).Number();
+		else
+			bytes += (fBlocks[i].right - sequence).Number() - 1;
+	}
+
+	return bytes;
+}
+
+
+tcp_sequence
+SackScoreboard::HighestSacked() const
+{
+	if (fCount == 0)
+		return 0;
+
+	return fBlocks[fCount - 1].right;
+}
+
+
+bool
+SackScoreboard::IsSacked(tcp_sequence sequence) const
+{
+	for (int32 i = 0; i < fCount; i++) {
+		if (fBlocks[i].left > sequence)
+			break;
+		if (fBlocks[i].right > sequence)
+			return true;
+	}
+
+	return false;
+}
+
+
+/*!	Implements IsLost() of RFC 6675: \a sequence is considered lost when
+	DupThresh segments have been SACKed above it.
+	The scoreboard does not know where the segments start and end, so every
+	block is counted as the number of full sized segments it would take to
+	send it. This also covers the second condition of the RFC, more than
+	(DupThresh - 1) * SMSS bytes SACKed above \a sequence.
+*/
+bool
+SackScoreboard::IsLost(tcp_sequence sequence, uint32 maxSegmentSize) const
+{
+	if (maxSegmentSize == 0)
+		maxSegmentSize = 1;
+
+	int32 segmentsAbove = 0;
+	for (int32 i = fCount - 1; i >= 0; i--) {
+		if (fBlocks[i].right <= sequence + 1)
+			break;
+
+		uint32 bytes;
+		if (fBlocks[i].left > sequence)
+			bytes = (fBlocks[i].right - fBlocks[i].left).Number();
+		else
+			bytes = (fBlocks[i].right - sequence).Number() - 1;
+
+		segmentsAbove += (bytes + maxSegmentSize - 1) / maxSegmentSize;
+		if (segmentsAbove >= kDuplicateThreshold)
+			return true;
+	}
+
+	return false;
+}
+
+
+/*!	Returns the first range of data starting at or after \a from that has
+	not been SACKed, but lies below the highest SACKed sequence.
+*/
+bool
+SackScoreboard::NextHole(tcp_sequence from, tcp_sequence& _start,
+	tcp_sequence& _end) const
+{
+	tcp_sequence start = from;
+
+	for (int32 i = 0; i < fCount; i++) {
+		if (fBlocks[i].right <= start)
+			continue;
+
+		if (fBlocks[i].left <= start) {
+			start = fBlocks[i].right;
+			continue;
+		}
+
+		_start = start;
+		_end = fBlocks[i].left;
+		return true;
+	}
+
+	return false;
+}
+
+
+void
+SackScoreboard::Dump() const
+{
+	kprintf("    sacked bytes: %" B_PRIu32 "\n", fSackedBytes);
+	for (int32 i = 0; i < fCount; i++) {
+		kprintf("      %" B_PRId32 ". %" B_PRIu32 " - %" B_PRIu32 "\n", i,
+			fBlocks[i].left.Number(), fBlocks[i].right.Number());
+	}
+}
+
+
+void
+SackScoreboard::_Remove(int32 index)
+{
+	fSackedBytes -= (fBlocks[index].right - fBlocks[index].left).Number();
+
+	fCount--;
+	for (int32 i = index; i < fCount; i++)
+		fBlocks[i] = fBlocks[i + 1];
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SACK_SCOREBOARD_H
+#define SACK_SCOREBOARD_H
+
+
+#include "tcp.h"
+
+
+#define TCP_SACK_SCOREBOARD_SIZE	16
+
+
+/*!	Keeps track of the sequence ranges the peer has selectively acknowledged
+	(RFC 2018), and implements the loss detection of RFC 6675 on top of it.
+	The blocks are kept sorted and never overlap.
+*/
+class SackScoreboard {
+public:
+								SackScoreboard();
+
+			void				Reset();
+			bool				IsEmpty() const { return fCount == 0; }
+
+			void				Add(tcp_sequence left, tcp_sequence right);
+			void				RemoveUntil(tcp_sequence sequence);
+
+			uint32				SackedBytes() const { return fSackedBytes; }
+			uint32				SackedBytesAbove(tcp_sequence sequence) const;
+			tcp_sequence		HighestSacked() const;
+
+			bool				IsSacked(tcp_sequence sequence) const;
+			bool				IsLost(tcp_sequence sequence,
+									uint32 maxSegmentSize) const;
+			bool				NextHole(tcp_sequence from,
+									tcp_sequence& _start,
+									tcp_sequence& _end) const;
+
+			void				Dump() const;
+
+private:
+			struct block {
+				tcp_sequence	left;
+				tcp_sequence	right;
+			};
+
+			void				_Remove(int32 index);
+
+private:
+			block				fBlocks[TCP_SACK_SCOREBOARD_SIZE];
+			int32				fCount;
+			uint32				fSackedBytes;
+};
+
+
+#endif	// SACK_SCOREBOARD_H
@@ -40,15 +40,18 @@
 //  - RFC 793 - Transmission Control Protocol
 //  - RFC 813 - Window and Acknowledgement Strategy in TCP
 //	- RFC 1337 - TIME_WAIT Assassination Hazards in TCP
+//	- RFC 2018 - TCP Selective Acknowledgment Options
+//	- RFC 5681 - TCP Congestion Control
+//	- RFC 6298 - Computing TCP's Retransmission Timer
+//	- RFC 6582 - The NewReno Modification to TCP's Fast Recovery Algorithm
+//	- RFC 6675 - A Conservative Loss Recovery Algorithm Based on SACK
 //
 // Things this implementation currently doesn't implement:
-//	- TCP Slow Start, Congestion Avoidance, Fast Retransmit, and Fast Recovery,
-//	  RFC 2001, RFC 2581, RFC 3042
-//	- NewReno Modification to TCP's Fast Recovery, RFC 2582
+//	- Limited Transmit, RFC 3042
 //	- Explicit Congestion Notification (ECN), RFC 3168
 //	- SYN-Cache
 //	- TCP Extensions for High Performance, RFC 1323
-//	- SACK, Selective Acknowledgment - RFC 2018, RFC 2883, RFC 3517
+//	- D-SACK, RFC 2883
 //	- Forward RTO-Recovery, RFC 4138
 //	- Time-Wait hash instead of keeping sockets alive
 
@@ -72,7 +75,8 @@
 	dprintf("TCP PROBE %llu %s %s %ld snxt %lu suna %lu cw %lu sst %lu win %lu swin %lu smax-suna %lu savail %lu sqused %lu rto %llu\n", \
 		system_time(), PrintAddress(buffer->source), \
 		PrintAddress(buffer->destination), buffer->size, fSendNext.Number(), \
-		fSendUnacknowledged.Number(), fCongestionWindow, fSlowStartThreshold, \
+		fSendUnacknowledged.Number(), fCongestionControl->Window(), \
+		fCongestionControl->SlowStartThreshold(), \
 		window, fSendWindow, (fSendMax - fSendUnacknowledged).Number(), \
 		fSendQueue.Available(fSendNext), fSendQueue.Used(), fRetransmitTimeout)
 #else
@@ -264,12 +268,18 @@ enum {
 	FLAG_NO_RECEIVE				= 0x04,
 	FLAG_CLOSED					= 0x08,
 	FLAG_DELETE_ON_CLOSE		= 0x10,
-	FLAG_LOCAL					= 0x20
+	FLAG_LOCAL					= 0x20,
+	FLAG_OPTION_SACK_PERMITTED	= 0x40,
+	FLAG_RECOVERY				= 0x80
 };
 
 
 static const int kTimestampFactor = 1024;
 
+// The largest segment passed to a device that supports segmentation offload;
+// leaves room for the IP and TCP headers.
+static const uint32 kMaxSegmentationSize = 65535 - 2 * 60;
+
 
 static inline bigtime_t
 absolute_timeout(bigtime_t timeout)
@@ -434,6 +444,8 @@ TCPEndpoint::TCPEndpoint(net_socket* socket)
 	fSendQueue(socket->send.buffer_size),
 	fInitialSendSequence(0),
 	fDuplicateAcknowledgeCount(0),
+	fRecover(0),
+	fRetransmitHigh(0),
 	fRoute(NULL),
 	fReceiveNext(0),
 	fReceiveMaxAdvertised(0),
@@ -444,10 +456,10 @@ TCPEndpoint::TCPEndpoint(net_socket* socket)
 	fRoundTripDeviation(TCP_INITIAL_RTT / kTimestampFactor),
 	fRetransmitTimeout(TCP_INITIAL_RTT),
 	fReceivedTimestamp(0),
-	fCongestionWindow(0),
-	fSlowStartThreshold(0),
+	fCongestionControl(create_congestion_control(kDefaultCongestionControl)),
 	fState(CLOSED),
-	fFlags(FLAG_OPTION_WINDOW_SCALE | FLAG_OPTION_TIMESTAMP)
+	fFlags(FLAG_OPTION_WINDOW_SCALE | FLAG_OPTION_TIMESTAMP
+		| FLAG_OPTION_SACK_PERMITTED)
 {
 	// TODO: to be replaced with a real read/write locking strategy!
 	mutex_init(&fLock, "tcp lock");
@@ -469,6 +481,8 @@ TCPEndpoint::~TCPEndpoint()
 	_CancelConnectionTimers();
 	gStackModule->cancel_timer(&fTimeWaitTimer);
 
+	delete fCongestionControl;
+
 	if (fManager != NULL) {
 		fManager->Unbind(this);
 		put_endpoint_manager(fManager);
@@ -495,6 +509,9 @@ TCPEndpoint::InitCheck() const
 	if (fSendList.InitCheck() < B_OK)
 		return fSendList.InitCheck();
 
+	if (fCongestionControl == NULL)
+		return B_NO_MEMORY;
+
 	return B_OK;
 }
 
@@ -1028,6 +1045,19 @@ TCPEndpoint::SetReceiveBufferSize(size_t length)
 status_t
 TCPEndpoint::GetOption(int option, void* _value, int* _length)
 {
+	if (option == TCP_CONGESTION) {
+		MutexLocker _(fLock);
+
+		const char* name = fCongestionControl->Name();
+		int length = strlen(name) + 1;
+		if (*_length < length)
+			return B_BAD_VALUE;
+
+		strlcpy((char*)_value, name, length);
+		*_length = length;
+		return B_OK;
+	}
+
 	if (*_length != sizeof(int))
 		return B_BAD_VALUE;
 
@@ -1054,6 +1084,31 @@ TCPEndpoint::GetOption(int option, void* _value, int* _length)
 status_t
 TCPEndpoint::SetOption(int option, const void* _value, int length)
 {
+	if (option == TCP_CONGESTION) {
+		if (length <= 0)
+			return B_BAD_VALUE;
+
+		char name[TCP_CA_NAME_MAX];
+		size_t nameLength = min_c((size_t)length, sizeof(name) - 1);
+		memcpy(name, _value, nameLength);
+		name[nameLength] = '\0';
+
+		TCPCongestionControl* congestionControl
+			= create_congestion_control(name);
+		if (congestionControl == NULL)
+			return ENOENT;
+
+		// the new algorithm continues where the previous one left off
+		MutexLocker _(fLock);
+		congestionControl->Init(fSendMaxSegmentSize,
+			fCongestionControl->Window(),
+			fCongestionControl->SlowStartThreshold());
+
+		delete fCongestionControl;
+		fCongestionControl = congestionControl;
+		return B_OK;
+	}
+
 	if (option != TCP_NODELAY)
 		return B_BAD_VALUE;
 
@@ -1251,16 +1306,143 @@ TCPEndpoint::_HandleReset(status_t error)
 void
 TCPEndpoint::_DuplicateAcknowledge(tcp_segment_header &segment)
 {
-	if (++fDuplicateAcknowledgeCount < 3)
+	fDuplicateAcknowledgeCount++;
+
+	if ((fFlags & FLAG_RECOVERY) != 0) {
+		if (_UseSack()) {
+			_SendSackRecovery();
+			return;
+		}
+
+		// every further duplicate acknowledgement means another segment has
+		// left the network
+		fCongestionControl->InflateWindow(fSendMaxSegmentSize);
+		_SendQueued();
+		return;
+	}
+
+	if (fDuplicateAcknowledgeCount < 3
+		&& (!_UseSack() || !fSackScoreboard.IsLost(fSendUnacknowledged,
+				fSendMaxSegmentSize)))
+		return;
+
+	// Do not enter fast recovery again for losses of data that was sent
+	// before the previous recovery or timeout (RFC 6582, section 3.2)
+	if (fSendUnacknowledged < fRecover)
 		return;
 
-	if (fDuplicateAcknowledgeCount == 3) {
-		_ResetSlowStart();
-		fCongestionWindow = fSlowStartThreshold + 3
-			* fSendMaxSegmentSize;
-		fSendNext = segment.acknowledge;
-	} else if (fDuplicateAcknowledgeCount > 3)
-		fCongestionWindow += fSendMaxSegmentSize;
+	TRACE("DuplicateAcknowledge(): entering fast recovery");
+
+	fFlags |= FLAG_RECOVERY;
+	fRecover = fSendMax;
+	fCongestionControl->EnterRecovery(
+		(fSendMax - fSendUnacknowledged).Number());
+
+	if (_UseSack()) {
+		// the first unacknowledged segment is always retransmitted, no
+		// matter what the scoreboard says (RFC 6675, section 5)
+		ssize_t bytesSent = _SendRetransmission(fSendUnacknowledged,
+			fSendMaxSegmentSize);
+		fRetransmitHigh = fSendUnacknowledged + max_c(bytesSent, 0);
+		_SendSackRecovery();
+		return;
+	}
+
+	// NewReno: retransmit the first unacknowledged segment, and account for
+	// the three segments that caused the duplicate acknowledgements
+	fCongestionControl->InflateWindow(3 * fSendMaxSegmentSize);
+	_SendRetransmission(fSendUnacknowledged, fSendMaxSegmentSize);
+	_SendQueued();
+}
+
+
+bool
+TCPEndpoint::_UseSack() const
+{
+	return (fFlags & FLAG_OPTION_SACK_PERMITTED) != 0
+		&& (fOptions & TCP_NOOPT) == 0;
+}
+
+
+void
+TCPEndpoint::_UpdateSackScoreboard(tcp_segment_header& segment)
+{
+	for (int i = 0; i < segment.sack_count; i++) {
+		tcp_sequence left = segment.sacks[i].left_edge;
+		tcp_sequence right = segment.sacks[i].right_edge;
+
+		// ignore blocks that are bogus, or already acknowledged
+		if (left >= right || right <= fSendUnacknowledged
+			|| right > fSendMax)
+			continue;
+		if (left < fSendUnacknowledged)
+			left = fSendUnacknowledged;
+
+		fSackScoreboard.Add(left, right);
+	}
+}
+
+
+/*!	Returns an estimate of the number of bytes that are still in flight,
+	as defined by SetPipe() in RFC 6675: data that is neither SACKed nor
+	considered lost, plus the lost data that has been retransmitted.
+*/
+uint32
+TCPEndpoint::_Pipe() const
+{
+	if (fSackScoreboard.IsEmpty())
+		return (fSendMax - fSendUnacknowledged).Number();
+
+	uint32 pipe = 0;
+	tcp_sequence highestSacked = fSackScoreboard.HighestSacked();
+	if (fSendMax > highestSacked)
+		pipe = (fSendMax - highestSacked).Number();
+
+	tcp_sequence from = fSendUnacknowledged;
+	tcp_sequence start;
+	tcp_sequence end;
+	while (fSackScoreboard.NextHole(from, start, end)) {
+		if (!fSackScoreboard.IsLost(start, fSendMaxSegmentSize))
+			pipe += (end - start).Number();
+		else if (fRetransmitHigh > start) {
+			pipe += ((fRetransmitHigh < end ? fRetransmitHigh : end)
+				- start).Number();
+		}
+
+		from = end;
+	}
+
+	return pipe;
+}
+
+
+/*!	Retransmits the holes in the scoreboard that are considered lost, as long
+	as the congestion window allows (NextSeg() of RFC 6675), and then
+	continues with new data.
+*/
+void
+TCPEndpoint::_SendSackRecovery()
+{
+	uint32 window = fCongestionControl->Window();
+	uint32 pipe = _Pipe();
+
+	while (pipe + fSendMaxSegmentSize <= window) {
+		tcp_sequence from = fRetransmitHigh > fSendUnacknowledged
+			? fRetransmitHigh : fSendUnacknowledged;
+		tcp_sequence start;
+		tcp_sequence end;
+		if (!fSackScoreboard.NextHole(from, start, end)
+			|| !fSackScoreboard.IsLost(start, fSendMaxSegmentSize))
+			break;
+
+		ssize_t bytesSent = _SendRetransmission(start,
+			(end - start).Number());
+		if (bytesSent <= 0)
+			break;
+
+		fRetransmitHigh = start + bytesSent;
+		pipe += bytesSent;
+	}
 
 	_SendQueued();
 }
@@ -1367,10 +1549,14 @@ TCPEndpoint::_PrepareReceivePath(tcp_segment_header& segment)
 			fReceivedTimestamp = segment.timestamp_value;
 		} else
 			fFlags &= ~FLAG_OPTION_TIMESTAMP;
+
+		if ((segment.options & TCP_SACK_PERMITTED) == 0)
+			fFlags &= ~FLAG_OPTION_SACK_PERMITTED;
 	}
 
-	fCongestionWindow = 2 * fSendMaxSegmentSize;
-	fSlowStartThreshold = (uint32)segment.advertised_window << fSendWindowShift;
+	fCongestionControl->Init(fSendMaxSegmentSize, 2 * fSendMaxSegmentSize,
+		(uint32)segment.advertised_window << fSendWindowShift);
+	fSackScoreboard.Reset();
 }
 
 
@@ -1417,6 +1603,17 @@ TCPEndpoint::_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
 	fOptions = parent->fOptions;
 	fAcceptSemaphore = parent->fAcceptSemaphore;
 
+	if (strcmp(fCongestionControl->Name(),
+			parent->fCongestionControl->Name()) != 0) {
+		// inherit the congestion control algorithm of the listening socket
+		TCPCongestionControl* congestionControl
+			= create_congestion_control(parent->fCongestionControl->Name());
+		if (congestionControl != NULL) {
+			delete fCongestionControl;
+			fCongestionControl = congestionControl;
+		}
+	}
+
 	_PrepareReceivePath(segment);
 
 	// send SYN+ACK
@@ -1512,7 +1709,8 @@ TCPEndpoint::_Receive(tcp_segment_header& segment, net_buffer* buffer)
 		&& segment.AcknowledgeOnly()
 		&& fReceiveNext == segment.sequence
 		&& advertisedWindow > 0 && advertisedWindow == fSendWindow
-		&& fSendNext == fSendMax) {
+		&& fSendNext == fSendMax
+		&& segment.sack_count == 0) {
 		_UpdateTimestamps(segment, segmentLength);
 
 		if (segmentLength == 0) {
@@ -1639,6 +1837,8 @@ TCPEndpoint::_Receive(tcp_segment_header& segment, net_buffer* buffer)
 	}
 #endif
 
+	bool windowUpdate = advertisedWindow != fSendWindow;
+
 	fSendWindow = advertisedWindow;
 	if (advertisedWindow > fSendMaxWindow)
 		fSendMaxWindow = advertisedWindow;
@@ -1653,25 +1853,28 @@ TCPEndpoint::_Receive(tcp_segment_header& segment, net_buffer* buffer)
 		if (fSendMax < segment.acknowledge)
 			return DROP | IMMEDIATE_ACKNOWLEDGE;
 
-		if (segment.acknowledge < fSendUnacknowledged) {
-			if (buffer->size == 0 && advertisedWindow == fSendWindow
-				&& (segment.flags & TCP_FLAG_FINISH) == 0) {
+		if (segment.sack_count > 0 && _UseSack())
+			_UpdateSackScoreboard(segment);
+
+		if (segment.acknowledge < fSendUnacknowledged)
+			return DROP;
+
+		if (segment.acknowledge == fSendUnacknowledged) {
+			if (buffer->size == 0 && !windowUpdate
+				&& (segment.flags & TCP_FLAG_FINISH) == 0
+				&& fSendUnacknowledged != fSendMax) {
 				TRACE("Receive(): duplicate ack!");
 
 				_DuplicateAcknowledge(segment);
+				return DROP;
 			}
 
-			return DROP;
+			// the window might have opened up
+			if (fSendQueue.Used() > 0)
+				_SendQueued();
 		} else {
 			// this segment acknowledges in flight data
 
-			if (fDuplicateAcknowledgeCount >= 3) {
-				// deflate the window.
-				fCongestionWindow = fSlowStartThreshold;
-			}
-
-			fDuplicateAcknowledgeCount = 0;
-
 			if (fSendMax == segment.acknowledge)
 				TRACE("Receive(): all inflight data ack'd!");
 
@@ -1719,9 +1922,19 @@ TCPEndpoint::_Receive(tcp_segment_header& segment, net_buffer* buffer)
 	uint32 bufferSize = buffer->size;
 
 	if ((bufferSize > 0 || (segment.flags & TCP_FLAG_FINISH) != 0)
-		&& _ShouldReceive())
+		&& _ShouldReceive()) {
+		bool wasContiguous = fReceiveQueue.IsContiguous()
+			&& segment.sequence == fReceiveNext;
+
 		notify = _AddData(segment, buffer);
-	else {
+
+		if (!wasContiguous || !fReceiveQueue.IsContiguous()) {
+			// Out of order data, or data that fills a hole, is acknowledged
+			// immediately, so that the peer can recover quickly (RFC 5681,
+			// section 4.2)
+			action |= IMMEDIATE_ACKNOWLEDGE;
+		}
+	} else {
 		if ((fFlags & FLAG_NO_RECEIVE) != 0)
 			fReceiveNext += buffer->size;
 
@@ -1870,6 +2083,51 @@ TCPEndpoint::_CurrentFlags()
 }
 
 
+/*!	Fills in the options, the advertised window, and the acknowledgement of
+	a segment that is about to be sent. If there is out of order data in the
+	receive queue, \a sacks is used to report it to the peer.
+*/
+void
+TCPEndpoint::_PrepareSegment(tcp_segment_header& segment, tcp_sack* sacks)
+{
+	if ((fOptions & TCP_NOOPT) == 0) {
+		if ((fFlags & FLAG_OPTION_TIMESTAMP) != 0) {
+			segment.options |= TCP_HAS_TIMESTAMPS;
+			segment.timestamp_reply = fReceivedTimestamp;
+			segment.timestamp_value = tcp_now();
+		}
+
+		if ((segment.flags & TCP_FLAG_SYNCHRONIZE) != 0
+			&& fSendNext == fInitialSendSequence) {
+			// add connection establishment options
+			segment.max_segment_size = fReceiveMaxSegmentSize;
+			if (fFlags & FLAG_OPTION_WINDOW_SCALE) {
+				segment.options |= TCP_HAS_WINDOW_SCALE;
+				segment.window_shift = fReceiveWindowShift;
+			}
+			if ((fFlags & FLAG_OPTION_SACK_PERMITTED) != 0)
+				segment.options |= TCP_SACK_PERMITTED;
+		}
+
+		if ((fFlags & FLAG_OPTION_SACK_PERMITTED) != 0
+			&& (segment.flags & TCP_FLAG_ACKNOWLEDGE) != 0
+			&& !fReceiveQueue.IsContiguous()) {
+			segment.sacks = sacks;
+			segment.sack_count = fReceiveQueue.PopulateSackInfo(fReceiveNext,
+				TCP_MAX_SACK_BLOCKS, sacks);
+		}
+	}
+
+	size_t availableBytes = fReceiveQueue.Free();
+	if (fFlags & FLAG_OPTION_WINDOW_SCALE)
+		segment.advertised_window = availableBytes >> fReceiveWindowShift;
+	else
+		segment.advertised_window = min_c(TCP_MAX_WINDOW, availableBytes);
+
+	segment.acknowledge = fReceiveNext.Number();
+}
+
+
 inline bool
 TCPEndpoint::_ShouldSendSegment(tcp_segment_header& segment, uint32 length,
 	uint32 segmentMaxSize, uint32 flightSize)
@@ -1934,33 +2192,9 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 	if (fState == LISTEN)
 		return B_ERROR;
 
+	tcp_sack sacks[TCP_MAX_SACK_BLOCKS];
 	tcp_segment_header segment(_CurrentFlags());
-
-	if ((fOptions & TCP_NOOPT) == 0) {
-		if ((fFlags & FLAG_OPTION_TIMESTAMP) != 0) {
-			segment.options |= TCP_HAS_TIMESTAMPS;
-			segment.timestamp_reply = fReceivedTimestamp;
-			segment.timestamp_value = tcp_now();
-		}
-
-		if ((segment.flags & TCP_FLAG_SYNCHRONIZE) != 0
-			&& fSendNext == fInitialSendSequence) {
-			// add connection establishment options
-			segment.max_segment_size = fReceiveMaxSegmentSize;
-			if (fFlags & FLAG_OPTION_WINDOW_SCALE) {
-				segment.options |= TCP_HAS_WINDOW_SCALE;
-				segment.window_shift = fReceiveWindowShift;
-			}
-		}
-	}
-
-	size_t availableBytes = fReceiveQueue.Free();
-	if (fFlags & FLAG_OPTION_WINDOW_SCALE)
-		segment.advertised_window = availableBytes >> fReceiveWindowShift;
-	else
-		segment.advertised_window = min_c(TCP_MAX_WINDOW, availableBytes);
-
-	segment.acknowledge = fReceiveNext.Number();
+	_PrepareSegment(segment, sacks);
 
 	// Process urgent data
 	if (fSendUrgentOffset > fSendNext) {
@@ -1973,9 +2207,6 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 		segment.urgent_offset = 0;
 	}
 
-	if (fCongestionWindow > 0 && fCongestionWindow < sendWindow)
-		sendWindow = fCongestionWindow;
-
 	// fSendUnacknowledged
 	//  |    fSendNext      fSendMax
 	//  |        |              |
@@ -1999,6 +2230,20 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 	} else
 		sendWindow -= consumedWindow;
 
+	uint32 congestionWindow = fCongestionControl->Window();
+	if (congestionWindow > 0) {
+		// During SACK based recovery, the data known to have left the
+		// network does not count against the congestion window
+		uint32 pipe = consumedWindow;
+		if ((fFlags & FLAG_RECOVERY) != 0 && _UseSack())
+			pipe = _Pipe();
+
+		if (pipe >= congestionWindow)
+			sendWindow = 0;
+		else if (congestionWindow - pipe < sendWindow)
+			sendWindow = congestionWindow - pipe;
+	}
+
 	if (force && sendWindow == 0 && fSendNext <= fSendQueue.LastSequence()) {
 		// send one byte of data to ask for a window update
 		// (triggered by the persist timer)
@@ -2011,7 +2256,8 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 	do {
 		uint32 segmentMaxSize = fSendMaxSegmentSize
 			- tcp_options_length(segment);
-		uint32 segmentLength = min_c(length, segmentMaxSize);
+		uint32 segmentLength = min_c(length,
+			_MaxSendSegmentSize(segmentMaxSize));
 
 		if (fSendNext + segmentLength == fSendQueue.LastSequence()) {
 			if (state_needs_finish(fState))
@@ -2021,8 +2267,9 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 		}
 
 		// Determine if we should really send this segment
-		if (!force && !_ShouldSendSegment(segment, segmentLength,
-				segmentMaxSize, flightSize)) {
+		if (!force && !_ShouldSendSegment(segment,
+				min_c(segmentLength, segmentMaxSize), segmentMaxSize,
+				flightSize)) {
 			if (fSendQueue.Available()
 				&& !gStackModule->is_timer_active(&fPersistTimer)
 				&& !gStackModule->is_timer_active(&fRetransmitTimer))
@@ -2054,7 +2301,8 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 			buffer, buffer->size, PrintAddress(buffer->source),
 			PrintAddress(buffer->destination), segment.flags, segment.sequence,
 			segment.acknowledge, segment.advertised_window,
-			fCongestionWindow, fSlowStartThreshold, segmentLength,
+			fCongestionControl->Window(),
+			fCongestionControl->SlowStartThreshold(), segmentLength,
 			fSendQueue.FirstSequence().Number(),
 			fSendQueue.LastSequence().Number());
 		T(Send(this, segment, buffer, fSendQueue.FirstSequence(),
@@ -2063,6 +2311,7 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 		PROBE(buffer, sendWindow);
 		sendWindow -= buffer->size;
 
+		_PrepareChecksum(buffer);
 		status = add_tcp_header(AddressModule(), segment, buffer);
 		if (status != B_OK) {
 			gBufferModule->free(buffer);
@@ -2073,7 +2322,7 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 		// for local connections as the answer is directly handled
 
 		if (segment.flags & TCP_FLAG_SYNCHRONIZE) {
-			segment.options &= ~TCP_HAS_WINDOW_SCALE;
+			segment.options &= ~(TCP_HAS_WINDOW_SCALE | TCP_SACK_PERMITTED);
 			segment.max_segment_size = 0;
 			size++;
 		}
@@ -2121,6 +2370,78 @@ TCPEndpoint::_SendQueued(bool force, uint32 sendWindow)
 }
 
 
+/*!	Retransmits a single segment of at most \a length bytes starting at
+	\a sequence, without changing the current send state.
+	Returns the number of sequence numbers sent, or an error code.
+*/
+ssize_t
+TCPEndpoint::_SendRetransmission(tcp_sequence sequence, uint32 length)
+{
+	if (fRoute == NULL)
+		return B_ERROR;
+
+	tcp_sack sacks[TCP_MAX_SACK_BLOCKS];
+	tcp_segment_header segment(_CurrentFlags());
+	_PrepareSegment(segment, sacks);
+
+	uint32 segmentMaxSize = fSendMaxSegmentSize - tcp_options_length(segment);
+	length = min_c(min_c(length, segmentMaxSize),
+		fSendQueue.Available(sequence));
+
+	if (sequence + length == fSendQueue.LastSequence()
+		&& state_needs_finish(fState))
+		segment.flags |= TCP_FLAG_FINISH;
+
+	if (length == 0 && (segment.flags & TCP_FLAG_FINISH) == 0)
+		return 0;
+
+	net_buffer* buffer = gBufferModule->create(256);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	status_t status = B_OK;
+	if (length > 0)
+		status = fSendQueue.Get(buffer, sequence, length);
+	if (status != B_OK) {
+		gBufferModule->free(buffer);
+		return status;
+	}
+
+	LocalAddress().CopyTo(buffer->source);
+	PeerAddress().CopyTo(buffer->destination);
+
+	segment.sequence = sequence.Number();
+
+	TRACE("SendRetransmission(): seq %lu, len %lu", segment.sequence, length);
+	T(Send(this, segment, buffer, fSendQueue.FirstSequence(),
+		fSendQueue.LastSequence()));
+
+	_PrepareChecksum(buffer);
+	status = add_tcp_header(AddressModule(), segment, buffer);
+	if (status != B_OK) {
+		gBufferModule->free(buffer);
+		return status;
+	}
+
+	fReceiveMaxAdvertised = fReceiveNext
+		+ ((uint32)segment.advertised_window << fReceiveWindowShift);
+
+	status = next->module->send_routed_data(next, fRoute, buffer);
+	if (status != B_OK) {
+		gBufferModule->free(buffer);
+		return status;
+	}
+
+	if (segment.flags & TCP_FLAG_ACKNOWLEDGE)
+		fLastAcknowledgeSent = segment.acknowledge;
+
+	if ((segment.flags & TCP_FLAG_FINISH) != 0)
+		length++;
+
+	return length;
+}
+
+
 int
 TCPEndpoint::_MaxSegmentSize(const sockaddr* address) const
 {
@@ -2128,6 +2449,34 @@ TCPEndpoint::_MaxSegmentSize(const sockaddr* address) const
 }
 
 
+/*!	Returns how much data may be passed on in a single segment. If the
+	device supports TCP segmentation offload, this may be a multiple of
+	\a segmentMaxSize, and the device will split it up again.
+*/
+uint32
+TCPEndpoint::_MaxSendSegmentSize(uint32 segmentMaxSize) const
+{
+	if (Domain()->family != AF_INET
+		|| (route_capabilities(fRoute) & NET_DEVICE_TCP_SEGMENTATION) == 0
+		|| segmentMaxSize >= kMaxSegmentationSize)
+		return segmentMaxSize;
+
+	return kMaxSegmentationSize / segmentMaxSize * segmentMaxSize;
+}
+
+
+/*!	Leaves computing the checksum of the outgoing segment \a buffer to the
+	device, if it supports that. Should the segment have to be fragmented
+	after all, the IP layer computes the checksum instead.
+*/
+void
+TCPEndpoint::_PrepareChecksum(net_buffer* buffer) const
+{
+	if ((route_capabilities(fRoute) & NET_DEVICE_TX_DATA_CHECKSUM) != 0)
+		buffer->flags |= NET_BUFFER_DATA_CHECKSUM_PENDING;
+}
+
+
 status_t
 TCPEndpoint::_PrepareSendPath(const sockaddr* peer)
 {
@@ -2151,6 +2500,8 @@ TCPEndpoint::_PrepareSendPath(const sockaddr* peer)
 	fSendUnacknowledged = fInitialSendSequence;
 	fSendMax = fInitialSendSequence;
 	fSendUrgentOffset = fInitialSendSequence;
+	fRecover = fInitialSendSequence;
+	fRetransmitHigh = fInitialSendSequence;
 
 	// we are counting the SYN here
 	fSendQueue.SetInitialSequence(fSendNext + 1);
@@ -2173,15 +2524,26 @@ void
 TCPEndpoint::_Acknowledged(tcp_segment_header& segment)
 {
 	size_t previouslyUsed = fSendQueue.Used();
+	uint32 flightSize = (fSendMax - fSendUnacknowledged).Number();
+	uint32 acknowledged = (tcp_sequence(segment.acknowledge)
+		- fSendUnacknowledged).Number();
 
 	fSendQueue.RemoveUntil(segment.acknowledge);
 	fSendUnacknowledged = segment.acknowledge;
+	fSackScoreboard.RemoveUntil(fSendUnacknowledged);
 
 	if (fSendNext < fSendUnacknowledged)
 		fSendNext = fSendUnacknowledged;
+	if (fRetransmitHigh < fSendUnacknowledged)
+		fRetransmitHigh = fSendUnacknowledged;
 
 	if (fSendUnacknowledged == fSendMax)
 		gStackModule->cancel_timer(&fRetransmitTimer);
+	else {
+		// restart the timer, as the connection makes progress (RFC 6298,
+		// section 5.3)
+		gStackModule->set_timer(&fRetransmitTimer, fRetransmitTimeout);
+	}
 
 	if (fSendQueue.Used() < previouslyUsed) {
 		// this ACK acknowledged data
@@ -2197,20 +2559,34 @@ TCPEndpoint::_Acknowledged(tcp_segment_header& segment)
 			fSendList.Signal();
 			gSocketModule->notify(socket, B_SELECT_WRITE, fSendQueue.Free());
 		}
-
-		if (fCongestionWindow < fSlowStartThreshold)
-			fCongestionWindow += fSendMaxSegmentSize;
 	}
 
-	if (fCongestionWindow >= fSlowStartThreshold) {
-		uint32 increment = fSendMaxSegmentSize * fSendMaxSegmentSize;
-
-		if (increment < fCongestionWindow)
-			increment = 1;
-		else
-			increment /= fCongestionWindow;
+	fDuplicateAcknowledgeCount = 0;
 
-		fCongestionWindow += increment;
+	if ((fFlags & FLAG_RECOVERY) != 0) {
+		if (fSendUnacknowledged >= fRecover) {
+			// everything that was outstanding when the loss was detected
+			// has been acknowledged
+			TRACE("Acknowledged(): leaving fast recovery");
+			fFlags &= ~FLAG_RECOVERY;
+			fCongestionControl->ExitRecovery();
+		} else if (_UseSack()) {
+			_SendSackRecovery();
+			return;
+		} else {
+			// NewReno partial acknowledgement (RFC 6582, section 3.2): the
+			// next segment has been lost as well
+			fCongestionControl->DeflateWindow(acknowledged);
+			if (acknowledged >= fSendMaxSegmentSize)
+				fCongestionControl->InflateWindow(fSendMaxSegmentSize);
+
+			_SendRetransmission(fSendUnacknowledged, fSendMaxSegmentSize);
+			_SendQueued();
+			return;
+		}
+	} else if (acknowledged > 0) {
+		fCongestionControl->Acknowledged(acknowledged, flightSize,
+			(bigtime_t)fRoundTripTime / 8 * kTimestampFactor);
 	}
 
 	// if there is data left to be send, send it now
@@ -2253,9 +2629,17 @@ TCPEndpoint::_UpdateRoundTripTime(int32 roundTripTime)
 void
 TCPEndpoint::_ResetSlowStart()
 {
-	fSlowStartThreshold = max_c((fSendMax - fSendUnacknowledged).Number() / 2,
-		2 * fSendMaxSegmentSize);
-	fCongestionWindow = fSendMaxSegmentSize;
+	fCongestionControl->RetransmitTimeout(
+		(fSendMax - fSendUnacknowledged).Number());
+
+	// The peer may have discarded the data it SACKed (RFC 2018, section 8),
+	// and the data sent before the timeout must not cause another fast
+	// recovery (RFC 6582, section 3.2)
+	fSackScoreboard.Reset();
+	fFlags &= ~FLAG_RECOVERY;
+	fRecover = fSendMax;
+	fRetransmitHigh = fSendUnacknowledged;
+	fDuplicateAcknowledgeCount = 0;
 }
 
 
@@ -2381,10 +2765,16 @@ TCPEndpoint::Dump() const
 		fInitialReceiveSequence.Number());
 	kprintf("    duplicate acknowledge count: %" B_PRIu32 "\n",
 		fDuplicateAcknowledgeCount);
+	kprintf("    recover: %" B_PRIu32 "\n", fRecover.Number());
+	kprintf("    retransmit high: %" B_PRIu32 "\n", fRetransmitHigh.Number());
+	fSackScoreboard.Dump();
 	kprintf("  round trip time: %" B_PRId32 " (deviation %" B_PRId32 ")\n",
 		fRoundTripTime, fRoundTripDeviation);
 	kprintf("  retransmit timeout: %" B_PRId64 "\n", fRetransmitTimeout);
-	kprintf("  congestion window: %" B_PRIu32 "\n", fCongestionWindow);
-	kprintf("  slow start threshold: %" B_PRIu32 "\n", fSlowStartThreshold);
+	kprintf("  congestion control: %s\n", fCongestionControl->Name());
+	kprintf("  congestion window: %" B_PRIu32 "\n",
+		fCongestionControl->Window());
+	kprintf("  slow start threshold: %" B_PRIu32 "\n",
+		fCongestionControl->SlowStartThreshold());
 }
 
@@ -12,7 +12,9 @@
 
 
 #include "BufferQueue.h"
+#include "CongestionControl.h"
 #include "EndpointManager.h"
+#include "SackScoreboard.h"
 #include "tcp.h"
 
 #include <ProtocolUtilities.h>
@@ -90,12 +92,18 @@ private:
 			void		_Close();
 			void		_CancelConnectionTimers();
 			uint8		_CurrentFlags();
+			void		_PrepareSegment(tcp_segment_header& segment,
+							tcp_sack* sacks);
 			bool		_ShouldSendSegment(tcp_segment_header& segment,
 							uint32 length, uint32 segmentMaxSize,
 							uint32 flightSize);
 			status_t	_SendQueued(bool force = false);
 			status_t	_SendQueued(bool force, uint32 sendWindow);
+			ssize_t		_SendRetransmission(tcp_sequence sequence,
+							uint32 length);
 			int			_MaxSegmentSize(const struct sockaddr* address) const;
+			uint32		_MaxSendSegmentSize(uint32 segmentMaxSize) const;
+			void		_PrepareChecksum(net_buffer* buffer) const;
 			status_t	_Disconnect(bool closing);
 			ssize_t		_AvailableData() const;
 			void		_NotifyReader();
@@ -125,6 +133,10 @@ private:
 			void		_UpdateRoundTripTime(int32 roundTripTime);
 			void		_ResetSlowStart();
 			void		_DuplicateAcknowledge(tcp_segment_header& segment);
+			bool		_UseSack() const;
+			void		_UpdateSackScoreboard(tcp_segment_header& segment);
+			uint32		_Pipe() const;
+			void		_SendSackRecovery();
 
 	static	void		_TimeWaitTimer(net_timer* timer, void* _endpoint);
 	static	void		_RetransmitTimer(net_timer* timer, void* _endpoint);
@@ -160,6 +172,9 @@ private:
 	tcp_sequence	fLastAcknowledgeSent;
 	tcp_sequence	fInitialSendSequence;
 	uint32			fDuplicateAcknowledgeCount;
+	tcp_sequence	fRecover;
+	tcp_sequence	fRetransmitHigh;
+	SackScoreboard	fSackScoreboard;
 
 	net_route 		*fRoute;
 		// TODO: don't use a net_route, but a net_route_info!!!
@@ -181,8 +196,7 @@ private:
 
 	uint32			fReceivedTimestamp;
 
-	uint32			fCongestionWindow;
-	uint32			fSlowStartThreshold;
+	TCPCongestionControl* fCongestionControl;
 
 	tcp_state		fState;
 	uint32			fFlags;
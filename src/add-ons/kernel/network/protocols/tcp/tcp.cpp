@@ -145,6 +145,8 @@ add_options(tcp_segment_header &segment, uint8 *buffer, size_t bufferSize)
 		int sackCount = ((int)(bufferSize - length) - 4) / sizeof(tcp_sack);
 		if (sackCount > segment.sack_count)
 			sackCount = segment.sack_count;
+		if (sackCount > TCP_MAX_SACK_BLOCKS)
+			sackCount = TCP_MAX_SACK_BLOCKS;
 
 		if (sackCount > 0) {
 			option->kind = TCP_OPTION_NOP;
@@ -153,7 +155,11 @@ add_options(tcp_segment_header &segment, uint8 *buffer, size_t bufferSize)
 			bump_option(option, length);
 			option->kind = TCP_OPTION_SACK;
 			option->length = 2 + sackCount * sizeof(tcp_sack);
-			memcpy(option->sack, segment.sacks, sackCount * sizeof(tcp_sack));
+			for (int i = 0; i < sackCount; i++) {
+				option->sack[i].left_edge = htonl(segment.sacks[i].left_edge);
+				option->sack[i].right_edge
+					= htonl(segment.sacks[i].right_edge);
+			}
 			bump_option(option, length);
 		}
 	}
@@ -219,6 +225,26 @@ process_options(tcp_segment_header &segment, net_buffer *buffer, size_t size)
 				if (option->length == 2 && size >= 2)
 					segment.options |= TCP_SACK_PERMITTED;
 				break;
+			case TCP_OPTION_SACK:
+			{
+				if (segment.sacks == NULL || option->length < 10
+					|| option->length > size
+					|| (option->length - 2) % sizeof(tcp_sack) != 0)
+					break;
+
+				int count = (option->length - 2) / sizeof(tcp_sack);
+				if (count > TCP_MAX_SACK_BLOCKS)
+					count = TCP_MAX_SACK_BLOCKS;
+
+				for (int i = 0; i < count; i++) {
+					segment.sacks[i].left_edge
+						= ntohl(option->sack[i].left_edge);
+					segment.sacks[i].right_edge
+						= ntohl(option->sack[i].right_edge);
+				}
+				segment.sack_count = count;
+				break;
+			}
 		}
 
 		if (length < 0) {
@@ -409,8 +435,10 @@ add_tcp_header(net_address_module_info* addressModule,
 		"win %u\n", buffer, segment.flags, segment.sequence,
 		segment.acknowledge, segment.urgent_offset, segment.advertised_window));
 
-	*TCPChecksumField(buffer) = Checksum::PseudoHeader(addressModule,
-		gBufferModule, buffer, IPPROTO_TCP);
+	if ((buffer->flags & NET_BUFFER_DATA_CHECKSUM_PENDING) == 0) {
+		*TCPChecksumField(buffer) = Checksum::PseudoHeader(addressModule,
+			gBufferModule, buffer, IPPROTO_TCP);
+	}
 
 	return B_OK;
 }
@@ -436,6 +464,7 @@ tcp_options_length(tcp_segment_header& segment)
 	if (segment.sack_count > 0) {
 		int sackCount = min_c((int)((kMaxOptionSize - length - 4)
 			/ sizeof(tcp_sack)), segment.sack_count);
+		sackCount = min_c(sackCount, TCP_MAX_SACK_BLOCKS);
 		if (sackCount > 0)
 			length += 4 + sackCount * sizeof(tcp_sack);
 	}
@@ -678,7 +707,8 @@ tcp_receive_data(net_buffer* buffer)
 	if (headerLength < sizeof(tcp_header))
 		return B_BAD_DATA;
 
-	if (Checksum::PseudoHeader(addressModule, gBufferModule, buffer,
+	if ((buffer->flags & NET_BUFFER_DATA_CHECKSUM_VALID) == 0
+		&& Checksum::PseudoHeader(addressModule, gBufferModule, buffer,
 			IPPROTO_TCP) != 0)
 		return B_BAD_DATA;
 
@@ -691,7 +721,10 @@ tcp_receive_data(net_buffer* buffer)
 	//dump_tcp_header(header);
 	//gBufferModule->dump(buffer);
 
+	tcp_sack sacks[TCP_MAX_SACK_BLOCKS];
+
 	tcp_segment_header segment(header.flags);
+	segment.sacks = sacks;
 	segment.sequence = header.Sequence();
 	segment.acknowledge = header.Acknowledge();
 	segment.advertised_window = header.AdvertisedWindow();
@@ -216,6 +216,7 @@ enum tcp_option_kind {
 };
 
 #define TCP_MAX_WINDOW_SHIFT	14
+#define TCP_MAX_SACK_BLOCKS		4
 
 enum {
 	TCP_HAS_WINDOW_SCALE	= 1 << 0,
@@ -229,6 +230,7 @@ struct tcp_segment_header {
 		flags(_flags),
 		window_shift(0),
 		max_segment_size(0),
+		sacks(NULL),
 		sack_count(0),
 		options(0)
 	{}
@@ -245,6 +247,7 @@ struct tcp_segment_header {
 	uint32	timestamp_reply;
 
 	tcp_sack	*sacks;
+		// in host byte order
 	int			sack_count;
 
 	uint32	options;
@@ -365,13 +365,21 @@ datalink_send_routed_data(struct net_route* route, net_buffer* buffer)
 		TRACE("  local route\n");
 
 		// We set the interface address here, so the buffer is delivered
-		// directly to the domain in interfaces.cpp:device_consumer_thread()
+		// directly to the domain in device_interfaces.cpp:receive_buffer()
 		address->AcquireReference();
 		set_interface_address(buffer->interface_address, address);
 
+		// the checksums left to the device will never be needed
+		if ((buffer->flags & NET_BUFFER_IP_CHECKSUM_PENDING) != 0)
+			buffer->flags |= NET_BUFFER_IP_CHECKSUM_VALID;
+		if ((buffer->flags & NET_BUFFER_DATA_CHECKSUM_PENDING) != 0)
+			buffer->flags |= NET_BUFFER_DATA_CHECKSUM_VALID;
+		buffer->flags &= ~(NET_BUFFER_IP_CHECKSUM_PENDING
+			| NET_BUFFER_DATA_CHECKSUM_PENDING);
+
 		// this one goes back to the domain directly
-		return fifo_enqueue_buffer(
-			&interface->DeviceInterface()->receive_queue, buffer);
+		return device_interface_enqueue_buffer(interface->DeviceInterface(),
+			buffer);
 	}
 
 	if ((route->flags & RTF_GATEWAY) != 0) {
@@ -16,12 +16,14 @@
 #include <net_device.h>
 
 #include <lock.h>
+#include <smp.h>
 #include <util/AutoLock.h>
 
 #include <KernelExport.h>
 
 #include <net/if_dl.h>
 #include <netinet/in.h>
+#include <netinet/ip.h>
 #include <new>
 #include <stdio.h>
 #include <stdlib.h>
@@ -36,25 +38,508 @@
 #endif
 
 
+static const size_t kReceiveQueueSize = 16 * 1024 * 1024;
+static const uint32 kMaxDeviceConsumers = 8;
+static const int32 kReceiveBatchSize = 32;
+static const uint32 kMaxReceiveOffloadFlows = 8;
+static const size_t kMaxReceiveOffloadSize = 65535;
+	// the maximum size of an IPv4 packet
+
+static const uint8 kTCPFlagPush = 0x08;
+static const uint8 kTCPFlagAcknowledge = 0x10;
+
 static mutex sLock;
 static DeviceInterfaceList sInterfaces;
 static uint32 sDeviceIndex;
 
 
-/*!	A service thread for each device interface. It just reads as many packets
-	as availabe, deframes them, and puts them into the receive queue of the
-	device interface.
+/*!	Passes the \a buffer on to the domain it has been delivered to locally,
+	or to the first receive handler of the \a interface that accepts it.
+*/
+static void
+receive_buffer(net_device_interface* interface, net_buffer* buffer)
+{
+	if (buffer->interface_address != NULL) {
+		// If the interface is already specified, this buffer was
+		// delivered locally.
+		if (buffer->interface_address->domain->module->receive_data(buffer)
+				== B_OK)
+			buffer = NULL;
+	} else {
+		sockaddr_dl& linkAddress = *(sockaddr_dl*)buffer->source;
+		int32 genericType = buffer->type;
+		int32 specificType = B_NET_FRAME_TYPE(linkAddress.sdl_type,
+			ntohs(linkAddress.sdl_e_type));
+
+		buffer->index = interface->device->index;
+
+		// Find handler for this packet
+
+		RecursiveLocker locker(interface->receive_lock);
+
+		DeviceHandlerList::Iterator iterator
+			= interface->receive_funcs.GetIterator();
+		while (buffer != NULL && iterator.HasNext()) {
+			net_device_handler* handler = iterator.Next();
+
+			// If the handler returns B_OK, it consumed the buffer - first
+			// handler wins.
+			if ((handler->type == genericType
+					|| handler->type == specificType)
+				&& handler->func(handler->cookie, interface->device, buffer)
+					== B_OK)
+				buffer = NULL;
+		}
+	}
+
+	if (buffer != NULL)
+		gNetBufferModule.free(buffer);
+}
+
+
+//	#pragma mark - receive offload
+
+
+/*!	Generic receive offload: in-order TCP segments of the same connection that
+	are dequeued in the same batch are coalesced into a single buffer before
+	they are passed on, so that the IP and TCP receive paths only have to run
+	once for all of them.
+
+	Only plain IPv4 segments that carry data and nothing but an ACK (and
+	possibly a PUSH) are considered, their checksums are verified here, and
+	their TCP options must be identical. Anything else is passed on as is,
+	but after any data of its connection that is still held back, so that the
+	order of the segments is preserved.
+*/
+class ReceiveOffload {
+public:
+								ReceiveOffload(
+									net_device_interface* interface);
+
+			void				Receive(net_buffer* buffer);
+			void				Flush();
+
+private:
+			struct ip_header {
+				uint8			version_length;
+				uint8			service_type;
+				uint16			total_length;
+				uint16			id;
+				uint16			fragment_offset;
+				uint8			time_to_live;
+				uint8			protocol;
+				uint16			checksum;
+				in_addr_t		source;
+				in_addr_t		destination;
+			} _PACKED;
+
+			struct tcp_header {
+				uint16			source_port;
+				uint16			destination_port;
+				uint32			sequence;
+				uint32			acknowledge;
+				uint8			header_length;
+				uint8			flags;
+				uint16			advertised_window;
+				uint16			checksum;
+				uint16			urgent_offset;
+				uint8			options[40];
+			} _PACKED;
+
+			struct segment_headers {
+				ip_header		ip;
+				tcp_header		tcp;
+			} _PACKED;
+
+			struct flow_state {
+				net_buffer*		buffer;
+				segment_headers	headers;
+				size_t			header_length;
+				uint32			next_sequence;
+			};
+
+			enum {
+				kOther,
+				kTCP,
+				kCoalescable
+			};
+
+			int32				_Parse(net_buffer* buffer,
+									segment_headers& headers,
+									size_t& _headerLength);
+			bool				_CanCoalesce(const flow_state& flow,
+									const segment_headers& headers,
+									size_t headerLength, size_t size) const;
+			flow_state*			_FindFlow(const segment_headers& headers,
+									bool create = false);
+			void				_FlushFlows(in_addr_t source,
+									in_addr_t destination);
+			void				_Flush(flow_state& flow);
+			void				_Deliver(net_buffer* buffer);
+
+private:
+			net_device_interface* fInterface;
+			flow_state			fFlows[kMaxReceiveOffloadFlows];
+			uint32				fNextFlow;
+};
+
+
+ReceiveOffload::ReceiveOffload(net_device_interface* interface)
+	:
+	fInterface(interface),
+	fNextFlow(0)
+{
+	for (uint32 i = 0; i < kMaxReceiveOffloadFlows; i++)
+		fFlows[i].buffer = NULL;
+}
+
+
+void
+ReceiveOffload::Receive(net_buffer* buffer)
+{
+	segment_headers headers;
+	size_t headerLength;
+	int32 type = _Parse(buffer, headers, headerLength);
+	if (type != kCoalescable) {
+		if (type == kTCP)
+			_FlushFlows(headers.ip.source, headers.ip.destination);
+
+		_Deliver(buffer);
+		return;
+	}
+
+	uint32 size = buffer->size - headerLength;
+	flow_state* flow = _FindFlow(headers);
+	if (flow != NULL) {
+		if (_CanCoalesce(*flow, headers, headerLength, size)) {
+			if (gNetBufferModule.remove_header(buffer, headerLength) != B_OK
+				|| gNetBufferModule.merge(flow->buffer, buffer, true)
+					!= B_OK) {
+				// drop the segment, TCP will have it retransmitted
+				gNetBufferModule.free(buffer);
+				_Flush(*flow);
+				return;
+			}
+
+			flow->next_sequence += size;
+			if ((headers.tcp.flags & kTCPFlagPush) != 0) {
+				flow->headers.tcp.flags |= kTCPFlagPush;
+				_Flush(*flow);
+			}
+			return;
+		}
+
+		_Flush(*flow);
+	}
+
+	if ((headers.tcp.flags & kTCPFlagPush) != 0) {
+		// the sender does not have any more data for us right now
+		_Deliver(buffer);
+		return;
+	}
+
+	flow = _FindFlow(headers, true);
+
+	flow->buffer = buffer;
+	flow->headers = headers;
+	flow->header_length = headerLength;
+	flow->next_sequence = ntohl(headers.tcp.sequence) + size;
+}
+
+
+/*!	Passes on all segments that are still held back. */
+void
+ReceiveOffload::Flush()
+{
+	for (uint32 i = 0; i < kMaxReceiveOffloadFlows; i++) {
+		if (fFlows[i].buffer != NULL)
+			_Flush(fFlows[i]);
+	}
+}
+
+
+/*!	Reads the headers of the \a buffer, and determines whether it can be
+	coalesced with other segments. If it's not, but is a TCP segment, its
+	addresses are still valid in \a headers.
+*/
+int32
+ReceiveOffload::_Parse(net_buffer* buffer, segment_headers& headers,
+	size_t& _headerLength)
+{
+	if (buffer->interface_address != NULL
+		|| buffer->type != B_NET_FRAME_TYPE_IPV4
+		|| buffer->size <= sizeof(ip_header) + sizeof(tcp_header)
+			- sizeof(headers.tcp.options))
+		return kOther;
+
+	if (gNetBufferModule.read(buffer, 0, &headers,
+			min_c(buffer->size, sizeof(headers))) != B_OK
+		|| (headers.ip.version_length >> 4) != 4
+		|| headers.ip.protocol != IPPROTO_TCP)
+		return kOther;
+
+	// only simple, unfragmented packets without IP options
+	if (headers.ip.version_length != 0x45
+		|| ntohs(headers.ip.total_length) != buffer->size
+		|| (ntohs(headers.ip.fragment_offset) & (IP_MF | IP_OFFMASK)) != 0)
+		return kTCP;
+
+	if ((buffer->flags & NET_BUFFER_IP_CHECKSUM_VALID) == 0
+		&& checksum((uint8*)&headers.ip, sizeof(ip_header)) != 0)
+		return kTCP;
+
+	size_t tcpLength = (headers.tcp.header_length >> 4) * 4;
+	size_t headerLength = sizeof(ip_header) + tcpLength;
+	if (tcpLength < sizeof(tcp_header) - sizeof(headers.tcp.options)
+		|| headerLength >= buffer->size
+		|| (headers.tcp.flags & ~kTCPFlagPush) != kTCPFlagAcknowledge)
+		return kTCP;
+
+	if ((buffer->flags & NET_BUFFER_DATA_CHECKSUM_VALID) == 0) {
+		// verify the checksum, including the pseudo header
+		uint16 length = buffer->size - sizeof(ip_header);
+		uint32 sum = gNetBufferModule.checksum(buffer, sizeof(ip_header),
+			length, false);
+		sum += (headers.ip.source >> 16) + (headers.ip.source & 0xffff)
+			+ (headers.ip.destination >> 16)
+			+ (headers.ip.destination & 0xffff)
+			+ htons(IPPROTO_TCP) + htons(length);
+		while (sum >> 16)
+			sum = (sum & 0xffff) + (sum >> 16);
+
+		if (sum != 0xffff)
+			return kTCP;
+	}
+
+	_headerLength = headerLength;
+	return kCoalescable;
+}
+
+
+bool
+ReceiveOffload::_CanCoalesce(const flow_state& flow,
+	const segment_headers& headers, size_t headerLength, size_t size) const
+{
+	return ntohl(headers.tcp.sequence) == flow.next_sequence
+		&& headers.tcp.acknowledge == flow.headers.tcp.acknowledge
+		&& headers.tcp.advertised_window
+			== flow.headers.tcp.advertised_window
+		&& headerLength == flow.header_length
+		&& memcmp(headers.tcp.options, flow.headers.tcp.options,
+			headerLength - sizeof(ip_header) - sizeof(tcp_header)
+				+ sizeof(headers.tcp.options)) == 0
+		&& flow.buffer->size + size <= kMaxReceiveOffloadSize;
+}
+
+
+/*!	Returns the flow the segment with the given \a headers belongs to. If
+	there is none, and \a create is \c true, an unused flow is returned,
+	and if there is none either, another flow is flushed to make room.
+*/
+ReceiveOffload::flow_state*
+ReceiveOffload::_FindFlow(const segment_headers& headers, bool create)
+{
+	flow_state* unused = NULL;
+
+	for (uint32 i = 0; i < kMaxReceiveOffloadFlows; i++) {
+		flow_state& flow = fFlows[i];
+		if (flow.buffer == NULL) {
+			if (unused == NULL)
+				unused = &flow;
+			continue;
+		}
+
+		if (flow.headers.ip.source == headers.ip.source
+			&& flow.headers.ip.destination == headers.ip.destination
+			&& flow.headers.tcp.source_port == headers.tcp.source_port
+			&& flow.headers.tcp.destination_port
+				== headers.tcp.destination_port)
+			return &flow;
+	}
+
+	if (!create)
+		return NULL;
+
+	if (unused == NULL) {
+		unused = &fFlows[fNextFlow];
+		fNextFlow = (fNextFlow + 1) % kMaxReceiveOffloadFlows;
+		_Flush(*unused);
+	}
+
+	return unused;
+}
+
+
+void
+ReceiveOffload::_FlushFlows(in_addr_t source, in_addr_t destination)
+{
+	for (uint32 i = 0; i < kMaxReceiveOffloadFlows; i++) {
+		flow_state& flow = fFlows[i];
+		if (flow.buffer != NULL && flow.headers.ip.source == source
+			&& flow.headers.ip.destination == destination)
+			_Flush(flow);
+	}
+}
+
+
+/*!	Passes on the segment held back for \a flow. If other segments have been
+	coalesced with it, its headers are updated to cover all of them.
+*/
+void
+ReceiveOffload::_Flush(flow_state& flow)
+{
+	net_buffer* buffer = flow.buffer;
+	flow.buffer = NULL;
+
+	if (ntohs(flow.headers.ip.total_length) != buffer->size) {
+		flow.headers.ip.total_length = htons(buffer->size);
+		flow.headers.ip.checksum = 0;
+		flow.headers.ip.checksum = checksum((uint8*)&flow.headers.ip,
+			sizeof(ip_header));
+
+		gNetBufferModule.write(buffer, 0, &flow.headers,
+			sizeof(ip_header) + sizeof(tcp_header)
+				- sizeof(flow.headers.tcp.options));
+	}
+
+	// The checksums have been verified already, and the TCP checksum no
+	// longer matches the coalesced data.
+	buffer->flags |= NET_BUFFER_IP_CHECKSUM_VALID
+		| NET_BUFFER_DATA_CHECKSUM_VALID;
+
+	_Deliver(buffer);
+}
+
+
+void
+ReceiveOffload::_Deliver(net_buffer* buffer)
+{
+	receive_buffer(fInterface, buffer);
+}
+
+
+//	#pragma mark - flow steering
+
+
+static inline uint32
+hash_word(uint32 hash, uint32 word)
+{
+	hash ^= word;
+	hash *= 0x9e3779b1;
+	return hash ^ (hash >> 16);
+}
+
+
+/*!	Computes a hash over the IPv4 or IPv6 packet in \a buffer, so that all
+	packets of the same flow are handed to the same consumer, and are
+	therefore processed in order.
+	The addresses, and for TCP and UDP also the protocol and ports are
+	hashed. Fragments don't carry the ports, and are only hashed by their
+	addresses; they may therefore be processed by another consumer than the
+	rest of their flow, which only costs some reordering, as fragmented
+	traffic is rare.
+	Buffers that have been delivered locally must start with the network
+	header, all others must have been deframed already.
+*/
+uint32
+device_flow_hash(net_buffer* buffer)
+{
+	int family;
+	if (buffer->interface_address != NULL)
+		family = buffer->interface_address->domain->family;
+	else if (buffer->type == B_NET_FRAME_TYPE_IPV4)
+		family = AF_INET;
+	else if (buffer->type == B_NET_FRAME_TYPE_IPV6)
+		family = AF_INET6;
+	else
+		return 0;
+
+	uint32 header[10];
+	uint32 hash = 0;
+	uint8 protocol;
+	size_t headerLength;
+
+	if (family == AF_INET) {
+		if (gNetBufferModule.read(buffer, 0, header, 20) != B_OK)
+			return 0;
+
+		// source and destination address
+		hash = hash_word(hash, header[3]);
+		hash = hash_word(hash, header[4]);
+
+		if ((ntohs(((uint16*)header)[3]) & (IP_MF | IP_OFFMASK)) != 0)
+			return hash;
+
+		protocol = ((uint8*)header)[9];
+		headerLength = (((uint8*)header)[0] & 0xf) * 4;
+	} else if (family == AF_INET6) {
+		if (gNetBufferModule.read(buffer, 0, header, 40) != B_OK)
+			return 0;
+
+		// source and destination address
+		for (int32 i = 2; i < 10; i++)
+			hash = hash_word(hash, header[i]);
+
+		// fragments, and packets with other extension headers are not
+		// looked into any further
+		protocol = ((uint8*)header)[6];
+		headerLength = 40;
+	} else
+		return 0;
+
+	if (protocol != IPPROTO_TCP && protocol != IPPROTO_UDP)
+		return hash;
+
+	uint32 ports;
+	if (gNetBufferModule.read(buffer, headerLength, &ports, sizeof(ports))
+			== B_OK) {
+		hash = hash_word(hash, protocol);
+		hash = hash_word(hash, ports);
+	}
+
+	return hash;
+}
+
+
+/*!	Puts the \a buffer into the receive queue of the consumer that is
+	responsible for its flow.
+*/
+status_t
+device_interface_enqueue_buffer(net_device_interface* interface,
+	net_buffer* buffer)
+{
+	uint32 index = 0;
+	if (interface->consumer_count > 1)
+		index = device_flow_hash(buffer) % interface->consumer_count;
+
+	return fifo_enqueue_buffer(&interface->consumers[index].queue, buffer);
+}
+
+
+//	#pragma mark -
+
+
+/*!	A service thread for each receive queue of a device interface. It just
+	reads as many packets as available, deframes them, and puts them into
+	the receive queue of one of the consumers of the device interface.
 */
 static status_t
-device_reader_thread(void* _interface)
+device_reader_thread(void* _reader)
 {
-	net_device_interface* interface = (net_device_interface*)_interface;
+	net_device_reader* reader = (net_device_reader*)_reader;
+	net_device_interface* interface = reader->interface;
 	net_device* device = interface->device;
+	bool multiQueue = interface->reader_count > 1;
 	status_t status = B_OK;
 
 	while ((device->flags & IFF_UP) != 0) {
 		net_buffer* buffer;
-		status = device->module->receive_data(device, &buffer);
+		if (multiQueue) {
+			status = device->module->receive_queue_data(device, reader->queue,
+				&buffer);
+		} else
+			status = device->module->receive_data(device, &buffer);
+
 		if (status == B_OK) {
 			// feed device monitors
 			if (atomic_get(&interface->monitor_count) > 0)
@@ -67,7 +552,14 @@ device_reader_thread(void* _interface)
 				continue;
 			}
 
-			fifo_enqueue_buffer(&interface->receive_queue, buffer);
+			if (multiQueue) {
+				// The device already distributes the packets by flow, we
+				// just need to stick to its choice.
+				net_device_consumer& consumer = interface->consumers[
+					reader->queue % interface->consumer_count];
+				fifo_enqueue_buffer(&consumer.queue, buffer);
+			} else
+				device_interface_enqueue_buffer(interface, buffer);
 		} else if (status == B_DEVICE_NOT_FOUND) {
 				device_removed(device);
 		} else {
@@ -81,56 +573,30 @@ device_reader_thread(void* _interface)
 }
 
 
+/*!	A service thread for each CPU and device interface that takes the packets
+	out of its receive queue in batches, and passes them on to the protocols.
+*/
 static status_t
-device_consumer_thread(void* _interface)
+device_consumer_thread(void* _consumer)
 {
-	net_device_interface* interface = (net_device_interface*)_interface;
-	net_device* device = interface->device;
-	net_buffer* buffer;
+	net_device_consumer* consumer = (net_device_consumer*)_consumer;
+	ReceiveOffload offload(consumer->interface);
 
 	while (true) {
-		ssize_t status = fifo_dequeue_buffer(&interface->receive_queue, 0,
-			B_INFINITE_TIMEOUT, &buffer);
-		if (status != B_OK) {
-			if (status == B_INTERRUPTED)
+		net_buffer* buffers[kReceiveBatchSize];
+		ssize_t count = fifo_dequeue_buffers(&consumer->queue,
+			B_INFINITE_TIMEOUT, buffers, kReceiveBatchSize);
+		if (count < 0) {
+			if (count == B_INTERRUPTED)
 				continue;
 			break;
 		}
 
-		if (buffer->interface_address != NULL) {
-			// If the interface is already specified, this buffer was
-			// delivered locally.
-			if (buffer->interface_address->domain->module->receive_data(buffer)
-					== B_OK)
-				buffer = NULL;
-		} else {
-			sockaddr_dl& linkAddress = *(sockaddr_dl*)buffer->source;
-			int32 genericType = buffer->type;
-			int32 specificType = B_NET_FRAME_TYPE(linkAddress.sdl_type,
-				ntohs(linkAddress.sdl_e_type));
-
-			buffer->index = interface->device->index;
-
-			// Find handler for this packet
-
-			RecursiveLocker locker(interface->receive_lock);
-
-			DeviceHandlerList::Iterator iterator
-				= interface->receive_funcs.GetIterator();
-			while (buffer != NULL && iterator.HasNext()) {
-				net_device_handler* handler = iterator.Next();
-
-				// If the handler returns B_OK, it consumed the buffer - first
-				// handler wins.
-				if ((handler->type == genericType
-						|| handler->type == specificType)
-					&& handler->func(handler->cookie, device, buffer) == B_OK)
-					buffer = NULL;
-			}
-		}
+		for (ssize_t i = 0; i < count; i++)
+			offload.Receive(buffers[i]);
 
-		if (buffer != NULL)
-			gNetBufferModule.free(buffer);
+		// never hold anything back beyond the current batch
+		offload.Flush();
 	}
 
 	return B_OK;
@@ -163,6 +629,72 @@ find_device_interface(const char* name)
 }
 
 
+/*!	Stops all consumer threads of the \a interface, and frees their queues. */
+static void
+stop_device_consumers(net_device_interface* interface)
+{
+	for (uint32 i = 0; i < interface->consumer_count; i++) {
+		net_device_consumer& consumer = interface->consumers[i];
+
+		uninit_fifo(&consumer.queue);
+		status_t status;
+		wait_for_thread(consumer.thread, &status);
+	}
+
+	delete[] interface->consumers;
+	interface->consumers = NULL;
+	interface->consumer_count = 0;
+}
+
+
+/*!	Starts a consumer thread with its own receive queue for each CPU. */
+static status_t
+start_device_consumers(net_device_interface* interface)
+{
+	net_device* device = interface->device;
+	uint32 count = min_c((uint32)smp_get_num_cpus(), kMaxDeviceConsumers);
+
+	interface->consumers = new(std::nothrow) net_device_consumer[count];
+	if (interface->consumers == NULL)
+		return B_NO_MEMORY;
+
+	interface->consumer_count = 0;
+
+	for (uint32 i = 0; i < count; i++) {
+		net_device_consumer& consumer = interface->consumers[i];
+		consumer.interface = interface;
+
+		char name[128];
+		snprintf(name, sizeof(name), "%s receive queue %" B_PRIu32,
+			device->name, i);
+
+		if (init_fifo(&consumer.queue, name, kReceiveQueueSize / count)
+				!= B_OK)
+			break;
+
+		snprintf(name, sizeof(name), "%s consumer %" B_PRIu32, device->name,
+			i);
+
+		consumer.thread = spawn_kernel_thread(device_consumer_thread, name,
+			B_DISPLAY_PRIORITY, &consumer);
+		if (consumer.thread < B_OK) {
+			uninit_fifo(&consumer.queue);
+			break;
+		}
+
+		resume_thread(consumer.thread);
+		interface->consumer_count++;
+	}
+
+	if (interface->consumer_count < count) {
+		stop_device_consumers(interface);
+		return B_NO_MEMORY;
+	}
+
+	return B_OK;
+}
+
+
 static net_device_interface*
 allocate_device_interface(net_device* device, net_device_module_info* module)
 {
@@ -173,12 +705,6 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	recursive_lock_init(&interface->receive_lock, "device interface receive");
 	recursive_lock_init(&interface->monitor_lock, "device interface monitors");
 
-	char name[128];
-	snprintf(name, sizeof(name), "%s receive queue", device->name);
-
-	if (init_fifo(&interface->receive_queue, name, 16 * 1024 * 1024) < B_OK)
-		goto error1;
-
 	interface->device = device;
 	interface->up_count = 0;
 	interface->ref_count = 1;
@@ -186,14 +712,11 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	interface->deframe_func = NULL;
 	interface->deframe_ref_count = 0;
 
-	snprintf(name, sizeof(name), "%s consumer", device->name);
+	interface->readers = NULL;
+	interface->reader_count = 0;
 
-	interface->reader_thread   = -1;
-	interface->consumer_thread = spawn_kernel_thread(device_consumer_thread,
-		name, B_DISPLAY_PRIORITY, interface);
-	if (interface->consumer_thread < B_OK)
-		goto error2;
-	resume_thread(interface->consumer_thread);
+	if (start_device_consumers(interface) != B_OK)
+		goto error;
 
 	// TODO: proper interface index allocation
 	device->index = ++sDeviceIndex;
@@ -202,9 +725,7 @@ allocate_device_interface(net_device* device, net_device_module_info* module)
 	sInterfaces.Add(interface);
 	return interface;
 
-error2:
-	uninit_fifo(&interface->receive_queue);
-error1:
+error:
 	recursive_lock_destroy(&interface->receive_lock);
 	recursive_lock_destroy(&interface->monitor_lock);
 	delete interface;
@@ -242,12 +763,20 @@ dump_device_interface(int argc, char** argv)
 		= (net_device_interface*)parse_expression(argv[1]);
 
 	kprintf("device:            %p\n", interface->device);
-	kprintf("reader_thread:     %" B_PRId32 "\n", interface->reader_thread);
+	kprintf("reader_threads:   ");
+	for (uint32 i = 0; i < interface->reader_count; i++)
+		kprintf(" %" B_PRId32, interface->readers[i].thread);
+	kprintf("\n");
 	kprintf("up_count:          %" B_PRIu32 "\n", interface->up_count);
 	kprintf("ref_count:         %" B_PRId32 "\n", interface->ref_count);
 	kprintf("deframe_func:      %p\n", interface->deframe_func);
 	kprintf("deframe_ref_count: %" B_PRId32 "\n", interface->ref_count);
-	kprintf("consumer_thread:   %" B_PRId32 "\n", interface->consumer_thread);
+	kprintf("consumers:\n");
+	for (uint32 i = 0; i < interface->consumer_count; i++) {
+		net_device_consumer& consumer = interface->consumers[i];
+		kprintf("  thread %" B_PRId32 ", queue %p\n", consumer.thread,
+			&consumer.queue);
+	}
 
 	kprintf("monitor_count:     %" B_PRId32 "\n", interface->monitor_count);
 	kprintf("monitor_lock:      %p\n", &interface->monitor_lock);
@@ -258,7 +787,6 @@ dump_device_interface(int argc, char** argv)
 		kprintf("  %p\n", monitorIterator.Next());
 
 	kprintf("receive_lock:      %p\n", &interface->receive_lock);
-	kprintf("receive_queue:     %p\n", &interface->receive_queue);
 	kprintf("receive_funcs:\n");
 	DeviceHandlerList::Iterator handlerIterator
 		= interface->receive_funcs.GetIterator();
@@ -382,9 +910,7 @@ put_device_interface(struct net_device_interface* interface)
 	sInterfaces.Remove(interface);
 	locker.Unlock();
 
-	uninit_fifo(&interface->receive_queue);
-	status_t status;
-	wait_for_thread(interface->consumer_thread, &status);
+	stop_device_consumers(interface);
 
 	net_device* device = interface->device;
 	const char* moduleName = device->module->info.name;
@@ -505,21 +1031,63 @@ up_device_interface(net_device_interface* interface)
 	if (status != B_OK)
 		return status;
 
-	if (device->module->receive_data != NULL) {
-		// give the thread a nice name
-		char name[B_OS_NAME_LENGTH];
-		snprintf(name, sizeof(name), "%s reader", device->name);
+	uint32 readerCount = 0;
+	if (device->module->receive_queue_data != NULL
+		&& device->receive_queue_count > 1)
+		readerCount = device->receive_queue_count;
+	else if (device->module->receive_data != NULL)
+		readerCount = 1;
+
+	if (readerCount > 0) {
+		interface->readers
+			= new(std::nothrow) net_device_reader[readerCount];
+		if (interface->readers == NULL) {
+			device->module->down(device);
+			return B_NO_MEMORY;
+		}
 
-		interface->reader_thread = spawn_kernel_thread(device_reader_thread,
-			name, B_REAL_TIME_DISPLAY_PRIORITY - 10, interface);
-		if (interface->reader_thread < B_OK)
-			return interface->reader_thread;
+		for (uint32 i = 0; i < readerCount; i++) {
+			net_device_reader& reader = interface->readers[i];
+			reader.interface = interface;
+			reader.queue = i;
+
+			// give the thread a nice name
+			char name[B_OS_NAME_LENGTH];
+			if (readerCount > 1) {
+				snprintf(name, sizeof(name), "%s reader %" B_PRIu32,
+					device->name, i);
+			} else
+				snprintf(name, sizeof(name), "%s reader", device->name);
+
+			reader.thread = spawn_kernel_thread(device_reader_thread,
+				name, B_REAL_TIME_DISPLAY_PRIORITY - 10, &reader);
+			if (reader.thread < B_OK) {
+				status = reader.thread;
+
+				// the threads already created will quit right away, as
+				// the device is not up
+				for (uint32 j = 0; j < i; j++) {
+					resume_thread(interface->readers[j].thread);
+
+					status_t exitStatus;
+					wait_for_thread(interface->readers[j].thread,
+						&exitStatus);
+				}
+
+				delete[] interface->readers;
+				interface->readers = NULL;
+				device->module->down(device);
+				return status;
+			}
+		}
+
+		interface->reader_count = readerCount;
 	}
 
 	device->flags |= IFF_UP;
 
-	if (device->module->receive_data != NULL)
-		resume_thread(interface->reader_thread);
+	for (uint32 i = 0; i < interface->reader_count; i++)
+		resume_thread(interface->readers[i].thread);
 
 	interface->up_count = 1;
 	return B_OK;
@@ -549,12 +1117,17 @@ down_device_interface(net_device_interface* interface)
 
 	notify_device_monitors(interface, B_DEVICE_GOING_DOWN);
 
-	if (device->module->receive_data != NULL) {
-		thread_id readerThread = interface->reader_thread;
+	if (interface->readers != NULL) {
+		// make sure the reader threads are gone before shutting down the
+		// interface
+		for (uint32 i = 0; i < interface->reader_count; i++) {
+			status_t status;
+			wait_for_thread(interface->readers[i].thread, &status);
+		}
 
-		// make sure the reader thread is gone before shutting down the interface
-		status_t status;
-		wait_for_thread(readerThread, &status);
+		delete[] interface->readers;
+		interface->readers = NULL;
+		interface->reader_count = 0;
 	}
 }
 
@@ -796,7 +1369,7 @@ device_enqueue_buffer(net_device* device, net_buffer* buffer)
 	if (interface == NULL)
 		return B_DEVICE_NOT_FOUND;
 
-	status_t status = fifo_enqueue_buffer(&interface->receive_queue, buffer);
+	status_t status = device_interface_enqueue_buffer(interface, buffer);
 
 	put_device_interface(interface);
 	return status;
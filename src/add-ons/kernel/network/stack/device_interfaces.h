@@ -26,9 +26,25 @@ typedef DoublyLinkedList<net_device_handler> DeviceHandlerList;
 typedef DoublyLinkedList<net_device_monitor,
 	DoublyLinkedListCLink<net_device_monitor> > DeviceMonitorList;
 
+struct net_device_interface;
+
+struct net_device_reader {
+	net_device_interface* interface;
+	uint32				queue;
+	thread_id			thread;
+};
+
+struct net_device_consumer {
+	net_device_interface* interface;
+	thread_id			thread;
+	net_fifo			queue;
+};
+
 struct net_device_interface : DoublyLinkedListLinkImpl<net_device_interface> {
 	struct net_device*	device;
-	thread_id			reader_thread;
+	net_device_reader*	readers;
+	uint32				reader_count;
+		// one reader thread per receive queue of the device
 	uint32				up_count;
 		// a device can be brought up by more than one interface
 	int32				ref_count;
@@ -43,8 +59,10 @@ struct net_device_interface : DoublyLinkedListLinkImpl<net_device_interface> {
 	DeviceHandlerList	receive_funcs;
 	recursive_lock		receive_lock;
 
-	thread_id			consumer_thread;
-	net_fifo			receive_queue;
+	net_device_consumer* consumers;
+	uint32				consumer_count;
+		// one consumer thread per CPU, the packets are distributed among
+		// them by flow
 };
 
 typedef DoublyLinkedList<net_device_interface> DeviceInterfaceList;
@@ -62,6 +80,8 @@ struct net_device_interface* get_device_interface(const char* name,
 	bool create = true);
 void device_interface_monitor_receive(net_device_interface* interface,
 	net_buffer* buffer);
+status_t device_interface_enqueue_buffer(net_device_interface* interface,
+	net_buffer* buffer);
 status_t up_device_interface(net_device_interface* interface);
 void down_device_interface(net_device_interface* interface);
 
@@ -81,6 +101,7 @@ status_t unregister_device_monitor(struct net_device* device,
 status_t device_link_changed(net_device* device);
 status_t device_removed(net_device* device);
 status_t device_enqueue_buffer(net_device* device, net_buffer* buffer);
+uint32 device_flow_hash(net_buffer* buffer);
 
 status_t init_device_interfaces();
 status_t uninit_device_interfaces();
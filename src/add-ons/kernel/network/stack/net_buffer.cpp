@@ -53,6 +53,8 @@
 #define DATA_NODE_READ_ONLY		0x1
 #define DATA_NODE_STORED_HEADER	0x2
 
+#define DATA_HEADER_EXTERNAL	0x1
+
 struct header_space {
 	uint16	size;
 	uint16	free;
@@ -70,6 +72,17 @@ struct data_header {
 	uint8*			data_end;
 	header_space	space;
 	uint16			tail_space;
+	uint16			flags;
+};
+
+/*!	Header for data that does not live in a buffer of its own, but has been
+	passed in by the owner of the net_buffer, like the file cache pages
+	sent by sendfile(). The header only controls the lifetime of the data;
+	the data nodes referencing it are located elsewhere.
+*/
+struct external_data_header : data_header {
+	net_buffer_free_func	free_func;
+	void*					cookie;
 };
 
 struct data_node {
@@ -153,6 +166,7 @@ struct net_buffer_private : net_buffer {
 
 static object_cache* sNetBufferCache;
 static object_cache* sDataNodeCache;
+static object_cache* sExternalHeaderCache;
 
 
 static status_t append_data(net_buffer* buffer, const void* data, size_t size);
@@ -813,6 +827,7 @@ create_data_header(size_t headerSpace)
 	header->tail_space = (uint8*)header + BUFFER_SIZE - header->data_end
 		- headerSpace;
 	header->first_free = NULL;
+	header->flags = 0;
 
 	TRACE(("%ld:   create new data header %p\n", find_thread(NULL), header));
 	T2(CreateDataHeader(header));
@@ -829,6 +844,14 @@ release_data_header(data_header* header)
 		return;
 
 	TRACE(("%ld:   free header %p\n", find_thread(NULL), header));
+
+	if ((header->flags & DATA_HEADER_EXTERNAL) != 0) {
+		external_data_header* externalHeader = (external_data_header*)header;
+		externalHeader->free_func(externalHeader->cookie);
+		object_cache_free(sExternalHeaderCache, externalHeader, 0);
+		return;
+	}
+
 	free_data_header(header);
 }
 
@@ -1413,8 +1436,7 @@ merge_buffer(net_buffer* _buffer, net_buffer* _with, bool after)
 		if (node == NULL)
 			break;
 
-		if ((uint8*)node > (uint8*)node->header
-			&& (uint8*)node < (uint8*)node->header + BUFFER_SIZE) {
+		if (node->located == node->header) {
 			// The node is already in the buffer, we can just move it
 			// over to the new owner
 			list_remove_item(&with->buffers, node);
@@ -2008,6 +2030,65 @@ append_cloned_data(net_buffer* _buffer, net_buffer* _source, uint32 offset,
 }
 
 
+/*!	Appends \a bytes of \a data that is owned by the caller without copying
+	it. The data must stay valid and unchanged until \a freeFunc is called
+	with \a cookie, which happens as soon as the last buffer referencing the
+	data (including clones) is gone.
+	If this function fails, \a freeFunc is not called, and the data remains
+	with the caller.
+*/
+static status_t
+append_external_data(net_buffer* _buffer, void* data, size_t bytes,
+	net_buffer_free_func freeFunc, void* cookie)
+{
+	net_buffer_private* buffer = (net_buffer_private*)_buffer;
+
+	if (bytes == 0 || bytes > UINT16_MAX || freeFunc == NULL)
+		return B_BAD_VALUE;
+
+	ParanoiaChecker _(buffer);
+
+	external_data_header* header = (external_data_header*)object_cache_alloc(
+		sExternalHeaderCache, 0);
+	if (header == NULL)
+		return B_NO_MEMORY;
+
+	header->ref_count = 1;
+	header->physical_address = 0;
+	header->first_free = NULL;
+	header->data_end = NULL;
+	header->space.size = 0;
+	header->space.free = 0;
+	header->tail_space = 0;
+	header->flags = DATA_HEADER_EXTERNAL;
+	header->free_func = freeFunc;
+	header->cookie = cookie;
+
+	data_node* node = add_data_node(buffer, header);
+	if (node == NULL) {
+		object_cache_free(sExternalHeaderCache, header, 0);
+		return ENOBUFS;
+	}
+
+	// the node holds the only reference to the header now
+	atomic_add(&header->ref_count, -1);
+
+	node->offset = buffer->size;
+	node->start = (uint8*)data;
+	node->used = bytes;
+	node->flags = DATA_NODE_READ_ONLY;
+
+	list_add_item(&buffer->buffers, node);
+	buffer->size += bytes;
+
+	CHECK_BUFFER(buffer);
+	SET_PARANOIA_CHECK(PARANOIA_SUSPICIOUS, buffer, &buffer->size,
+		sizeof(buffer->size));
+
+	return B_OK;
+}
+
+
 void
 set_ancillary_data(net_buffer* buffer, ancillary_data_container* container)
 {
@@ -2324,6 +2405,15 @@ std_ops(int32 op, ...)
 				return B_NO_MEMORY;
 			}
 
+			sExternalHeaderCache = create_object_cache(
+				"external data header cache", sizeof(external_data_header), 8,
+				NULL, NULL, NULL);
+			if (sExternalHeaderCache == NULL) {
+				delete_object_cache(sNetBufferCache);
+				delete_object_cache(sDataNodeCache);
+				return B_NO_MEMORY;
+			}
+
 #if ENABLE_STATS
 			add_debugger_command_etc("net_buffer_stats", &dump_net_buffer_stats,
 				"Print net buffer statistics",
@@ -2345,6 +2435,7 @@ std_ops(int32 op, ...)
 #endif
 			delete_object_cache(sNetBufferCache);
 			delete_object_cache(sDataNodeCache);
+			delete_object_cache(sExternalHeaderCache);
 			return B_OK;
 
 		default:
@@ -2377,6 +2468,7 @@ net_buffer_module_info gNetBufferModule = {
 	remove_trailer,
 	trim_data,
 	append_cloned_data,
+	append_external_data,
 
 	NULL,	// associate_data
 
@@ -1460,7 +1460,7 @@ socket_send(net_socket* socket, msghdr* header, const void* data, size_t length,
 		}
 
 		size_t bufferSize = buffer->size;
-		buffer->flags = flags;
+		buffer->flags = flags & ~NET_BUFFER_CHECKSUM_FLAGS;
 		memcpy(buffer->source, &socket->address, socket->address.ss_len);
 		memcpy(buffer->destination, address, addressLength);
 		buffer->destination->sa_len = addressLength;
@@ -1489,6 +1489,81 @@ socket_send(net_socket* socket, msghdr* header, const void* data, size_t length,
 }
 
 
+/*!	Sends the data referenced by \a vecs over a connected stream socket
+	without copying it; the data is attached to the outgoing buffers as
+	external data. Each vector must not be larger than 64 KB.
+	The socket takes over all vectors, even those it could not send: once
+	the stack no longer needs the data of a vector, \a freeFunc is called
+	with the respective entry of \a cookies.
+*/
+ssize_t
+socket_send_external(net_socket* socket, const iovec* vecs,
+	void* const* cookies, uint32 count, net_buffer_free_func freeFunc,
+	int flags)
+{
+	ssize_t bytesSent = 0;
+	status_t status = B_OK;
+	uint32 index = 0;
+
+	if ((socket->first_info->flags & NET_PROTOCOL_ATOMIC_MESSAGES) != 0
+		|| socket->first_info->send_data_no_buffer != NULL) {
+		status = B_NOT_SUPPORTED;
+	} else if (socket->peer.ss_len == 0)
+		status = ENOTCONN;
+
+	while (status == B_OK && index < count) {
+		net_buffer* buffer = gNetBufferModule.create(256);
+		if (buffer == NULL) {
+			status = ENOBUFS;
+			break;
+		}
+
+		while (index < count && buffer->size < socket->send.buffer_size) {
+			status = gNetBufferModule.append_external(buffer,
+				vecs[index].iov_base, vecs[index].iov_len, freeFunc,
+				cookies[index]);
+			if (status != B_OK)
+				break;
+
+			index++;
+		}
+
+		if (status != B_OK) {
+			// the vectors already added are released with the buffer
+			gNetBufferModule.free(buffer);
+			break;
+		}
+
+		size_t bufferSize = buffer->size;
+		buffer->flags = flags & ~NET_BUFFER_CHECKSUM_FLAGS;
+		memcpy(buffer->source, &socket->address, socket->address.ss_len);
+		memcpy(buffer->destination, &socket->peer, socket->peer.ss_len);
+
+		status = socket->first_info->send_data(socket->first_protocol, buffer);
+		if (status != B_OK) {
+			size_t sizeAfterSend = buffer->size;
+			gNetBufferModule.free(buffer);
+
+			bytesSent += bufferSize - sizeAfterSend;
+			break;
+		}
+
+		bytesSent += bufferSize;
+	}
+
+	// release the vectors we did not get to
+	for (; index < count; index++)
+		freeFunc(cookies[index]);
+
+	if (status != B_OK && (bytesSent == 0
+			|| (status != B_INTERRUPTED && status != B_WOULD_BLOCK))) {
+		return status;
+	}
+
+	return bytesSent;
+}
+
+
 status_t
 socket_set_option(net_socket* socket, int level, int option, const void* value,
 	int length)
@@ -1766,6 +1841,7 @@ net_socket_module_info gNetSocketModule = {
 	socket_listen,
 	socket_receive,
 	socket_send,
+	socket_send_external,
 	socket_setsockopt,
 	socket_shutdown,
 	socket_socketpair
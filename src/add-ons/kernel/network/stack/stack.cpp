@@ -949,6 +949,7 @@ net_stack_module_info gNetStackModule = {
 	device_link_changed,
 	device_removed,
 	device_enqueue_buffer,
+	device_flow_hash,
 
 	notify_socket,
 
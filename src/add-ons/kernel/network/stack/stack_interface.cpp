@@ -161,6 +161,16 @@ stack_interface_sendmsg(net_socket* socket, const struct msghdr* message,
 }
 
 
+static ssize_t
+stack_interface_send_external(net_socket* socket, const struct iovec* vecs,
+	void* const* cookies, uint32 count, void (*freeFunc)(void* cookie),
+	int flags)
+{
+	return gNetSocketModule.send_external(socket, vecs, cookies, count,
+		freeFunc, flags);
+}
+
+
 static status_t
 stack_interface_getsockopt(net_socket* socket, int level, int option,
 	void* value, socklen_t* _length)
@@ -283,6 +293,7 @@ net_stack_interface_module_info gNetStackInterfaceModule = {
 	&stack_interface_send,
 	&stack_interface_sendto,
 	&stack_interface_sendmsg,
+	&stack_interface_send_external,
 
 	&stack_interface_getsockopt,
 	&stack_interface_setsockopt,
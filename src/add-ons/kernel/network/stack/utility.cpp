@@ -188,11 +188,30 @@ uint16
 compute_checksum(uint8* _buffer, size_t length)
 {
 	uint16* buffer = (uint16*)_buffer;
-	uint32 sum = 0;
+	uint64 sum = 0;
 
-	// TODO: unfold loop for speed
-	// TODO: write processor dependent version for speed
-	while (length >= 2) {
+	if (((addr_t)buffer & 2) != 0 && length >= 2) {
+		sum += *buffer++;
+		length -= 2;
+	}
+
+	// Add up 32 bit words - the one's complement sum is independent of the
+	// word size, as long as all carries are folded back in at the end. The
+	// 64 bit accumulator cannot overflow for any buffer of sensible size.
+	uint32* words = (uint32*)buffer;
+	while (length >= 32) {
+		sum += (uint64)words[0] + words[1] + words[2] + words[3]
+			+ words[4] + words[5] + words[6] + words[7];
+		words += 8;
+		length -= 32;
+	}
+	while (length >= 4) {
+		sum += *words++;
+		length -= 4;
+	}
+
+	buffer = (uint16*)words;
+	if (length >= 2) {
 		sum += *buffer++;
 		length -= 2;
 	}
@@ -425,6 +444,47 @@ fifo_dequeue_buffer(net_fifo* fifo, uint32 flags, bigtime_t timeout,
 }
 
 
+/*!	Dequeues up to \a maxCount buffers from the \a fifo at once, and waits at
+	most \a timeout for the first one to arrive.
+	Returns the number of buffers dequeued, or an error code.
+*/
+ssize_t
+fifo_dequeue_buffers(net_fifo* fifo, bigtime_t timeout, net_buffer** buffers,
+	size_t maxCount)
+{
+	MutexLocker locker(fifo->lock);
+
+	while (true) {
+		size_t count = 0;
+		while (count < maxCount) {
+			net_buffer* buffer
+				= (net_buffer*)list_remove_head_item(&fifo->buffers);
+			if (buffer == NULL)
+				break;
+
+			fifo->current_bytes -= buffer->size;
+			buffers[count++] = buffer;
+		}
+
+		if (count > 0)
+			return count;
+		if (timeout == 0)
+			return B_WOULD_BLOCK;
+
+		fifo->waiting++;
+		locker.Unlock();
+
+		// we need to wait until a new buffer becomes available
+		status_t status = acquire_sem_etc(fifo->notify, 1,
+			B_CAN_INTERRUPT | B_RELATIVE_TIMEOUT, timeout);
+		if (status < B_OK)
+			return status;
+
+		locker.Lock();
+	}
+}
+
+
 status_t
 clear_fifo(net_fifo* fifo)
 {
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2026, Haiku Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <sys/sendfile.h>
+
+#include <errno.h>
+#include <pthread.h>
+
+#include <syscall_utils.h>
+#include <syscalls.h>
+
+
+/*!	Sends \a count bytes of the file \a fd to the connected stream socket
+	\a socket. If \a offset is \c NULL, the data is read from the current file
+	position, which is advanced accordingly; otherwise it is read from
+	\a *offset, which is updated instead, and the file position is left alone.
+	Regular files are sent directly out of the file cache, without copying
+	the data.
+*/
+ssize_t
+sendfile(int socket, int fd, off_t* offset, size_t count)
+{
+	RETURN_AND_SET_ERRNO_TEST_CANCEL(_kern_sendfile(socket, fd, offset, count));
+}
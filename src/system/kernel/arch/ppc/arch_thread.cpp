@@ -255,3 +255,10 @@ arch_restore_fork_frame(struct arch_fork_arg *arg)
 {
 }
 
+
+bool
+arch_thread_abort_user_sequence(addr_t start, addr_t end, addr_t abortAddress)
+{
+	// restartable sequences are not supported yet
+	return false;
+}
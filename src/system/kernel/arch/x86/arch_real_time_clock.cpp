@@ -12,6 +12,7 @@
 
 #include <real_time_clock.h>
 #include <real_time_data.h>
+#include <util/AutoLock.h>
 
 
 #define CMOS_ADDR_PORT 0x70
@@ -28,6 +29,9 @@ typedef struct	{
 } cmos_time;
 
 
+static spinlock sSystemTimeOffsetLock = B_SPINLOCK_INITIALIZER;
+
+
 static uint32
 bcd_to_int(uint8 bcd)
 {
@@ -221,7 +225,13 @@ arch_rtc_set_hw_time(uint32 seconds)
 void
 arch_rtc_set_system_time_offset(struct real_time_data *data, bigtime_t offset)
 {
+	InterruptsSpinLocker locker(sSystemTimeOffsetLock);
+
+	// Userland can't use atomic_get64() on the read-only commpage; it retries
+	// reading the offset while the version is odd or has changed instead.
+	atomic_add(&data->arch_data.version, 1);
 	atomic_set64(&data->arch_data.system_time_offset, offset);
+	atomic_add(&data->arch_data.version, 1);
 }
 
 
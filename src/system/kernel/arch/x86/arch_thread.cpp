@@ -298,3 +298,20 @@ arch_restore_fork_frame(struct arch_fork_arg* arg)
 {
 	x86_initial_return_to_userland(thread_get_current_thread(), &arg->iframe);
 }
+
+
+/*!	Lets the current thread continue at \a abortAddress when it returns to
+	userland, if it has been interrupted between \a start and \a end.
+*/
+bool
+arch_thread_abort_user_sequence(addr_t start, addr_t end, addr_t abortAddress)
+{
+	struct iframe* frame = x86_get_user_iframe();
+	if (frame == NULL || frame->ip < start || frame->ip >= end
+		|| !IS_USER_ADDRESS(abortAddress)) {
+		return false;
+	}
+
+	frame->ip = abortAddress;
+	return true;
+}
@@ -75,6 +75,8 @@ public:
 	status_t	MemcpyToPhysical(phys_addr_t to, const void* from,
 					size_t length, bool user) override;
 	void		MemcpyPhysicalPage(phys_addr_t to, phys_addr_t from) override;
+	void		ClearPhysicalPage(phys_addr_t address, bool nonTemporal)
+					override;
 };
 
 
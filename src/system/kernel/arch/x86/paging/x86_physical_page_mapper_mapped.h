@@ -192,6 +192,18 @@ X86PhysicalPageMapper::MemcpyPhysicalPage(phys_addr_t to,
 }
 
 
+inline void
+X86PhysicalPageMapper::ClearPhysicalPage(phys_addr_t address,
+	bool nonTemporal)
+{
+	void* page = (void*)(address + KERNEL_PMAP_BASE);
+	if (nonTemporal)
+		x86_clear_page_nontemporal(page);
+	else
+		gX86ClearPageFunc(page);
+}
+
+
 status_t mapped_physical_page_ops_init(kernel_args* args,
 	X86PhysicalPageMapper*& _pageMapper,
 	TranslationMapPhysicalPageMapper*& _kernelPageMapper);
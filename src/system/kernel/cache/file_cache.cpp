@@ -1037,6 +1037,112 @@ cache_prefetch(dev_t mountID, ino_t vnodeID, off_t offset, size_t size)
 }
 
 
+/*!	Wires the pages of the file cache of \a vnode that contain the \a *_size
+	bytes at \a offset, but no more than \a maxPages pages. Pages that are
+	not in the cache yet are read in first.
+	On return, \a *_size is set to the number of bytes starting at \a offset
+	that are covered by the wired pages, it never extends beyond the end of
+	the file, and \a *_cache is set to the file's cache. Each page also holds
+	a reference to the cache, and has to be released with
+	file_cache_unwire_page() again.
+	Wired pages cannot be stolen, and thus allow someone else (like the
+	network stack for sendfile()) to access the cached data without copying
+	it. If the file is truncated in the meantime, VMCache::Resize() removes
+	the pages from the cache, but leaves them to file_cache_unwire_page() to
+	free.
+*/
+extern "C" status_t
+file_cache_wire_pages(struct vnode* vnode, void* cookie, off_t offset,
+	size_t* _size, vm_page** pages, uint32 maxPages, VMCache** _cache)
+{
+	VMCache* cache;
+	status_t status = vfs_get_vnode_cache(vnode, &cache, false);
+	if (status != B_OK)
+		return status;
+
+	file_cache_ref* ref = ((VMVnodeCache*)cache)->FileCacheRef();
+	if (ref == NULL || ref->disabled_count > 0) {
+		cache->ReleaseRef();
+		return B_NOT_SUPPORTED;
+	}
+
+	int32 pageOffset = offset & (B_PAGE_SIZE - 1);
+	off_t pageStart = offset - pageOffset;
+	size_t size = min_c(*_size, maxPages * B_PAGE_SIZE - pageOffset);
+
+	// make sure the pages are in the cache -- cache_io() leaves the pages
+	// alone that are already there
+	size_t bytesRead = size;
+	status = cache_io(ref, cookie, offset, 0, &bytesRead, false);
+	if (status != B_OK) {
+		cache->ReleaseRef();
+		return status;
+	}
+
+	cache->Lock();
+
+	off_t fileSize = cache->virtual_end;
+	if (offset >= fileSize)
+		size = 0;
+	else if (offset + (off_t)size > fileSize)
+		size = fileSize - offset;
+
+	uint32 count = 0;
+	size_t wiredSize = 0;
+	while (wiredSize < size) {
+		vm_page* page = cache->LookupPage(
+			pageStart + (off_t)count * B_PAGE_SIZE);
+		if (page != NULL && page->busy) {
+			cache->WaitForPageEvents(page, PAGE_EVENT_NOT_BUSY, true);
+			continue;
+		}
+		if (page == NULL) {
+			// the page has been stolen in the meantime
+			break;
+		}
+
+		if (!page->IsMapped())
+			atomic_add(&gMappedPagesCount, 1);
+		page->IncrementWiredCount();
+		cache->AcquireRefLocked();
+
+		pages[count++] = page;
+		wiredSize = min_c(count * B_PAGE_SIZE - pageOffset, size);
+	}
+
+	cache->ReleaseRefAndUnlock();
+
+	if (count == 0 && size > 0)
+		return B_BUSY;
+
+	*_size = wiredSize;
+	*_cache = cache;
+	return B_OK;
+}
+
+
+/*!	Releases a page of \a cache previously wired by file_cache_wire_pages().
+*/
+extern "C" void
+file_cache_unwire_page(VMCache* cache, vm_page* page)
+{
+	cache->Lock();
+
+	if (page->Cache() != cache) {
+		// the file has been truncated while the page was wired
+		cache->ReleaseRefAndUnlock();
+		vm_cache_unwire_removed_page(page);
+		return;
+	}
+
+	page->DecrementWiredCount();
+	if (!page->IsMapped())
+		atomic_add(&gMappedPagesCount, -1);
+
+	cache->ReleaseRefAndUnlock();
+}
+
+
 extern "C" void
 cache_node_opened(struct vnode* vnode, int32 fdType, VMCache* cache,
 	dev_t mountID, ino_t parentID, ino_t vnodeID, const char* name)
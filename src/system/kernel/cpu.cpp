@@ -19,6 +19,8 @@
 #include <cpuidle.h>
 
 #include <boot/kernel_args.h>
+#include <commpage.h>
+#include <cpu_data.h>
 #include <kscheduler.h>
 #include <thread_types.h>
 #include <util/AutoLock.h>
@@ -35,6 +37,8 @@ static cpuidle_module_info* sCPUIdleModule;
 
 static spinlock sSetCpuLock;
 
+static cpu_data* sCPUData;
+
 
 status_t
 cpu_init(kernel_args *args)
@@ -57,6 +61,20 @@ cpu_init_post_vm(kernel_args *args)
 }
 
 
+/*!	Publishes the CPU count in the commpage. Must be called after smp_init(),
+	and before the first team is created.
+*/
+status_t
+cpu_init_post_smp(kernel_args *args)
+{
+	sCPUData = (cpu_data*)allocate_commpage_entry(COMMPAGE_ENTRY_CPU_DATA,
+		sizeof(cpu_data));
+	sCPUData->cpu_count = smp_get_num_cpus();
+	sCPUData->enabled_cpu_count = smp_get_num_cpus();
+	return B_OK;
+}
+
+
 static void
 load_cpufreq_module()
 {
@@ -388,8 +406,10 @@ _user_set_cpu_enabled(int32 cpu, bool enabled)
 
 	bool oldState = gCPU[cpu].disabled;
 
-	if (oldState != !enabled)
+	if (oldState != !enabled) {
 		scheduler_set_cpu_enabled(cpu, enabled);
+		atomic_add(&sCPUData->enabled_cpu_count, enabled ? 1 : -1);
+	}
 
 	if (!enabled) {
 		if (smp_get_current_cpu() == cpu) {
@@ -0,0 +1,748 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Event queues keep objects selected between calls, so that waiting for
+	events does not have to select and deselect every object each time as
+	wait_for_objects(), select(), and poll() do. Objects are added to the
+	ready list when notified, and the waiting thread only has to look at
+	those.
+
+	Every object in a queue has its own select_sync, a select_event, so that
+	it can be freed independently of the queue once the object released its
+	reference -- which might happen after it has been removed from the queue,
+	for example when an FD is closed concurrently.
+*/
+
+
+#include <event_queue.h>
+
+#include <new>
+
+#include <fcntl.h>
+#include <stdlib.h>
+
+#include <OS.h>
+
+#include <condition_variable.h>
+#include <fs/fd.h>
+#include <kernel.h>
+#include <lock.h>
+#include <syscall_restart.h>
+#include <syscalls.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+#include <util/DoublyLinkedList.h>
+#include <util/KernelReferenceable.h>
+#include <util/OpenHashTable.h>
+#include <wait_for_objects.h>
+
+
+// the number of infos copied from/to userland at once
+static const int kMaxInfosPerCopy = 32;
+
+// events that are always reported
+static const uint16 kAlwaysSelectedEvents
+	= B_EVENT_INVALID | B_EVENT_ERROR | B_EVENT_DISCONNECTED;
+
+
+class EventQueue;
+
+
+struct select_event : select_sync, DoublyLinkedListLinkImpl<select_event> {
+								select_event(EventQueue* queue, int32 object,
+									uint16 type);
+	virtual						~select_event();
+
+	virtual	status_t			Notify(select_info* info, uint16 events);
+
+			select_info			info;
+			EventQueue*			queue;
+			select_event*		hash_link;
+			int32				object;
+			uint16				type;
+			uint32				behavior;
+			void*				user_data;
+
+			// protected by the queue lock
+			bool				queued;
+			bool				removed;
+			bool				invalid;
+
+			// protected by the queue mutex
+			bool				selected;
+};
+
+
+struct EventKey {
+	int32	object;
+	uint16	type;
+};
+
+
+struct EventHashDefinition {
+	typedef EventKey		KeyType;
+	typedef select_event	ValueType;
+
+	size_t HashKey(const EventKey& key) const
+	{
+		return (size_t)key.object ^ ((size_t)key.type << 24);
+	}
+
+	size_t Hash(select_event* value) const
+	{
+		return (size_t)value->object ^ ((size_t)value->type << 24);
+	}
+
+	bool Compare(const EventKey& key, select_event* value) const
+	{
+		return value->object == key.object && value->type == key.type;
+	}
+
+	select_event*& GetLink(select_event* value) const
+	{
+		return value->hash_link;
+	}
+};
+
+
+typedef BOpenHashTable<EventHashDefinition> EventTable;
+typedef DoublyLinkedList<select_event> EventList;
+
+
+class EventQueue : public KernelReferenceable {
+public:
+								EventQueue(bool kernel);
+	virtual						~EventQueue();
+
+			status_t			Init();
+
+			void				Close();
+			void				RemoveAll();
+
+			status_t			Select(int32 object, uint16 type,
+									int32 events, void* userData);
+			status_t			Deselect(int32 object, uint16 type);
+
+			ssize_t				Wait(event_wait_info* infos, int numInfos,
+									uint32 flags, bigtime_t timeout);
+
+			void				Notify(select_event* event, uint16 events);
+
+private:
+			status_t			_SelectEvent(select_event* event);
+			void				_DeselectEvent(select_event* event);
+			void				_RemoveEvent(select_event* event);
+			void				_Dequeued(select_event* event,
+									uint16 events);
+			int					_DequeueEvents(event_wait_info* infos,
+									int numInfos);
+
+private:
+			mutex				fLock;
+			spinlock			fQueueLock;
+			ConditionVariable	fQueueCondition;
+			EventTable			fEvents;
+			EventList			fQueue;
+			bool				fKernel;
+			bool				fClosed;
+};
+
+
+select_event::select_event(EventQueue* queue, int32 object, uint16 type)
+	:
+	queue(queue),
+	hash_link(NULL),
+	object(object),
+	type(type),
+	behavior(0),
+	user_data(NULL),
+	queued(false),
+	removed(false),
+	invalid(false),
+	selected(false)
+{
+	info.next = NULL;
+	info.sync = this;
+	info.events = 0;
+	info.selected_events = 0;
+
+	queue->AcquireReference();
+}
+
+
+select_event::~select_event()
+{
+	queue->ReleaseReference();
+}
+
+
+status_t
+select_event::Notify(select_info* info, uint16 events)
+{
+	queue->Notify(this, events);
+	return B_OK;
+}
+
+
+//	#pragma mark - EventQueue
+
+
+EventQueue::EventQueue(bool kernel)
+	:
+	fKernel(kernel),
+	fClosed(false)
+{
+	mutex_init(&fLock, "event queue");
+	B_INITIALIZE_SPINLOCK(&fQueueLock);
+	fQueueCondition.Init(this, "event queue");
+}
+
+
+EventQueue::~EventQueue()
+{
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+EventQueue::Init()
+{
+	return fEvents.Init();
+}
+
+
+/*!	Wakes up all waiting threads; the queue cannot be waited on anymore. */
+void
+EventQueue::Close()
+{
+	InterruptsSpinLocker locker(fQueueLock);
+	fClosed = true;
+	fQueueCondition.NotifyAll(B_FILE_ERROR);
+}
+
+
+/*!	Removes all objects from the queue. Called when the queue's descriptor is
+	freed.
+*/
+void
+EventQueue::RemoveAll()
+{
+	MutexLocker locker(fLock);
+
+	select_event* event = fEvents.Clear(true);
+	while (event != NULL) {
+		select_event* next = event->hash_link;
+		_RemoveEvent(event);
+		event = next;
+	}
+}
+
+
+/*!	Adds the object to the queue, or updates the events and user data of an
+	object that is already in it. If \a events is 0, the object is removed.
+*/
+status_t
+EventQueue::Select(int32 object, uint16 type, int32 events, void* userData)
+{
+	if (events == 0)
+		return Deselect(object, type);
+	if (events < 0 || (events & ~(0xffff | B_EVENT_QUEUE_FLAGS_MASK)) != 0)
+		return B_BAD_VALUE;
+
+	MutexLocker locker(fLock);
+
+	EventKey key = { object, type };
+	select_event* event = fEvents.Lookup(key);
+	if (event != NULL) {
+		// modify the existing selection
+		_DeselectEvent(event);
+	} else {
+		event = new(std::nothrow) select_event(this, object, type);
+		if (event == NULL)
+			return B_NO_MEMORY;
+
+		fEvents.InsertUnchecked(event);
+	}
+
+	event->behavior = events & B_EVENT_QUEUE_FLAGS_MASK;
+	event->user_data = userData;
+	event->info.selected_events = (events & 0xffff) | kAlwaysSelectedEvents;
+
+	status_t status = _SelectEvent(event);
+	if (status != B_OK) {
+		fEvents.RemoveUnchecked(event);
+		_RemoveEvent(event);
+	}
+
+	return status;
+}
+
+
+status_t
+EventQueue::Deselect(int32 object, uint16 type)
+{
+	MutexLocker locker(fLock);
+
+	EventKey key = { object, type };
+	select_event* event = fEvents.Lookup(key);
+	if (event == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	fEvents.RemoveUnchecked(event);
+	_RemoveEvent(event);
+
+	return B_OK;
+}
+
+
+/*!	Waits until events are pending, and harvests up to \a numInfos of them.
+	\a timeout must be absolute, unless it is a relative timeout of 0.
+*/
+ssize_t
+EventQueue::Wait(event_wait_info* infos, int numInfos, uint32 flags,
+	bigtime_t timeout)
+{
+	while (true) {
+		InterruptsSpinLocker queueLocker(fQueueLock);
+
+		if (fClosed)
+			return B_FILE_ERROR;
+
+		if (fQueue.IsEmpty()) {
+			if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout <= 0)
+				return B_WOULD_BLOCK;
+
+			ConditionVariableEntry entry;
+			fQueueCondition.Add(&entry);
+			queueLocker.Unlock();
+
+			status_t status = entry.Wait(B_CAN_INTERRUPT | flags, timeout);
+			if (status != B_OK)
+				return status;
+
+			continue;
+		}
+
+		queueLocker.Unlock();
+
+		// Another thread might have harvested the events in the meantime.
+		MutexLocker locker(fLock);
+		int count = _DequeueEvents(infos, numInfos);
+		if (count > 0)
+			return count;
+	}
+}
+
+
+/*!	Called by the select_event whenever its object is notified. This might
+	happen in any context, including with interrupts disabled.
+*/
+void
+EventQueue::Notify(select_event* event, uint16 events)
+{
+	InterruptsSpinLocker locker(fQueueLock);
+
+	if (event->removed)
+		return;
+
+	event->info.events |= events;
+	if ((events & B_EVENT_INVALID) != 0)
+		event->invalid = true;
+
+	if ((events & event->info.selected_events) == 0 || event->queued)
+		return;
+
+	fQueue.Add(event);
+	event->queued = true;
+
+	fQueueCondition.NotifyOne();
+}
+
+
+/*!	The queue mutex must be held. */
+status_t
+EventQueue::_SelectEvent(select_event* event)
+{
+	status_t status = select_object(event->type, event->object, &event->info,
+		fKernel);
+	if (status != B_OK)
+		return status;
+
+	event->selected = true;
+	return B_OK;
+}
+
+
+/*!	The queue mutex must be held. */
+void
+EventQueue::_DeselectEvent(select_event* event)
+{
+	// Objects that became invalid already dropped the info, and might
+	// even have been replaced by another one with the same ID.
+	if (event->selected && !event->invalid) {
+		deselect_object(event->type, event->object, &event->info,
+			fKernel);
+	}
+
+	event->selected = false;
+
+	InterruptsSpinLocker locker(fQueueLock);
+	if (event->queued) {
+		fQueue.Remove(event);
+		event->queued = false;
+	}
+	event->info.events = 0;
+	event->invalid = false;
+}
+
+
+/*!	Deselects the event and releases the queue's reference to it. The event
+	must already have been removed from the table, and the queue mutex must
+	be held.
+*/
+void
+EventQueue::_RemoveEvent(select_event* event)
+{
+	{
+		InterruptsSpinLocker locker(fQueueLock);
+		event->removed = true;
+	}
+
+	_DeselectEvent(event);
+	put_select_sync(event);
+}
+
+
+/*!	Handles an event after its \a events have been reported. The queue
+	mutex must be held.
+*/
+void
+EventQueue::_Dequeued(select_event* event, uint16 events)
+{
+	if (event->invalid) {
+		// the object is gone, there is no need to keep it around
+		fEvents.RemoveUnchecked(event);
+		_RemoveEvent(event);
+		return;
+	}
+
+	if ((event->behavior & B_EVENT_ONE_SHOT) != 0) {
+		_DeselectEvent(event);
+		return;
+	}
+
+	if ((event->behavior & B_EVENT_LEVEL_TRIGGERED) != 0) {
+		// Selecting the reported events again notifies us right away, if
+		// their condition still holds. FDs can do that in place; the other
+		// object types have to be deselected first.
+		status_t status;
+		if (event->type == B_OBJECT_TYPE_FD) {
+			status = reselect_fd(event->object, &event->info, events,
+				fKernel);
+		} else {
+			_DeselectEvent(event);
+			status = _SelectEvent(event);
+		}
+
+		if (status != B_OK)
+			Notify(event, B_EVENT_INVALID);
+	}
+}
+
+
+/*!	The queue mutex must be held. */
+int
+EventQueue::_DequeueEvents(event_wait_info* infos, int numInfos)
+{
+	int count = 0;
+
+	InterruptsSpinLocker queueLocker(fQueueLock);
+
+	while (count < numInfos) {
+		select_event* event = fQueue.RemoveHead();
+		if (event == NULL)
+			break;
+
+		event->queued = false;
+
+		infos[count].object = event->object;
+		infos[count].type = event->type;
+		infos[count].events = event->info.events
+			& event->info.selected_events;
+		infos[count].user_data = event->user_data;
+		count++;
+
+		event->info.events = 0;
+	}
+
+	queueLocker.Unlock();
+
+	for (int i = 0; i < count; i++) {
+		EventKey key = { infos[i].object, infos[i].type };
+		select_event* event = fEvents.Lookup(key);
+		if (event != NULL)
+			_Dequeued(event, infos[i].events);
+	}
+
+	return count;
+}
+
+
+//	#pragma mark - file descriptor
+
+
+static status_t
+event_queue_close(struct file_descriptor* descriptor)
+{
+	((EventQueue*)descriptor->cookie)->Close();
+	return B_OK;
+}
+
+
+static void
+event_queue_free(struct file_descriptor* descriptor)
+{
+	EventQueue* queue = (EventQueue*)descriptor->cookie;
+	queue->RemoveAll();
+	queue->ReleaseReference();
+}
+
+
+static struct fd_ops sEventQueueFDOps = {
+	NULL,	// fd_read
+	NULL,	// fd_write
+	NULL,	// fd_seek
+	NULL,	// fd_ioctl
+	NULL,	// fd_set_flags
+	NULL,	// fd_select
+	NULL,	// fd_deselect
+	NULL,	// fd_read_dir
+	NULL,	// fd_rewind_dir
+	NULL,	// fd_read_stat
+	NULL,	// fd_write_stat
+	&event_queue_close,
+	&event_queue_free
+};
+
+
+static status_t
+get_event_queue_descriptor(int fd, bool kernel,
+	file_descriptor*& descriptor)
+{
+	if (fd < 0)
+		return B_FILE_ERROR;
+
+	descriptor = get_fd(get_current_io_context(kernel), fd);
+	if (descriptor == NULL)
+		return B_FILE_ERROR;
+
+	if (descriptor->type != FDTYPE_EVENT_QUEUE) {
+		put_fd(descriptor);
+		return B_BAD_VALUE;
+	}
+
+	return B_OK;
+}
+
+
+static int
+create_event_queue(int openFlags, bool kernel)
+{
+	if ((openFlags & ~O_CLOEXEC) != 0)
+		return B_BAD_VALUE;
+
+	EventQueue* queue = new(std::nothrow) EventQueue(kernel);
+	if (queue == NULL)
+		return B_NO_MEMORY;
+	BReference<EventQueue> queueReference(queue, true);
+
+	status_t status = queue->Init();
+	if (status != B_OK)
+		return status;
+
+	file_descriptor* descriptor = alloc_fd();
+	if (descriptor == NULL)
+		return B_NO_MEMORY;
+
+	descriptor->type = FDTYPE_EVENT_QUEUE;
+	descriptor->ops = &sEventQueueFDOps;
+	descriptor->cookie = queue;
+	descriptor->open_mode = O_RDWR;
+
+	io_context* context = get_current_io_context(kernel);
+	int fd = new_fd(context, descriptor);
+	if (fd < 0) {
+		free(descriptor);
+		return B_NO_MORE_FDS;
+	}
+
+	// the descriptor owns the reference now
+	queueReference.Detach();
+
+	mutex_lock(&context->io_mutex);
+	fd_set_close_on_exec(context, fd, (openFlags & O_CLOEXEC) != 0);
+	mutex_unlock(&context->io_mutex);
+
+	return fd;
+}
+
+
+//	#pragma mark - Kernel calls
+
+
+int
+_kern_event_queue_create(int openFlags)
+{
+	return create_event_queue(openFlags, true);
+}
+
+
+status_t
+_kern_event_queue_select(int queueFD, event_wait_info* infos, int numInfos)
+{
+	if (numInfos < 0)
+		return B_BAD_VALUE;
+
+	file_descriptor* descriptor;
+	status_t status = get_event_queue_descriptor(queueFD, true, descriptor);
+	if (status != B_OK)
+		return status;
+	FileDescriptorPutter _(descriptor);
+
+	EventQueue* queue = (EventQueue*)descriptor->cookie;
+
+	status_t result = B_OK;
+	for (int i = 0; i < numInfos; i++) {
+		status = queue->Select(infos[i].object, infos[i].type,
+			infos[i].events, infos[i].user_data);
+		if (status != B_OK) {
+			infos[i].events = status;
+			if (result == B_OK)
+				result = status;
+		}
+	}
+
+	return result;
+}
+
+
+ssize_t
+_kern_event_queue_wait(int queueFD, event_wait_info* infos, int numInfos,
+	uint32 flags, bigtime_t timeout)
+{
+	if (numInfos <= 0)
+		return B_BAD_VALUE;
+
+	file_descriptor* descriptor;
+	status_t status = get_event_queue_descriptor(queueFD, true, descriptor);
+	if (status != B_OK)
+		return status;
+	FileDescriptorPutter _(descriptor);
+
+	if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout > 0) {
+		timeout += system_time();
+		if (timeout < 0)
+			timeout = B_INFINITE_TIMEOUT;
+		flags = (flags & ~B_RELATIVE_TIMEOUT) | B_ABSOLUTE_TIMEOUT;
+	}
+
+	return ((EventQueue*)descriptor->cookie)->Wait(infos, numInfos, flags,
+		timeout);
+}
+
+
+//	#pragma mark - User syscalls
+
+
+int
+_user_event_queue_create(int openFlags)
+{
+	return create_event_queue(openFlags, false);
+}
+
+
+status_t
+_user_event_queue_select(int queueFD, event_wait_info* userInfos,
+	int numInfos)
+{
+	if (numInfos < 0)
+		return B_BAD_VALUE;
+	if (numInfos > 0
+		&& (userInfos == NULL || !IS_USER_ADDRESS(userInfos)))
+		return B_BAD_ADDRESS;
+
+	file_descriptor* descriptor;
+	status_t status = get_event_queue_descriptor(queueFD, false, descriptor);
+	if (status != B_OK)
+		return status;
+	FileDescriptorPutter _(descriptor);
+
+	EventQueue* queue = (EventQueue*)descriptor->cookie;
+
+	status_t result = B_OK;
+	event_wait_info infos[kMaxInfosPerCopy];
+
+	for (int offset = 0; offset < numInfos; offset += kMaxInfosPerCopy) {
+		int count = min_c(numInfos - offset, kMaxInfosPerCopy);
+		size_t bytes = sizeof(event_wait_info) * count;
+		if (user_memcpy(infos, userInfos + offset, bytes) != B_OK)
+			return B_BAD_ADDRESS;
+
+		bool failed = false;
+		for (int i = 0; i < count; i++) {
+			status = queue->Select(infos[i].object, infos[i].type,
+				infos[i].events, infos[i].user_data);
+			if (status != B_OK) {
+				infos[i].events = status;
+				failed = true;
+				if (result == B_OK)
+					result = status;
+			}
+		}
+
+		// report the errors back
+		if (failed && user_memcpy(userInfos + offset, infos, bytes) != B_OK)
+			return B_BAD_ADDRESS;
+	}
+
+	return result;
+}
+
+
+ssize_t
+_user_event_queue_wait(int queueFD, event_wait_info* userInfos, int numInfos,
+	uint32 flags, bigtime_t timeout)
+{
+	syscall_restart_handle_timeout_pre(flags, timeout);
+
+	if (numInfos <= 0)
+		return B_BAD_VALUE;
+	if (userInfos == NULL || !IS_USER_ADDRESS(userInfos))
+		return B_BAD_ADDRESS;
+
+	file_descriptor* descriptor;
+	status_t status = get_event_queue_descriptor(queueFD, false, descriptor);
+	if (status != B_OK)
+		return status;
+	FileDescriptorPutter _(descriptor);
+
+	if (numInfos > kMaxInfosPerCopy)
+		numInfos = kMaxInfosPerCopy;
+
+	event_wait_info infos[kMaxInfosPerCopy];
+	ssize_t result = ((EventQueue*)descriptor->cookie)->Wait(infos, numInfos,
+		flags, timeout);
+
+	if (result > 0) {
+		if (user_memcpy(userInfos, infos, sizeof(event_wait_info) * result)
+				!= B_OK) {
+			return B_BAD_ADDRESS;
+		}
+	} else
+		syscall_restart_handle_timeout_post(result, timeout);
+
+	return result;
+}
@@ -40,8 +40,6 @@ static const size_t kMaxReadDirBufferSize = 64 * 1024;
 static struct file_descriptor* get_fd_locked(struct io_context* context,
 	int fd);
 static struct file_descriptor* remove_fd(struct io_context* context, int fd);
-static void deselect_select_infos(file_descriptor* descriptor,
-	select_info* infos, bool putSyncObjects);
 
 
 struct FDGetterLocking {
@@ -407,7 +405,7 @@ dup_fd(int fd, bool kernel)
 
 	We do dup2() directly to be thread-safe.
 */
-static int
+int
 dup2_fd(int oldfd, int newfd, bool kernel)
 {
 	struct file_descriptor* evicted = NULL;
@@ -524,7 +522,7 @@ fd_ioctl(bool kernelFD, int fd, uint32 op, void* buffer, size_t length)
 }
 
 
-static void
+void
 deselect_select_infos(file_descriptor* descriptor, select_info* infos,
 	bool putSyncObjects)
 {
@@ -676,6 +674,72 @@ deselect_fd(int32 fd, struct select_info* info, bool kernel)
 }
 
 
+/*!	Asks the FD's select hook again for the given \a events of \a info,
+	which must already be selected, so that the info is notified right away
+	if their condition still holds. Unlike deselect_fd() followed by
+	select_fd(), this leaves the info registered with the FD.
+*/
+status_t
+reselect_fd(int32 fd, struct select_info* info, uint16 events, bool kernel)
+{
+	FDGetter fdGetter;
+		// define before the context locker, so it will be destroyed after it
+
+	io_context* context = get_current_io_context(kernel);
+	MutexLocker locker(context->io_mutex);
+
+	struct file_descriptor* descriptor = fdGetter.SetTo(context, fd, true);
+	if (descriptor == NULL)
+		return B_FILE_ERROR;
+
+	// the info must still be registered with this descriptor
+	select_info* selectedInfo = context->select_infos[fd];
+	while (selectedInfo != NULL && selectedInfo != info)
+		selectedInfo = selectedInfo->next;
+	if (selectedInfo == NULL)
+		return B_FILE_ERROR;
+
+	events &= info->selected_events & ~B_EVENT_INVALID;
+	if (events == 0)
+		return B_OK;
+
+	if (descriptor->ops->fd_select == NULL)
+		return notify_select_events(info, events);
+
+	// keep the FD open while we're calling the hooks, as in select_fd()
+	atomic_add(&descriptor->open_count, 1);
+
+	locker.Unlock();
+
+	for (uint16 event = 1; event < 16; event++) {
+		if ((events & SELECT_FLAG(event)) != 0)
+			descriptor->ops->fd_select(descriptor, event, (selectsync*)info);
+	}
+
+	locker.Lock();
+	if (context->fds[fd] != descriptor) {
+		// Someone close()d the index in the meantime, and might have
+		// deselected the info before we selected the events again.
+		if (descriptor->ops->fd_deselect != NULL) {
+			for (uint16 event = 1; event < 16; event++) {
+				if ((events & SELECT_FLAG(event)) != 0) {
+					descriptor->ops->fd_deselect(descriptor, event,
+						(selectsync*)info);
+				}
+			}
+		}
+
+		// Release our open reference of the descriptor.
+		close_fd(descriptor);
+		return B_FILE_ERROR;
+	}
+
+	atomic_add(&descriptor->open_count, -1);
+
+	return B_OK;
+}
+
+
 /*!	This function checks if the specified fd is valid in the current
 	context. It can be used for a quick check; the fd is not locked
 	so it could become invalid immediately after this check.
@@ -745,8 +809,7 @@ common_user_io(int fd, off_t pos, void* buffer, size_t length, bool write)
 		return B_BAD_VALUE;
 	}
 
-	SyscallRestartWrapper<status_t> status;
-
+	status_t status;
 	if (write)
 		status = descriptor->ops->fd_write(descriptor, pos, buffer, &length);
 	else
@@ -805,8 +868,7 @@ common_user_vector_io(int fd, off_t pos, const iovec* userVecs, size_t count,
 		return B_BAD_VALUE;
 	}
 
-	SyscallRestartWrapper<status_t> status;
-
+	status_t status;
 	ssize_t bytesTransferred = 0;
 	for (uint32 i = 0; i < count; i++) {
 		size_t length = vecs[i].iov_len;
@@ -852,34 +914,58 @@ user_fd_kernel_ioctl(int fd, uint32 op, void* buffer, size_t length)
 }
 
 
+/*!	Reads from or writes to the current team's \a fd like read() and write()
+	do, but for kernel threads acting on behalf of the team: \a buffer is a
+	userland buffer, but there is no syscall to restart.
+*/
+ssize_t
+user_fd_kernel_io(int fd, off_t pos, void* buffer, size_t length, bool write)
+{
+	return common_user_io(fd, pos, buffer, length, write);
+}
+
+
+/*!	The vector version of user_fd_kernel_io(). */
+ssize_t
+user_fd_kernel_vector_io(int fd, off_t pos, const iovec* vecs, size_t count,
+	bool write)
+{
+	return common_user_vector_io(fd, pos, vecs, count, write);
+}
+
+
 //	#pragma mark - User syscalls
 
 
 ssize_t
 _user_read(int fd, off_t pos, void* buffer, size_t length)
 {
-	return common_user_io(fd, pos, buffer, length, false);
+	SyscallRestartWrapper<ssize_t> result;
+	return result = common_user_io(fd, pos, buffer, length, false);
 }
 
 
 ssize_t
 _user_readv(int fd, off_t pos, const iovec* userVecs, size_t count)
 {
-	return common_user_vector_io(fd, pos, userVecs, count, false);
+	SyscallRestartWrapper<ssize_t> result;
+	return result = common_user_vector_io(fd, pos, userVecs, count, false);
 }
 
 
 ssize_t
 _user_write(int fd, off_t pos, const void* buffer, size_t length)
 {
-	return common_user_io(fd, pos, (void*)buffer, length, true);
+	SyscallRestartWrapper<ssize_t> result;
+	return result = common_user_io(fd, pos, (void*)buffer, length, true);
 }
 
 
 ssize_t
 _user_writev(int fd, off_t pos, const iovec* userVecs, size_t count)
 {
-	return common_user_vector_io(fd, pos, userVecs, count, true);
+	SyscallRestartWrapper<ssize_t> result;
+	return result = common_user_vector_io(fd, pos, userVecs, count, true);
 }
 
 
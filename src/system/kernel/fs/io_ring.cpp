@@ -0,0 +1,567 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Asynchronous I/O rings.
+
+	The submission and completion queues live in an area that is shared
+	with the team (see io_ring_defs.h). Submitted requests are executed by a
+	small pool of worker threads, which are kernel threads that belong to
+	the team that created the ring, so that they see its FDs and address
+	space. They use the same implementation as the syscalls, but through the
+	kernel entry points for userland FDs, as they aren't in a syscall.
+	A ring is bound to its team, and is not inherited by forked teams.
+*/
+
+
+#include <fs/io_ring.h>
+
+#include <new>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <OS.h>
+
+#include <condition_variable.h>
+#include <fs/fd.h>
+#include <kernel.h>
+#include <ksignal.h>
+#include <lock.h>
+#include <syscall_restart.h>
+#include <team.h>
+#include <thread.h>
+#include <util/AutoLock.h>
+#include <util/DoublyLinkedList.h>
+#include <util/KernelReferenceable.h>
+#include <vfs.h>
+#include <vm/vm.h>
+
+
+//#define TRACE_IO_RING
+#ifdef TRACE_IO_RING
+#	define TRACE(x...) dprintf("io_ring: " x)
+#else
+#	define TRACE(x...) ;
+#endif
+
+
+static const int32 kMaxWorkers = 16;
+
+
+struct io_ring_request : DoublyLinkedListLinkImpl<io_ring_request> {
+	io_ring_sqe	sqe;
+};
+
+typedef DoublyLinkedList<io_ring_request> RequestList;
+
+
+class IORing : public KernelReferenceable {
+public:
+								IORing();
+	virtual						~IORing();
+
+			status_t			Init(uint32 entries, void** _userAddress);
+
+			void				Close();
+
+			ssize_t				Enter(uint32 toSubmit, uint32 minComplete,
+									uint32 flags, bigtime_t timeout);
+
+private:
+	static	status_t			_WorkerThread(void* data);
+			void				_Worker();
+
+			status_t			_SpawnWorker();
+			int64				_Execute(const io_ring_sqe& sqe);
+			void				_Complete(io_ring_request* request,
+									int64 result);
+			uint32				_CompletionsAvailable() const;
+
+private:
+			mutex				fLock;
+			ConditionVariable	fRequestCondition;
+			ConditionVariable	fCompletionCondition;
+
+			team_id				fTeam;
+			area_id				fArea;
+			area_id				fUserArea;
+			io_ring_info*		fInfo;
+			io_ring_sqe*		fSQEs;
+			io_ring_cqe*		fCQEs;
+
+			// private copies, the shared ones cannot be trusted
+			uint32				fSQMask;
+			uint32				fSQHead;
+			uint32				fCQMask;
+			uint32				fCQTail;
+
+			io_ring_request*	fRequests;
+			RequestList			fFreeRequests;
+			RequestList			fPendingRequests;
+			uint32				fInFlight;
+
+			thread_id			fWorkers[kMaxWorkers];
+			int32				fWorkerCount;
+			int32				fIdleWorkers;
+			bool				fClosed;
+};
+
+
+IORing::IORing()
+	:
+	fTeam(team_get_current_team_id()),
+	fArea(-1),
+	fUserArea(-1),
+	fInfo(NULL),
+	fSQEs(NULL),
+	fCQEs(NULL),
+	fSQMask(0),
+	fSQHead(0),
+	fCQMask(0),
+	fCQTail(0),
+	fRequests(NULL),
+	fInFlight(0),
+	fWorkerCount(0),
+	fIdleWorkers(0),
+	fClosed(false)
+{
+	mutex_init(&fLock, "io ring");
+	fRequestCondition.Init(this, "io ring request");
+	fCompletionCondition.Init(this, "io ring completion");
+}
+
+
+IORing::~IORing()
+{
+	if (fUserArea >= 0)
+		vm_delete_area(fTeam, fUserArea, true);
+	if (fArea >= 0)
+		delete_area(fArea);
+
+	delete[] fRequests;
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+IORing::Init(uint32 entries, void** _userAddress)
+{
+	// the CQ is twice as large as the SQ, so that a full SQ can be submitted
+	// while the previous batch has not been reaped yet
+	uint32 sqEntries = 1;
+	while (sqEntries < entries)
+		sqEntries <<= 1;
+	uint32 cqEntries = 2 * sqEntries;
+
+	fRequests = new(std::nothrow) io_ring_request[cqEntries];
+	if (fRequests == NULL)
+		return B_NO_MEMORY;
+
+	for (uint32 i = 0; i < cqEntries; i++)
+		fFreeRequests.Add(&fRequests[i]);
+
+	size_t sqesOffset = ROUNDUP(sizeof(io_ring_info), sizeof(io_ring_sqe));
+	size_t cqesOffset = sqesOffset + sqEntries * sizeof(io_ring_sqe);
+	size_t size = PAGE_ALIGN(cqesOffset + cqEntries * sizeof(io_ring_cqe));
+
+	fArea = create_area("io ring", (void**)&fInfo, B_ANY_KERNEL_ADDRESS, size,
+		B_FULL_LOCK, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (fArea < 0)
+		return fArea;
+
+	memset(fInfo, 0, size);
+	fInfo->sq_mask = fSQMask = sqEntries - 1;
+	fInfo->sq_entries = sqEntries;
+	fInfo->cq_mask = fCQMask = cqEntries - 1;
+	fInfo->cq_entries = cqEntries;
+	fInfo->sqes_offset = sqesOffset;
+	fInfo->cqes_offset = cqesOffset;
+
+	fSQEs = (io_ring_sqe*)((uint8*)fInfo + sqesOffset);
+	fCQEs = (io_ring_cqe*)((uint8*)fInfo + cqesOffset);
+
+	void* address = NULL;
+	fUserArea = vm_clone_area(fTeam, "io ring", &address,
+		B_RANDOMIZED_ANY_ADDRESS, B_READ_AREA | B_WRITE_AREA,
+		REGION_NO_PRIVATE_MAP, fArea, true);
+	if (fUserArea < 0)
+		return fUserArea;
+
+	*_userAddress = address;
+	return B_OK;
+}
+
+
+/*!	Drops all requests that have not been started yet, and makes the workers
+	exit. Workers that are blocked in a request, like in accept() or recv(),
+	are interrupted.
+*/
+void
+IORing::Close()
+{
+	MutexLocker locker(fLock);
+
+	fClosed = true;
+
+	while (io_ring_request* request = fPendingRequests.RemoveHead()) {
+		fFreeRequests.Add(request);
+		fInFlight--;
+	}
+
+	// Kernel threads never handle their signals, so the signal stays pending,
+	// and also interrupts a worker that is just about to block.
+	Signal signal(SIGKILLTHR, SI_USER, B_OK, fTeam);
+	for (int32 i = 0; i < fWorkerCount; i++)
+		send_signal_to_thread_id(fWorkers[i], signal, 0);
+
+	fRequestCondition.NotifyAll();
+	fCompletionCondition.NotifyAll(B_FILE_ERROR);
+}
+
+
+/*!	Submits up to \a toSubmit requests from the SQ, and waits until at least
+	\a minComplete completions are available in the CQ. Returns the number of
+	submitted requests.
+	\a timeout must be absolute, unless it is a relative timeout of 0.
+*/
+ssize_t
+IORing::Enter(uint32 toSubmit, uint32 minComplete, uint32 flags,
+	bigtime_t timeout)
+{
+	if (team_get_current_team_id() != fTeam)
+		return B_NOT_ALLOWED;
+
+	MutexLocker locker(fLock);
+
+	if (fClosed)
+		return B_FILE_ERROR;
+
+	uint32 available = *(volatile uint32*)&fInfo->sq_tail - fSQHead;
+	if (toSubmit > available)
+		toSubmit = available;
+
+	memory_read_barrier();
+
+	uint32 submitted = 0;
+	while (submitted < toSubmit) {
+		// never have more requests in flight than the CQ has room for
+		if (fInFlight + _CompletionsAvailable() > fCQMask)
+			break;
+
+		io_ring_request* request = fFreeRequests.RemoveHead();
+		if (request == NULL)
+			break;
+
+		request->sqe = fSQEs[fSQHead & fSQMask];
+		fSQHead++;
+		submitted++;
+
+		fPendingRequests.Add(request);
+		fInFlight++;
+	}
+
+	memory_write_barrier();
+	fInfo->sq_head = fSQHead;
+
+	// make sure there are enough workers to handle the new requests
+	if (submitted > 0) {
+		int32 needed = min_c((int32)submitted - fIdleWorkers,
+			kMaxWorkers - fWorkerCount);
+		for (int32 i = 0; i < needed; i++) {
+			if (_SpawnWorker() != B_OK)
+				break;
+		}
+
+		if (fWorkerCount == 0) {
+			// nobody would ever complete them
+			while (io_ring_request* request = fPendingRequests.RemoveHead())
+				_Complete(request, B_NO_MORE_THREADS);
+		}
+
+		fRequestCondition.NotifyAll();
+	}
+
+	while (_CompletionsAvailable() < minComplete && fInFlight > 0) {
+		if ((flags & B_RELATIVE_TIMEOUT) != 0 && timeout <= 0)
+			break;
+
+		ConditionVariableEntry entry;
+		fCompletionCondition.Add(&entry);
+		locker.Unlock();
+
+		status_t status = entry.Wait(B_CAN_INTERRUPT | flags, timeout);
+
+		locker.Lock();
+
+		if (status != B_OK) {
+			if (submitted > 0)
+				break;
+			return status;
+		}
+	}
+
+	return submitted;
+}
+
+
+/*static*/ status_t
+IORing::_WorkerThread(void* data)
+{
+	IORing* ring = (IORing*)data;
+	ring->_Worker();
+	ring->ReleaseReference();
+	return B_OK;
+}
+
+
+void
+IORing::_Worker()
+{
+	Thread* thread = thread_get_current_thread();
+
+	MutexLocker locker(fLock);
+
+	while (!fClosed && !thread_is_interrupted(thread, B_KILL_CAN_INTERRUPT)) {
+		io_ring_request* request = fPendingRequests.RemoveHead();
+		if (request == NULL) {
+			ConditionVariableEntry entry;
+			fRequestCondition.Add(&entry);
+			fIdleWorkers++;
+			locker.Unlock();
+
+			status_t status = entry.Wait(B_KILL_CAN_INTERRUPT);
+
+			locker.Lock();
+			fIdleWorkers--;
+
+			if (status == B_INTERRUPTED)
+				break;
+			continue;
+		}
+
+		locker.Unlock();
+		int64 result = _Execute(request->sqe);
+		locker.Lock();
+
+		_Complete(request, result);
+	}
+
+	// remove us from the workers, so that Close() doesn't signal us anymore
+	for (int32 i = 0; i < fWorkerCount; i++) {
+		if (fWorkers[i] == thread->id) {
+			fWorkers[i] = fWorkers[--fWorkerCount];
+			break;
+		}
+	}
+}
+
+
+/*!	The ring lock must be held. */
+status_t
+IORing::_SpawnWorker()
+{
+	// The workers belong to the ring's team, and must not take over any
+	// signals meant for its userland threads.
+	ThreadCreationAttributes attributes(&_WorkerThread, "io ring worker",
+		B_NORMAL_PRIORITY, this, fTeam);
+	attributes.signal_mask = ~KILL_SIGNALS;
+
+	thread_id thread = thread_create_thread(attributes, true);
+	if (thread < 0)
+		return thread;
+
+	AcquireReference();
+	fWorkers[fWorkerCount++] = thread;
+
+	resume_thread(thread);
+	return B_OK;
+}
+
+
+/*!	Executes the request in the context of the ring's team. */
+int64
+IORing::_Execute(const io_ring_sqe& sqe)
+{
+	void* address = (void*)(addr_t)sqe.address;
+
+	switch (sqe.opcode) {
+		case B_IO_RING_OP_NOP:
+			return B_OK;
+		case B_IO_RING_OP_READ:
+			return user_fd_kernel_io(sqe.fd, sqe.offset, address, sqe.length,
+				false);
+		case B_IO_RING_OP_WRITE:
+			return user_fd_kernel_io(sqe.fd, sqe.offset, address, sqe.length,
+				true);
+		case B_IO_RING_OP_READV:
+			return user_fd_kernel_vector_io(sqe.fd, sqe.offset,
+				(const iovec*)address, sqe.length, false);
+		case B_IO_RING_OP_WRITEV:
+			return user_fd_kernel_vector_io(sqe.fd, sqe.offset,
+				(const iovec*)address, sqe.length, true);
+		case B_IO_RING_OP_FSYNC:
+			// not restartable, the syscall is fine
+			return _user_fsync(sqe.fd);
+		case B_IO_RING_OP_ACCEPT:
+			return user_socket_kernel_accept(sqe.fd, (sockaddr*)address,
+				(socklen_t*)(addr_t)sqe.offset);
+		case B_IO_RING_OP_RECV:
+			return user_socket_kernel_recv(sqe.fd, address, sqe.length,
+				sqe.op_flags);
+		case B_IO_RING_OP_SEND:
+			return user_socket_kernel_send(sqe.fd, address, sqe.length,
+				sqe.op_flags);
+	}
+
+	return B_BAD_VALUE;
+}
+
+
+/*!	Posts the completion of \a request to the CQ. The ring lock must be
+	held.
+*/
+void
+IORing::_Complete(io_ring_request* request, int64 result)
+{
+	TRACE("request %p (op %u) completed: %" B_PRId64 "\n", request,
+		request->sqe.opcode, result);
+
+	if (!fClosed) {
+		io_ring_cqe* cqe = &fCQEs[fCQTail & fCQMask];
+		cqe->user_data = request->sqe.user_data;
+		cqe->result = result;
+
+		memory_write_barrier();
+		fInfo->cq_tail = ++fCQTail;
+
+		fCompletionCondition.NotifyAll();
+	}
+
+	fFreeRequests.Add(request);
+	fInFlight--;
+}
+
+
+uint32
+IORing::_CompletionsAvailable() const
+{
+	return fCQTail - *(volatile uint32*)&fInfo->cq_head;
+}
+
+
+//	#pragma mark - file descriptor
+
+
+static status_t
+io_ring_close(struct file_descriptor* descriptor)
+{
+	((IORing*)descriptor->cookie)->Close();
+	return B_OK;
+}
+
+
+static void
+io_ring_free(struct file_descriptor* descriptor)
+{
+	((IORing*)descriptor->cookie)->ReleaseReference();
+}
+
+
+static struct fd_ops sIORingFDOps = {
+	NULL,	// fd_read
+	NULL,	// fd_write
+	NULL,	// fd_seek
+	NULL,	// fd_ioctl
+	NULL,	// fd_set_flags
+	NULL,	// fd_select
+	NULL,	// fd_deselect
+	NULL,	// fd_read_dir
+	NULL,	// fd_rewind_dir
+	NULL,	// fd_read_stat
+	NULL,	// fd_write_stat
+	&io_ring_close,
+	&io_ring_free
+};
+
+
+//	#pragma mark - User syscalls
+
+
+int
+_user_io_ring_create(uint32 entries, uint32 flags, io_ring_info** _userInfo)
+{
+	if (entries == 0 || entries > B_IO_RING_MAX_ENTRIES
+		|| (flags & ~O_CLOEXEC) != 0) {
+		return B_BAD_VALUE;
+	}
+	if (_userInfo == NULL || !IS_USER_ADDRESS(_userInfo))
+		return B_BAD_ADDRESS;
+
+	IORing* ring = new(std::nothrow) IORing;
+	if (ring == NULL)
+		return B_NO_MEMORY;
+	BReference<IORing> ringReference(ring, true);
+
+	void* address;
+	status_t status = ring->Init(entries, &address);
+	if (status != B_OK)
+		return status;
+
+	if (user_memcpy(_userInfo, &address, sizeof(void*)) != B_OK)
+		return B_BAD_ADDRESS;
+
+	file_descriptor* descriptor = alloc_fd();
+	if (descriptor == NULL)
+		return B_NO_MEMORY;
+
+	descriptor->type = FDTYPE_IO_RING;
+	descriptor->ops = &sIORingFDOps;
+	descriptor->cookie = ring;
+	descriptor->open_mode = O_RDWR;
+
+	io_context* context = get_current_io_context(false);
+	int fd = new_fd(context, descriptor);
+	if (fd < 0) {
+		free(descriptor);
+		return B_NO_MORE_FDS;
+	}
+
+	// the descriptor owns the reference now
+	ringReference.Detach();
+
+	mutex_lock(&context->io_mutex);
+	fd_set_close_on_exec(context, fd, (flags & O_CLOEXEC) != 0);
+	mutex_unlock(&context->io_mutex);
+
+	return fd;
+}
+
+
+ssize_t
+_user_io_ring_enter(int ringFD, uint32 toSubmit, uint32 minComplete,
+	uint32 flags, bigtime_t timeout)
+{
+	syscall_restart_handle_timeout_pre(flags, timeout);
+
+	file_descriptor* descriptor = get_fd(get_current_io_context(false),
+		ringFD);
+	if (descriptor == NULL)
+		return B_FILE_ERROR;
+
+	if (descriptor->type != FDTYPE_IO_RING) {
+		put_fd(descriptor);
+		return B_BAD_VALUE;
+	}
+
+	ssize_t result = ((IORing*)descriptor->cookie)->Enter(toSubmit,
+		minComplete, flags, timeout);
+	put_fd(descriptor);
+
+	return syscall_restart_handle_timeout_post(result, timeout);
+}
@@ -9,7 +9,11 @@
 #include <sys/socket.h>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <stdlib.h>
+
+#include <new>
 
 #include <module.h>
 
@@ -18,11 +22,14 @@
 #include <syscall_utils.h>
 
 #include <fd.h>
+#include <file_cache.h>
 #include <kernel.h>
 #include <lock.h>
 #include <syscall_restart.h>
 #include <util/AutoLock.h>
 #include <vfs.h>
+#include <vm/vm.h>
+#include <vm/vm_types.h>
 
 #include <net_stack_interface.h>
 #include <net_stat.h>
@@ -32,6 +39,12 @@
 #define MAX_SOCKET_OPTION_LENGTH	128
 #define MAX_ANCILLARY_DATA_LENGTH	1024
 
+#ifdef KERNEL_PMAP_BASE
+	// All physical memory is permanently mapped, so sendfile() can pass the
+	// file cache pages to the network stack without copying them.
+#	define ZERO_COPY_SENDFILE	1
+#endif
+
 #define GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor)	\
 	do {												\
 		status_t getError = get_socket_descriptor(fd, kernel, descriptor); \
@@ -45,22 +58,6 @@ static vint32 sStackInterfaceInitialized = 0;
 static mutex sLock = MUTEX_INITIALIZER("stack interface");
 
 
-struct FDPutter {
-	FDPutter(file_descriptor* descriptor)
-		: descriptor(descriptor)
-	{
-	}
-
-	~FDPutter()
-	{
-		if (descriptor != NULL)
-			put_fd(descriptor);
-	}
-
-	file_descriptor*	descriptor;
-};
-
-
 static net_stack_interface_module_info*
 get_stack_interface_module()
 {
@@ -403,7 +400,7 @@ common_bind(int fd, const struct sockaddr *address, socklen_t addressLength,
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->bind(descriptor->u.socket, address, addressLength);
 }
@@ -414,7 +411,7 @@ common_shutdown(int fd, int how, bool kernel)
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->shutdown(descriptor->u.socket, how);
 }
@@ -426,7 +423,7 @@ common_connect(int fd, const struct sockaddr *address,
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->connect(descriptor->u.socket, address,
 		addressLength);
@@ -438,7 +435,7 @@ common_listen(int fd, int backlog, bool kernel)
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->listen(descriptor->u.socket, backlog);
 }
@@ -450,7 +447,7 @@ common_accept(int fd, struct sockaddr *address, socklen_t *_addressLength,
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	net_socket* acceptedSocket;
 	status_t error = sStackInterface->accept(descriptor->u.socket, address,
@@ -477,7 +474,7 @@ common_recv(int fd, void *data, size_t length, int flags, bool kernel)
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->recv(descriptor->u.socket, data, length, flags);
 }
@@ -489,7 +486,7 @@ common_recvfrom(int fd, void *data, size_t length, int flags,
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->recvfrom(descriptor->u.socket, data, length,
 		flags, address, _addressLength);
@@ -501,7 +498,7 @@ common_recvmsg(int fd, struct msghdr *message, int flags, bool kernel)
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->recvmsg(descriptor->u.socket, message, flags);
 }
@@ -512,7 +509,7 @@ common_send(int fd, const void *data, size_t length, int flags, bool kernel)
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->send(descriptor->u.socket, data, length, flags);
 }
@@ -524,7 +521,7 @@ common_sendto(int fd, const void *data, size_t length, int flags,
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->sendto(descriptor->u.socket, data, length, flags,
 		address, addressLength);
@@ -536,19 +533,208 @@ common_sendmsg(int fd, const struct msghdr *message, int flags, bool kernel)
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->sendmsg(descriptor->u.socket, message, flags);
 }
 
 
+static const size_t kSendFileChunkSize = 64 * 1024;
+
+
+#if ZERO_COPY_SENDFILE
+
+
+static const uint32 kSendFileChunkPages = kSendFileChunkSize / B_PAGE_SIZE + 1;
+	// an unaligned chunk spans one page more
+
+
+struct sendfile_page {
+	VMCache*	cache;
+	vm_page*	page;
+	addr_t		address;
+	void*		handle;
+};
+
+
+static void
+sendfile_page_free(void* cookie)
+{
+	sendfile_page* page = (sendfile_page*)cookie;
+
+	vm_put_physical_page(page->address, page->handle);
+	file_cache_unwire_page(page->cache, page->page);
+	delete page;
+}
+
+
+/*!	Sends the next chunk of the file at \a offset by handing its file cache
+	pages to the network stack directly.
+	Returns \c B_NOT_SUPPORTED if either the file or the socket do not
+	support this, and \c B_BUSY if the pages could not be wired right now.
+*/
+static ssize_t
+send_file_pages(net_socket* socket, file_descriptor* descriptor, off_t offset,
+	size_t length)
+{
+	vm_page* pages[kSendFileChunkPages];
+	iovec vecs[kSendFileChunkPages];
+	void* cookies[kSendFileChunkPages];
+	VMCache* cache;
+
+	size_t size = min_c(length, kSendFileChunkSize);
+	status_t status = file_cache_wire_pages(descriptor->u.vnode,
+		descriptor->cookie, offset, &size, pages, kSendFileChunkPages, &cache);
+	if (status != B_OK)
+		return status;
+	if (size == 0)
+		return 0;
+
+	uint32 pageOffset = offset & (B_PAGE_SIZE - 1);
+	uint32 count = (pageOffset + size + B_PAGE_SIZE - 1) / B_PAGE_SIZE;
+	uint32 index = 0;
+
+	for (; index < count; index++) {
+		sendfile_page* page = new(std::nothrow) sendfile_page;
+		if (page == NULL)
+			break;
+
+		page->cache = cache;
+		page->page = pages[index];
+		if (vm_get_physical_page(
+				(phys_addr_t)pages[index]->physical_page_number * B_PAGE_SIZE,
+				&page->address, &page->handle) != B_OK) {
+			delete page;
+			break;
+		}
+
+		vecs[index].iov_base = (uint8*)page->address + pageOffset;
+		vecs[index].iov_len = min_c(B_PAGE_SIZE - pageOffset, size);
+		cookies[index] = page;
+
+		size -= vecs[index].iov_len;
+		pageOffset = 0;
+	}
+
+	for (uint32 i = index; i < count; i++)
+		file_cache_unwire_page(cache, pages[i]);
+
+	if (index == 0)
+		return B_NO_MEMORY;
+
+	// the stack releases the pages once it is done with them
+	return sStackInterface->send_external(socket, vecs, cookies, index,
+		&sendfile_page_free, 0);
+}
+
+
+#endif	// ZERO_COPY_SENDFILE
+
+
+/*!	Sends the next chunk of the file at \a offset by reading it into
+	\a buffer first.
+*/
+static ssize_t
+send_file_data(net_socket* socket, file_descriptor* descriptor, off_t offset,
+	size_t length, void* buffer)
+{
+	size_t size = min_c(length, kSendFileChunkSize);
+	status_t status = descriptor->ops->fd_read(descriptor, offset, buffer,
+		&size);
+	if (status != B_OK)
+		return status;
+	if (size == 0)
+		return 0;
+
+	return sStackInterface->send(socket, buffer, size, 0);
+}
+
+
+static ssize_t
+common_sendfile(int socketFD, int fd, off_t* _offset, size_t length,
+	bool kernel)
+{
+	file_descriptor* socketDescriptor;
+	GET_SOCKET_FD_OR_RETURN(socketFD, kernel, socketDescriptor);
+	FileDescriptorPutter _(socketDescriptor);
+
+	file_descriptor* descriptor = get_fd(get_current_io_context(kernel), fd);
+	if (descriptor == NULL)
+		return EBADF;
+	FileDescriptorPutter _2(descriptor);
+
+	if ((descriptor->open_mode & O_RWMASK) == O_WRONLY)
+		return EBADF;
+	if (descriptor->ops->fd_read == NULL)
+		return B_BAD_VALUE;
+
+	off_t offset = _offset != NULL ? *_offset : descriptor->pos;
+	if (offset < 0)
+		return B_BAD_VALUE;
+
+	net_socket* socket = socketDescriptor->u.socket;
+#if ZERO_COPY_SENDFILE
+	bool zeroCopy = descriptor->type == FDTYPE_FILE;
+#endif
+	void* buffer = NULL;
+	MemoryDeleter bufferDeleter;
+
+	size_t bytesSent = 0;
+	status_t status = B_OK;
+
+	while (bytesSent < length) {
+		ssize_t sent = B_NOT_SUPPORTED;
+#if ZERO_COPY_SENDFILE
+		if (zeroCopy) {
+			sent = send_file_pages(socket, descriptor, offset,
+				length - bytesSent);
+			if (sent == B_NOT_SUPPORTED)
+				zeroCopy = false;
+		}
+#endif
+		if (sent == B_NOT_SUPPORTED || sent == B_BUSY) {
+			if (buffer == NULL) {
+				buffer = malloc(kSendFileChunkSize);
+				if (buffer == NULL) {
+					status = B_NO_MEMORY;
+					break;
+				}
+				bufferDeleter.SetTo(buffer);
+			}
+
+			sent = send_file_data(socket, descriptor, offset,
+				length - bytesSent, buffer);
+		}
+
+		if (sent <= 0) {
+			// error, or end of file
+			status = sent;
+			break;
+		}
+
+		bytesSent += sent;
+		offset += sent;
+	}
+
+	if (_offset != NULL)
+		*_offset = offset;
+	else
+		descriptor->pos = offset;
+
+	if (bytesSent == 0 && status != B_OK)
+		return status;
+
+	return bytesSent;
+}
+
+
 static status_t
 common_getsockopt(int fd, int level, int option, void *value,
 	socklen_t *_length, bool kernel)
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->getsockopt(descriptor->u.socket, level, option,
 		value, _length);
@@ -561,7 +747,7 @@ common_setsockopt(int fd, int level, int option, const void *value,
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->setsockopt(descriptor->u.socket, level, option,
 		value, length);
@@ -574,7 +760,7 @@ common_getpeername(int fd, struct sockaddr *address,
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->getpeername(descriptor->u.socket, address,
 		_addressLength);
@@ -587,7 +773,7 @@ common_getsockname(int fd, struct sockaddr *address,
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->getsockname(descriptor->u.socket, address,
 		_addressLength);
@@ -599,7 +785,7 @@ common_sockatmark(int fd, bool kernel)
 {
 	file_descriptor* descriptor;
 	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
-	FDPutter _(descriptor);
+	FileDescriptorPutter _(descriptor);
 
 	return sStackInterface->sockatmark(descriptor->u.socket);
 }
@@ -883,8 +1069,8 @@ _user_listen(int socket, int backlog)
 }
 
 
-int
-_user_accept(int socket, struct sockaddr *userAddress,
+static int
+common_user_accept(int socket, struct sockaddr *userAddress,
 	socklen_t *_addressLength)
 {
 	// check parameters
@@ -895,11 +1081,9 @@ _user_accept(int socket, struct sockaddr *userAddress,
 		return error;
 
 	// accept()
-	SyscallRestartWrapper<int> result;
-
 	char address[MAX_SOCKET_ADDRESS_LENGTH];
 	socklen_t userAddressBufferSize = addressLength;
-	result = common_accept(socket,
+	int result = common_accept(socket,
 		userAddress != NULL ? (sockaddr*)address : NULL, &addressLength, false);
 
 	// copy address size and address back to userland
@@ -913,6 +1097,15 @@ _user_accept(int socket, struct sockaddr *userAddress,
 }
 
 
+int
+_user_accept(int socket, struct sockaddr *userAddress,
+	socklen_t *_addressLength)
+{
+	SyscallRestartWrapper<int> result;
+	return result = common_user_accept(socket, userAddress, _addressLength);
+}
+
+
 ssize_t
 _user_recv(int socket, void *data, size_t length, int flags)
 {
@@ -1106,6 +1299,33 @@ _user_sendmsg(int socket, const struct msghdr *userMessage, int flags)
 }
 
 
+ssize_t
+_user_sendfile(int socket, int fd, off_t *userOffset, size_t length)
+{
+	off_t offset;
+	if (userOffset != NULL) {
+		if (!IS_USER_ADDRESS(userOffset)
+			|| user_memcpy(&offset, userOffset, sizeof(off_t)) != B_OK) {
+			return B_BAD_ADDRESS;
+		}
+	}
+
+	if (length > SSIZE_MAX)
+		length = SSIZE_MAX;
+
+	SyscallRestartWrapper<ssize_t> result;
+	result = common_sendfile(socket, fd, userOffset != NULL ? &offset : NULL,
+		length, false);
+
+	if (result >= 0 && userOffset != NULL
+		&& user_memcpy(userOffset, &offset, sizeof(off_t)) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	return result;
+}
+
+
 status_t
 _user_getsockopt(int socket, int level, int option, void *userValue,
 	socklen_t *_length)
@@ -1285,3 +1505,41 @@ _user_get_next_socket_stat(int family, uint32 *_cookie, struct net_stat *_stat)
 
 	return B_OK;
 }
+
+
+// #pragma mark - userland sockets for kernel threads
+
+
+/*!	The following functions work like the syscalls, on the current team's
+	sockets and with userland buffers, but are meant for kernel threads
+	acting on behalf of the team, and thus don't deal with syscall restarts.
+*/
+
+
+int
+user_socket_kernel_accept(int socket, struct sockaddr *userAddress,
+	socklen_t *_addressLength)
+{
+	return common_user_accept(socket, userAddress, _addressLength);
+}
+
+
+ssize_t
+user_socket_kernel_recv(int socket, void *data, size_t length, int flags)
+{
+	if (data == NULL || !IS_USER_ADDRESS(data))
+		return B_BAD_ADDRESS;
+
+	return common_recv(socket, data, length, flags, false);
+}
+
+
+ssize_t
+user_socket_kernel_send(int socket, const void *data, size_t length,
+	int flags)
+{
+	if (data == NULL || !IS_USER_ADDRESS(data))
+		return B_BAD_ADDRESS;
+
+	return common_send(socket, data, length, flags, false);
+}
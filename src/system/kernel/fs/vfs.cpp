@@ -403,6 +403,9 @@ static inline void put_vnode(struct vnode* vnode);
 static status_t fs_unmount(char* path, dev_t mountID, uint32 flags,
 	bool kernel);
 static int open_vnode(struct vnode* vnode, int openMode, bool kernel);
+static int file_create(int fd, char* path, int openMode, int perms,
+	bool kernel);
+static int file_open(int fd, char* path, int openMode, bool kernel);
 
 
 static struct fd_ops sFileOps = {
@@ -4153,6 +4156,25 @@ vfs_open_vnode(struct vnode* vnode, int openMode, bool kernel)
 }
 
 
+/*!	Opens or creates the file at \a path like _kern_open() does, but in the
+	I/O context selected by \a kernel. \a path must be a kernel buffer.
+*/
+int
+vfs_open(const char* path, int openMode, int perms, bool kernel)
+{
+	KPath pathBuffer(path, false, B_PATH_NAME_LENGTH + 1);
+	if (pathBuffer.InitCheck() != B_OK)
+		return B_NO_MEMORY;
+
+	if ((openMode & O_CREAT) != 0) {
+		return file_create(-1, pathBuffer.LockBuffer(), openMode, perms,
+			kernel);
+	}
+
+	return file_open(-1, pathBuffer.LockBuffer(), openMode, kernel);
+}
+
+
 /*!	Looks up a vnode with the given mount and vnode ID.
 	Must only be used with "in-use" vnodes as it doesn't grab a reference
 	to the node.
@@ -4850,6 +4872,10 @@ vfs_new_io_context(io_context* parentContext, bool purgeCloseOnExec)
 				if (closeOnExec && purgeCloseOnExec)
 					continue;
 
+				// I/O rings can only be used by the team that created them
+				if (descriptor->type == FDTYPE_IO_RING)
+					continue;
+
 				TFD(InheritFD(context, i, descriptor, parentContext));
 
 				context->fds[i] = descriptor;
@@ -4896,6 +4922,16 @@ vfs_free_io_context(io_context* context)
 	if (context->cwd)
 		put_vnode(context->cwd);
 
+	// Persistent selections (event queues) may still be attached to our
+	// descriptors -- invalidate them, so that their references are released.
+	for (i = 0; i < context->table_size; i++) {
+		if (context->fds[i] != NULL && context->select_infos[i] != NULL) {
+			deselect_select_infos(context->fds[i], context->select_infos[i],
+				true);
+			context->select_infos[i] = NULL;
+		}
+	}
+
 	mutex_lock(&context->io_mutex);
 
 	for (i = 0; i < context->table_size; i++) {
@@ -13,6 +13,7 @@
 
 #include <elf.h>
 #include <lock.h>
+#include <thread.h>
 #include <util/AutoLock.h>
 #include <util/DoublyLinkedList.h>
 
@@ -245,7 +246,8 @@ KernelDaemon::_DaemonThread()
 		locker.Unlock();
 
 		iteration++;
-		snooze(100000);	// 0.1 seconds
+		snooze_etc(100000, B_SYSTEM_TIMEBASE,
+			B_RELATIVE_TIMEOUT | B_TIMEOUT_ALLOW_SLACK);	// 0.1 seconds
 	}
 
 	return B_OK;
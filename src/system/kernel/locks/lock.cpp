@@ -18,11 +18,13 @@
 
 #include <OS.h>
 
+#include <cpu.h>
 #include <debug.h>
 #include <int.h>
 #include <kernel.h>
 #include <listeners.h>
 #include <scheduling_analysis.h>
+#include <smp.h>
 #include <thread.h>
 #include <util/AutoLock.h>
 
@@ -45,6 +47,120 @@ struct rw_lock_waiter {
 
 #define RW_LOCK_FLAG_OWNS_NAME	RW_LOCK_FLAG_CLONE_NAME
 
+static const int32 kMaxMutexSpinCount = 1000;
+	// upper bound for the number of cpu_pause() iterations a thread spends
+	// waiting for a contended mutex before it blocks
+
+#if DEBUG_LOCK_CONTENTION
+
+static const int32 kLockContentionSlotCount = 256;
+
+struct lock_contention {
+	char		name[32];
+	int64		contended;
+	int64		spun;
+	int64		blocked;
+	bigtime_t	wait_time;
+	bigtime_t	max_wait_time;
+};
+
+static lock_contention sLockContention[kLockContentionSlotCount];
+static int64 sLockContentionDropped;
+static spinlock sLockContentionLock = B_SPINLOCK_INITIALIZER;
+
+#endif	// DEBUG_LOCK_CONTENTION
+
+
+// #pragma mark - contention statistics
+
+
+#if DEBUG_LOCK_CONTENTION
+
+/*!	Accounts a contended acquisition of the lock called \a name. Locks are
+	identified by their name only, so that all instances of e.g. a per vnode
+	lock add up, and locks whose names have been freed are still listed.
+	If \a blocked is \c false, the lock was acquired by spinning.
+*/
+static void
+lock_contention_record(const char* name, bool blocked, bigtime_t waitTime)
+{
+	if (name == NULL)
+		name = "<unnamed>";
+
+	uint32 hash = 0;
+	for (const char* c = name; *c != '\0'; c++)
+		hash = hash * 31 + (uint8)*c;
+
+	InterruptsSpinLocker locker(sLockContentionLock);
+
+	for (int32 i = 0; i < kLockContentionSlotCount; i++) {
+		lock_contention& entry
+			= sLockContention[(hash + i) % kLockContentionSlotCount];
+		if (entry.name[0] == '\0')
+			strlcpy(entry.name, name, sizeof(entry.name));
+		else if (strncmp(entry.name, name, sizeof(entry.name) - 1) != 0)
+			continue;
+
+		entry.contended++;
+		if (blocked) {
+			entry.blocked++;
+			entry.wait_time += waitTime;
+			if (waitTime > entry.max_wait_time)
+				entry.max_wait_time = waitTime;
+		} else
+			entry.spun++;
+		return;
+	}
+
+	sLockContentionDropped++;
+}
+
+
+static int
+dump_lock_contention(int argc, char** argv)
+{
+	bool reset = argc == 2 && strcmp(argv[1], "reset") == 0;
+	if (argc > 2 || (argc == 2 && !reset)) {
+		print_debugger_command_usage(argv[0]);
+		return 0;
+	}
+
+	if (reset) {
+		memset(sLockContention, 0, sizeof(sLockContention));
+		sLockContentionDropped = 0;
+		return 0;
+	}
+
+	kprintf("%-32s %10s %10s %10s %12s %10s\n", "name", "contended",
+		"spun", "blocked", "wait (us)", "max (us)");
+
+	for (int32 i = 0; i < kLockContentionSlotCount; i++) {
+		lock_contention& entry = sLockContention[i];
+		if (entry.name[0] == '\0')
+			continue;
+
+		kprintf("%-32s %10" B_PRId64 " %10" B_PRId64 " %10" B_PRId64 " %12"
+			B_PRId64 " %10" B_PRId64 "\n", entry.name, entry.contended,
+			entry.spun, entry.blocked, entry.wait_time, entry.max_wait_time);
+	}
+
+	if (sLockContentionDropped > 0) {
+		kprintf("%" B_PRId64 " contended acquisitions of further locks were "
+			"not accounted\n", sLockContentionDropped);
+	}
+
+	return 0;
+}
+
+#	define T_LOCK_CONTENTION(name, blocked, waitTime) \
+		lock_contention_record(name, blocked, waitTime)
+#else
+#	define T_LOCK_CONTENTION(name, blocked, waitTime) do {} while (false)
+#endif	// DEBUG_LOCK_CONTENTION
+
+
+// #pragma mark -
+
 
 int32
 recursive_lock_get_recursion(recursive_lock *lock)
@@ -168,7 +284,11 @@ rw_lock_wait(rw_lock* lock, bool writer, InterruptsSpinLocker& locker)
 	thread_prepare_to_block(waiter.thread, 0, THREAD_BLOCK_TYPE_RW_LOCK, lock);
 	locker.Unlock();
 
+#if DEBUG_LOCK_CONTENTION
+	bigtime_t startTime = system_time();
+#endif
 	status_t result = thread_block();
+	T_LOCK_CONTENTION(lock->name, true, system_time() - startTime);
 
 	locker.Lock();
 	return result;
@@ -569,6 +689,62 @@ dump_rw_lock_info(int argc, char** argv)
 // #pragma mark -
 
 
+static inline bool
+mutex_released(mutex* lock)
+{
+#if KDEBUG
+	return *(volatile thread_id*)&lock->holder < 0;
+#else
+	return (*(volatile uint8*)&lock->flags & MUTEX_FLAG_RELEASED) != 0;
+#endif
+}
+
+
+/*!	Spins while the mutex is held by another thread, and no other thread has
+	given up and is blocking on it already. Since the mutex is always handed
+	over to the first blocking waiter on unlock, a spinning thread can never
+	overtake a waiter that is already queued.
+	The number of iterations adapts to how long the lock has been held on
+	previous contention, so that locks guarding short critical sections are
+	usually acquired without blocking, while spinning on locks that are held
+	for long is given up quickly: only spins that saw the lock released feed
+	the estimate, every failed one shrinks it.
+	Returns the number of iterations spun, or -1 if the lock was not released
+	in time.
+*/
+static int32
+mutex_spin(mutex* lock)
+{
+	if (smp_get_num_cpus() < 2 || gKernelStartup || !are_interrupts_enabled())
+		return -1;
+
+	int32 maxSpins = min_c(kMaxMutexSpinCount, lock->spin_estimate * 2 + 10);
+	int32 spins = 0;
+	bool released = false;
+
+	while (spins < maxSpins) {
+		if (mutex_released(lock)) {
+			released = true;
+			break;
+		}
+		if (*(mutex_waiter* volatile*)&lock->waiters != NULL)
+			break;
+
+		cpu_pause();
+		spins++;
+	}
+
+	if (!released) {
+		// spinning did not pay off, spin less next time
+		lock->spin_estimate -= lock->spin_estimate / 4;
+		return -1;
+	}
+
+	lock->spin_estimate += (spins - lock->spin_estimate) / 8;
+	return spins;
+}
+
+
 void
 mutex_init(mutex* lock, const char *name)
 {
@@ -582,6 +758,7 @@ mutex_init(mutex* lock, const char *name)
 	lock->ignore_unlock_count = 0;
 #endif
 	lock->flags = 0;
+	lock->spin_estimate = 0;
 
 	T_SCHEDULING_ANALYSIS(InitMutex(lock, name));
 	NotifyWaitObjectListeners(&WaitObjectListener::MutexInitialized, lock);
@@ -601,6 +778,7 @@ mutex_init_etc(mutex* lock, const char *name, uint32 flags)
 	lock->ignore_unlock_count = 0;
 #endif
 	lock->flags = flags & MUTEX_FLAG_CLONE_NAME;
+	lock->spin_estimate = 0;
 
 	T_SCHEDULING_ANALYSIS(InitMutex(lock, name));
 	NotifyWaitObjectListeners(&WaitObjectListener::MutexInitialized, lock);
@@ -701,8 +879,12 @@ _mutex_lock(mutex* lock, void* _locker)
 	InterruptsSpinLocker* locker
 		= reinterpret_cast<InterruptsSpinLocker*>(_locker);
 
+	// Unless the caller already holds the spinlock, try to avoid blocking, if
+	// the holder is about to release the lock.
+	int32 spins = -1;
 	InterruptsSpinLocker lockLocker;
 	if (locker == NULL) {
+		spins = mutex_spin(lock);
 		lockLocker.SetTo(lock->lock, false);
 		locker = &lockLocker;
 	}
@@ -712,6 +894,8 @@ _mutex_lock(mutex* lock, void* _locker)
 #if KDEBUG
 	if (lock->holder < 0) {
 		lock->holder = thread_get_current_thread_id();
+		if (spins > 0)
+			T_LOCK_CONTENTION(lock->name, false, 0);
 		return B_OK;
 	} else if (lock->holder == thread_get_current_thread_id()) {
 		panic("_mutex_lock(): double lock of %p by thread %" B_PRId32, lock,
@@ -721,6 +905,8 @@ _mutex_lock(mutex* lock, void* _locker)
 #else
 	if ((lock->flags & MUTEX_FLAG_RELEASED) != 0) {
 		lock->flags &= ~MUTEX_FLAG_RELEASED;
+		if (spins > 0)
+			T_LOCK_CONTENTION(lock->name, false, 0);
 		return B_OK;
 	}
 #endif
@@ -741,7 +927,11 @@ _mutex_lock(mutex* lock, void* _locker)
 	thread_prepare_to_block(waiter.thread, 0, THREAD_BLOCK_TYPE_MUTEX, lock);
 	locker->Unlock();
 
+#if DEBUG_LOCK_CONTENTION
+	bigtime_t startTime = system_time();
+#endif
 	status_t error = thread_block();
+	T_LOCK_CONTENTION(lock->name, true, system_time() - startTime);
 #if KDEBUG
 	if (error == B_OK)
 		atomic_set(&lock->holder, waiter.thread->id);
@@ -826,6 +1016,7 @@ _mutex_lock_with_timeout(mutex* lock, uint32 timeoutFlags, bigtime_t timeout)
 	}
 #endif
 
+	int32 spins = mutex_spin(lock);
 	InterruptsSpinLocker locker(lock->lock);
 
 	// Might have been released after we decremented the count, but before
@@ -833,6 +1024,8 @@ _mutex_lock_with_timeout(mutex* lock, uint32 timeoutFlags, bigtime_t timeout)
 #if KDEBUG
 	if (lock->holder < 0) {
 		lock->holder = thread_get_current_thread_id();
+		if (spins > 0)
+			T_LOCK_CONTENTION(lock->name, false, 0);
 		return B_OK;
 	} else if (lock->holder == thread_get_current_thread_id()) {
 		panic("_mutex_lock(): double lock of %p by thread %" B_PRId32, lock,
@@ -842,6 +1035,8 @@ _mutex_lock_with_timeout(mutex* lock, uint32 timeoutFlags, bigtime_t timeout)
 #else
 	if ((lock->flags & MUTEX_FLAG_RELEASED) != 0) {
 		lock->flags &= ~MUTEX_FLAG_RELEASED;
+		if (spins > 0)
+			T_LOCK_CONTENTION(lock->name, false, 0);
 		return B_OK;
 	}
 #endif
@@ -862,7 +1057,11 @@ _mutex_lock_with_timeout(mutex* lock, uint32 timeoutFlags, bigtime_t timeout)
 	thread_prepare_to_block(waiter.thread, 0, THREAD_BLOCK_TYPE_MUTEX, lock);
 	locker.Unlock();
 
+#if DEBUG_LOCK_CONTENTION
+	bigtime_t startTime = system_time();
+#endif
 	status_t error = thread_block_with_timeout(timeoutFlags, timeout);
+	T_LOCK_CONTENTION(lock->name, true, system_time() - startTime);
 
 	if (error == B_OK) {
 #if KDEBUG
@@ -929,6 +1128,7 @@ dump_mutex_info(int argc, char** argv)
 	kprintf("mutex %p:\n", lock);
 	kprintf("  name:            %s\n", lock->name);
 	kprintf("  flags:           0x%x\n", lock->flags);
+	kprintf("  spin estimate:   %" B_PRId16 "\n", lock->spin_estimate);
 #if KDEBUG
 	kprintf("  holder:          %" B_PRId32 "\n", lock->holder);
 #else
@@ -963,4 +1163,12 @@ lock_debug_init()
 		"<lock>\n"
 		"Prints info about the specified rw lock.\n"
 		"  <lock>  - pointer to the rw lock to print the info for.\n", 0);
+#if DEBUG_LOCK_CONTENTION
+	add_debugger_command_etc("lock_contention", &dump_lock_contention,
+		"Dump lock contention statistics",
+		"[ \"reset\" ]\n"
+		"Prints how often mutexes and rw locks, grouped by name, could not be\n"
+		"acquired immediately, and how long threads blocked on them.\n"
+		"  reset  - clears the statistics instead.\n", 0);
+#endif
 }
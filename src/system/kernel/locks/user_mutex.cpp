@@ -8,6 +8,8 @@
 #include <user_mutex.h>
 #include <user_mutex_defs.h>
 
+#include <new>
+
 #include <condition_variable.h>
 #include <kernel.h>
 #include <lock.h>
@@ -28,6 +30,9 @@ struct UserMutexEntry : public DoublyLinkedListLinkImpl<UserMutexEntry> {
 	bool				locked;
 	UserMutexEntryList	otherEntries;
 	UserMutexEntry*		hashNext;
+	VMPageWiringInfo*	requeueWiring;
+		// keeps the page of the futex the entry has been requeued to wired,
+		// as long as the entry is keyed by its physical address
 };
 
 struct UserMutexHashDefinition {
@@ -59,24 +64,29 @@ typedef BOpenHashTable<UserMutexHashDefinition> UserMutexTable;
 
 
 static UserMutexTable sUserMutexTable;
+static UserMutexTable sUserFutexTable;
+	// Threads waiting in _user_futex_wait(). Futex words are not interpreted
+	// by the kernel, so they are kept apart from the user mutexes.
 static mutex sUserMutexTableLock = MUTEX_INITIALIZER("user mutex table");
 
+static const int32 kFutexRequeueBatchSize = 16;
+
 
 static void
-add_user_mutex_entry(UserMutexEntry* entry)
+add_user_mutex_entry(UserMutexTable& table, UserMutexEntry* entry)
 {
-	UserMutexEntry* firstEntry = sUserMutexTable.Lookup(entry->address);
+	UserMutexEntry* firstEntry = table.Lookup(entry->address);
 	if (firstEntry != NULL)
 		firstEntry->otherEntries.Add(entry);
 	else
-		sUserMutexTable.Insert(entry);
+		table.Insert(entry);
 }
 
 
 static bool
-remove_user_mutex_entry(UserMutexEntry* entry)
+remove_user_mutex_entry(UserMutexTable& table, UserMutexEntry* entry)
 {
-	UserMutexEntry* firstEntry = sUserMutexTable.Lookup(entry->address);
+	UserMutexEntry* firstEntry = table.Lookup(entry->address);
 	if (firstEntry != entry) {
 		// The entry is not the first entry in the table. Just remove it from
 		// the first entry's list.
@@ -86,12 +96,12 @@ remove_user_mutex_entry(UserMutexEntry* entry)
 
 	// The entry is the first entry in the table. Remove it from the table and,
 	// if any, add the next entry to the table.
-	sUserMutexTable.Remove(entry);
+	table.Remove(entry);
 
 	firstEntry = entry->otherEntries.RemoveHead();
 	if (firstEntry != NULL) {
 		firstEntry->otherEntries.MoveFrom(&entry->otherEntries);
-		sUserMutexTable.Insert(firstEntry);
+		table.Insert(firstEntry);
 		return true;
 	}
 
@@ -107,7 +117,7 @@ user_mutex_wait_locked(int32* mutex, addr_t physicalAddress, const char* name,
 	UserMutexEntry entry;
 	entry.address = physicalAddress;
 	entry.locked = false;
-	add_user_mutex_entry(&entry);
+	add_user_mutex_entry(sUserMutexTable, &entry);
 
 	// wait
 	ConditionVariableEntry waitEntry;
@@ -123,7 +133,7 @@ user_mutex_wait_locked(int32* mutex, addr_t physicalAddress, const char* name,
 
 	if (!entry.locked) {
 		// if nobody woke us up, we have to dequeue ourselves
-		lastWaiter = !remove_user_mutex_entry(&entry);
+		lastWaiter = !remove_user_mutex_entry(sUserMutexTable, &entry);
 	} else {
 		// otherwise the waker has done the work of marking the
 		// mutex or semaphore uncontended
@@ -191,66 +201,13 @@ user_mutex_unlock_locked(int32* mutex, addr_t physicalAddress, uint32 flags)
 		sUserMutexTable.Remove(entry);
 		atomic_and(mutex, ~(int32)B_USER_MUTEX_WAITING);
 	} else {
-		bool otherWaiters = remove_user_mutex_entry(entry);
+		bool otherWaiters = remove_user_mutex_entry(sUserMutexTable, entry);
 		if (!otherWaiters)
 			atomic_and(mutex, ~(int32)B_USER_MUTEX_WAITING);
 	}
 }
 
 
-static status_t
-user_mutex_sem_acquire_locked(int32* sem, addr_t physicalAddress,
-	const char* name, uint32 flags, bigtime_t timeout, MutexLocker& locker)
-{
-	// The semaphore may have been released in the meantime, and we also
-	// need to mark it as contended if it isn't already.
-	int32 oldValue = atomic_get(sem);
-	while (oldValue > -1) {
-		int32 value = atomic_test_and_set(sem, oldValue - 1, oldValue);
-		if (value == oldValue && value > 0)
-			return B_OK;
-		oldValue = value;
-	}
-
-	bool lastWaiter;
-	status_t error = user_mutex_wait_locked(sem, physicalAddress, name, flags,
-		timeout, locker, lastWaiter);
-
-	if (lastWaiter)
-		atomic_test_and_set(sem, 0, -1);
-
-	return error;
-}
-
-
-static void
-user_mutex_sem_release_locked(int32* sem, addr_t physicalAddress)
-{
-	UserMutexEntry* entry = sUserMutexTable.Lookup(physicalAddress);
-	if (!entry) {
-		// no waiters - mark as uncontended and release
-		int32 oldValue = atomic_get(sem);
-		while (true) {
-			int32 inc = oldValue < 0 ? 2 : 1;
-			int32 value = atomic_test_and_set(sem, oldValue + inc, oldValue);
-			if (value == oldValue)
-				return;
-			oldValue = value;
-		}
-	}
-
-	bool otherWaiters = remove_user_mutex_entry(entry);
-
-	entry->locked = true;
-	entry->condition.NotifyOne();
-
-	if (!otherWaiters) {
-		// mark the semaphore uncontended
-		atomic_test_and_set(sem, 0, -1);
-	}
-}
-
-
 static status_t
 user_mutex_lock(int32* mutex, const char* name, uint32 flags, bigtime_t timeout)
 {
@@ -311,13 +268,112 @@ user_mutex_switch_lock(int32* fromMutex, int32* toMutex, const char* name,
 }
 
 
+static status_t
+user_futex_wait_locked(int32* address, addr_t physicalAddress, int32 value,
+	uint32 flags, bigtime_t timeout, MutexLocker& locker)
+{
+	// Since wakers change the value before they take the table lock, we
+	// cannot miss a wake-up, if the value still matches now.
+	if (atomic_get(address) != value)
+		return B_WOULD_BLOCK;
+
+	UserMutexEntry entry;
+	entry.address = physicalAddress;
+	entry.locked = false;
+	entry.requeueWiring = NULL;
+	add_user_mutex_entry(sUserFutexTable, &entry);
+
+	ConditionVariableEntry waitEntry;
+	entry.condition.Init((void*)physicalAddress, "user futex");
+	entry.condition.Add(&waitEntry);
+
+	locker.Unlock();
+	status_t error = waitEntry.Wait(flags, timeout);
+	locker.Lock();
+
+	// If we have been woken up, that counts, even if the wait failed.
+	// Otherwise we're still queued -- at the address we have been requeued
+	// to, if any.
+	if (entry.locked)
+		error = B_OK;
+	else
+		remove_user_mutex_entry(sUserFutexTable, &entry);
+
+	if (entry.requeueWiring != NULL) {
+		locker.Unlock();
+		vm_unwire_page(entry.requeueWiring);
+		delete entry.requeueWiring;
+		locker.Lock();
+	}
+
+	return error;
+}
+
+
+static int32
+user_futex_wake_locked(addr_t physicalAddress, int32 count)
+{
+	int32 woken = 0;
+	while (woken < count) {
+		UserMutexEntry* entry = sUserFutexTable.Lookup(physicalAddress);
+		if (entry == NULL)
+			break;
+
+		remove_user_mutex_entry(sUserFutexTable, entry);
+		entry->locked = true;
+		entry->condition.NotifyOne();
+		woken++;
+	}
+
+	return woken;
+}
+
+
+/*!	Moves up to \a count waiters to the futex at \a targetAddress. Every
+	requeued waiter takes one of the \a wirings of the target's page, so that
+	the page stays at \a targetAddress while the waiter is keyed by it. The
+	wiring of a previous requeue of the waiter is handed back in its place.
+	If there is no wiring left, the waiter is woken up instead.
+	Since unwiring may block, the caller has to unwire and delete what is
+	left in \a wirings after releasing the table lock.
+	Returns the number of waiters that have been moved or woken up.
+*/
+static int32
+user_futex_requeue_locked(addr_t physicalAddress, addr_t targetAddress,
+	VMPageWiringInfo** wirings, int32 count)
+{
+	int32 requeued = 0;
+	while (requeued < count) {
+		UserMutexEntry* entry = sUserFutexTable.Lookup(physicalAddress);
+		if (entry == NULL)
+			break;
+
+		remove_user_mutex_entry(sUserFutexTable, entry);
+		VMPageWiringInfo* wiring = wirings[requeued];
+		wirings[requeued++] = entry->requeueWiring;
+
+		if (wiring == NULL) {
+			entry->locked = true;
+			entry->condition.NotifyOne();
+			continue;
+		}
+
+		entry->requeueWiring = wiring;
+		entry->address = targetAddress;
+		add_user_mutex_entry(sUserFutexTable, entry);
+	}
+
+	return requeued;
+}
+
+
 // #pragma mark - kernel private
 
 
 void
 user_mutex_init()
 {
-	if (sUserMutexTable.Init() != B_OK)
+	if (sUserMutexTable.Init() != B_OK || sUserFutexTable.Init() != B_OK)
 		panic("user_mutex_init(): Failed to init table!");
 }
 
@@ -381,25 +437,26 @@ _user_mutex_switch_lock(int32* fromMutex, int32* toMutex, const char* name,
 
 
 status_t
-_user_mutex_sem_acquire(int32* sem, const char* name, uint32 flags,
-	bigtime_t timeout)
+_user_futex_wait(int32* address, int32 value, uint32 flags, bigtime_t timeout)
 {
-	if (sem == NULL || !IS_USER_ADDRESS(sem) || (addr_t)sem % 4 != 0)
+	if (address == NULL || !IS_USER_ADDRESS(address)
+			|| (addr_t)address % 4 != 0) {
 		return B_BAD_ADDRESS;
+	}
 
 	syscall_restart_handle_timeout_pre(flags, timeout);
 
 	// wire the page and get the physical address
 	VMPageWiringInfo wiringInfo;
-	status_t error = vm_wire_page(B_CURRENT_TEAM, (addr_t)sem, true,
+	status_t error = vm_wire_page(B_CURRENT_TEAM, (addr_t)address, true,
 		&wiringInfo);
 	if (error != B_OK)
 		return error;
 
 	{
 		MutexLocker locker(sUserMutexTableLock);
-		error = user_mutex_sem_acquire_locked(sem, wiringInfo.physicalAddress,
-			name, flags | B_CAN_INTERRUPT, timeout, locker);
+		error = user_futex_wait_locked(address, wiringInfo.physicalAddress,
+			value, flags | B_CAN_INTERRUPT, timeout, locker);
 	}
 
 	vm_unwire_page(&wiringInfo);
@@ -407,24 +464,112 @@ _user_mutex_sem_acquire(int32* sem, const char* name, uint32 flags,
 }
 
 
-status_t
-_user_mutex_sem_release(int32* sem)
+int32
+_user_futex_wake(int32* address, int32 count)
 {
-	if (sem == NULL || !IS_USER_ADDRESS(sem) || (addr_t)sem % 4 != 0)
+	if (address == NULL || !IS_USER_ADDRESS(address)
+			|| (addr_t)address % 4 != 0) {
 		return B_BAD_ADDRESS;
+	}
+	if (count <= 0)
+		return 0;
 
 	// wire the page and get the physical address
 	VMPageWiringInfo wiringInfo;
-	status_t error = vm_wire_page(B_CURRENT_TEAM, (addr_t)sem, true,
+	status_t error = vm_wire_page(B_CURRENT_TEAM, (addr_t)address, true,
 		&wiringInfo);
 	if (error != B_OK)
 		return error;
 
+	int32 woken;
 	{
 		MutexLocker locker(sUserMutexTableLock);
-		user_mutex_sem_release_locked(sem, wiringInfo.physicalAddress);
+		woken = user_futex_wake_locked(wiringInfo.physicalAddress, count);
 	}
 
 	vm_unwire_page(&wiringInfo);
-	return B_OK;
+	return woken;
+}
+
+
+int32
+_user_futex_requeue(int32* address, int32 value, int32 wakeCount,
+	int32* target, int32 requeueCount)
+{
+	if (address == NULL || !IS_USER_ADDRESS(address)
+			|| (addr_t)address % 4 != 0 || target == NULL
+			|| !IS_USER_ADDRESS(target) || (addr_t)target % 4 != 0) {
+		return B_BAD_ADDRESS;
+	}
+
+	// wire the pages and get the physical addresses
+	VMPageWiringInfo wiringInfo;
+	status_t error = vm_wire_page(B_CURRENT_TEAM, (addr_t)address, true,
+		&wiringInfo);
+	if (error != B_OK)
+		return error;
+
+	VMPageWiringInfo targetWiringInfo;
+	error = vm_wire_page(B_CURRENT_TEAM, (addr_t)target, true,
+		&targetWiringInfo);
+	if (error != B_OK) {
+		vm_unwire_page(&wiringInfo);
+		return error;
+	}
+
+	if (requeueCount < 0
+		|| targetWiringInfo.physicalAddress == wiringInfo.physicalAddress) {
+		requeueCount = 0;
+	}
+
+	// The requeued waiters are moved in batches, each with the target's page
+	// wired for them in advance, as wiring cannot be done while holding the
+	// table lock. Only the first batch is atomic with the value check; a
+	// thread that starts waiting in between may be requeued as well, which
+	// it sees as a spurious wake-up at worst.
+	int32 woken = B_WOULD_BLOCK;
+	for (bool first = true; first || requeueCount > 0; first = false) {
+		VMPageWiringInfo* wirings[kFutexRequeueBatchSize];
+		int32 batchSize = min_c(requeueCount, kFutexRequeueBatchSize);
+		for (int32 i = 0; i < batchSize; i++) {
+			// The target page is wired already, so this neither faults nor
+			// changes the physical address.
+			wirings[i] = new(std::nothrow) VMPageWiringInfo;
+			if (wirings[i] != NULL && vm_wire_page(B_CURRENT_TEAM,
+					(addr_t)target, true, wirings[i]) != B_OK) {
+				delete wirings[i];
+				wirings[i] = NULL;
+			}
+		}
+
+		int32 requeued = 0;
+		{
+			MutexLocker locker(sUserMutexTableLock);
+			if (!first || atomic_get(address) == value) {
+				if (first) {
+					woken = user_futex_wake_locked(wiringInfo.physicalAddress,
+						wakeCount);
+				}
+				requeued = user_futex_requeue_locked(
+					wiringInfo.physicalAddress,
+					targetWiringInfo.physicalAddress, wirings, batchSize);
+			}
+		}
+
+		for (int32 i = 0; i < batchSize; i++) {
+			if (wirings[i] != NULL) {
+				vm_unwire_page(wirings[i]);
+				delete wirings[i];
+			}
+		}
+
+		if (requeued < batchSize)
+			break;
+
+		requeueCount -= requeued;
+	}
+
+	vm_unwire_page(&targetWiringInfo);
+	vm_unwire_page(&wiringInfo);
+	return woken;
 }
@@ -169,6 +169,7 @@ _start(kernel_args *bootKernelArgs, int currentCPU)
 
 		TRACE("init SMP\n");
 		smp_init(&sKernelArgs);
+		cpu_init_post_smp(&sKernelArgs);
 		cpu_build_topology_tree();
 		TRACE("init timer\n");
 		timer_init(&sKernelArgs);
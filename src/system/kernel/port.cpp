@@ -22,8 +22,10 @@
 #include <OS.h>
 
 #include <AutoDeleter.h>
+#include <port_defs.h>
 
 #include <arch/int.h>
+#include <cpu.h>
 #include <heap.h>
 #include <kernel.h>
 #include <Notifications.h>
@@ -34,6 +36,7 @@
 #include <util/AutoLock.h>
 #include <util/list.h>
 #include <vm/vm.h>
+#include <vm/VMAddressSpace.h>
 #include <wait_for_objects.h>
 
 
@@ -56,16 +59,23 @@
 
 
 // Locking:
-// * sPortsLock: Protects the sPorts and sPortsByName hash tables.
+// * sPortsLock: Protects the sPortsByName hash table, and serializes changes
+//   to the port slot table.
+// * port_slot::lock: Protects port_slot::port. Looking up a port by ID only
+//   requires computing the slot index (id % sMaxPorts), locking the slot and
+//   verifying the port's ID, so that lookups of different ports don't touch
+//   any shared cache lines. Changing port_slot::port additionally requires
+//   sPortsLock to be write locked, so that the slots can be read while
+//   holding it.
 // * sTeamListLock[]: Protects Team::port_list. Lock index for given team is
 //   (Team::id % kTeamListLockCount).
-// * Port::lock: Protects all Port members save team_link, hash_link, lock and
-//   state. id is immutable.
+// * Port::lock: Protects all Port members save team_link, name_hash_link, lock
+//   and state. id is immutable.
 //
 // Port::state ensures atomicity by providing a linearization point for adding
-// and removing ports to the hash tables and the team port list.
+// and removing ports to the port table, the hash table and the team port list.
 // * sPortsLock and sTeamListLock[] are locked separately and not in a nested
-//   fashion, so a port can be in the hash table but not in the team port list
+//   fashion, so a port can be in the port table but not in the team port list
 //   or vice versa. => Without further provisions, insertion and removal are
 //   not linearizable and thus not concurrency-safe.
 // * To make insertion and removal linearizable, Port::state was added. It is
@@ -98,6 +108,14 @@ struct port_message : DoublyLinkedListLinkImpl<port_message> {
 	uid_t				sender;
 	gid_t				sender_group;
 	team_id				sender_team;
+	area_id				area;
+		// kernel area holding the payload of an area message, -1 once the
+		// area has been handed on to the reader
+	void*				area_address;
+		// kernel address of that area; non-NULL for area messages only
+	size_t				area_size;
+		// size of that area, accounted for instead of the message size;
+		// 0 for other messages
 	char				buffer[0];
 };
 
@@ -112,7 +130,6 @@ struct Port : public KernelReferenceable {
 	};
 
 	struct list_link	team_link;
-	Port*				hash_link;
 	port_id				id;
 	team_id				owner;
 	Port*				name_hash_link;
@@ -158,32 +175,10 @@ struct Port : public KernelReferenceable {
 };
 
 
-struct PortHashDefinition {
-	typedef port_id		KeyType;
-	typedef	Port		ValueType;
-
-	size_t HashKey(port_id key) const
-	{
-		return key;
-	}
-
-	size_t Hash(Port* value) const
-	{
-		return HashKey(value->id);
-	}
-
-	bool Compare(port_id key, Port* value) const
-	{
-		return value->id == key;
-	}
-
-	Port*& GetLink(Port* value) const
-	{
-		return value->hash_link;
-	}
-};
-
-typedef BOpenHashTable<PortHashDefinition> PortHashTable;
+struct port_slot {
+	spinlock			lock;
+	Port*				port;
+} CACHE_LINE_ALIGN;
 
 
 struct PortNameHashDefinition {
@@ -438,11 +433,12 @@ static const size_t kBufferGrowRate = kInitialPortBufferSize;
 
 #define MAX_QUEUE_LENGTH 4096
 #define PORT_MAX_MESSAGE_SIZE (256 * 1024)
+#define PORT_MAX_AREA_MESSAGE_SIZE (16 * 1024 * 1024)
 
 static int32 sMaxPorts = 4096;
 static int32 sUsedPorts;
 
-static PortHashTable sPorts;
+static port_slot* sPortSlots;
 static PortNameHashTable sPortsByName;
 static ConditionVariable sNoSpaceCondition;
 static int32 sTotalSpaceCommited;
@@ -512,9 +508,10 @@ dump_port_list(int argc, char** argv)
 	kprintf("port             id  cap  read-cnt  write-cnt   total   team  "
 		"name\n");
 
-	for (PortHashTable::Iterator it = sPorts.GetIterator();
-		Port* port = it.Next();) {
-		if ((owner != -1 && port->owner != owner)
+	for (int32 i = 0; i < sMaxPorts; i++) {
+		Port* port = sPortSlots[i].port;
+		if (port == NULL
+			|| (owner != -1 && port->owner != owner)
 			|| (name != NULL && strstr(port->lock.name, name) == NULL))
 			continue;
 
@@ -577,8 +574,9 @@ dump_port_info(int argc, char** argv)
 	} else if (parse_expression(argv[1]) > 0) {
 		// if the argument looks like a number, treat it as such
 		int32 num = parse_expression(argv[1]);
-		Port* port = sPorts.Lookup(num);
-		if (port == NULL || port->state != Port::kActive) {
+		Port* port = sPortSlots[num % sMaxPorts].port;
+		if (port == NULL || port->id != num
+			|| port->state != Port::kActive) {
 			kprintf("port %" B_PRId32 " (%#" B_PRIx32 ") doesn't exist!\n",
 				num, num);
 			return 0;
@@ -589,8 +587,11 @@ dump_port_info(int argc, char** argv)
 		name = argv[1];
 
 	// walk through the ports list, trying to match name
-	for (PortHashTable::Iterator it = sPorts.GetIterator();
-		Port* port = it.Next();) {
+	for (int32 i = 0; i < sMaxPorts; i++) {
+		Port* port = sPortSlots[i].port;
+		if (port == NULL)
+			continue;
+
 		if ((name != NULL && port->lock.name != NULL
 				&& !strcmp(name, port->lock.name))
 			|| (condition != NULL && (&port->read_condition == condition
@@ -619,38 +620,51 @@ notify_port_select_events(Port* port, uint16 events)
 
 
 static BReference<Port>
-get_locked_port(port_id id) GCC_2_NRV(portRef)
+get_port(port_id id) GCC_2_NRV(portRef)
 {
 #if __GNUC__ >= 3
 	BReference<Port> portRef;
 #endif
-	{
-		ReadLocker portsLocker(sPortsLock);
-		portRef.SetTo(sPorts.Lookup(id));
-	}
+	port_slot& slot = sPortSlots[id % sMaxPorts];
 
-	if (portRef != NULL && portRef->state == Port::kActive)
-		mutex_lock(&portRef->lock);
-	else
-		portRef.Unset();
+	InterruptsSpinLocker slotLocker(slot.lock);
+	if (slot.port != NULL && slot.port->id == id)
+		portRef.SetTo(slot.port);
 
 	return portRef;
 }
 
 
 static BReference<Port>
-get_port(port_id id) GCC_2_NRV(portRef)
+get_locked_port(port_id id) GCC_2_NRV(portRef)
 {
 #if __GNUC__ >= 3
 	BReference<Port> portRef;
 #endif
-	ReadLocker portsLocker(sPortsLock);
-	portRef.SetTo(sPorts.Lookup(id));
+	portRef = get_port(id);
+
+	if (portRef != NULL && portRef->state == Port::kActive)
+		mutex_lock(&portRef->lock);
+	else
+		portRef.Unset();
 
 	return portRef;
 }
 
 
+/*!	Sets the port of the slot the given port ID maps to.
+	sPortsLock must be write locked.
+*/
+static void
+set_port_slot(port_id id, Port* port)
+{
+	port_slot& slot = sPortSlots[id % sMaxPorts];
+
+	InterruptsSpinLocker slotLocker(slot.lock);
+	slot.port = port;
+}
+
+
 /*!	You need to own the port's lock when calling this function */
 static inline bool
 is_port_closed(Port* port)
@@ -662,7 +676,12 @@ is_port_closed(Port* port)
 static void
 put_port_message(port_message* message)
 {
-	const size_t size = sizeof(port_message) + message->size;
+	const size_t size = sizeof(port_message)
+		+ (message->area_size != 0 ? message->area_size : message->size);
+
+	if (message->area >= 0)
+		vm_delete_area(VMAddressSpace::KernelID(), message->area, true);
+
 	free(message);
 
 	atomic_add(&sTotalSpaceCommited, -size);
@@ -671,12 +690,17 @@ put_port_message(port_message* message)
 }
 
 
-/*! Port must be locked. */
+/*!	Allocates a message with a buffer of \a bufferSize bytes. For area
+	messages, \a areaSize is the size of the area, which is accounted for
+	instead of the buffer.
+	Port must be locked.
+*/
 static status_t
-get_port_message(int32 code, size_t bufferSize, uint32 flags, bigtime_t timeout,
-	port_message** _message, Port& port)
+get_port_message(int32 code, size_t bufferSize, size_t areaSize, uint32 flags,
+	bigtime_t timeout, port_message** _message, Port& port)
 {
-	const size_t size = sizeof(port_message) + bufferSize;
+	const size_t size = sizeof(port_message)
+		+ (areaSize != 0 ? areaSize : bufferSize);
 
 	while (true) {
 		int32 previouslyCommited = atomic_add(&sTotalSpaceCommited, size);
@@ -726,10 +750,14 @@ get_port_message(int32 code, size_t bufferSize, uint32 flags, bigtime_t timeout,
 		}
 
 		// Quota is fulfilled, try to allocate the buffer
-		port_message* message = (port_message*)malloc(size);
+		port_message* message
+			= (port_message*)malloc(sizeof(port_message) + bufferSize);
 		if (message != NULL) {
 			message->code = code;
 			message->size = bufferSize;
+			message->area = -1;
+			message->area_address = NULL;
+			message->area_size = areaSize;
 
 			*_message = message;
 			return B_OK;
@@ -772,19 +800,43 @@ copy_port_message(port_message* message, int32* _code, void* buffer,
 	if (_code != NULL)
 		*_code = message->code;
 
+	const void* source = message->area_address != NULL
+		? message->area_address : message->buffer;
+
 	if (size > 0) {
 		if (userCopy) {
-			status_t status = user_memcpy(buffer, message->buffer, size);
+			status_t status = user_memcpy(buffer, source, size);
 			if (status != B_OK)
 				return status;
 		} else
-			memcpy(buffer, message->buffer, size);
+			memcpy(buffer, source, size);
 	}
 
 	return size;
 }
 
 
+/*!	Transfers the payload area of the given area message to the current
+	team. The message must already have been removed from its port.
+*/
+static area_id
+transfer_port_message_area(port_message* message, void** _address)
+{
+	*_address = NULL;
+	area_id area = vm_clone_area(team_get_current_team_id(), "port message",
+		_address, B_ANY_ADDRESS, B_READ_AREA | B_WRITE_AREA
+			| B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA,
+		REGION_NO_PRIVATE_MAP, message->area, true);
+	if (area < 0)
+		return area;
+
+	vm_delete_area(VMAddressSpace::KernelID(), message->area, true);
+	message->area = -1;
+
+	return area;
+}
+
+
 static void
 uninit_port(Port* port)
 {
@@ -872,7 +924,7 @@ delete_owned_ports(Team* team)
 
 	teamPortsListLocker.Unlock();
 
-	// Remove all ports in deletionList from hashes
+	// Remove all ports in deletionList from the port table and hash
 	{
 		WriteLocker portsLocker(sPortsLock);
 
@@ -880,10 +932,10 @@ delete_owned_ports(Team* team)
 			 port != NULL;
 			 port = (Port*)list_get_next_item(&deletionList, port)) {
 
-			sPorts.Remove(port);
+			set_port_slot(port->id, NULL);
 			sPortsByName.Remove(port);
 			port->ReleaseReference();
-				// joint reference for sPorts and sPortsByName
+				// joint reference for sPortSlots and sPortsByName
 		}
 	}
 
@@ -925,19 +977,29 @@ status_t
 port_init(kernel_args *args)
 {
 	// initialize ports table and by-name hash
-	new(&sPorts) PortHashTable;
-	if (sPorts.Init() != B_OK) {
-		panic("Failed to init port hash table!");
+	virtual_address_restrictions virtualRestrictions = {};
+	virtualRestrictions.address_specification = B_ANY_KERNEL_ADDRESS;
+	physical_address_restrictions physicalRestrictions = {};
+	area_id area = create_area_etc(B_SYSTEM_TEAM, "port_table",
+		sizeof(port_slot) * sMaxPorts, B_FULL_LOCK,
+		B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA, CREATE_AREA_DONT_WAIT, 0,
+		&virtualRestrictions, &physicalRestrictions, (void**)&sPortSlots);
+	if (area < 0) {
+		panic("Failed to create port table!");
 		return B_NO_MEMORY;
 	}
 
+	memset(sPortSlots, 0, sizeof(port_slot) * sMaxPorts);
+	for (int32 i = 0; i < sMaxPorts; i++)
+		B_INITIALIZE_SPINLOCK(&sPortSlots[i].lock);
+
 	new(&sPortsByName) PortNameHashTable;
 	if (sPortsByName.Init() != B_OK) {
 		panic("Failed to init port by name hash table!");
 		return B_NO_MEMORY;
 	}
 
-	sNoSpaceCondition.Init(&sPorts, "port space");
+	sNoSpaceCondition.Init(sPortSlots, "port space");
 
 	// add debugger commands
 	add_debugger_command_etc("ports", &dump_port_list,
@@ -1007,21 +1069,22 @@ create_port(int32 queueLength, const char* name)
 	{
 		WriteLocker locker(sPortsLock);
 
-		// allocate a port ID
+		// allocate a port ID whose slot is free -- since we checked the
+		// ports limit, there is one
 		do {
 			port->id = sNextPortID++;
 
 			// handle integer overflow
 			if (sNextPortID < 0)
 				sNextPortID = 1;
-		} while (sPorts.Lookup(port->id) != NULL);
+		} while (sPortSlots[port->id % sMaxPorts].port != NULL);
 
 		// Insert port physically:
-		// (1/2) Insert into hash tables
+		// (1/2) Insert into slot table and hash table
 		port->AcquireReference();
-			// joint reference for sPorts and sPortsByName
+			// joint reference for sPortSlots and sPortsByName
 
-		sPorts.Insert(port);
+		set_port_slot(port->id, port);
 		sPortsByName.Insert(port);
 	}
 
@@ -1106,15 +1169,15 @@ delete_port(port_id id)
 		return status;
 
 	// Now remove port physically:
-	// (1/2) Remove from hash tables
+	// (1/2) Remove from slot table and hash table
 	{
 		WriteLocker portsLocker(sPortsLock);
 
-		sPorts.Remove(portRef);
+		set_port_slot(portRef->id, NULL);
 		sPortsByName.Remove(portRef);
 
 		portRef->ReleaseReference();
-			// joint reference for sPorts and sPortsByName
+			// joint reference for sPortSlots and sPortsByName
 	}
 
 	// (2/2) Remove from team port list
@@ -1429,9 +1492,14 @@ read_port(port_id port, int32* msgCode, void* buffer, size_t bufferSize)
 }
 
 
-ssize_t
-read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
-	uint32 flags, bigtime_t timeout)
+/*!	Reads a message from the port. If \a _area is not \c NULL, the payload
+	area of an area message is transferred to the current team and returned
+	in \a _area and \a _areaAddress instead of being copied; \a _area is set
+	to -1 for all other messages.
+*/
+static ssize_t
+read_port_message(port_id id, int32* _code, void* buffer, size_t bufferSize,
+	uint32 flags, bigtime_t timeout, area_id* _area, void** _areaAddress)
 {
 	if (!sPortsActive || id < 0)
 		return B_BAD_PORT_ID;
@@ -1522,6 +1590,25 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 
 	locker.Unlock();
 
+	if (_area != NULL) {
+		*_area = -1;
+
+		// If the area can't be transferred, the payload is copied instead.
+		if (message->area >= 0) {
+			area_id area = transfer_port_message_area(message, _areaAddress);
+			if (area >= 0) {
+				if (_code != NULL)
+					*_code = message->code;
+
+				size_t size = message->size;
+				*_area = area;
+
+				put_port_message(message);
+				return size;
+			}
+		}
+	}
+
 	size_t size = copy_port_message(message, _code, buffer, bufferSize,
 		userCopy);
 
@@ -1530,6 +1617,15 @@ read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
 }
 
 
+ssize_t
+read_port_etc(port_id id, int32* _code, void* buffer, size_t bufferSize,
+	uint32 flags, bigtime_t timeout)
+{
+	return read_port_message(id, _code, buffer, bufferSize, flags, timeout,
+		NULL, NULL);
+}
+
+
 status_t
 write_port(port_id id, int32 msgCode, const void* buffer, size_t bufferSize)
 {
@@ -1549,13 +1645,32 @@ write_port_etc(port_id id, int32 msgCode, const void* buffer,
 }
 
 
-status_t
-writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
-	size_t vecCount, size_t bufferSize, uint32 flags, bigtime_t timeout)
+/*!	Writes a message to the port. If \a area is valid, the ownership of the
+	area is transferred to the message, and its first \a bufferSize bytes
+	form the payload; \a msgVecs is ignored then.
+*/
+static status_t
+write_port_message(port_id id, int32 msgCode, const iovec* msgVecs,
+	size_t vecCount, size_t bufferSize, area_id area, uint32 flags,
+	bigtime_t timeout)
 {
 	if (!sPortsActive || id < 0)
 		return B_BAD_PORT_ID;
-	if (bufferSize > PORT_MAX_MESSAGE_SIZE)
+
+	// The area is checked again once it has been transferred, as it could be
+	// changed until then.
+	size_t areaSize = 0;
+	if (area >= 0) {
+		area_info info;
+		status_t status = get_area_info(area, &info);
+		if (status != B_OK)
+			return status;
+		if (info.team != team_get_current_team_id())
+			return B_PERMISSION_DENIED;
+		if (bufferSize > info.size || info.size > PORT_MAX_AREA_MESSAGE_SIZE)
+			return B_BAD_VALUE;
+		areaSize = info.size;
+	} else if (bufferSize > PORT_MAX_MESSAGE_SIZE)
 		return B_BAD_VALUE;
 
 	// mask irrelevant flags (for acquire_sem() usage)
@@ -1620,8 +1735,8 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 	} else
 		portRef->write_count--;
 
-	status = get_port_message(msgCode, bufferSize, flags, timeout,
-		&message, *portRef);
+	status = get_port_message(msgCode, area >= 0 ? 0 : bufferSize, areaSize,
+		flags, timeout, &message, *portRef);
 	if (status != B_OK) {
 		if (status == B_BAD_PORT_ID) {
 			// the port had to be unlocked and is now no longer there
@@ -1637,7 +1752,20 @@ writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
 	message->sender_group = getegid();
 	message->sender_team = team_get_current_team_id();
 
-	if (bufferSize > 0) {
+	if (area >= 0) {
+		void* address;
+		area_id kernelArea = vm_transfer_area_to_kernel(area, areaSize,
+			&address);
+		if (kernelArea < 0) {
+			put_port_message(message);
+			status = kernelArea;
+			goto error;
+		}
+
+		message->area = kernelArea;
+		message->area_address = address;
+		message->size = bufferSize;
+	} else if (bufferSize > 0) {
 		size_t offset = 0;
 		for (uint32 i = 0; i < vecCount; i++) {
 			size_t bytes = msgVecs[i].iov_len;
@@ -1684,6 +1812,15 @@ error:
 }
 
 
+status_t
+writev_port_etc(port_id id, int32 msgCode, const iovec* msgVecs,
+	size_t vecCount, size_t bufferSize, uint32 flags, bigtime_t timeout)
+{
+	return write_port_message(id, msgCode, msgVecs, vecCount, bufferSize, -1,
+		flags, timeout);
+}
+
+
 status_t
 set_port_owner(port_id id, team_id newTeamID)
 {
@@ -1942,6 +2079,141 @@ _user_writev_port_etc(port_id port, int32 messageCode, const iovec *userVecs,
 }
 
 
+ssize_t
+_user_read_port_batch(port_id port, port_batch_message* userMessages,
+	size_t count, uint32 flags, bigtime_t timeout)
+{
+	syscall_restart_handle_timeout_pre(flags, timeout);
+
+	if (userMessages == NULL || count == 0 || count > B_PORT_MAX_BATCH_COUNT)
+		return B_BAD_VALUE;
+	if (!IS_USER_ADDRESS(userMessages))
+		return B_BAD_ADDRESS;
+
+	uint32 messageFlags = flags | PORT_FLAG_USE_USER_MEMCPY | B_CAN_INTERRUPT;
+	bigtime_t messageTimeout = timeout;
+	ssize_t status = B_OK;
+
+	size_t read = 0;
+	for (; read < count; read++) {
+		// Make sure the result can be written back before dequeuing the
+		// message, so that it is not lost.
+		port_batch_message message;
+		if (user_memcpy(&message, userMessages + read, sizeof(message))
+				!= B_OK
+			|| user_memcpy(userMessages + read, &message, sizeof(message))
+				!= B_OK) {
+			status = B_BAD_ADDRESS;
+			break;
+		}
+
+		if (message.buffer == NULL && message.size != 0) {
+			status = B_BAD_VALUE;
+			break;
+		}
+		if (message.buffer != NULL && !IS_USER_ADDRESS(message.buffer)) {
+			status = B_BAD_ADDRESS;
+			break;
+		}
+
+		bool acceptArea = (message.flags & B_PORT_MESSAGE_AREA) != 0;
+		void* areaAddress = NULL;
+		status = read_port_message(port, &message.code, message.buffer,
+			message.size, messageFlags, messageTimeout,
+			acceptArea ? &message.area : NULL, &areaAddress);
+		if (status < 0)
+			break;
+
+		message.size = status;
+		message.flags &= ~B_PORT_MESSAGE_AREA;
+		if (!acceptArea)
+			message.area = -1;
+		else if (message.area >= 0) {
+			message.flags |= B_PORT_MESSAGE_AREA;
+			message.buffer = areaAddress;
+		}
+
+		if (user_memcpy(userMessages + read, &message, sizeof(message))
+				!= B_OK) {
+			// Another thread has unmapped or protected the array since we
+			// checked it, and the message is lost. At least don't leave its
+			// area behind in our team.
+			if (message.area >= 0)
+				vm_delete_area(team_get_current_team_id(), message.area, false);
+			status = B_BAD_ADDRESS;
+			break;
+		}
+
+		// only wait for the first message
+		messageFlags = (messageFlags & ~B_ABSOLUTE_TIMEOUT)
+			| B_RELATIVE_TIMEOUT;
+		messageTimeout = 0;
+	}
+
+	if (read > 0)
+		return read;
+
+	return syscall_restart_handle_timeout_post(status, timeout);
+}
+
+
+ssize_t
+_user_write_port_batch(port_id port, const port_batch_message* userMessages,
+	size_t count, uint32 flags, bigtime_t timeout)
+{
+	syscall_restart_handle_timeout_pre(flags, timeout);
+
+	if (userMessages == NULL || count == 0 || count > B_PORT_MAX_BATCH_COUNT)
+		return B_BAD_VALUE;
+	if (!IS_USER_ADDRESS(userMessages))
+		return B_BAD_ADDRESS;
+
+	uint32 messageFlags = flags | PORT_FLAG_USE_USER_MEMCPY | B_CAN_INTERRUPT;
+	bigtime_t messageTimeout = timeout;
+	status_t status = B_OK;
+
+	size_t written = 0;
+	for (; written < count; written++) {
+		port_batch_message message;
+		if (user_memcpy(&message, userMessages + written, sizeof(message))
+				!= B_OK) {
+			status = B_BAD_ADDRESS;
+			break;
+		}
+
+		if ((message.flags & B_PORT_MESSAGE_AREA) != 0) {
+			status = write_port_message(port, message.code, NULL, 0,
+				message.size, message.area, messageFlags, messageTimeout);
+		} else {
+			if (message.buffer == NULL && message.size != 0) {
+				status = B_BAD_VALUE;
+				break;
+			}
+			if (message.buffer != NULL && !IS_USER_ADDRESS(message.buffer)) {
+				status = B_BAD_ADDRESS;
+				break;
+			}
+
+			iovec vec = { message.buffer, message.size };
+			status = write_port_message(port, message.code, &vec, 1,
+				message.size, -1, messageFlags, messageTimeout);
+		}
+		if (status != B_OK)
+			break;
+
+		// only wait for the first message
+		messageFlags = (messageFlags & ~B_ABSOLUTE_TIMEOUT)
+			| B_RELATIVE_TIMEOUT;
+		messageTimeout = 0;
+	}
+
+	if (written > 0)
+		return written;
+
+	return syscall_restart_handle_timeout_post(status, timeout);
+}
+
+
 status_t
 _user_get_port_message_info_etc(port_id port, port_message_info *userInfo,
 	size_t infoSize, uint32 flags, bigtime_t timeout)
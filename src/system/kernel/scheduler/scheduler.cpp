@@ -295,6 +295,11 @@ switch_thread(Thread* fromThread, Thread* toThread)
 	// stop CPU time based user timers
 	stop_cpu_timers(fromThread, toThread);
 
+	// a restartable sequence toThread is in has to be aborted, and its CPU
+	// number updated, before it returns to userland
+	if ((toThread->flags & THREAD_FLAGS_RSEQ) != 0)
+		atomic_or(&toThread->flags, THREAD_FLAGS_RSEQ_PENDING);
+
 	// update CPU and Thread structures and perform the context switch
 	cpu_ent* cpu = fromThread->cpu;
 	toThread->previous_cpu = toThread->cpu = cpu;
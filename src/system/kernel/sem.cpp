@@ -116,7 +116,9 @@ struct sem_entry {
 	sem_id				id;
 	spinlock			lock;	// protects only the id field when unused
 	ThreadQueue			queue;	// should be in u.used, but has a constructor
-};
+} CACHE_LINE_ALIGN;
+	// Each entry gets its own cache line, so that using different semaphores
+	// doesn't make their locks bounce between CPUs.
 
 static const int32 kMaxSemaphores = 65536;
 static int32 sMaxSems = 4096;
@@ -417,9 +419,10 @@ haiku_sem_init(kernel_args *args)
 	TRACE(("sem_init: entry\n"));
 
 	// compute maximal number of semaphores depending on the available memory
-	// 128 MB -> 16384 semaphores, 448 kB fixed array size
-	// 256 MB -> 32768, 896 kB
-	// 512 MB and more-> 65536, 1.75 MB
+	// 128 MB -> 16384 semaphores
+	// 256 MB -> 32768
+	// 512 MB and more-> 65536
+	// Since entries are cache line aligned, that's 64 or 128 bytes each.
 	i = vm_page_num_pages() / 2;
 	while (sMaxSems < i && sMaxSems < kMaxSemaphores)
 		sMaxSems <<= 1;
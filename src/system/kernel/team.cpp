@@ -15,6 +15,7 @@
 #include <team.h>
 
 #include <errno.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,6 +33,7 @@
 #include <elf.h>
 #include <file_cache.h>
 #include <find_directory_private.h>
+#include <fs/fd.h>
 #include <fs/KPath.h>
 #include <heap.h>
 #include <int.h>
@@ -44,6 +46,7 @@
 #include <posix/realtime_sem.h>
 #include <posix/xsi_semaphore.h>
 #include <sem.h>
+#include <spawn_defs.h>
 #include <syscall_process_info.h>
 #include <syscall_restart.h>
 #include <syscalls.h>
@@ -82,6 +85,8 @@ struct team_arg {
 	uint32	flags;
 	port_id	error_port;
 	uint32	error_token;
+	const struct spawn_attributes* spawn_attributes;
+		// owned by the thread waiting for the team to be loaded
 };
 
 #define TEAM_ARGS_FLAG_NO_ASLR	0x01
@@ -447,6 +452,7 @@ Team::Team(team_id id, bool kernel)
 	thread_list = NULL;
 	main_thread = NULL;
 	loading_info = NULL;
+	vfork_condition = NULL;
 	state = TEAM_STATE_BIRTH;
 	flags = 0;
 	death_entry = NULL;
@@ -455,6 +461,7 @@ Team::Team(team_id id, bool kernel)
 	used_user_data = 0;
 	user_data_size = 0;
 	free_user_threads = NULL;
+	cached_user_stack_count = 0;
 
 	commpage_address = NULL;
 
@@ -1404,6 +1411,9 @@ delete_team_user_data(Team* team)
 			free(entry);
 		}
 	}
+
+	// the cached stacks are deleted with the other areas of the team
+	team->cached_user_stack_count = 0;
 }
 
 
@@ -1501,6 +1511,7 @@ create_team_arg(struct team_arg** _teamArg, const char* path, char** flatArgs,
 	teamArg->umask = umask;
 	teamArg->error_port = port;
 	teamArg->error_token = token;
+	teamArg->spawn_attributes = NULL;
 
 	// determine the flags from the environment
 	const char* const* env = flatArgs + argCount + 1;
@@ -1516,6 +1527,95 @@ create_team_arg(struct team_arg** _teamArg, const char* path, char** flatArgs,
 }
 
 
+/*!	Lets the thread waiting for \a team to be loaded know that this failed
+	with \a error.
+*/
+static void
+notify_team_loading_failed(Team* team, status_t error)
+{
+	TeamLocker teamLocker(team);
+
+	if (team->loading_info != NULL) {
+		struct team_loading_info* loadingInfo = team->loading_info;
+		team->loading_info = NULL;
+
+		loadingInfo->result = error;
+		loadingInfo->done = true;
+
+		thread_continue(loadingInfo->thread);
+	}
+}
+
+
+/*!	Performs the file actions and applies those attributes of a spawned team
+	that have to be applied by the team itself. Must be called by the team's
+	main thread before it enters userland.
+*/
+static status_t
+apply_spawn_attributes(Team* team, const spawn_attributes* attributes)
+{
+	for (int32 i = 0; i < attributes->file_action_count; i++) {
+		const spawn_file_action& action = attributes->file_actions[i];
+		status_t status = B_OK;
+
+		switch (action.type) {
+			case B_SPAWN_FILE_ACTION_OPEN:
+			{
+				// the file is created by the child, with the umask the
+				// parent had when it spawned it
+				int fd = vfs_open(action.path, action.open_flags,
+					action.open_mode & ~attributes->umask, false);
+				if (fd < 0)
+					return fd;
+
+				if (fd != action.fd) {
+					status = dup2_fd(fd, action.fd, false);
+					close_fd_index(team->io_context, fd);
+				}
+				break;
+			}
+
+			case B_SPAWN_FILE_ACTION_CLOSE:
+				status = close_fd_index(team->io_context, action.fd);
+				break;
+
+			case B_SPAWN_FILE_ACTION_DUP2:
+				if (action.source_fd == action.fd) {
+					// POSIX wants the close-on-exec flag to be cleared
+					if (!fd_is_valid(action.fd, false))
+						return B_FILE_ERROR;
+					fd_set_close_on_exec(team->io_context, action.fd, false);
+				} else
+					status = dup2_fd(action.source_fd, action.fd, false);
+				break;
+
+			default:
+				return B_BAD_VALUE;
+		}
+
+		if (status < B_OK)
+			return status;
+	}
+
+	// the file actions may still have needed them
+	vfs_exec_io_context(team->io_context);
+
+	if ((attributes->flags & POSIX_SPAWN_SETSID) != 0) {
+		pid_t session = _user_setsid();
+		if (session < 0)
+			return session;
+	}
+
+	if ((attributes->flags & POSIX_SPAWN_SETPGROUP) != 0) {
+		pid_t group = _user_setpgid(0, attributes->process_group);
+		if (group < 0)
+			return group;
+	}
+
+	return B_OK;
+}
+
+
 static status_t
 team_create_thread_start_internal(void* args)
 {
@@ -1534,6 +1634,15 @@ team_create_thread_start_internal(void* args)
 	team = thread->team;
 	cache_node_launched(teamArgs->arg_count, teamArgs->flat_args);
 
+	if (teamArgs->spawn_attributes != NULL) {
+		err = apply_spawn_attributes(team, teamArgs->spawn_attributes);
+		if (err != B_OK) {
+			notify_team_loading_failed(team, err);
+			free_team_arg(teamArgs);
+			return err;
+		}
+	}
+
 	TRACE(("team_create_thread_start: entry thread %" B_PRId32 "\n",
 		thread->id));
 
@@ -1665,10 +1774,17 @@ team_create_thread_start(void* args)
 }
 
 
+/*!	Creates a new team running the executable \a executablePath, or the one
+	given by the first of the \a _flatArgs, if that is \c NULL.
+	If \a spawnAttributes is not \c NULL, the team is set up as for
+	posix_spawn() as described in <spawn_defs.h>, and \a flags must contain
+	\c B_WAIT_TILL_LOADED.
+*/
 static thread_id
 load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	int32 envCount, int32 priority, team_id parentID, uint32 flags,
-	port_id errorPort, uint32 errorToken)
+	port_id errorPort, uint32 errorToken, const char* executablePath = NULL,
+	const spawn_attributes* spawnAttributes = NULL)
 {
 	char** flatArgs = _flatArgs;
 	thread_id thread;
@@ -1680,8 +1796,10 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 
 	if (flatArgs == NULL || argCount == 0)
 		return B_BAD_VALUE;
+	if (spawnAttributes != NULL && (flags & B_WAIT_TILL_LOADED) == 0)
+		return B_BAD_VALUE;
 
-	const char* path = flatArgs[0];
+	const char* path = executablePath != NULL ? executablePath : flatArgs[0];
 
 	TRACE(("load_image_internal: name '%s', args = %p, argCount = %" B_PRId32
 		"\n", path, flatArgs, argCount));
@@ -1725,6 +1843,26 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	// inherit the parent's user/group
 	inherit_parent_user_and_group(team, parent);
 
+	if (spawnAttributes != NULL) {
+		if ((spawnAttributes->flags & POSIX_SPAWN_RESETIDS) != 0) {
+			team->effective_uid = team->real_uid;
+			team->effective_gid = team->real_gid;
+		}
+
+		// keep ignored signals ignored, as exec*() would
+		team->InheritSignalActions(parent);
+		team->ResetSignalsOnExec();
+
+		if ((spawnAttributes->flags & POSIX_SPAWN_SETSIGDEF) != 0) {
+			for (uint32 i = 1; i <= MAX_SIGNAL_NUMBER; i++) {
+				if ((spawnAttributes->default_signals
+						& SIGNAL_TO_MASK(i)) != 0) {
+					team->SignalActionFor(i).sa_handler = SIG_DFL;
+				}
+			}
+		}
+	}
+
  	InterruptsSpinLocker teamsLocker(sTeamHashLock);
 
 	sTeamHash.Insert(team);
@@ -1756,15 +1894,21 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	}
 
 	status = create_team_arg(&teamArgs, path, flatArgs, flatArgsSize, argCount,
-		envCount, (mode_t)-1, errorPort, errorToken);
+		envCount, spawnAttributes != NULL ? spawnAttributes->umask : (mode_t)-1,
+		errorPort, errorToken);
 	if (status != B_OK)
 		goto err1;
 
 	_flatArgs = NULL;
 		// args are owned by the team_arg structure now
 
-	// create a new io_context for this team
-	team->io_context = vfs_new_io_context(parentIOContext, true);
+	teamArgs->spawn_attributes = spawnAttributes;
+
+	// create a new io_context for this team -- the file actions of a spawned
+	// team may still use the parent's close-on-exec FDs, so the team closes
+	// them itself
+	team->io_context = vfs_new_io_context(parentIOContext,
+		spawnAttributes == NULL);
 	if (!team->io_context) {
 		status = B_NO_MEMORY;
 		goto err2;
@@ -1775,7 +1919,8 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 	parentIOContext = NULL;
 
 	// remove any fds that have the CLOEXEC flag set (emulating BeOS behaviour)
-	vfs_exec_io_context(team->io_context);
+	if (spawnAttributes == NULL)
+		vfs_exec_io_context(team->io_context);
 
 	// create an address space for this team
 	status = VMAddressSpace::Create(team->id, USER_BASE, USER_SIZE, false,
@@ -1802,6 +1947,10 @@ load_image_internal(char**& _flatArgs, size_t flatArgsSize, int32 argCount,
 			threadName, B_NORMAL_PRIORITY, teamArgs, teamID, mainThread);
 		threadAttributes.additional_stack_size = sizeof(user_space_program_args)
 			+ teamArgs->flat_args_size;
+		if (spawnAttributes != NULL) {
+			threadAttributes.signal_mask
+				= spawnAttributes->signal_mask & BLOCKABLE_SIGNALS;
+		}
 		thread = thread_create_thread(threadAttributes, false);
 		if (thread < 0) {
 			status = thread;
@@ -1870,6 +2019,22 @@ err1:
 }
 
 
+/*!	Lets the parent thread of a vfork() child continue, if \a team is such a
+	child. Must be called once the team no longer uses the areas it got from
+	its parent, as those are not write protected in the parent until then.
+*/
+static void
+release_vfork_parent(Team* team)
+{
+	TeamLocker teamLocker(team);
+
+	if (team->vfork_condition != NULL) {
+		team->vfork_condition->NotifyAll();
+		team->vfork_condition = NULL;
+	}
+}
+
+
 /*!	Almost shuts down the current team and loads a new image into it.
 	If successful, this function does not return and will takeover ownership of
 	the arguments provided.
@@ -1944,6 +2109,7 @@ exec_team(const char* path, char**& _flatArgs, size_t flatArgsSize,
 
 	delete_team_user_data(team);
 	vm_delete_areas(team->address_space, false);
+	release_vfork_parent(team);
 	xsi_sem_undo(team);
 	delete_owned_ports(team);
 	sem_delete_owned_sems(team);
@@ -2018,8 +2184,13 @@ exec_team(const char* path, char**& _flatArgs, size_t flatArgsSize,
 }
 
 
+/*!	Creates a copy of the current team, running a copy of the current thread.
+	If \a vfork is \c true, the areas of the current team are not write
+	protected for copy-on-write, and the current thread waits until the child
+	has called exec*() or has exited instead. The pages stay shared until then.
+*/
 static thread_id
-fork_team(void)
+fork_team(bool vfork)
 {
 	Thread* parentThread = thread_get_current_thread();
 	Team* parentTeam = parentThread->team;
@@ -2030,12 +2201,22 @@ fork_team(void)
 	status_t status;
 	ssize_t areaCookie;
 	int32 imageCookie;
+	ConditionVariable vforkCondition;
 
-	TRACE(("fork_team(): team %" B_PRId32 "\n", parentTeam->id));
+	TRACE(("fork_team(vfork = %d): team %" B_PRId32 "\n", vfork,
+		parentTeam->id));
 
 	if (parentTeam == team_get_kernel_team())
 		return B_NOT_ALLOWED;
 
+	// A vfork() child still shares its pages with its parent, so any copy of
+	// it would see the parent's changes.
+	parentTeam->Lock();
+	bool isVforkChild = parentTeam->vfork_condition != NULL;
+	parentTeam->Unlock();
+	if (isVforkChild)
+		return B_NOT_ALLOWED;
+
 	// create a new team
 	// TODO: this is very similar to load_image_internal() - maybe we can do
 	// something about it :)
@@ -2060,6 +2241,11 @@ fork_team(void)
 
 	team->commpage_address = parentTeam->commpage_address;
 
+	if (vfork) {
+		vforkCondition.Init(team, "vfork");
+		team->vfork_condition = &vforkCondition;
+	}
+
 	// Inherit the parent's user/group.
 	inherit_parent_user_and_group(team, parentTeam);
 
@@ -2138,7 +2324,7 @@ fork_team(void)
 		} else {
 			void* address;
 			area_id area = vm_copy_area(team->address_space->ID(), info.name,
-				&address, B_CLONE_ADDRESS, info.protection, info.area);
+				&address, B_CLONE_ADDRESS, info.protection, info.area, !vfork);
 			if (area < B_OK) {
 				status = area;
 				break;
@@ -2198,6 +2384,31 @@ fork_team(void)
 
 	T(TeamForked(threadID));
 
+	if (vfork) {
+		// Our pages are not write protected, so we must not touch them
+		// before the child is done with its copies of our areas. Keep a
+		// reference, as another thread of ours could reap the child meanwhile.
+		BReference<Team> teamReference(team);
+		ConditionVariableEntry entry;
+
+		team->Lock();
+		bool wait = team->vfork_condition != NULL;
+		if (wait)
+			vforkCondition.Add(&entry);
+		team->Unlock();
+
+		resume_thread(threadID);
+
+		if (wait)
+			entry.Wait(B_KILL_CAN_INTERRUPT);
+
+		team->Lock();
+		team->vfork_condition = NULL;
+		team->Unlock();
+
+		return threadID;
+	}
+
 	resume_thread(threadID);
 	return threadID;
 
@@ -3221,6 +3432,7 @@ team_delete_team(Team* team, port_id debuggerPort)
 	xsi_sem_undo(team);
 	remove_images(team);
 	team->address_space->RemoveAndPut();
+	release_vfork_parent(team);
 
 	team->ReleaseReference();
 
@@ -3508,6 +3720,56 @@ team_free_user_thread(Team* team, struct user_thread* userThread)
 }
 
 
+/*!	Takes a stack area of an exited thread from the team's cache.
+	The team's lock must not be held. Interrupts must be enabled.
+	\param team The team the stack area shall belong to.
+	\param size The size the area must have.
+	\param _address Set to the base address of the area.
+	\return The ID of the area, or \c -1, if there is no suitable one.
+*/
+area_id
+team_get_cached_user_stack(Team* team, size_t size, void** _address)
+{
+	TeamLocker teamLocker(team);
+
+	while (team->cached_user_stack_count > 0) {
+		area_id area
+			= team->cached_user_stacks[--team->cached_user_stack_count];
+
+		// the team might have deleted or resized the area in the meantime
+		area_info info;
+		if (get_area_info(area, &info) == B_OK && info.team == team->id
+			&& info.size == size) {
+			*_address = info.address;
+			return area;
+		}
+	}
+
+	return -1;
+}
+
+
+/*!	Puts the stack area of an exited thread into the team's cache, so that it
+	can be reused for a new thread.
+	The team's lock must not be held. Interrupts must be enabled.
+	\return \c true, if the area has been cached, \c false, if the cache is
+		full or the team is going away, and the caller has to delete the area.
+*/
+bool
+team_cache_user_stack(Team* team, area_id area)
+{
+	TeamLocker teamLocker(team);
+
+	if (team->state >= TEAM_STATE_SHUTDOWN
+		|| team->cached_user_stack_count == MAX_CACHED_USER_STACKS) {
+		return false;
+	}
+
+	team->cached_user_stacks[team->cached_user_stack_count++] = area;
+	return true;
+}
+
+
 //	#pragma mark - Associated data interface
 
 
@@ -3909,7 +4171,14 @@ _user_exec(const char* userPath, const char* const* userFlatArgs,
 thread_id
 _user_fork(void)
 {
-	return fork_team();
+	return fork_team(false);
+}
+
+
+thread_id
+_user_vfork(void)
+{
+	return fork_team(true);
 }
 
 
@@ -4202,6 +4471,141 @@ _user_load_image(const char* const* userFlatArgs, size_t flatArgsSize,
 }
 
 
+static void
+free_spawn_file_actions(spawn_file_action* actions, int32 count)
+{
+	if (actions == NULL)
+		return;
+
+	for (int32 i = 0; i < count; i++)
+		free(actions[i].path);
+
+	free(actions);
+}
+
+
+/*!	Copies the file actions of \a attributes from userland. On success, the
+	caller owns \a attributes.file_actions and the paths referred to by it.
+*/
+static status_t
+copy_user_spawn_file_actions(spawn_attributes& attributes)
+{
+	int32 count = attributes.file_action_count;
+	if (count == 0) {
+		attributes.file_actions = NULL;
+		return B_OK;
+	}
+
+	if (count < 0 || count > B_SPAWN_MAX_FILE_ACTIONS)
+		return B_BAD_VALUE;
+
+	const spawn_file_action* userActions = attributes.file_actions;
+	if (userActions == NULL || !IS_USER_ADDRESS(userActions))
+		return B_BAD_ADDRESS;
+
+	spawn_file_action* actions = (spawn_file_action*)malloc(
+		count * sizeof(spawn_file_action));
+	if (actions == NULL)
+		return B_NO_MEMORY;
+
+	if (user_memcpy(actions, userActions, count * sizeof(spawn_file_action))
+			!= B_OK) {
+		free(actions);
+		return B_BAD_ADDRESS;
+	}
+
+	KPath pathBuffer(B_PATH_NAME_LENGTH + 1);
+	if (pathBuffer.InitCheck() != B_OK) {
+		free(actions);
+		return B_NO_MEMORY;
+	}
+
+	// Replace the user paths with kernel copies. Only the first i actions
+	// have kernel paths in case of an error.
+	for (int32 i = 0; i < count; i++) {
+		char* userPath = actions[i].path;
+		actions[i].path = NULL;
+
+		if (actions[i].type != B_SPAWN_FILE_ACTION_OPEN)
+			continue;
+
+		status_t status = B_OK;
+		char* buffer = pathBuffer.LockBuffer();
+		ssize_t length = B_BAD_ADDRESS;
+		if (userPath != NULL && IS_USER_ADDRESS(userPath))
+			length = user_strlcpy(buffer, userPath, B_PATH_NAME_LENGTH);
+
+		if (length < 0)
+			status = B_BAD_ADDRESS;
+		else if (length >= B_PATH_NAME_LENGTH)
+			status = B_NAME_TOO_LONG;
+		else if ((actions[i].path = strdup(buffer)) == NULL)
+			status = B_NO_MEMORY;
+
+		pathBuffer.UnlockBuffer();
+
+		if (status != B_OK) {
+			free_spawn_file_actions(actions, i);
+			return status;
+		}
+	}
+
+	attributes.file_actions = actions;
+	return B_OK;
+}
+
+
+thread_id
+_user_spawn(const char* userPath, const char* const* userFlatArgs,
+	size_t flatArgsSize, int32 argCount, int32 envCount,
+	const spawn_attributes* userAttributes)
+{
+	TRACE(("_user_spawn: argc = %" B_PRId32 "\n", argCount));
+
+	if (argCount < 1 || userAttributes == NULL)
+		return B_BAD_VALUE;
+
+	char path[B_PATH_NAME_LENGTH];
+	if (!IS_USER_ADDRESS(userPath)
+		|| user_strlcpy(path, userPath, sizeof(path)) < B_OK)
+		return B_BAD_ADDRESS;
+
+	spawn_attributes attributes;
+	if (!IS_USER_ADDRESS(userAttributes)
+		|| user_memcpy(&attributes, userAttributes, sizeof(attributes))
+			!= B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	status_t error = copy_user_spawn_file_actions(attributes);
+	if (error != B_OK)
+		return error;
+
+	// copy and relocate the flat arguments
+	char** flatArgs;
+	error = copy_user_process_args(userFlatArgs, flatArgsSize, argCount,
+		envCount, flatArgs);
+	if (error != B_OK) {
+		free_spawn_file_actions(attributes.file_actions,
+			attributes.file_action_count);
+		return error;
+	}
+
+	// We wait until the team has been loaded, so the attributes are no longer
+	// needed when this returns.
+	thread_id thread = load_image_internal(flatArgs, _ALIGN(flatArgsSize),
+		argCount, envCount, B_NORMAL_PRIORITY, B_CURRENT_TEAM,
+		B_WAIT_TILL_LOADED, -1, 0, path, &attributes);
+
+	free(flatArgs);
+		// load_image_internal() unset our variable if it took over ownership
+	free_spawn_file_actions(attributes.file_actions,
+		attributes.file_action_count);
+
+	return thread;
+}
+
+
 void
 _user_exit_team(status_t returnValue)
 {
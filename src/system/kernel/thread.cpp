@@ -654,6 +654,8 @@ enter_userspace(Thread* thread, UserThreadEntryArguments* args)
 	userThread->defer_signals
 		= (args->flags & THREAD_CREATION_FLAG_DEFER_SIGNALS) != 0 ? 1 : 0;
 	userThread->pending_signals = 0;
+	userThread->cpu = -1;
+	userThread->rseq = NULL;
 
 	if (args->forkArgs != NULL) {
 		// This is a fork()ed thread. Copy the fork args onto the stack and
@@ -770,6 +772,30 @@ init_thread_kernel_stack(Thread* thread, const void* data, size_t dataSize)
 }
 
 
+/*!	Returns whether the given stack area of the thread has the layout a stack
+	created with the default attributes has, so that it can be reused for any
+	such thread.
+*/
+static bool
+has_default_user_stack(Thread* thread, area_id stackArea)
+{
+	area_info info;
+	if (thread->user_stack_size != USER_STACK_SIZE
+		|| get_area_info(stackArea, &info) != B_OK
+		|| info.size != PAGE_ALIGN(USER_STACK_GUARD_SIZE + USER_STACK_SIZE
+			+ TLS_SIZE)) {
+		return false;
+	}
+
+#ifdef STACK_GROWS_DOWNWARDS
+	return thread->user_stack_base
+		== (addr_t)info.address + USER_STACK_GUARD_SIZE;
+#else
+	return thread->user_stack_base == (addr_t)info.address;
+#endif
+}
+
+
 static status_t
 create_thread_user_stack(Team* team, Thread* thread, void* _stackBase,
 	size_t stackSize, size_t additionalSize, size_t guardSize,
@@ -808,23 +834,46 @@ create_thread_user_stack(Team* team, Thread* thread, void* _stackBase,
 		size_t areaSize = PAGE_ALIGN(guardSize + stackSize + TLS_SIZE
 			+ additionalSize);
 
-		snprintf(nameBuffer, B_OS_NAME_LENGTH, "%s_%" B_PRId32 "_stack",
-			thread->name, thread->id);
+		// Reuse the stack of an exited thread, if it has the default layout.
+		// We can only clear its TLS, if we're in the team's address space.
+		if (stackSize == USER_STACK_SIZE && guardSize == USER_STACK_GUARD_SIZE
+			&& additionalSize == 0
+			&& team == thread_get_current_thread()->team) {
+			stackArea = team_get_cached_user_stack(team, areaSize,
+				(void**)&stackBase);
+			if (stackArea >= 0) {
+#ifdef STACK_GROWS_DOWNWARDS
+				uint8* tls = stackBase + guardSize + stackSize;
+#else
+				uint8* tls = stackBase + stackSize;
+#endif
+				if (user_memset(tls, 0, TLS_SIZE) != B_OK) {
+					vm_delete_area(team->id, stackArea, true);
+					stackArea = -1;
+				}
+			}
+		}
+
+		if (stackArea < 0) {
+			snprintf(nameBuffer, B_OS_NAME_LENGTH, "%s_%" B_PRId32 "_stack",
+				thread->name, thread->id);
 
-		stackBase = (uint8*)USER_STACK_REGION;
+			stackBase = (uint8*)USER_STACK_REGION;
 
-		virtual_address_restrictions virtualRestrictions = {};
-		virtualRestrictions.address_specification = B_RANDOMIZED_BASE_ADDRESS;
-		virtualRestrictions.address = (void*)stackBase;
+			virtual_address_restrictions virtualRestrictions = {};
+			virtualRestrictions.address_specification
+				= B_RANDOMIZED_BASE_ADDRESS;
+			virtualRestrictions.address = (void*)stackBase;
 
-		physical_address_restrictions physicalRestrictions = {};
+			physical_address_restrictions physicalRestrictions = {};
 
-		stackArea = create_area_etc(team->id, nameBuffer,
-			areaSize, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA | B_STACK_AREA,
-			0, guardSize, &virtualRestrictions, &physicalRestrictions,
-			(void**)&stackBase);
-		if (stackArea < 0)
-			return stackArea;
+			stackArea = create_area_etc(team->id, nameBuffer,
+				areaSize, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA | B_STACK_AREA,
+				0, guardSize, &virtualRestrictions, &physicalRestrictions,
+				(void**)&stackBase);
+			if (stackArea < 0)
+				return stackArea;
+		}
 	}
 
 	// set the stack
@@ -1413,6 +1462,37 @@ common_snooze_etc(bigtime_t timeout, clockid_t clockID, uint32 flags,
 }
 
 
+/*!	Updates the CPU number in the current thread's user_thread, and aborts the
+	restartable sequence the thread was interrupted in, if any.
+	Interrupts must be enabled, as the sequence is read from userland memory.
+*/
+static void
+handle_rseq(Thread* thread)
+{
+	atomic_and(&thread->flags, ~THREAD_FLAGS_RSEQ_PENDING);
+
+	user_thread* userThread = thread->user_thread;
+	userThread->cpu = smp_get_current_cpu();
+
+	const user_rseq* sequence = userThread->rseq;
+	if (sequence == NULL)
+		return;
+
+	// Once the thread has left the sequence, there is no need to check it
+	// again. If it is still inside, it stores the pointer again when the
+	// sequence is restarted.
+	userThread->rseq = NULL;
+
+	user_rseq info;
+	if (!IS_USER_ADDRESS(sequence)
+		|| user_memcpy(&info, sequence, sizeof(info)) != B_OK) {
+		return;
+	}
+
+	arch_thread_abort_user_sequence(info.start, info.end, info.abort);
+}
+
+
 //	#pragma mark - debugger calls
 
 
@@ -1949,11 +2029,14 @@ thread_exit(void)
 			team_free_user_thread(team, userThread);
 	}
 
-	// remember the user stack area -- we will delete it below
+	// remember the user stack area -- we will delete or cache it below
 	area_id userStackArea = -1;
+	bool cacheUserStack = false;
 	if (team->address_space != NULL && thread->user_stack_area >= 0) {
 		userStackArea = thread->user_stack_area;
 		thread->user_stack_area = -1;
+		cacheUserStack = thread != team->main_thread
+			&& has_default_user_stack(thread, userStackArea);
 	}
 
 	struct job_control_entry *death = NULL;
@@ -2235,7 +2318,18 @@ thread_exit(void)
 		// first.
 		// When the team is deleted, all areas are deleted anyway, so we don't
 		// need to do that explicitly in that case.
-		vm_delete_area(teamID, userStackArea, true);
+		// Stacks of the default layout are kept by the team instead, to be
+		// reused for the next threads it creates.
+		bool cached = false;
+		if (cacheUserStack) {
+			if (Team* stackTeam = Team::Get(teamID)) {
+				BReference<Team> teamReference(stackTeam, true);
+				cached = team_cache_user_stack(stackTeam, userStackArea);
+			}
+		}
+
+		if (!cached)
+			vm_delete_area(teamID, userStackArea, true);
 	}
 
 	// notify the debugger
@@ -2295,10 +2389,21 @@ thread_at_kernel_exit(void)
 
 	TRACE(("thread_at_kernel_exit: exit thread %" B_PRId32 "\n", thread->id));
 
+	// a signal handler must not run in the middle of a restartable sequence
+	if ((thread->flags & THREAD_FLAGS_RSEQ) != 0)
+		handle_rseq(thread);
+
 	handle_signals(thread);
 
 	disable_interrupts();
 
+	// we might have been rescheduled in the meantime
+	while ((thread->flags & THREAD_FLAGS_RSEQ_PENDING) != 0) {
+		enable_interrupts();
+		handle_rseq(thread);
+		disable_interrupts();
+	}
+
 	// track kernel time
 	bigtime_t now = system_time();
 	SpinLocker threadTimeLocker(thread->time_lock);
@@ -2352,6 +2457,10 @@ thread_reset_for_exec(void)
 	// reset signals
 	thread->ResetSignalsOnExec();
 
+	// the new image has to register for restartable sequences again
+	atomic_and(&thread->flags,
+		~(THREAD_FLAGS_RSEQ | THREAD_FLAGS_RSEQ_PENDING));
+
 	// reset thread CPU time clock
 	InterruptsSpinLocker timeLocker(thread->time_lock);
 	thread->cpu_clock_offset = -thread->CPUTime(false);
@@ -2869,6 +2978,8 @@ thread_block()
 		- \c B_TIMEOUT_REAL_TIME_BASE: Only relevant when \c B_ABSOLUTE_TIMEOUT
 			is specified, too. Specifies that \a timeout is a real time, not a
 			system time.
+		- \c B_TIMEOUT_ALLOW_SLACK: The timeout may occur a little late, so
+			that the timer can be coalesced with others.
 		If neither \c B_RELATIVE_TIMEOUT nor \c B_ABSOLUTE_TIMEOUT are
 		specified, an infinite timeout is implied and the function behaves like
 		thread_block_locked().
@@ -2902,6 +3013,9 @@ thread_block_with_timeout(uint32 timeoutFlags, bigtime_t timeout)
 				timerFlags |= B_TIMER_REAL_TIME_BASE;
 		}
 
+		if ((timeoutFlags & B_TIMEOUT_ALLOW_SLACK) != 0)
+			timerFlags |= B_TIMER_ALLOW_SLACK;
+
 		// install the timer
 		thread->wait.unblock_timer.user_data = thread;
 		add_timer(&thread->wait.unblock_timer, &thread_block_timeout, timeout,
@@ -3677,6 +3791,23 @@ _user_unblock_threads(thread_id* userThreads, uint32 count, status_t status)
 }
 
 
+/*!	Enables restartable sequences for the current thread. From now on, the
+	kernel keeps user_thread::cpu up to date, and aborts the sequence
+	user_thread::rseq points to, when the thread is interrupted within it.
+*/
+status_t
+_user_register_rseq(void)
+{
+	Thread* thread = thread_get_current_thread();
+
+	thread->user_thread->rseq = NULL;
+	atomic_or(&thread->flags, THREAD_FLAGS_RSEQ | THREAD_FLAGS_RSEQ_PENDING);
+		// the CPU number is filled in on the way back to userland
+
+	return B_OK;
+}
+
+
 // TODO: the following two functions don't belong here
 
 
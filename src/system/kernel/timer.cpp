@@ -25,9 +25,36 @@
 #include <util/AutoLock.h>
 
 
+/*!	Each CPU keeps its timers in a hierarchical timer wheel: time is divided
+	into ticks of 2^kTimerTickShift microseconds, and a timer expiring in tick
+	T is stored in the level given by the highest group of kTimerWheelBits
+	bits in which T differs from the wheel's current tick, in the slot that
+	group of T selects. When the current tick enters a slot of a higher level,
+	that slot is cascaded, i.e. its timers are redistributed into the lower
+	levels. Timers due in the current tick (or earlier) are kept in the
+	sorted \c events list, so that they still fire with full precision.
+
+	Thus inserting a timer is O(1), and since a timer's location follows from
+	its schedule time and the current tick, canceling it only has to search a
+	single (usually short) slot list.
+*/
+static const uint32 kTimerTickShift = 10;
+static const uint32 kTimerWheelBits = 6;
+static const uint32 kTimerWheelSlots = 1 << kTimerWheelBits;
+static const uint32 kTimerWheelLevels = 4;
+
+// Timers with B_TIMER_ALLOW_SLACK may expire up to 1/2^kTimerSlackShift of
+// their delay later than requested, but never more than kMaxTimerSlack.
+static const uint32 kTimerSlackShift = 6;
+static const bigtime_t kMaxTimerSlack = 2000;
+
 struct per_cpu_timer_data {
 	spinlock		lock;
 	timer* volatile	events;
+	timer*			wheel[kTimerWheelLevels][kTimerWheelSlots];
+	uint64			occupied[kTimerWheelLevels];
+	timer*			overflow;
+	uint64			clock;
 	timer* volatile	current_event;
 	int32			current_event_in_progress;
 	bigtime_t		real_time_offset;
@@ -67,6 +94,13 @@ set_hardware_timer(bigtime_t scheduleTime)
 }
 
 
+static inline uint64
+timer_tick(bigtime_t time)
+{
+	return time > 0 ? (uint64)time >> kTimerTickShift : 0;
+}
+
+
 /*! NOTE: expects interrupts to be off */
 static void
 add_event_to_list(timer* event, timer* volatile* list)
@@ -90,24 +124,195 @@ add_event_to_list(timer* event, timer* volatile* list)
 }
 
 
+/*!	Returns the list the given timer belongs into according to its schedule
+	time and the wheel's current tick. If the timer belongs into a wheel slot,
+	\a _level and \a _slot are set accordingly, otherwise \a _level is set to
+	\c kTimerWheelLevels.
+*/
+static timer* volatile*
+timer_list_for(per_cpu_timer_data& cpuData, timer* event, uint32& _level,
+	uint32& _slot)
+{
+	_level = kTimerWheelLevels;
+
+	uint64 tick = timer_tick(event->schedule_time);
+	if (tick <= cpuData.clock)
+		return &cpuData.events;
+
+	uint64 diff = tick ^ cpuData.clock;
+	uint32 level = (63 - __builtin_clzll(diff)) / kTimerWheelBits;
+	if (level >= kTimerWheelLevels)
+		return &cpuData.overflow;
+
+	_level = level;
+	_slot = (tick >> (level * kTimerWheelBits)) & (kTimerWheelSlots - 1);
+	return &cpuData.wheel[level][_slot];
+}
+
+
+/*! NOTE: expects interrupts to be off and the CPU's lock to be held */
 static void
-per_cpu_real_time_clock_changed(void*, int cpu)
+enqueue_timer(per_cpu_timer_data& cpuData, timer* event)
 {
-	per_cpu_timer_data& cpuData = sPerCPU[cpu];
-	SpinLocker cpuDataLocker(cpuData.lock);
+	uint32 level;
+	uint32 slot;
+	timer* volatile* list = timer_list_for(cpuData, event, level, slot);
 
-	bigtime_t realTimeOffset = rtc_boot_time();
-	if (realTimeOffset == cpuData.real_time_offset)
+	if (list == &cpuData.events) {
+		add_event_to_list(event, list);
 		return;
+	}
 
-	// The real time offset has changed. We need to update all affected
-	// timers. First find and dequeue them.
-	bigtime_t timeDiff = cpuData.real_time_offset - realTimeOffset;
-	cpuData.real_time_offset = realTimeOffset;
+	event->next = *list;
+	*list = event;
 
-	timer* affectedTimers = NULL;
-	timer* volatile* it = &cpuData.events;
-	timer* firstEvent = *it;
+	if (level < kTimerWheelLevels)
+		cpuData.occupied[level] |= (uint64)1 << slot;
+}
+
+
+/*!	Removes the given timer from the CPU's timers.
+	NOTE: expects interrupts to be off and the CPU's lock to be held
+
+	\return \c true, if the timer was found, \c false otherwise.
+*/
+static bool
+dequeue_timer(per_cpu_timer_data& cpuData, timer* event)
+{
+	uint32 level;
+	uint32 slot;
+	timer* volatile* list = timer_list_for(cpuData, event, level, slot);
+
+	for (timer* volatile* it = list; *it != NULL; it = &(*it)->next) {
+		if (*it != event)
+			continue;
+
+		*it = event->next;
+		event->next = NULL;
+
+		if (level < kTimerWheelLevels && *list == NULL)
+			cpuData.occupied[level] &= ~((uint64)1 << slot);
+		return true;
+	}
+
+	return false;
+}
+
+
+/*!	Advances the wheel's current tick to \a tick, cascading all slots that
+	are passed on the way, so that all timers due up to \a tick end up in the
+	\c events list. Empty stretches of the wheel are skipped at once.
+	NOTE: expects interrupts to be off and the CPU's lock to be held
+*/
+static void
+advance_timer_wheel(per_cpu_timer_data& cpuData, uint64 tick)
+{
+	while (cpuData.clock < tick) {
+		// find the next tick at which timers have to be cascaded
+		uint32 level = 0;
+		while (level < kTimerWheelLevels && cpuData.occupied[level] == 0)
+			level++;
+
+		uint64 next;
+		uint32 slot = 0;
+		if (level < kTimerWheelLevels) {
+			uint32 shift = level * kTimerWheelBits;
+			slot = __builtin_ctzll(cpuData.occupied[level]);
+			next = (cpuData.clock >> (shift + kTimerWheelBits)
+					<< (shift + kTimerWheelBits))
+				| ((uint64)slot << shift);
+		} else if (cpuData.overflow != NULL) {
+			uint32 shift = kTimerWheelLevels * kTimerWheelBits;
+			next = ((cpuData.clock >> shift) + 1) << shift;
+		} else
+			break;
+
+		if (next > tick)
+			break;
+
+		cpuData.clock = next;
+
+		timer* event;
+		if (level < kTimerWheelLevels) {
+			event = cpuData.wheel[level][slot];
+			cpuData.wheel[level][slot] = NULL;
+			cpuData.occupied[level] &= ~((uint64)1 << slot);
+		} else {
+			event = cpuData.overflow;
+			cpuData.overflow = NULL;
+		}
+
+		while (event != NULL) {
+			timer* nextEvent = event->next;
+			enqueue_timer(cpuData, event);
+			event = nextEvent;
+		}
+	}
+
+	cpuData.clock = tick;
+}
+
+
+/*!	Retrieves the schedule time of the CPU's earliest timer.
+	NOTE: expects interrupts to be off and the CPU's lock to be held
+
+	\return \c false, if the CPU has no timers, \c true otherwise.
+*/
+static bool
+first_timer_time(per_cpu_timer_data& cpuData, bigtime_t& _time)
+{
+	if (cpuData.events != NULL) {
+		_time = cpuData.events->schedule_time;
+		return true;
+	}
+
+	// The first occupied slot of the lowest occupied level contains the
+	// earliest timers; without any, only the overflow list is left.
+	timer* list = cpuData.overflow;
+	for (uint32 level = 0; level < kTimerWheelLevels; level++) {
+		if (cpuData.occupied[level] != 0) {
+			list = cpuData.wheel[level][
+				__builtin_ctzll(cpuData.occupied[level])];
+			break;
+		}
+	}
+
+	if (list == NULL)
+		return false;
+
+	_time = list->schedule_time;
+	for (timer* event = list->next; event != NULL; event = event->next) {
+		if (event->schedule_time < _time)
+			_time = event->schedule_time;
+	}
+
+	return true;
+}
+
+
+/*!	Programs the hardware timer for the CPU's earliest timer, or clears it,
+	if there are no timers.
+	NOTE: expects interrupts to be off, the CPU's lock to be held, and to be
+	called on the CPU \a cpuData belongs to.
+*/
+static void
+update_hardware_timer(per_cpu_timer_data& cpuData)
+{
+	bigtime_t time;
+	if (first_timer_time(cpuData, time))
+		set_hardware_timer(time);
+	else
+		arch_timer_clear_hardware_timer();
+}
+
+
+/*!	Removes all absolute real-time timers from \a list and prepends them to
+	\a affectedTimers.
+*/
+static void
+remove_real_time_timers(timer* volatile* list, timer*& affectedTimers)
+{
+	timer* volatile* it = list;
 	while (timer* event = *it) {
 		// check whether it's an absolute real-time timer
 		uint32 flags = event->flags;
@@ -123,11 +328,41 @@ per_cpu_real_time_clock_changed(void*, int cpu)
 		event->next = affectedTimers;
 		affectedTimers = event;
 	}
+}
 
-	// update and requeue the affected timers
-	bool firstEventChanged = cpuData.events != firstEvent;
-	firstEvent = cpuData.events;
 
+static void
+per_cpu_real_time_clock_changed(void*, int cpu)
+{
+	per_cpu_timer_data& cpuData = sPerCPU[cpu];
+	SpinLocker cpuDataLocker(cpuData.lock);
+
+	bigtime_t realTimeOffset = rtc_boot_time();
+	if (realTimeOffset == cpuData.real_time_offset)
+		return;
+
+	// The real time offset has changed. We need to update all affected
+	// timers. First find and dequeue them.
+	bigtime_t timeDiff = cpuData.real_time_offset - realTimeOffset;
+	cpuData.real_time_offset = realTimeOffset;
+
+	timer* affectedTimers = NULL;
+	remove_real_time_timers(&cpuData.events, affectedTimers);
+	remove_real_time_timers(&cpuData.overflow, affectedTimers);
+
+	for (uint32 level = 0; level < kTimerWheelLevels; level++) {
+		for (uint32 slot = 0; slot < kTimerWheelSlots; slot++) {
+			timer* volatile* list = &cpuData.wheel[level][slot];
+			remove_real_time_timers(list, affectedTimers);
+			if (*list == NULL)
+				cpuData.occupied[level] &= ~((uint64)1 << slot);
+		}
+	}
+
+	if (affectedTimers == NULL)
+		return;
+
+	// update and requeue the affected timers
 	while (affectedTimers != NULL) {
 		timer* event = affectedTimers;
 		affectedTimers = event->next;
@@ -144,59 +379,73 @@ per_cpu_real_time_clock_changed(void*, int cpu)
 				event->schedule_time = 0;
 		}
 
-		add_event_to_list(event, &cpuData.events);
+		enqueue_timer(cpuData, event);
 	}
 
-	firstEventChanged |= cpuData.events != firstEvent;
-
-	// If the first event has changed, reset the hardware timer.
-	if (firstEventChanged)
-		set_hardware_timer(cpuData.events->schedule_time);
+	update_hardware_timer(cpuData);
 }
 
 
 // #pragma mark - debugging
 
 
+static void
+dump_timer_list(timer* list)
+{
+	for (timer* event = list; event != NULL; event = event->next) {
+		kprintf("  [%9lld] %p: ", (long long)event->schedule_time, event);
+		if ((event->flags & ~B_TIMER_FLAGS) == B_PERIODIC_TIMER)
+			kprintf("periodic %9lld, ", (long long)event->period);
+		else
+			kprintf("one shot,           ");
+
+		kprintf("flags: %#x, user data: %p, callback: %p  ",
+			event->flags, event->user_data, event->hook);
+
+		// look up and print the hook function symbol
+		const char* symbol;
+		const char* imageName;
+		bool exactMatch;
+
+		status_t error = elf_debug_lookup_symbol_address(
+			(addr_t)event->hook, NULL, &symbol, &imageName, &exactMatch);
+		if (error == B_OK && exactMatch) {
+			if (const char* slash = strchr(imageName, '/'))
+				imageName = slash + 1;
+
+			kprintf("   %s:%s", imageName, symbol);
+		}
+
+		kprintf("\n");
+	}
+}
+
+
 static int
 dump_timers(int argc, char** argv)
 {
 	int32 cpuCount = smp_get_num_cpus();
 	for (int32 i = 0; i < cpuCount; i++) {
-		kprintf("CPU %" B_PRId32 ":\n", i);
+		per_cpu_timer_data& cpuData = sPerCPU[i];
+		kprintf("CPU %" B_PRId32 ": (wheel at tick %" B_PRIu64 ")\n", i,
+			cpuData.clock);
 
-		if (sPerCPU[i].events == NULL) {
+		bigtime_t firstTime;
+		if (!first_timer_time(cpuData, firstTime)) {
 			kprintf("  no timers scheduled\n");
 			continue;
 		}
 
-		for (timer* event = sPerCPU[i].events; event != NULL;
-				event = event->next) {
-			kprintf("  [%9lld] %p: ", (long long)event->schedule_time, event);
-			if ((event->flags & ~B_TIMER_FLAGS) == B_PERIODIC_TIMER)
-				kprintf("periodic %9lld, ", (long long)event->period);
-			else
-				kprintf("one shot,           ");
-
-			kprintf("flags: %#x, user data: %p, callback: %p  ",
-				event->flags, event->user_data, event->hook);
-
-			// look up and print the hook function symbol
-			const char* symbol;
-			const char* imageName;
-			bool exactMatch;
-
-			status_t error = elf_debug_lookup_symbol_address(
-				(addr_t)event->hook, NULL, &symbol, &imageName, &exactMatch);
-			if (error == B_OK && exactMatch) {
-				if (const char* slash = strchr(imageName, '/'))
-					imageName = slash + 1;
-
-				kprintf("   %s:%s", imageName, symbol);
-			}
+		// Only the due timers are sorted; the wheel is dumped level by
+		// level, slot by slot, which is roughly chronological.
+		dump_timer_list(cpuData.events);
 
-			kprintf("\n");
+		for (uint32 level = 0; level < kTimerWheelLevels; level++) {
+			for (uint32 slot = 0; slot < kTimerWheelSlots; slot++)
+				dump_timer_list(cpuData.wheel[level][slot]);
 		}
+
+		dump_timer_list(cpuData.overflow);
 	}
 
 	kprintf("current time: %lld\n", (long long)system_time());
@@ -257,6 +506,8 @@ timer_interrupt()
 
 	acquire_spinlock(spinlock);
 
+	advance_timer_wheel(cpuData, timer_tick(system_time()));
+
 	event = cpuData.events;
 	while (event != NULL && ((bigtime_t)event->schedule_time < system_time())) {
 		// this event needs to happen
@@ -295,17 +546,21 @@ timer_interrupt()
 					- (now - event->schedule_time) % event->period;
 			}
 
-			add_event_to_list(event, &cpuData.events);
+			enqueue_timer(cpuData, event);
 		}
 
 		cpuData.current_event = NULL;
 
+		// the hook may have taken a while, so more timers may be due now
+		advance_timer_wheel(cpuData, timer_tick(system_time()));
+
 		event = cpuData.events;
 	}
 
 	// setup the next hardware timer
-	if (cpuData.events != NULL)
-		set_hardware_timer(cpuData.events->schedule_time);
+	bigtime_t nextTime;
+	if (first_timer_time(cpuData, nextTime))
+		set_hardware_timer(nextTime);
 
 	release_spinlock(spinlock);
 
@@ -328,12 +583,10 @@ add_timer(timer* event, timer_hook hook, bigtime_t period, int32 flags)
 	TRACE(("add_timer: event %p\n", event));
 
 	// compute the schedule time
-	bigtime_t scheduleTime;
 	if ((flags & B_TIMER_USE_TIMER_STRUCT_TIMES) != 0) {
-		scheduleTime = event->schedule_time;
 		period = event->period;
 	} else {
-		scheduleTime = period;
+		bigtime_t scheduleTime = period;
 		if ((flags & ~B_TIMER_FLAGS) != B_ONE_SHOT_ABSOLUTE_TIMER)
 			scheduleTime += currentTime;
 		event->schedule_time = (int64)scheduleTime;
@@ -358,12 +611,36 @@ add_timer(timer* event, timer_hook hook, bigtime_t period, int32 flags)
 			event->schedule_time = 0;
 	}
 
-	add_event_to_list(event, &cpuData.events);
+	// If the timer may be late, round its schedule time up to a multiple of
+	// a power of two within the allowed slack, so that it is likely to expire
+	// together with other timers.
+	if ((flags & B_TIMER_ALLOW_SLACK) != 0
+		&& (flags & ~B_TIMER_FLAGS) != B_PERIODIC_TIMER
+		&& event->schedule_time > currentTime) {
+		bigtime_t slack = (event->schedule_time - currentTime)
+			>> kTimerSlackShift;
+		if (slack > kMaxTimerSlack)
+			slack = kMaxTimerSlack;
+		if (slack > 1) {
+			bigtime_t granularity = (bigtime_t)1
+				<< (63 - __builtin_clzll(slack));
+			bigtime_t scheduleTime = (event->schedule_time + granularity - 1)
+				& ~(granularity - 1);
+			if (scheduleTime > event->schedule_time)
+				event->schedule_time = scheduleTime;
+		}
+	}
+
+	// If the timer precedes all others, we have to set the hardware timer.
+	bigtime_t firstTime;
+	bool isFirst = !first_timer_time(cpuData, firstTime)
+		|| event->schedule_time < firstTime;
+
+	enqueue_timer(cpuData, event);
 	event->cpu = currentCPU;
 
-	// if we were stuck at the head of the list, set the hardware timer
-	if (event == cpuData.events)
-		set_hardware_timer(scheduleTime, currentTime);
+	if (isFirst)
+		set_hardware_timer(event->schedule_time, currentTime);
 
 	release_spinlock(&cpuData.lock);
 	restore_interrupts(state);
@@ -398,40 +675,17 @@ cancel_timer(timer* event)
 	per_cpu_timer_data& cpuData = sPerCPU[cpu];
 
 	if (event != cpuData.current_event) {
-		// The timer hook is not yet being executed.
-		timer* current = cpuData.events;
-		timer* last = NULL;
-
-		while (current != NULL) {
-			if (current == event) {
-				// we found it
-				if (last == NULL)
-					cpuData.events = current->next;
-				else
-					last->next = current->next;
-				current->next = NULL;
-				// break out of the whole thing
-				break;
-			}
-			last = current;
-			current = current->next;
-		}
-
-		// If not found, we assume this was a one-shot timer and has already
-		// fired.
-		if (current == NULL)
+		// The timer hook is not yet being executed. If the timer can't be
+		// found, we assume this was a one-shot timer and has already fired.
+		if (!dequeue_timer(cpuData, event))
 			return true;
 
 		// invalidate CPU field
 		event->cpu = 0xffff;
 
 		// If on the current CPU, also reset the hardware timer.
-		if (cpu == smp_get_current_cpu()) {
-			if (cpuData.events == NULL)
-				arch_timer_clear_hardware_timer();
-			else
-				set_hardware_timer(cpuData.events->schedule_time);
-		}
+		if (cpu == smp_get_current_cpu())
+			update_hardware_timer(cpuData);
 
 		return false;
 	}
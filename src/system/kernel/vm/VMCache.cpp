@@ -524,6 +524,30 @@ vm_cache_init_post_heap()
 }
 
 
+/*!	Releases a wiring of a page that VMCache::Resize() has removed from its
+	cache while it was wired, and frees the page when that was the last one.
+	All wirings of such a page are released through this function, with the
+	cache list lock serializing them.
+*/
+void
+vm_cache_unwire_removed_page(vm_page* page)
+{
+	MutexLocker cacheListLocker(sCacheListLock);
+	ASSERT(page->CacheRef() == NULL);
+
+	page->DecrementWiredCount();
+	if (page->WiredCount() > 0)
+		return;
+
+	cacheListLocker.Unlock();
+
+	atomic_add(&gMappedPagesCount, -1);
+
+	DEBUG_PAGE_ACCESS_START(page);
+	vm_page_free(NULL, page);
+}
+
+
 VMCache*
 vm_cache_acquire_locked_page_cache(vm_page* page, bool dontWait)
 {
@@ -1080,6 +1104,9 @@ VMCache::SetMinimalCommitment(off_t commitment, int priority)
 	The cache lock must be held when you call it.
 	Since removed pages don't belong to the cache any longer, they are not
 	written back before they will be removed.
+	Pages that are wired temporarily cannot be freed yet; they are only
+	removed from the cache, and freed by vm_cache_unwire_removed_page() once
+	their last wiring is released.
 
 	Note, this function may temporarily release the cache lock in case it
 	has to wait for busy pages.
@@ -1126,10 +1153,20 @@ VMCache::Resize(off_t newSize, int priority)
 			// remove the page and put it into the free queue
 			DEBUG_PAGE_ACCESS_START(page);
 			vm_remove_all_page_mappings(page);
-			ASSERT(page->WiredCount() == 0);
-				// TODO: Find a real solution! If the page is wired
-				// temporarily (e.g. by lock_memory()), we actually must not
-				// unmap it!
+
+			if (page->WiredCount() > 0) {
+				// The page is wired temporarily (e.g. by
+				// file_cache_wire_pages()), and its data is still in use.
+				// Take it out of its queue and the cache, but leave it to
+				// the one releasing the last wiring to free it.
+				// TODO: Pages wired by lock_memory() are unwired via their
+				// area's cache, and are not freed this way.
+				vm_page_set_state(page, PAGE_STATE_WIRED);
+				RemovePage(page);
+				DEBUG_PAGE_ACCESS_END(page);
+				continue;
+			}
+
 			RemovePage(page);
 			vm_page_free(this, page);
 				// Note: When iterating through a IteratableSplayTree
@@ -279,3 +279,10 @@ VMPhysicalPageMapper::VMPhysicalPageMapper()
 VMPhysicalPageMapper::~VMPhysicalPageMapper()
 {
 }
+
+
+void
+VMPhysicalPageMapper::ClearPhysicalPage(phys_addr_t address, bool nonTemporal)
+{
+	MemsetPhysical(address, 0, B_PAGE_SIZE);
+}
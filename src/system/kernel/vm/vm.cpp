@@ -2298,10 +2298,14 @@ vm_delete_area(team_id team, area_id id, bool kernel)
 	\param wiredPagesReservation If \c NULL there must not be any wired pages
 		in \a lowerCache. Otherwise as many pages must be reserved as the cache
 		has wired page. The wired pages are copied in this case.
+	\param protectPages If \c false, the pages that are currently mapped stay
+		writable for the cache's areas. This is only safe as long as nothing
+		else can write to them until the other consumers of \a lowerCache are
+		gone again, as for the parent of a vfork() child.
 */
 static status_t
 vm_copy_on_write_area(VMCache* lowerCache,
-	vm_page_reservation* wiredPagesReservation)
+	vm_page_reservation* wiredPagesReservation, bool protectPages = true)
 {
 	VMCache* upperCache;
 
@@ -2355,7 +2359,7 @@ vm_copy_on_write_area(VMCache* lowerCache,
 					page->cache_offset * B_PAGE_SIZE);
 
 				DEBUG_PAGE_ACCESS_END(copiedPage);
-			} else {
+			} else if (protectPages) {
 				// Change the protection of this page in all areas.
 				for (VMArea* tempArea = upperCache->areas; tempArea != NULL;
 						tempArea = tempArea->cache_next) {
@@ -2374,7 +2378,7 @@ vm_copy_on_write_area(VMCache* lowerCache,
 				}
 			}
 		}
-	} else {
+	} else if (protectPages) {
 		ASSERT(lowerCache->WiredPagesCount() == 0);
 
 		// just change the protection of all areas
@@ -2399,9 +2403,14 @@ vm_copy_on_write_area(VMCache* lowerCache,
 }
 
 
+/*!	Creates a copy-on-write copy of the area \a sourceID in the address space
+	of \a team.
+	If \a protectSource is \c false, the pages of the source area are not
+	remapped read-only; see vm_copy_on_write_area() for when this is safe.
+*/
 area_id
 vm_copy_area(team_id team, const char* name, void** _address,
-	uint32 addressSpec, uint32 protection, area_id sourceID)
+	uint32 addressSpec, uint32 protection, area_id sourceID, bool protectSource)
 {
 	bool writableCopy = (protection & (B_KERNEL_WRITE_AREA | B_WRITE_AREA)) != 0;
 
@@ -2516,7 +2525,8 @@ vm_copy_area(team_id team, const char* name, void** _address,
 		if ((source->protection & (B_KERNEL_WRITE_AREA | B_WRITE_AREA)) != 0) {
 			// TODO: do something more useful if this fails!
 			if (vm_copy_on_write_area(cache,
-					wiredPages > 0 ? &wiredPagesReservation : NULL) < B_OK) {
+					wiredPages > 0 ? &wiredPagesReservation : NULL,
+					protectSource) < B_OK) {
 				panic("vm_copy_on_write_area() failed!\n");
 			}
 		}
@@ -5043,7 +5053,9 @@ vm_resize_area(area_id areaID, size_t newSize, bool kernel)
 		if (!kernel) {
 			if ((area->protection & B_KERNEL_AREA) != 0)
 				return B_NOT_ALLOWED;
-			// TODO: Enforce all restrictions (team, etc.)!
+			// userland may only resize its own areas
+			if (area->address_space->ID() != team_get_current_team_id())
+				return B_NOT_ALLOWED;
 		}
 
 		oldSize = area->Size();
@@ -5194,6 +5206,13 @@ vm_memcpy_physical_page(phys_addr_t to, phys_addr_t from)
 }
 
 
+void
+vm_clear_physical_page(phys_addr_t address, bool nonTemporal)
+{
+	sPhysicalPageMapper->ClearPhysicalPage(address, nonTemporal);
+}
+
+
 /*!	Copies a range of memory directly from/to a page that might not be mapped
 	at the moment.
 
@@ -5979,12 +5998,21 @@ _get_next_area_info(team_id team, ssize_t* cookie, area_info* info, size_t size)
 	if (!locker.IsLocked())
 		return B_BAD_TEAM_ID;
 
-	VMArea* area;
-	for (VMAddressSpace::AreaIterator it
-				= locker.AddressSpace()->GetAreaIterator();
-			(area = it.Next()) != NULL;) {
-		if (area->Base() > nextBase)
-			break;
+	VMAddressSpace* addressSpace = locker.AddressSpace();
+
+	// The cookie is the base of the area returned last, so as long as that
+	// one is still there, its successor can be found without walking the
+	// whole list. This keeps iterating over all areas linear.
+	VMArea* area = nextBase != 0 ? addressSpace->LookupArea(nextBase) : NULL;
+	if (area != NULL && area->Base() == nextBase)
+		area = addressSpace->NextArea(area);
+	else {
+		for (VMAddressSpace::AreaIterator it
+					= addressSpace->GetAreaIterator();
+				(area = it.Next()) != NULL;) {
+			if (area->Base() > nextBase)
+				break;
+		}
 	}
 
 	if (area == NULL) {
@@ -6046,6 +6074,46 @@ transfer_area(area_id id, void** _address, uint32 addressSpec, team_id target,
 }
 
 
+/*!	Transfers the area \a id of the current team to the kernel address space,
+	so that the kernel can hold on to its contents.
+	Unlike with transfer_area(), the area is validated only after the
+	transfer, when its former owner can no longer change it: it must still be
+	\a size bytes large, and must not share its cache with any other area.
+	Otherwise, the area is deleted. The kernel area cannot be cloned or
+	changed by userland.
+*/
+area_id
+vm_transfer_area_to_kernel(area_id id, size_t size, void** _address)
+{
+	area_id kernelArea = transfer_area(id, _address, B_ANY_KERNEL_ADDRESS,
+		VMAddressSpace::KernelID(), true);
+	if (kernelArea < 0)
+		return kernelArea;
+
+	AddressSpaceWriteLocker locker;
+	VMArea* area;
+	status_t status = locker.SetFromArea(kernelArea, area);
+	if (status == B_OK) {
+		VMCache* cache = vm_area_get_locked_cache(area);
+		if (area->Size() != size)
+			status = B_BAD_VALUE;
+		else if (cache->areas != area || area->cache_next != NULL)
+			status = B_NOT_ALLOWED;
+		else
+			area->protection |= B_KERNEL_AREA;
+		vm_area_put_locked_cache(cache);
+	}
+	locker.Unlock();
+
+	if (status != B_OK) {
+		vm_delete_area(VMAddressSpace::KernelID(), kernelArea, true);
+		return status;
+	}
+
+	return kernelArea;
+}
+
+
 extern "C" area_id
 __map_physical_memory_haiku(const char* name, phys_addr_t physicalAddress,
 	size_t numBytes, uint32 addressSpec, uint32 protection,
@@ -6237,8 +6305,6 @@ _user_set_area_protection(area_id area, uint32 newProtection)
 status_t
 _user_resize_area(area_id area, size_t newSize)
 {
-	// TODO: Since we restrict deleting of areas to those owned by the team,
-	// we should also do that for resizing (check other functions, too).
 	return vm_resize_area(area, newSize, false);
 }
 
@@ -1652,11 +1652,15 @@ move_page_to_appropriate_queue(vm_page *page)
 }
 
 
+/*!	Fills the page with zeroes. Pass \c true for \a nonTemporal if the page
+	is not going to be used soon, so that clearing it doesn't evict more
+	useful data from the caches.
+*/
 static void
-clear_page(struct vm_page *page)
+clear_page(struct vm_page *page, bool nonTemporal = false)
 {
-	vm_memset_physical(page->physical_page_number << PAGE_SHIFT, 0,
-		B_PAGE_SIZE);
+	vm_clear_physical_page(page->physical_page_number << PAGE_SHIFT,
+		nonTemporal);
 }
 
 
@@ -1726,10 +1730,15 @@ mark_page_range_in_use(page_num_t startPage, page_num_t length, bool wired)
 
 
 /*!
-	This is a background thread that wakes up every now and then (every 100ms)
-	and moves some pages from the free queue over to the clear queue.
-	Given enough time, it will clear out all pages from the free queue - we
-	could probably slow it down after having reached a certain threshold.
+	This is a background thread that moves pages from the free queue over to
+	the clear queue, so that page faults on anonymous memory rarely have to
+	clear a page themselves.
+	It runs at the lowest active priority, so it only gets to run when a CPU
+	would otherwise be idle. As long as there are free pages left, it clears
+	them in batches of SCRUB_SIZE pages without pausing; it only sleeps
+	(100ms) when there's nothing to do or free memory is low. The pages are
+	cleared with non-temporal stores where available, so that this doesn't
+	evict the caches of the threads that are actually running.
 */
 static int32
 page_scrubber(void *unused)
@@ -1738,8 +1747,11 @@ page_scrubber(void *unused)
 
 	TRACE(("page_scrubber starting...\n"));
 
+	bool idle = true;
 	for (;;) {
-		snooze(100000); // 100ms
+		if (idle)
+			snooze(100000); // 100ms
+		idle = true;
 
 		if (sFreePageQueue.Count() == 0
 				|| atomic_get(&sUnreservedFreePages)
@@ -1785,7 +1797,7 @@ page_scrubber(void *unused)
 
 		// clear them
 		for (int32 i = 0; i < scrubCount; i++)
-			clear_page(page[i]);
+			clear_page(page[i], true);
 
 		locker.Lock();
 
@@ -1802,6 +1814,9 @@ page_scrubber(void *unused)
 		unreserve_pages(reserved);
 
 		TA(ScrubbedPages(scrubCount));
+
+		// continue right away, if there is more to do
+		idle = false;
 	}
 
 	return 0;
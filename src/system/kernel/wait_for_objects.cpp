@@ -58,6 +58,18 @@ struct select_sync_pool {
 };
 
 
+struct wait_for_objects_sync : select_sync {
+								wait_for_objects_sync();
+	virtual						~wait_for_objects_sync();
+
+	virtual	status_t			Notify(select_info* info, uint16 events);
+
+			sem_id				sem;
+			uint32				count;
+			struct select_info*	set;
+};
+
+
 struct select_ops {
 	status_t (*select)(int32 object, struct select_info* info, bool kernel);
 	status_t (*deselect)(int32 object, struct select_info* info, bool kernel);
@@ -376,20 +388,65 @@ fd_zero(fd_set *set, int numFDs)
 }
 
 
+select_sync::select_sync()
+	:
+	ref_count(1)
+{
+}
+
+
+select_sync::~select_sync()
+{
+}
+
+
+wait_for_objects_sync::wait_for_objects_sync()
+	:
+	sem(-1),
+	count(0),
+	set(NULL)
+{
+}
+
+
+wait_for_objects_sync::~wait_for_objects_sync()
+{
+	if (sem >= 0)
+		delete_sem(sem);
+	delete[] set;
+}
+
+
+status_t
+wait_for_objects_sync::Notify(select_info* info, uint16 events)
+{
+	if (sem < B_OK)
+		return B_BAD_VALUE;
+
+	atomic_or(&info->events, events);
+
+	// only wake up the waiting select()/poll() call if the events
+	// match one of the selected ones
+	if (info->selected_events & events)
+		return release_sem_etc(sem, 1, B_DO_NOT_RESCHEDULE);
+
+	return B_OK;
+}
+
+
 static status_t
-create_select_sync(int numFDs, select_sync*& _sync)
+create_select_sync(int numFDs, wait_for_objects_sync*& _sync)
 {
 	// create sync structure
-	select_sync* sync = new(nothrow) select_sync;
+	wait_for_objects_sync* sync = new(nothrow) wait_for_objects_sync;
 	if (sync == NULL)
 		return B_NO_MEMORY;
-	ObjectDeleter<select_sync> syncDeleter(sync);
+	ObjectDeleter<wait_for_objects_sync> syncDeleter(sync);
 
 	// create info set
 	sync->set = new(nothrow) select_info[numFDs];
 	if (sync->set == NULL)
 		return B_NO_MEMORY;
-	ArrayDeleter<select_info> setDeleter(sync->set);
 
 	// create select event semaphore
 	sync->sem = create_sem(0, "select");
@@ -397,14 +454,12 @@ create_select_sync(int numFDs, select_sync*& _sync)
 		return sync->sem;
 
 	sync->count = numFDs;
-	sync->ref_count = 1;
 
 	for (int i = 0; i < numFDs; i++) {
 		sync->set[i].next = NULL;
 		sync->set[i].sync = sync;
 	}
 
-	setDeleter.Detach();
 	syncDeleter.Detach();
 	_sync = sync;
 
@@ -417,11 +472,8 @@ put_select_sync(select_sync* sync)
 {
 	FUNCTION(("put_select_sync(%p): -> %ld\n", sync, sync->ref_count - 1));
 
-	if (atomic_add(&sync->ref_count, -1) == 1) {
-		delete_sem(sync->sem);
-		delete[] sync->set;
+	if (atomic_add(&sync->ref_count, -1) == 1)
 		delete sync;
-	}
 }
 
 
@@ -447,7 +499,7 @@ common_select(int numFDs, fd_set *readSet, fd_set *writeSet, fd_set *errorSet,
 	}
 
 	// allocate sync object
-	select_sync* sync;
+	wait_for_objects_sync* sync;
 	status = create_select_sync(numFDs, sync);
 	if (status != B_OK)
 		return status;
@@ -547,7 +599,7 @@ static int
 common_poll(struct pollfd *fds, nfds_t numFDs, bigtime_t timeout, bool kernel)
 {
 	// allocate sync object
-	select_sync* sync;
+	wait_for_objects_sync* sync;
 	status_t status = create_select_sync(numFDs, sync);
 	if (status != B_OK)
 		return status;
@@ -625,7 +677,7 @@ common_wait_for_objects(object_wait_info* infos, int numInfos, uint32 flags,
 	status_t status = B_OK;
 
 	// allocate sync object
-	select_sync* sync;
+	wait_for_objects_sync* sync;
 	status = create_select_sync(numInfos, sync);
 	if (status != B_OK)
 		return status;
@@ -696,19 +748,10 @@ notify_select_events(select_info* info, uint16 events)
 	FUNCTION(("notify_select_events(%p (%p), 0x%x)\n", info, info->sync,
 		events));
 
-	if (info == NULL
-		|| info->sync == NULL
-		|| info->sync->sem < B_OK)
+	if (info == NULL || info->sync == NULL)
 		return B_BAD_VALUE;
 
-	atomic_or(&info->events, events);
-
-	// only wake up the waiting select()/poll() call if the events
-	// match one of the selected ones
-	if (info->selected_events & events)
-		return release_sem_etc(info->sync->sem, 1, B_DO_NOT_RESCHEDULE);
-
-	return B_OK;
+	return info->sync->Notify(info, events);
 }
 
 
@@ -723,6 +766,26 @@ notify_select_events_list(select_info* list, uint16 events)
 }
 
 
+status_t
+select_object(uint32 type, int32 object, select_info* info, bool kernel)
+{
+	if (type >= kSelectOpsCount)
+		return B_BAD_VALUE;
+
+	return kSelectOps[type].select(object, info, kernel);
+}
+
+
+status_t
+deselect_object(uint32 type, int32 object, select_info* info, bool kernel)
+{
+	if (type >= kSelectOpsCount)
+		return B_BAD_VALUE;
+
+	return kSelectOps[type].deselect(object, info, kernel);
+}
+
+
 //	#pragma mark - public kernel API
 
 
@@ -50,7 +50,6 @@ int _data_offset_main_;
 void
 initialize_before(image_id imageID)
 {
-	system_info info;
 	char *programPath = __gRuntimeLoader->program_args->args[0];
 	__gCommPageAddress = __gRuntimeLoader->commpage_address;
 	__gABIVersion = __gRuntimeLoader->abi_version;
@@ -73,8 +72,8 @@ initialize_before(image_id imageID)
 
 	pthread_self()->id = find_thread(NULL);
 
-	get_system_info(&info);
-	__gCPUCount = info.cpu_count;
+	__init_cpu_data((addr_t)__gCommPageAddress);
+	__gCPUCount = __get_cpu_count(false);
 
 	__init_time((addr_t)__gCommPageAddress);
 	__init_heap();
@@ -19,6 +19,7 @@ __arch_init_time(real_time_data* data, bool setDefaults)
 	if (setDefaults) {
 		data->arch_data.system_time_offset = 0;
 		data->arch_data.system_time_conversion_factor = 100000;
+		data->arch_data.version = 0;
 	}
 
 	// TODO: this should only store a pointer to that value
@@ -38,7 +39,16 @@ __arch_init_time(real_time_data* data, bool setDefaults)
 bigtime_t
 __arch_get_system_time_offset(struct real_time_data *data)
 {
-	//we don't use atomic_get64 because memory is read-only, maybe find another way to lock
-	return data->arch_data.system_time_offset;
+	// The commpage is read-only, so atomic_get64() can't be used. Instead, the
+	// kernel increments the version before and after changing the offset.
+	volatile arch_real_time_data* realTimeData = &data->arch_data;
+	int32 version;
+	bigtime_t offset;
+	do {
+		version = realTimeData->version;
+		offset = realTimeData->system_time_offset;
+	} while ((version & 1) != 0 || version != realTimeData->version);
+
+	return offset;
 }
 
@@ -0,0 +1,282 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Per-CPU counters and lists built on restartable sequences.
+
+	A restartable sequence reads the number of the CPU the thread runs on from
+	its user_thread, and ends with a single store that commits the operation.
+	The thread publishes a user_rseq describing the sequence right before
+	entering it. When the thread is preempted, migrated, or interrupted by a
+	signal inside the sequence, the kernel lets it continue at the abort
+	address, which simply starts over. That makes the per-CPU data safe to
+	use without atomic instructions.
+
+	The sequences are only implemented for x86_64 so far; elsewhere, and
+	when the kernel doesn't support them, all threads share the slot of the
+	first CPU, and use atomics or a lock instead.
+*/
+
+
+#include <per_cpu.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <syscalls.h>
+#include <user_thread.h>
+
+
+// every CPU gets a cache line of its own
+#define SLOT_SHIFT		6
+#define SLOT_SIZE		(1 << SLOT_SHIFT)
+
+
+extern int32 __gCPUCount;
+
+
+static void*
+allocate_slots()
+{
+	void* slots;
+	if (posix_memalign(&slots, SLOT_SIZE, __gCPUCount * SLOT_SIZE) != 0)
+		return NULL;
+
+	memset(slots, 0, __gCPUCount * SLOT_SIZE);
+	return slots;
+}
+
+
+template<typename Type>
+static inline Type*
+slot_at(Type* slots, int32 cpu)
+{
+	return (Type*)((addr_t)slots + ((addr_t)cpu << SLOT_SHIFT));
+}
+
+
+#ifdef __x86_64__
+
+
+/*!	Returns the current thread's user_thread, if it can use restartable
+	sequences, or \c NULL otherwise.
+*/
+static inline user_thread*
+rseq_thread()
+{
+	user_thread* thread = get_user_thread();
+	if (thread->cpu < 0) {
+		// the kernel fills in the CPU number on the way back from the syscall
+		if (_kern_register_rseq() != B_OK)
+			return NULL;
+	}
+
+	return thread;
+}
+
+
+// Emits the user_rseq for the sequence between the labels 1 and 2, and the
+// code that publishes it. The abort address 4 is the publishing code itself,
+// so an aborted sequence is simply restarted. Publishing must immediately
+// precede label 1, or a preemption in between would go unnoticed.
+#define RSEQ_START(rseq)								\
+		".pushsection .data\n"							\
+		".balign 8\n"									\
+		"3:\n"											\
+		".quad 1f, 2f, 4f\n"							\
+		".popsection\n"									\
+		"4:\n"											\
+		"leaq 3b(%%rip), %%rax\n"						\
+		"movq %%rax, " rseq "\n"						\
+		"1:\n"
+
+
+static inline void
+rseq_counter_add(user_thread* thread, int64* slots, int64 value)
+{
+	asm volatile(
+		RSEQ_START("%[rseq]")
+		"movslq %[cpu], %%rax\n"
+		"shlq %[shift], %%rax\n"
+		"addq %[value], (%[slots], %%rax)\n"
+			// commit
+		"2:\n"
+		: [rseq] "=m" (thread->rseq)
+		: [cpu] "m" (thread->cpu), [shift] "i" (SLOT_SHIFT),
+			[slots] "r" (slots), [value] "r" (value)
+		: "rax", "memory", "cc");
+}
+
+
+static inline void
+rseq_list_push(user_thread* thread, void** heads, void* element)
+{
+	asm volatile(
+		RSEQ_START("%[rseq]")
+		"movslq %[cpu], %%rax\n"
+		"shlq %[shift], %%rax\n"
+		"addq %[heads], %%rax\n"
+		"movq (%%rax), %%rdx\n"
+		"movq %%rdx, (%[element])\n"
+		"movq %[element], (%%rax)\n"
+			// commit
+		"2:\n"
+		: [rseq] "=m" (thread->rseq)
+		: [cpu] "m" (thread->cpu), [shift] "i" (SLOT_SHIFT),
+			[heads] "r" (heads), [element] "r" (element)
+		: "rax", "rdx", "memory", "cc");
+}
+
+
+static inline void*
+rseq_list_pop(user_thread* thread, void** heads)
+{
+	void* element;
+	asm volatile(
+		RSEQ_START("%[rseq]")
+		"movslq %[cpu], %%rax\n"
+		"shlq %[shift], %%rax\n"
+		"addq %[heads], %%rax\n"
+		"movq (%%rax), %[element]\n"
+		"testq %[element], %[element]\n"
+		"jz 2f\n"
+		"movq (%[element]), %%rdx\n"
+		"movq %%rdx, (%%rax)\n"
+			// commit
+		"2:\n"
+		: [rseq] "=m" (thread->rseq), [element] "=&r" (element)
+		: [cpu] "m" (thread->cpu), [shift] "i" (SLOT_SHIFT),
+			[heads] "r" (heads)
+		: "rax", "rdx", "memory", "cc");
+
+	return element;
+}
+
+
+#else	// !__x86_64__
+
+
+static inline user_thread*
+rseq_thread()
+{
+	return NULL;
+}
+
+
+static inline void
+rseq_counter_add(user_thread* thread, int64* slots, int64 value)
+{
+}
+
+
+static inline void
+rseq_list_push(user_thread* thread, void** heads, void* element)
+{
+}
+
+
+static inline void*
+rseq_list_pop(user_thread* thread, void** heads)
+{
+	return NULL;
+}
+
+
+#endif	// !__x86_64__
+
+
+// #pragma mark - counter
+
+
+status_t
+__per_cpu_counter_init(per_cpu_counter* counter)
+{
+	counter->slots = (int64*)allocate_slots();
+	return counter->slots != NULL ? B_OK : B_NO_MEMORY;
+}
+
+
+void
+__per_cpu_counter_destroy(per_cpu_counter* counter)
+{
+	free(counter->slots);
+	counter->slots = NULL;
+}
+
+
+void
+__per_cpu_counter_add(per_cpu_counter* counter, int64 value)
+{
+	if (user_thread* thread = rseq_thread())
+		rseq_counter_add(thread, counter->slots, value);
+	else
+		atomic_add64(counter->slots, value);
+}
+
+
+/*!	Returns the sum of all CPUs' values. Additions that happen concurrently
+	may or may not be included.
+*/
+int64
+__per_cpu_counter_sum(const per_cpu_counter* counter)
+{
+	int64 sum = 0;
+	for (int32 i = 0; i < __gCPUCount; i++)
+		sum += atomic_get64(slot_at((int64*)counter->slots, i));
+
+	return sum;
+}
+
+
+// #pragma mark - list
+
+
+status_t
+__per_cpu_list_init(per_cpu_list* list)
+{
+	mutex_init(&list->lock, "per-CPU list");
+	list->heads = (void**)allocate_slots();
+	return list->heads != NULL ? B_OK : B_NO_MEMORY;
+}
+
+
+void
+__per_cpu_list_destroy(per_cpu_list* list)
+{
+	free(list->heads);
+	list->heads = NULL;
+	mutex_destroy(&list->lock);
+}
+
+
+void
+__per_cpu_list_push(per_cpu_list* list, void* element)
+{
+	if (user_thread* thread = rseq_thread()) {
+		rseq_list_push(thread, list->heads, element);
+		return;
+	}
+
+	mutex_lock(&list->lock);
+	*(void**)element = list->heads[0];
+	list->heads[0] = element;
+	mutex_unlock(&list->lock);
+}
+
+
+void*
+__per_cpu_list_pop(per_cpu_list* list)
+{
+	if (user_thread* thread = rseq_thread())
+		return rseq_list_pop(thread, list->heads);
+
+	mutex_lock(&list->lock);
+	void* element = list->heads[0];
+	if (element != NULL)
+		list->heads[0] = *(void**)element;
+	mutex_unlock(&list->lock);
+
+	return element;
+}
@@ -11,6 +11,9 @@
 
 #include <algorithm>
 
+#include <commpage_defs.h>
+#include <cpu_data.h>
+#include <libroot_private.h>
 #include <syscalls.h>
 #include <system_info.h>
 
@@ -146,6 +149,28 @@ _get_system_info(legacy_system_info* info, size_t size)
 #endif	// _BEOS_R5_COMPATIBLE_
 
 
+static const cpu_data* sCPUData;
+
+
+void
+__init_cpu_data(addr_t commPageTable)
+{
+	sCPUData = (const cpu_data*)
+		(((addr_t*)commPageTable)[COMMPAGE_ENTRY_CPU_DATA] + commPageTable);
+}
+
+
+/*!	Returns the number of CPUs without entering the kernel. The commpage is
+	read-only, so the counts are read directly instead of with atomic_get().
+*/
+int32
+__get_cpu_count(bool enabledOnly)
+{
+	volatile const cpu_data* data = sCPUData;
+	return enabledOnly ? data->enabled_cpu_count : data->cpu_count;
+}
+
+
 status_t
 __get_system_info(system_info* info)
 {
@@ -127,6 +127,8 @@ typedef unsigned int _G_uint32_t __attribute__ ((__mode__ (__SI__)));
 /*#define _G_HAVE_ST_BLKSIZE defined (_STATBUF_ST_BLKSIZE)*/
 
 #define _G_BUFSIZ 8192
+/* Buffers of regular files may grow up to this size.  */
+#define _G_MAX_FILE_BUFSIZ 65536
 
 /* These are the vtbl details for ELF.  */
 #define _G_NAMES_HAVE_UNDERSCORE 0
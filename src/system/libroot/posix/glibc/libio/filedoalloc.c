@@ -115,6 +115,19 @@ _IO_file_doallocate (fp)
 #if _IO_HAVE_ST_BLKSIZE
       if (st.st_blksize > 0)
 	size = st.st_blksize;
+#else
+      if (S_ISREG (st.st_mode))
+	{
+	  /* Regular files are read and written in the preferred I/O size of
+	     their file system, within limits.  Files that are only read don't
+	     need a buffer larger than they are themselves, though.  */
+	  if (st.st_blksize > size)
+	    size = st.st_blksize < _IO_MAX_FILE_BUFSIZ
+	      ? st.st_blksize : _IO_MAX_FILE_BUFSIZ;
+	  if ((fp->_flags & _IO_NO_WRITES) != 0 && st.st_size < size)
+	    size = st.st_size > _IO_BUFSIZ
+	      ? (st.st_size + _IO_BUFSIZ - 1) & ~(_IO_BUFSIZ - 1) : _IO_BUFSIZ;
+	}
 #endif
     }
   ALLOC_BUF (p, size, EOF);
@@ -6,22 +6,34 @@
 
 #include "libioP.h"
 
+#include <libroot_private.h>
+
 
 #undef _IO_flockfile
 #undef _IO_funlockfile
 
 
+/*!	As long as the team has only a single thread, the stream locks are taken
+	without atomic operations -- every getc() and putc() locks the stream, and
+	most programs never spawn a thread.
+*/
 void
 _IO_flockfile(_IO_FILE *stream)
 {
-	__libc_lock_lock_recursive(*stream->_lock);
+	if (_single_threaded)
+		__pthread_mutex_lock_single_threaded(&stream->_lock->mutex);
+	else
+		__libc_lock_lock_recursive(*stream->_lock);
 }
 
 
 void
 _IO_funlockfile(_IO_FILE *stream)
 {
-	__libc_lock_unlock_recursive(*stream->_lock);
+	if (_single_threaded)
+		__pthread_mutex_unlock_single_threaded(&stream->_lock->mutex);
+	else
+		__libc_lock_unlock_recursive(*stream->_lock);
 }
 
 
@@ -44,6 +44,7 @@
 #define _IO_HAVE_SYS_WAIT _G_HAVE_SYS_WAIT
 #define _IO_HAVE_ST_BLKSIZE _G_HAVE_ST_BLKSIZE
 #define _IO_BUFSIZ _G_BUFSIZ
+#define _IO_MAX_FILE_BUFSIZ _G_MAX_FILE_BUFSIZ
 #define _IO_va_list _G_va_list
 #define _IO_wint_t _G_wint_t
 #define __mbstate_t __c_mbstate_t
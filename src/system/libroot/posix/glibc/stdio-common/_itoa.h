@@ -33,6 +33,7 @@ extern const char _itoa_upper_digits[];
 extern const char _itoa_upper_digits_internal[] attribute_hidden;
 extern const char _itoa_lower_digits[];
 extern const char _itoa_lower_digits_internal[] attribute_hidden;
+extern const char _itoa_decimal_pairs[];
 
 static inline char * __attribute__ ((unused))
 _itoa_word (unsigned long value, char *buflim,
@@ -57,7 +58,24 @@ _itoa_word (unsigned long value, char *buflim,
       while ((value /= Base) != 0);					      \
       break
 
-      SPECIAL (10);
+    case 10:
+      /* Two digits per division.  */
+      while (value >= 100)
+	{
+	  const char *pair = &_itoa_decimal_pairs[(value % 100) * 2];
+	  value /= 100;
+	  *--buflim = pair[1];
+	  *--buflim = pair[0];
+	}
+      if (value >= 10)
+	{
+	  *--buflim = _itoa_decimal_pairs[value * 2 + 1];
+	  *--buflim = _itoa_decimal_pairs[value * 2];
+	}
+      else
+	*--buflim = digits[value];
+      break;
+
       SPECIAL (16);
       SPECIAL (8);
     default:
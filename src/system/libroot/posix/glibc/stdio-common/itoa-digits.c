@@ -21,3 +21,10 @@
 const char _itoa_lower_digits[36]
 	= "0123456789abcdefghijklmnopqrstuvwxyz";
 //INTVARDEF(_itoa_lower_digits)
+
+/* Pairs of decimal digits, to convert two digits at a time.  */
+const char _itoa_decimal_pairs[201]
+	= "00010203040506070809101112131415161718192021222324"
+	  "25262728293031323334353637383940414243444546474849"
+	  "50515253545556575859606162636465666768697071727374"
+	  "75767778798081828384858687888990919293949596979899";
@@ -70,15 +70,19 @@ static size_t sFreeHeapSize, sHeapAreaSize;
 static free_chunk *sFreeChunks;
 
 
-static void
-init_after_fork(void)
+extern "C" void
+__heap_after_fork_child(void)
 {
+	// TODO: We should actually also have a hook that is called before fork()
+	// is being executed. In a multithreaded app it would need to acquire *all*
+	// allocator locks, so that we don't fork() an inconsistent state.
+
 	// find the heap area
 	sHeapArea = area_for((void*)sFreeHeapBase);
 	if (sHeapArea < 0) {
 		// Where is it gone?
-		debug_printf("hoard: init_after_fork(): thread %" B_PRId32 ", Heap "
-			"area not found! Base address: %p\n", find_thread(NULL),
+		debug_printf("hoard: __heap_after_fork_child(): thread %" B_PRId32
+			", Heap area not found! Base address: %p\n", find_thread(NULL),
 			sHeapBase);
 		exit(1);
 	}
@@ -113,13 +117,6 @@ __init_heap(void)
 
 	hoardLockInit(sHeapLock, "heap");
 
-	atfork(&init_after_fork);
-		// Note: Needs malloc(). Hence we need to be fully initialized.
-		// TODO: We should actually also install a hook that is called before
-		// fork() is being executed. In a multithreaded app it would need to
-		// acquire *all* allocator locks, so that we don't fork() an
-		// inconsistent state.
-
 	return B_OK;
 }
 
@@ -138,6 +135,13 @@ __heap_terminate_after()
 }
 
 
+extern "C" void
+__heap_thread_exit()
+{
+	// nothing to do
+}
+
+
 static void
 insert_chunk(free_chunk *newChunk)
 {
@@ -1125,20 +1125,6 @@ heap_debug_set_stack_trace_depth(size_t stackTraceDepth)
 // #pragma mark - Init
 
 
-static void
-init_after_fork()
-{
-	// The memory has actually been copied (or is in a copy on write state) but
-	// but the area ids have changed.
-	for (guarded_heap_area* area = sGuardedHeap.areas; area != NULL;
-			area = area->next) {
-		area->area = area_for(area);
-		if (area->area < 0)
-			panic("failed to find area for heap area %p after fork", area);
-	}
-}
-
-
 extern "C" status_t
 __init_heap(void)
 {
@@ -1153,13 +1139,6 @@ __init_heap(void)
 	sigemptyset(&action.sa_mask);
 	sigaction(SIGSEGV, &action, NULL);
 
-	atfork(&init_after_fork);
-		// Note: Needs malloc(). Hence we need to be fully initialized.
-		// TODO: We should actually also install a hook that is called before
-		// fork() is being executed. In a multithreaded app it would need to
-		// acquire *all* allocator locks, so that we don't fork() an
-		// inconsistent state.
-
 	return B_OK;
 }
 
@@ -1199,6 +1178,27 @@ __heap_terminate_after()
 }
 
 
+extern "C" void
+__heap_thread_exit()
+{
+	// nothing to do
+}
+
+
+extern "C" void
+__heap_after_fork_child()
+{
+	// The memory has actually been copied (or is in a copy on write state) but
+	// but the area ids have changed.
+	for (guarded_heap_area* area = sGuardedHeap.areas; area != NULL;
+			area = area->next) {
+		area->area = area_for(area);
+		if (area->area < 0)
+			panic("failed to find area for heap area %p after fork", area);
+	}
+}
+
+
 // #pragma mark - Public API
 
 
@@ -1886,6 +1886,20 @@ __heap_terminate_after()
 }
 
 
+extern "C" void
+__heap_thread_exit()
+{
+	// nothing to do
+}
+
+
+extern "C" void
+__heap_after_fork_child()
+{
+	// nothing to do
+}
+
+
 //	#pragma mark - Public API
 
 
@@ -0,0 +1,981 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	A slab allocator with per-thread caches.
+
+	Small allocations are rounded up to one of kSizeClassCount size classes.
+	The objects of a size class are carved from slabs, which consist of one or
+	more units of a segment. Every thread keeps a cache of free objects for
+	each size class, so that most allocations and frees neither need a lock
+	nor an atomic operation. Objects are moved between the thread caches and
+	the slabs in batches, under the lock of their size class.
+
+	Slabs that become empty are given back to their segment, and a segment
+	without slabs is deleted, except for one that is kept for future use.
+	Large allocations get an area of their own, which is deleted when they
+	are freed, unless it is small enough to be kept in a small cache of
+	recently freed areas. The kernel cannot yet discard individual pages of
+	an area, so this is the granularity memory is returned to the system
+	with.
+*/
+
+
+#include "heap.h"
+
+#include <string.h>
+
+#include <locks.h>
+#include <syscalls.h>
+#include <tls.h>
+
+#include <libroot_private.h>
+
+
+namespace BPrivate {
+
+
+static const uint32 kSegmentKind = 'sgmt';
+static const uint32 kLargeKind = 'larg';
+
+static const size_t kSegmentHeaderSize = B_PAGE_SIZE;
+	// the objects of a slab that starts in the first unit of a segment follow
+	// the header, all others start at the beginning of their unit
+static const uint8 kFreeUnit = 0xff;
+
+static const size_t kMaxBatchSize = 32 * 1024;
+static const uint32 kMaxBatchCount = 64;
+static const uint32 kMinBatchCount = 2;
+static const uint32 kMinObjectsPerSlab = 8;
+
+static const uint32 kMaxCachedLargeAreas = 8;
+static const size_t kMaxCachedLargeSize = 1024 * 1024;
+
+
+struct heap_segment;
+
+struct heap_slab {
+	heap_slab*		next;
+	heap_slab*		previous;
+		// in the list of slabs of the size class that have free objects
+	heap_segment*	segment;
+	void*			free_list;
+	addr_t			unused;
+		// the objects from here to the end of the slab were never allocated
+	addr_t			end;
+	uint32			object_count;
+	uint32			used_count;
+		// objects that are either allocated, or in a thread cache
+	uint16			size_class;
+	uint16			unit_count;
+};
+
+struct heap_segment {
+	uint32			kind;
+	heap_segment*	next;
+	heap_segment*	previous;
+	uint32			free_units;
+	uint8			slab_unit[kUnitsPerSegment];
+		// the first unit of the slab each unit belongs to, or kFreeUnit
+	heap_slab		slabs[kUnitsPerSegment];
+		// only the entry of the first unit of a slab is used
+};
+
+struct heap_large_allocation {
+	uint32			kind;
+	size_t			area_size;
+	size_t			header_size;
+		// the allocation starts this many bytes after the header
+};
+
+struct heap_size_class {
+	mutex			lock;
+	size_t			size;
+	uint32			batch_count;
+	uint32			unit_count;
+	heap_slab*		partial_slabs;
+	uint32			slab_count;
+	uint32			object_count;
+	uint32			used_count;
+};
+
+struct heap_cache_list {
+	void*			objects;
+	uint32			count;
+};
+
+struct heap_thread_cache {
+	heap_thread_cache*	next;
+	heap_thread_cache*	previous;
+	heap_cache_list		lists[kSizeClassCount];
+};
+
+
+static const size_t kLargeHeaderSize = (sizeof(heap_large_allocation)
+	+ kHeapAlignment - 1) & ~(kHeapAlignment - 1);
+
+
+static heap_size_class sSizeClasses[kSizeClassCount];
+static uint8 sSizeClassIndex[kMaxSmallSize / kHeapAlignment + 1];
+static uint32 sThreadCacheClass;
+static uint32 sAreaProtection;
+
+static mutex sSegmentLock = MUTEX_INITIALIZER("heap segments");
+static heap_segment* sSegments;
+static heap_segment* sEmptySegment;
+static uint32 sSegmentCount;
+
+static mutex sLargeLock = MUTEX_INITIALIZER("heap large areas");
+static heap_large_allocation* sCachedLargeAreas[kMaxCachedLargeAreas];
+static uint32 sCachedLargeAreaCount;
+static size_t sLargeMappedBytes;
+static size_t sLargeUsedBytes;
+
+static mutex sThreadCacheLock = MUTEX_INITIALIZER("heap thread caches");
+static heap_thread_cache* sThreadCaches;
+
+static int64 sReturnedBytes;
+
+
+static inline uint32
+size_class_for(size_t size)
+{
+	return sSizeClassIndex[(size + kHeapAlignment - 1) / kHeapAlignment];
+}
+
+
+static inline heap_segment*
+segment_for(void* address)
+{
+	// Allocations never start at the beginning of a segment or a large
+	// allocation area, but they may end up exactly one segment after it.
+	return (heap_segment*)(((addr_t)address - 1) & ~(kSegmentSize - 1));
+}
+
+
+static inline heap_slab*
+slab_for(heap_segment* segment, void* address)
+{
+	uint32 unit = ((addr_t)address - (addr_t)segment) / kUnitSize;
+	return &segment->slabs[segment->slab_unit[unit]];
+}
+
+
+/*!	Creates an area of \a size bytes, whose address plus \a offset is aligned
+	to \a alignment.
+*/
+static void*
+create_aligned_area(const char* name, size_t size, size_t alignment,
+	size_t offset)
+{
+	// Reserve a range that is large enough for the aligned area, create the
+	// area in it, and release the rest of the range again.
+	addr_t rangeSize = size + alignment;
+	if (rangeSize < size)
+		return NULL;
+
+	addr_t rangeBase = 0;
+	if (_kern_reserve_address_range(&rangeBase, B_RANDOMIZED_ANY_ADDRESS,
+			rangeSize) != B_OK) {
+		return NULL;
+	}
+
+	void* address = (void*)(((rangeBase + offset + alignment - 1)
+		& ~(alignment - 1)) - offset);
+	area_id area = _kern_create_area(name, &address, B_EXACT_ADDRESS, size,
+		B_NO_LOCK, sAreaProtection);
+
+	_kern_unreserve_address_range(rangeBase, rangeSize);
+
+	if (area < 0)
+		return NULL;
+
+	return address;
+}
+
+
+//	#pragma mark - segments and slabs
+
+
+static heap_segment*
+create_segment()
+{
+	heap_segment* segment = sEmptySegment;
+	if (segment != NULL)
+		sEmptySegment = NULL;
+	else {
+		segment = (heap_segment*)create_aligned_area("heap segment",
+			kSegmentSize, kSegmentSize, 0);
+		if (segment == NULL)
+			return NULL;
+
+		segment->kind = kSegmentKind;
+		segment->free_units = kUnitsPerSegment;
+		memset(segment->slab_unit, kFreeUnit, sizeof(segment->slab_unit));
+		sSegmentCount++;
+	}
+
+	segment->previous = NULL;
+	segment->next = sSegments;
+	if (sSegments != NULL)
+		sSegments->previous = segment;
+	sSegments = segment;
+
+	return segment;
+}
+
+
+static int32
+find_free_units(heap_segment* segment, uint32 count)
+{
+	uint32 found = 0;
+	for (uint32 unit = 0; unit < kUnitsPerSegment; unit++) {
+		if (segment->slab_unit[unit] != kFreeUnit) {
+			found = 0;
+			continue;
+		}
+
+		if (++found == count)
+			return unit + 1 - count;
+	}
+
+	return -1;
+}
+
+
+/*!	The lock of the size class must be held.
+*/
+static heap_slab*
+allocate_slab(uint32 classIndex)
+{
+	heap_size_class& sizeClass = sSizeClasses[classIndex];
+	uint32 unitCount = sizeClass.unit_count;
+
+	mutex_lock(&sSegmentLock);
+
+	// Use the fullest segment that has room for the slab, so that the others
+	// have a chance to become empty.
+	heap_segment* segment = NULL;
+	int32 firstUnit = -1;
+	for (heap_segment* candidate = sSegments; candidate != NULL;
+			candidate = candidate->next) {
+		if (candidate->free_units < unitCount
+			|| (segment != NULL
+				&& candidate->free_units >= segment->free_units)) {
+			continue;
+		}
+
+		int32 unit = find_free_units(candidate, unitCount);
+		if (unit >= 0) {
+			segment = candidate;
+			firstUnit = unit;
+		}
+	}
+
+	if (segment == NULL) {
+		segment = create_segment();
+		if (segment == NULL) {
+			mutex_unlock(&sSegmentLock);
+			return NULL;
+		}
+
+		firstUnit = 0;
+	}
+
+	for (uint32 i = 0; i < unitCount; i++)
+		segment->slab_unit[firstUnit + i] = firstUnit;
+	segment->free_units -= unitCount;
+
+	mutex_unlock(&sSegmentLock);
+
+	addr_t start = (addr_t)segment + firstUnit * kUnitSize;
+	if (firstUnit == 0)
+		start += kSegmentHeaderSize;
+
+	heap_slab* slab = &segment->slabs[firstUnit];
+	slab->segment = segment;
+	slab->free_list = NULL;
+	slab->unused = start;
+	slab->end = (addr_t)segment + (firstUnit + unitCount) * kUnitSize;
+	slab->object_count = (slab->end - start) / sizeClass.size;
+	slab->used_count = 0;
+	slab->size_class = classIndex;
+	slab->unit_count = unitCount;
+
+	return slab;
+}
+
+
+/*!	The lock of the slab's size class must be held.
+*/
+static void
+free_slab(heap_slab* slab)
+{
+	heap_segment* segment = slab->segment;
+	uint32 firstUnit = slab - segment->slabs;
+
+	mutex_lock(&sSegmentLock);
+
+	for (uint32 i = 0; i < slab->unit_count; i++)
+		segment->slab_unit[firstUnit + i] = kFreeUnit;
+	segment->free_units += slab->unit_count;
+
+	if (segment->free_units < kUnitsPerSegment) {
+		mutex_unlock(&sSegmentLock);
+		return;
+	}
+
+	// the segment is empty now, keep it for later use, or delete it
+
+	if (segment->previous != NULL)
+		segment->previous->next = segment->next;
+	else
+		sSegments = segment->next;
+	if (segment->next != NULL)
+		segment->next->previous = segment->previous;
+
+	if (sEmptySegment == NULL) {
+		sEmptySegment = segment;
+		mutex_unlock(&sSegmentLock);
+		return;
+	}
+
+	sSegmentCount--;
+	mutex_unlock(&sSegmentLock);
+
+	_kern_delete_area(_kern_area_for(segment));
+	atomic_add64(&sReturnedBytes, kSegmentSize);
+}
+
+
+static inline void
+add_partial_slab(heap_size_class& sizeClass, heap_slab* slab)
+{
+	slab->previous = NULL;
+	slab->next = sizeClass.partial_slabs;
+	if (slab->next != NULL)
+		slab->next->previous = slab;
+	sizeClass.partial_slabs = slab;
+}
+
+
+static inline void
+remove_partial_slab(heap_size_class& sizeClass, heap_slab* slab)
+{
+	if (slab->previous != NULL)
+		slab->previous->next = slab->next;
+	else
+		sizeClass.partial_slabs = slab->next;
+	if (slab->next != NULL)
+		slab->next->previous = slab->previous;
+}
+
+
+//	#pragma mark - size classes
+
+
+/*!	Moves up to \a count objects of the given size class out of its slabs,
+	and returns them as a list linked through their first word. The number
+	of objects is returned in \a _count.
+*/
+static void*
+central_allocate(uint32 classIndex, uint32 count, uint32* _count)
+{
+	heap_size_class& sizeClass = sSizeClasses[classIndex];
+	size_t size = sizeClass.size;
+	void* objects = NULL;
+	uint32 allocated = 0;
+
+	mutex_lock(&sizeClass.lock);
+
+	while (allocated < count) {
+		heap_slab* slab = sizeClass.partial_slabs;
+		if (slab == NULL) {
+			slab = allocate_slab(classIndex);
+			if (slab == NULL)
+				break;
+
+			add_partial_slab(sizeClass, slab);
+			sizeClass.slab_count++;
+			sizeClass.object_count += slab->object_count;
+		}
+
+		while (allocated < count && slab->used_count < slab->object_count) {
+			void* object = slab->free_list;
+			if (object != NULL)
+				slab->free_list = *(void**)object;
+			else {
+				object = (void*)slab->unused;
+				slab->unused += size;
+			}
+
+			*(void**)object = objects;
+			objects = object;
+			slab->used_count++;
+			allocated++;
+		}
+
+		if (slab->used_count == slab->object_count)
+			remove_partial_slab(sizeClass, slab);
+	}
+
+	sizeClass.used_count += allocated;
+
+	mutex_unlock(&sizeClass.lock);
+
+	*_count = allocated;
+	return objects;
+}
+
+
+/*!	Returns a list of objects of the given size class, as created by
+	central_allocate(), to their slabs.
+*/
+static void
+central_free(uint32 classIndex, void* objects)
+{
+	heap_size_class& sizeClass = sSizeClasses[classIndex];
+	uint32 freed = 0;
+
+	mutex_lock(&sizeClass.lock);
+
+	while (objects != NULL) {
+		void* object = objects;
+		objects = *(void**)object;
+		freed++;
+
+		heap_slab* slab = slab_for(segment_for(object), object);
+		*(void**)object = slab->free_list;
+		slab->free_list = object;
+
+		if (slab->used_count-- == slab->object_count)
+			add_partial_slab(sizeClass, slab);
+
+		if (slab->used_count == 0) {
+			remove_partial_slab(sizeClass, slab);
+			sizeClass.slab_count--;
+			sizeClass.object_count -= slab->object_count;
+			free_slab(slab);
+		}
+	}
+
+	sizeClass.used_count -= freed;
+
+	mutex_unlock(&sizeClass.lock);
+}
+
+
+static void
+init_size_classes()
+{
+	// 16 byte steps up to 128 bytes, then four steps per power of two
+	size_t size = 0;
+	for (uint32 i = 0; i < kSizeClassCount; i++) {
+		if (i < 8)
+			size = (i + 1) * 16;
+		else
+			size += (size_t)128 << ((i - 8) / 4) >> 2;
+
+		heap_size_class& sizeClass = sSizeClasses[i];
+		mutex_init_etc(&sizeClass.lock, "heap size class",
+			MUTEX_FLAG_ADAPTIVE);
+		sizeClass.size = size;
+
+		uint32 batchCount = kMaxBatchSize / size;
+		if (batchCount > kMaxBatchCount)
+			batchCount = kMaxBatchCount;
+		else if (batchCount < kMinBatchCount)
+			batchCount = kMinBatchCount;
+		sizeClass.batch_count = batchCount;
+
+		sizeClass.unit_count = (size * kMinObjectsPerSlab + kUnitSize - 1)
+			/ kUnitSize;
+	}
+
+	uint32 classIndex = 0;
+	for (uint32 i = 0; i <= kMaxSmallSize / kHeapAlignment; i++) {
+		while (sSizeClasses[classIndex].size < i * kHeapAlignment)
+			classIndex++;
+		sSizeClassIndex[i] = classIndex;
+	}
+}
+
+
+//	#pragma mark - thread caches
+
+
+static heap_thread_cache*
+create_thread_cache()
+{
+	uint32 count;
+	heap_thread_cache* cache = (heap_thread_cache*)central_allocate(
+		sThreadCacheClass, 1, &count);
+	if (cache == NULL)
+		return NULL;
+
+	memset(cache, 0, sizeof(heap_thread_cache));
+
+	mutex_lock(&sThreadCacheLock);
+	cache->next = sThreadCaches;
+	if (cache->next != NULL)
+		cache->next->previous = cache;
+	sThreadCaches = cache;
+	mutex_unlock(&sThreadCacheLock);
+
+	tls_set(TLS_MALLOC_SLOT, cache);
+	return cache;
+}
+
+
+static inline heap_thread_cache*
+get_thread_cache()
+{
+	heap_thread_cache* cache = (heap_thread_cache*)tls_get(TLS_MALLOC_SLOT);
+	if (cache != NULL)
+		return cache;
+
+	return create_thread_cache();
+}
+
+
+/*!	Moves \a count objects from the front of the cache list to their slabs.
+*/
+static void
+release_cached_objects(heap_cache_list& list, uint32 classIndex, uint32 count)
+{
+	void* objects = list.objects;
+	void* last = objects;
+	for (uint32 i = 1; i < count; i++)
+		last = *(void**)last;
+
+	list.objects = *(void**)last;
+	list.count -= count;
+	*(void**)last = NULL;
+
+	central_free(classIndex, objects);
+}
+
+
+//	#pragma mark - small and large allocations
+
+
+static void*
+allocate_small(uint32 classIndex)
+{
+	uint32 count;
+	heap_thread_cache* cache = get_thread_cache();
+	if (cache == NULL)
+		return central_allocate(classIndex, 1, &count);
+
+	heap_cache_list& list = cache->lists[classIndex];
+	void* object = list.objects;
+	if (object != NULL) {
+		list.objects = *(void**)object;
+		list.count--;
+		return object;
+	}
+
+	object = central_allocate(classIndex, sSizeClasses[classIndex].batch_count,
+		&count);
+	if (object == NULL)
+		return NULL;
+
+	list.objects = *(void**)object;
+	list.count = count - 1;
+	return object;
+}
+
+
+static void
+free_small(heap_segment* segment, void* address)
+{
+	uint32 classIndex = slab_for(segment, address)->size_class;
+
+	heap_thread_cache* cache = get_thread_cache();
+	if (cache == NULL) {
+		*(void**)address = NULL;
+		central_free(classIndex, address);
+		return;
+	}
+
+	heap_cache_list& list = cache->lists[classIndex];
+	*(void**)address = list.objects;
+	list.objects = address;
+
+	uint32 batchCount = sSizeClasses[classIndex].batch_count;
+	if (++list.count > 2 * batchCount)
+		release_cached_objects(list, classIndex, batchCount);
+}
+
+
+static heap_large_allocation*
+get_cached_large_area(size_t areaSize)
+{
+	mutex_lock(&sLargeLock);
+
+	// use the smallest area that fits, if it doesn't waste too much
+	int32 best = -1;
+	for (uint32 i = 0; i < sCachedLargeAreaCount; i++) {
+		size_t size = sCachedLargeAreas[i]->area_size;
+		if (size >= areaSize && size / 2 <= areaSize
+			&& (best < 0 || size < sCachedLargeAreas[best]->area_size)) {
+			best = i;
+		}
+	}
+
+	heap_large_allocation* large = NULL;
+	if (best >= 0) {
+		large = sCachedLargeAreas[best];
+		sCachedLargeAreas[best] = sCachedLargeAreas[--sCachedLargeAreaCount];
+		sLargeUsedBytes += large->area_size;
+	}
+
+	mutex_unlock(&sLargeLock);
+	return large;
+}
+
+
+static void*
+allocate_large(size_t size, size_t alignment)
+{
+	// The header is at the start of the area, which is aligned to the segment
+	// size. Alignments larger than that are achieved by placing the header a
+	// segment before the allocation.
+	size_t headerSize = alignment > kLargeHeaderSize
+		? alignment : kLargeHeaderSize;
+	size_t areaAlignment = kSegmentSize;
+	size_t offset = 0;
+	if (headerSize >= kSegmentSize) {
+		headerSize = kSegmentSize;
+		areaAlignment = alignment;
+		offset = kSegmentSize;
+	}
+
+	if (size > ~(size_t)0 - headerSize - B_PAGE_SIZE - areaAlignment)
+		return NULL;
+
+	size_t areaSize = (headerSize + size + B_PAGE_SIZE - 1)
+		& ~(B_PAGE_SIZE - 1);
+
+	heap_large_allocation* large = NULL;
+	if (offset == 0)
+		large = get_cached_large_area(areaSize);
+
+	if (large == NULL) {
+		large = (heap_large_allocation*)create_aligned_area("heap large",
+			areaSize, areaAlignment, offset);
+		if (large == NULL)
+			return NULL;
+
+		large->kind = kLargeKind;
+		large->area_size = areaSize;
+
+		mutex_lock(&sLargeLock);
+		sLargeMappedBytes += areaSize;
+		sLargeUsedBytes += areaSize;
+		mutex_unlock(&sLargeLock);
+	}
+
+	large->header_size = headerSize;
+	return (uint8*)large + headerSize;
+}
+
+
+static void
+free_large(heap_large_allocation* large)
+{
+	size_t areaSize = large->area_size;
+
+	mutex_lock(&sLargeLock);
+
+	sLargeUsedBytes -= areaSize;
+
+	if (areaSize <= kMaxCachedLargeSize
+		&& sCachedLargeAreaCount < kMaxCachedLargeAreas) {
+		sCachedLargeAreas[sCachedLargeAreaCount++] = large;
+		mutex_unlock(&sLargeLock);
+		return;
+	}
+
+	sLargeMappedBytes -= areaSize;
+
+	mutex_unlock(&sLargeLock);
+
+	_kern_delete_area(_kern_area_for(large));
+	atomic_add64(&sReturnedBytes, areaSize);
+}
+
+
+/*!	Tries to resize the large allocation in place.
+*/
+static bool
+resize_large(heap_large_allocation* large, size_t newSize)
+{
+	if (newSize > ~(size_t)0 - large->header_size - B_PAGE_SIZE)
+		return false;
+
+	size_t oldAreaSize = large->area_size;
+	size_t areaSize = (large->header_size + newSize + B_PAGE_SIZE - 1)
+		& ~(B_PAGE_SIZE - 1);
+	if (areaSize == oldAreaSize)
+		return true;
+
+	if (_kern_resize_area(_kern_area_for(large), areaSize) != B_OK)
+		return false;
+
+	large->area_size = areaSize;
+
+	mutex_lock(&sLargeLock);
+	sLargeMappedBytes += areaSize - oldAreaSize;
+	sLargeUsedBytes += areaSize - oldAreaSize;
+	mutex_unlock(&sLargeLock);
+
+	if (areaSize < oldAreaSize)
+		atomic_add64(&sReturnedBytes, oldAreaSize - areaSize);
+
+	return true;
+}
+
+
+//	#pragma mark - private API
+
+
+status_t
+heap_init()
+{
+	sAreaProtection = B_READ_AREA | B_WRITE_AREA;
+	if (__gABIVersion < B_HAIKU_ABI_GCC_2_HAIKU)
+		sAreaProtection |= B_EXECUTE_AREA;
+
+	init_size_classes();
+	sThreadCacheClass = size_class_for(sizeof(heap_thread_cache));
+
+	return B_OK;
+}
+
+
+/*!	Only the thread that called fork() continues to exist in the child. The
+	objects in the caches of the other threads are lost, but the locks they
+	held must not be.
+*/
+void
+heap_init_after_fork()
+{
+	for (uint32 i = 0; i < kSizeClassCount; i++) {
+		mutex_init_etc(&sSizeClasses[i].lock, "heap size class",
+			MUTEX_FLAG_ADAPTIVE);
+	}
+
+	mutex_init(&sSegmentLock, "heap segments");
+	mutex_init(&sLargeLock, "heap large areas");
+	mutex_init(&sThreadCacheLock, "heap thread caches");
+
+	heap_thread_cache* cache = (heap_thread_cache*)tls_get(TLS_MALLOC_SLOT);
+	if (cache != NULL)
+		cache->next = cache->previous = NULL;
+	sThreadCaches = cache;
+}
+
+
+void*
+heap_allocate(size_t size, size_t alignment)
+{
+	if (alignment <= kHeapAlignment) {
+		if (size <= kMaxSmallSize)
+			return allocate_small(size_class_for(size));
+
+		return allocate_large(size, kHeapAlignment);
+	}
+
+	if (alignment <= B_PAGE_SIZE && size <= kMaxSmallSize) {
+		// The objects of power of two size classes are aligned to their size,
+		// or at least to the page size.
+		size_t alignedSize = alignment;
+		while (alignedSize < size)
+			alignedSize <<= 1;
+
+		if (alignedSize <= kMaxSmallSize)
+			return allocate_small(size_class_for(alignedSize));
+	}
+
+	return allocate_large(size, alignment);
+}
+
+
+void
+heap_free(void* address)
+{
+	if (address == NULL)
+		return;
+
+	heap_segment* segment = segment_for(address);
+	if (segment->kind == kSegmentKind)
+		free_small(segment, address);
+	else if (segment->kind == kLargeKind)
+		free_large((heap_large_allocation*)segment);
+	else
+		debugger("free(): address was not allocated by malloc()");
+}
+
+
+/*!	Returns \a address, if the allocation could be resized in place, or a
+	new allocation, to which the contents have been moved.
+*/
+void*
+heap_reallocate(void* address, size_t newSize)
+{
+	heap_segment* segment = segment_for(address);
+	size_t oldSize;
+
+	if (segment->kind == kLargeKind) {
+		heap_large_allocation* large = (heap_large_allocation*)segment;
+		if (newSize > kMaxSmallSize && resize_large(large, newSize))
+			return address;
+
+		oldSize = large->area_size - large->header_size;
+	} else {
+		oldSize = sSizeClasses[slab_for(segment, address)->size_class].size;
+		if (newSize <= oldSize)
+			return address;
+	}
+
+	void* newAddress = heap_allocate(newSize, kHeapAlignment);
+	if (newAddress == NULL)
+		return NULL;
+
+	memcpy(newAddress, address, oldSize < newSize ? oldSize : newSize);
+	heap_free(address);
+
+	return newAddress;
+}
+
+
+size_t
+heap_usable_size(void* address)
+{
+	heap_segment* segment = segment_for(address);
+	if (segment->kind == kLargeKind) {
+		heap_large_allocation* large = (heap_large_allocation*)segment;
+		return large->area_size - large->header_size;
+	}
+
+	return sSizeClasses[slab_for(segment, address)->size_class].size;
+}
+
+
+/*!	Returns the objects in the cache of the current thread to their slabs,
+	and deletes the cache.
+*/
+void
+heap_thread_exit()
+{
+	heap_thread_cache* cache = (heap_thread_cache*)tls_get(TLS_MALLOC_SLOT);
+	if (cache == NULL)
+		return;
+
+	tls_set(TLS_MALLOC_SLOT, NULL);
+
+	mutex_lock(&sThreadCacheLock);
+	if (cache->previous != NULL)
+		cache->previous->next = cache->next;
+	else
+		sThreadCaches = cache->next;
+	if (cache->next != NULL)
+		cache->next->previous = cache->previous;
+	mutex_unlock(&sThreadCacheLock);
+
+	for (uint32 i = 0; i < kSizeClassCount; i++) {
+		if (cache->lists[i].objects != NULL)
+			central_free(i, cache->lists[i].objects);
+	}
+
+	*(void**)cache = NULL;
+	central_free(sThreadCacheClass, cache);
+}
+
+
+status_t
+heap_get_statistics(malloc_statistics* stats)
+{
+	// The numbers are collected without stopping the other threads, so they
+	// don't have to add up exactly.
+	size_t smallUsed = 0;
+	for (uint32 i = 0; i < kSizeClassCount; i++) {
+		heap_size_class& sizeClass = sSizeClasses[i];
+		mutex_lock(&sizeClass.lock);
+		smallUsed += sizeClass.used_count * sizeClass.size;
+		mutex_unlock(&sizeClass.lock);
+	}
+
+	size_t cached = 0;
+	mutex_lock(&sThreadCacheLock);
+	for (heap_thread_cache* cache = sThreadCaches; cache != NULL;
+			cache = cache->next) {
+		for (uint32 i = 0; i < kSizeClassCount; i++)
+			cached += cache->lists[i].count * sSizeClasses[i].size;
+	}
+	mutex_unlock(&sThreadCacheLock);
+
+	mutex_lock(&sSegmentLock);
+	size_t mapped = sSegmentCount * kSegmentSize;
+	mutex_unlock(&sSegmentLock);
+
+	mutex_lock(&sLargeLock);
+	mapped += sLargeMappedBytes;
+	size_t used = smallUsed + sLargeUsedBytes;
+	mutex_unlock(&sLargeLock);
+
+	if (cached > used)
+		cached = used;
+	if (used > mapped)
+		used = mapped;
+
+	stats->mapped_bytes = mapped;
+	stats->used_bytes = used - cached;
+	stats->cached_bytes = cached;
+	stats->free_bytes = mapped - used;
+	stats->returned_bytes = atomic_get64(&sReturnedBytes);
+	stats->size_class_count = kSizeClassCount;
+
+	return B_OK;
+}
+
+
+status_t
+heap_get_size_class_statistics(uint32 index,
+	malloc_size_class_statistics* stats)
+{
+	if (index >= kSizeClassCount)
+		return B_BAD_INDEX;
+
+	heap_size_class& sizeClass = sSizeClasses[index];
+	mutex_lock(&sizeClass.lock);
+	uint32 slabCount = sizeClass.slab_count;
+	uint32 objectCount = sizeClass.object_count;
+	uint32 used = sizeClass.used_count;
+	mutex_unlock(&sizeClass.lock);
+
+	uint32 cached = 0;
+	mutex_lock(&sThreadCacheLock);
+	for (heap_thread_cache* cache = sThreadCaches; cache != NULL;
+			cache = cache->next) {
+		cached += cache->lists[index].count;
+	}
+	mutex_unlock(&sThreadCacheLock);
+
+	if (cached > used)
+		cached = used;
+
+	stats->object_size = sizeClass.size;
+	stats->slab_count = slabCount;
+	stats->used_objects = used - cached;
+	stats->cached_objects = cached;
+	stats->free_objects = objectCount - used;
+
+	return B_OK;
+}
+
+
+}	// namespace BPrivate
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SLAB_HEAP_H
+#define SLAB_HEAP_H
+
+
+#include <OS.h>
+
+#include <malloc_stats.h>
+
+
+namespace BPrivate {
+
+
+static const size_t kHeapAlignment = 16;
+	// the minimum alignment of all allocations
+
+static const size_t kSegmentSize = 1024 * 1024;
+	// memory for small allocations is obtained from the system in segments of
+	// this size; they, and all large allocations, are aligned to it, so that
+	// the header of the memory an allocation belongs to can be found by
+	// masking its address
+static const size_t kUnitSize = 64 * 1024;
+	// segments are divided into units of this size, slabs consist of one or
+	// more units
+static const uint32 kUnitsPerSegment = kSegmentSize / kUnitSize;
+
+static const size_t kMaxSmallSize = 32 * 1024;
+	// larger allocations get an area of their own
+static const uint32 kSizeClassCount = 40;
+
+
+status_t	heap_init();
+void		heap_init_after_fork();
+
+void*		heap_allocate(size_t size, size_t alignment);
+void		heap_free(void* address);
+void*		heap_reallocate(void* address, size_t newSize);
+size_t		heap_usable_size(void* address);
+
+void		heap_thread_exit();
+
+status_t	heap_get_statistics(malloc_statistics* stats);
+status_t	heap_get_size_class_statistics(uint32 index,
+				malloc_size_class_statistics* stats);
+
+
+}	// namespace BPrivate
+
+
+#endif	// SLAB_HEAP_H
@@ -0,0 +1,323 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "heap.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <errno_private.h>
+#include <libroot_private.h>
+#include <user_thread.h>
+
+#include "tracing_config.h"
+
+
+using namespace BPrivate;
+
+
+#if USER_MALLOC_TRACING
+#	define KTRACE(format...)	ktrace_printf(format)
+#else
+#	define KTRACE(format...)	do {} while (false)
+#endif
+
+
+extern "C" void *(*sbrk_hook)(long);
+void *(*sbrk_hook)(long) = NULL;
+	// sbrk() is not supported
+
+
+extern "C" status_t
+__init_heap(void)
+{
+	status_t status = heap_init();
+	if (status != B_OK)
+		return status;
+
+	return B_OK;
+}
+
+
+extern "C" void
+__init_heap_post_env(void)
+{
+	// no heap options available
+}
+
+
+extern "C" void
+__heap_terminate_after()
+{
+	// nothing to do
+}
+
+
+extern "C" void
+__heap_thread_exit(void)
+{
+	defer_signals();
+	heap_thread_exit();
+	undefer_signals();
+}
+
+
+extern "C" void
+__heap_after_fork_child(void)
+{
+	heap_init_after_fork();
+}
+
+
+//	#pragma mark - public functions
+
+
+extern "C" void *
+malloc(size_t size)
+{
+	defer_signals();
+	void *address = heap_allocate(size, 0);
+	undefer_signals();
+
+	if (address == NULL) {
+		__set_errno(B_NO_MEMORY);
+		KTRACE("malloc(%lu) -> NULL", size);
+		return NULL;
+	}
+
+	KTRACE("malloc(%lu) -> %p", size, address);
+	return address;
+}
+
+
+extern "C" void *
+calloc(size_t nelem, size_t elsize)
+{
+	size_t size = nelem * elsize;
+	if (elsize != 0 && size / elsize != nelem) {
+		__set_errno(B_NO_MEMORY);
+		KTRACE("calloc(%lu, %lu) -> NULL", nelem, elsize);
+		return NULL;
+	}
+
+	defer_signals();
+	void *address = heap_allocate(size, 0);
+	undefer_signals();
+
+	if (address == NULL) {
+		__set_errno(B_NO_MEMORY);
+		KTRACE("calloc(%lu, %lu) -> NULL", nelem, elsize);
+		return NULL;
+	}
+
+	memset(address, 0, size);
+	KTRACE("calloc(%lu, %lu) -> %p", nelem, elsize, address);
+	return address;
+}
+
+
+extern "C" void
+free(void *address)
+{
+	KTRACE("free(%p)", address);
+
+	defer_signals();
+	heap_free(address);
+	undefer_signals();
+}
+
+
+extern "C" void *
+memalign(size_t alignment, size_t size)
+{
+	// only power of two alignments are supported
+	size_t powerOfTwo = 1;
+	while (powerOfTwo < alignment && powerOfTwo != 0)
+		powerOfTwo <<= 1;
+
+	if (powerOfTwo == 0) {
+		__set_errno(B_BAD_VALUE);
+		return NULL;
+	}
+
+	defer_signals();
+	void *address = heap_allocate(size, powerOfTwo);
+	undefer_signals();
+
+	if (address == NULL) {
+		__set_errno(B_NO_MEMORY);
+		KTRACE("memalign(%lu, %lu) -> NULL", alignment, size);
+		return NULL;
+	}
+
+	KTRACE("memalign(%lu, %lu) -> %p", alignment, size, address);
+	return address;
+}
+
+
+extern "C" int
+posix_memalign(void **_pointer, size_t alignment, size_t size)
+{
+	if ((alignment & (sizeof(void *) - 1)) != 0
+		|| (alignment & (alignment - 1)) != 0 || _pointer == NULL) {
+		return B_BAD_VALUE;
+	}
+
+	defer_signals();
+	void *pointer = heap_allocate(size, alignment);
+	undefer_signals();
+
+	if (pointer == NULL) {
+		KTRACE("posix_memalign(%p, %lu, %lu) -> NULL", _pointer, alignment,
+			size);
+		return B_NO_MEMORY;
+	}
+
+	*_pointer = pointer;
+	KTRACE("posix_memalign(%p, %lu, %lu) -> %p", _pointer, alignment, size,
+		pointer);
+	return 0;
+}
+
+
+extern "C" void *
+valloc(size_t size)
+{
+	return memalign(B_PAGE_SIZE, size);
+}
+
+
+extern "C" void *
+realloc(void *address, size_t size)
+{
+	if (address == NULL)
+		return malloc(size);
+
+	if (size == 0) {
+		free(address);
+		return NULL;
+	}
+
+	defer_signals();
+	void *newAddress = heap_reallocate(address, size);
+	undefer_signals();
+
+	if (newAddress == NULL) {
+		// Allocation failed, leave old block and return
+		__set_errno(B_NO_MEMORY);
+		KTRACE("realloc(%p, %lu) -> NULL", address, size);
+		return NULL;
+	}
+
+	KTRACE("realloc(%p, %lu) -> %p", address, size, newAddress);
+	return newAddress;
+}
+
+
+extern "C" size_t
+malloc_usable_size(void *address)
+{
+	if (address == NULL)
+		return 0;
+
+	return heap_usable_size(address);
+}
+
+
+//	#pragma mark - statistics
+
+
+extern "C" status_t
+malloc_get_statistics(malloc_statistics *stats)
+{
+	if (stats == NULL)
+		return B_BAD_VALUE;
+
+	return heap_get_statistics(stats);
+}
+
+
+extern "C" status_t
+malloc_get_size_class_statistics(uint32 index,
+	malloc_size_class_statistics *stats)
+{
+	if (stats == NULL)
+		return B_BAD_VALUE;
+
+	return heap_get_size_class_statistics(index, stats);
+}
+
+
+extern "C" void
+malloc_dump_statistics(void)
+{
+	malloc_statistics stats;
+	heap_get_statistics(&stats);
+
+	printf("mapped: %" B_PRIuSIZE ", used: %" B_PRIuSIZE ", cached: %"
+		B_PRIuSIZE ", free: %" B_PRIuSIZE ", returned: %" B_PRIu64 "\n",
+		stats.mapped_bytes, stats.used_bytes, stats.cached_bytes,
+		stats.free_bytes, stats.returned_bytes);
+
+	printf("  size    slabs     used   cached     free\n");
+	for (uint32 i = 0; i < stats.size_class_count; i++) {
+		malloc_size_class_statistics classStats;
+		if (heap_get_size_class_statistics(i, &classStats) != B_OK
+			|| classStats.slab_count == 0) {
+			continue;
+		}
+
+		printf("%6" B_PRIuSIZE " %8" B_PRIu32 " %8" B_PRIu32 " %8" B_PRIu32
+			" %8" B_PRIu32 "\n", classStats.object_size, classStats.slab_count,
+			classStats.used_objects, classStats.cached_objects,
+			classStats.free_objects);
+	}
+}
+
+
+//	#pragma mark - BeOS specific extensions
+
+
+struct mstats {
+	size_t bytes_total;
+	size_t chunks_used;
+	size_t bytes_used;
+	size_t chunks_free;
+	size_t bytes_free;
+};
+
+
+extern "C" struct mstats mstats(void);
+
+extern "C" struct mstats
+mstats(void)
+{
+	// Note, the stats structure is not thread-safe, but it doesn't
+	// matter that much either
+	static struct mstats stats;
+
+	malloc_statistics heapStats;
+	heap_get_statistics(&heapStats);
+
+	uint32 chunks = 0;
+	for (uint32 i = 0; i < heapStats.size_class_count; i++) {
+		malloc_size_class_statistics classStats;
+		if (heap_get_size_class_statistics(i, &classStats) == B_OK
+			&& classStats.used_objects > 0) {
+			chunks++;
+		}
+	}
+
+	stats.bytes_total = heapStats.mapped_bytes;
+	stats.chunks_used = chunks;
+	stats.bytes_used = heapStats.used_bytes;
+	stats.chunks_free = heapStats.size_class_count - chunks;
+	stats.bytes_free = heapStats.mapped_bytes - heapStats.used_bytes;
+
+	return stats;
+}
@@ -152,6 +152,9 @@ pthread_create(pthread_t* _thread, const pthread_attr_t* attr,
 		return error;
 	}
 
+	_single_threaded = false;
+		// from now on, stdio streams have to be locked for real
+
 	thread->id = _kern_spawn_thread(&attributes);
 	if (thread->id < 0) {
 		// stupid error code but demanded by POSIX
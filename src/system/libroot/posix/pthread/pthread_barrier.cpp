@@ -0,0 +1,140 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <pthread.h>
+#include "pthread_private.h"
+
+#include <stdlib.h>
+
+#include <syscalls.h>
+
+
+#define BARRIER_FLAG_SHARED	0x80000000
+
+
+static const pthread_barrierattr pthread_barrierattr_default = {
+	false
+};
+
+
+int
+pthread_barrier_init(pthread_barrier_t* barrier,
+	const pthread_barrierattr_t* _attr, unsigned count)
+{
+	const pthread_barrierattr* attr = _attr != NULL
+		? *_attr : &pthread_barrierattr_default;
+
+	if (barrier == NULL || attr == NULL || count == 0 || count > INT32_MAX)
+		return B_BAD_VALUE;
+
+	barrier->flags = attr->process_shared ? BARRIER_FLAG_SHARED : 0;
+	barrier->sequence = 0;
+	barrier->waiter_count = 0;
+	barrier->waiter_max = count;
+
+	return B_OK;
+}
+
+
+int
+pthread_barrier_destroy(pthread_barrier_t* barrier)
+{
+	if (barrier == NULL)
+		return B_BAD_VALUE;
+
+	return atomic_get((int32*)&barrier->waiter_count) == 0 ? B_OK : B_BUSY;
+}
+
+
+int
+pthread_barrier_wait(pthread_barrier_t* barrier)
+{
+	if (barrier == NULL)
+		return B_BAD_VALUE;
+
+	int32 sequence = atomic_get((int32*)&barrier->sequence);
+
+	if (atomic_add((int32*)&barrier->waiter_count, 1) + 1
+			== barrier->waiter_max) {
+		// We're the last one to arrive. Reset the barrier before letting the
+		// others go, so that it can be reused as soon as they return.
+		atomic_set((int32*)&barrier->waiter_count, 0);
+		atomic_add((int32*)&barrier->sequence, 1);
+		_kern_futex_wake((int32*)&barrier->sequence, INT32_MAX);
+		return PTHREAD_BARRIER_SERIAL_THREAD;
+	}
+
+	while (atomic_get((int32*)&barrier->sequence) == sequence)
+		_kern_futex_wait((int32*)&barrier->sequence, sequence, 0, 0);
+
+	return 0;
+}
+
+
+// #pragma mark - barrier attributes
+
+
+int
+pthread_barrierattr_init(pthread_barrierattr_t* _attr)
+{
+	if (_attr == NULL)
+		return B_BAD_VALUE;
+
+	pthread_barrierattr* attr = (pthread_barrierattr*)malloc(
+		sizeof(pthread_barrierattr));
+	if (attr == NULL)
+		return B_NO_MEMORY;
+
+	*attr = pthread_barrierattr_default;
+	*_attr = attr;
+
+	return B_OK;
+}
+
+
+int
+pthread_barrierattr_destroy(pthread_barrierattr_t* _attr)
+{
+	pthread_barrierattr* attr;
+	if (_attr == NULL || (attr = *_attr) == NULL)
+		return B_BAD_VALUE;
+
+	*_attr = NULL;
+	free(attr);
+
+	return B_OK;
+}
+
+
+int
+pthread_barrierattr_getpshared(const pthread_barrierattr_t* _attr,
+	int* shared)
+{
+	pthread_barrierattr* attr;
+	if (_attr == NULL || (attr = *_attr) == NULL || shared == NULL)
+		return B_BAD_VALUE;
+
+	*shared = attr->process_shared
+		? PTHREAD_PROCESS_SHARED : PTHREAD_PROCESS_PRIVATE;
+
+	return B_OK;
+}
+
+
+int
+pthread_barrierattr_setpshared(pthread_barrierattr_t* _attr, int shared)
+{
+	pthread_barrierattr* attr;
+	if (_attr == NULL || (attr = *_attr) == NULL
+		|| (shared != PTHREAD_PROCESS_SHARED
+			&& shared != PTHREAD_PROCESS_PRIVATE)) {
+		return B_BAD_VALUE;
+	}
+
+	attr->process_shared = shared == PTHREAD_PROCESS_SHARED;
+
+	return B_OK;
+}
@@ -15,7 +15,6 @@
 #include <syscall_utils.h>
 
 #include <syscalls.h>
-#include <user_mutex_defs.h>
 
 
 #define COND_FLAG_SHARED	0x01
@@ -72,27 +71,26 @@ cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, bigtime_t timeout)
 	cond->mutex = mutex;
 	cond->waiter_count++;
 
-	// make sure the user mutex we use for blocking is locked
-	atomic_or((int32*)&cond->lock, B_USER_MUTEX_LOCKED);
+	// Any signal after this point changes the sequence number, so that we
+	// cannot miss it, even before we actually started to wait.
+	int32 sequence = atomic_get((int32*)&cond->lock);
 
-	// atomically unlock the mutex and start waiting on the user mutex
-	mutex->owner = -1;
-	mutex->owner_count = 0;
+	int32 ownerCount = __pthread_mutex_unlock_for_wait(mutex);
 
 	int32 flags = (cond->flags & COND_FLAG_MONOTONIC) != 0 ? B_ABSOLUTE_TIMEOUT
 		: B_ABSOLUTE_REAL_TIME_TIMEOUT;
 
-	status_t status = _kern_mutex_switch_lock((int32*)&mutex->lock,
-		(int32*)&cond->lock, "pthread condition",
+	status_t status = _kern_futex_wait((int32*)&cond->lock, sequence,
 		timeout == B_INFINITE_TIMEOUT ? 0 : flags, timeout);
 
-	if (status == B_INTERRUPTED) {
-		// EINTR is not an allowed return value. We either have to restart
-		// waiting -- which we can't atomically -- or return a spurious 0.
+	if (status == B_WOULD_BLOCK || status == B_INTERRUPTED) {
+		// We have been signalled before we could start waiting. Also, EINTR
+		// is not an allowed return value. We either have to restart waiting
+		// -- which we can't atomically -- or return a spurious 0.
 		status = 0;
 	}
 
-	pthread_mutex_lock(mutex);
+	__pthread_mutex_lock_after_wait(mutex, ownerCount);
 
 	cond->waiter_count--;
 	// If there are no more waiters, we can change mutexes.
@@ -109,9 +107,20 @@ cond_signal(pthread_cond_t* cond, bool broadcast)
 	if (cond->waiter_count == 0)
 		return;
 
-	// release the condition lock
-	_kern_mutex_unlock((int32*)&cond->lock,
-		broadcast ? B_USER_MUTEX_UNBLOCK_ALL : 0);
+	// let threads that are about to wait know they have been signalled
+	int32 sequence = atomic_add((int32*)&cond->lock, 1) + 1;
+
+	pthread_mutex_t* mutex = cond->mutex;
+	if (broadcast && mutex != NULL) {
+		// All but one of the waiters would immediately block on the mutex,
+		// so move them over to it directly.
+		if (_kern_futex_requeue((int32*)&cond->lock, sequence, 1,
+				(int32*)&mutex->lock, INT32_MAX) >= 0) {
+			return;
+		}
+	}
+
+	_kern_futex_wake((int32*)&cond->lock, broadcast ? INT32_MAX : 1);
 }
 
 
@@ -12,6 +12,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <libroot_private.h>
 #include <syscalls.h>
 #include <user_mutex_defs.h>
 
@@ -20,6 +21,11 @@
 #define MUTEX_TYPE_BITS		0x0000000f
 #define MUTEX_TYPE(mutex)	((mutex)->flags & MUTEX_TYPE_BITS)
 
+#define MAX_UNSUCCESSFUL_SPINS	100
+
+
+extern int32 __gCPUCount;
+
 
 static const pthread_mutexattr pthread_mutexattr_default = {
 	PTHREAD_MUTEX_DEFAULT,
@@ -49,6 +55,41 @@ pthread_mutex_destroy(pthread_mutex_t* mutex)
 }
 
 
+/*!	Locks the mutex, assuming that other threads are waiting for it. The
+	waiting flag is set along with the locked flag, so that the next unlock
+	wakes up one more waiter, even if the mutex is acquired right away.
+*/
+static status_t
+mutex_lock_contended(pthread_mutex_t* mutex, bigtime_t timeout)
+{
+	const int32 contendedValue = B_USER_MUTEX_LOCKED | B_USER_MUTEX_WAITING;
+
+	while (true) {
+		int32 oldValue = atomic_or((int32*)&mutex->lock, contendedValue);
+		if ((oldValue & B_USER_MUTEX_LOCKED) == 0)
+			return B_OK;
+
+		status_t error = _kern_futex_wait((int32*)&mutex->lock,
+			contendedValue,
+			timeout == B_INFINITE_TIMEOUT ? 0 : B_ABSOLUTE_REAL_TIME_TIMEOUT,
+			timeout);
+		if (error != B_OK && error != B_WOULD_BLOCK && error != B_INTERRUPTED)
+			return error;
+	}
+}
+
+
+static void
+mutex_unlock(pthread_mutex_t* mutex)
+{
+	// clear the locked flag, and wake up a waiter, if there might be one
+	int32 oldValue = atomic_and((int32*)&mutex->lock,
+		~(int32)(B_USER_MUTEX_LOCKED | B_USER_MUTEX_WAITING));
+	if ((oldValue & B_USER_MUTEX_WAITING) != 0)
+		_kern_futex_wake((int32*)&mutex->lock, 1);
+}
+
+
 static status_t
 mutex_lock(pthread_mutex_t* mutex, bigtime_t timeout)
 {
@@ -75,20 +116,35 @@ mutex_lock(pthread_mutex_t* mutex, bigtime_t timeout)
 	// set the locked flag
 	int32 oldValue = atomic_or((int32*)&mutex->lock, B_USER_MUTEX_LOCKED);
 
-	if ((oldValue & (B_USER_MUTEX_LOCKED | B_USER_MUTEX_WAITING)) != 0) {
-		// someone else has the lock or is at least waiting for it
+	if ((oldValue & (B_USER_MUTEX_LOCKED | B_USER_MUTEX_WAITING))
+			== B_USER_MUTEX_LOCKED
+		&& timeout >= 0 && __gCPUCount > 1) {
+		// Only the owner holds the lock -- if it is running on another CPU,
+		// it might release it before entering the kernel would pay off. Spin
+		// for a while, but stop as soon as anyone starts to wait in the
+		// kernel, so that we don't overtake them.
+		for (int32 count = 0; count < MAX_UNSUCCESSFUL_SPINS; count++) {
+			int32 value = *(volatile int32*)&mutex->lock;
+			if ((value & B_USER_MUTEX_WAITING) != 0)
+				break;
+			if ((value & B_USER_MUTEX_LOCKED) != 0)
+				continue;
+
+			oldValue = atomic_or((int32*)&mutex->lock, B_USER_MUTEX_LOCKED);
+			if ((oldValue & (B_USER_MUTEX_LOCKED | B_USER_MUTEX_WAITING))
+					!= B_USER_MUTEX_LOCKED) {
+				break;
+			}
+		}
+	}
+
+	if ((oldValue & B_USER_MUTEX_LOCKED) != 0) {
+		// someone else has the lock
 		if (timeout < 0)
 			return EBUSY;
 
-		// we have to call the kernel
-		status_t error;
-		do {
-			error = _kern_mutex_lock((int32*)&mutex->lock, NULL,
-				timeout == B_INFINITE_TIMEOUT
-					? 0 : B_ABSOLUTE_REAL_TIME_TIMEOUT,
-				timeout);
-		} while (error == B_INTERRUPTED);
-
+		// we have to wait in the kernel
+		status_t error = mutex_lock_contended(mutex, timeout);
 		if (error != B_OK)
 			return error;
 	}
@@ -150,17 +206,68 @@ pthread_mutex_unlock(pthread_mutex_t* mutex)
 	}
 
 	mutex->owner = -1;
-
-	// clear the locked flag
-	int32 oldValue = atomic_and((int32*)&mutex->lock,
-		~(int32)B_USER_MUTEX_LOCKED);
-	if ((oldValue & B_USER_MUTEX_WAITING) != 0)
-		_kern_mutex_unlock((int32*)&mutex->lock, 0);
+	mutex_unlock(mutex);
 
 	return 0;
 }
 
 
+int32
+__pthread_mutex_unlock_for_wait(pthread_mutex_t* mutex)
+{
+	int32 ownerCount = mutex->owner_count;
+	mutex->owner = -1;
+	mutex->owner_count = 0;
+	mutex_unlock(mutex);
+
+	return ownerCount;
+}
+
+
+void
+__pthread_mutex_lock_after_wait(pthread_mutex_t* mutex, int32 ownerCount)
+{
+	// We might have been requeued to the mutex, so we have to pass the
+	// wake-up on to the others.
+	mutex_lock_contended(mutex, B_INFINITE_TIMEOUT);
+
+	mutex->owner = find_thread(NULL);
+	mutex->owner_count = ownerCount;
+}
+
+
+/*!	Locks a recursive mutex without any atomic operations. May only be used
+	while the team has a single thread, as there is nobody to contend with.
+	The mutex is left in the same state as by pthread_mutex_lock(), so that it
+	can be unlocked normally, if another thread has been spawned meanwhile.
+*/
+void
+__pthread_mutex_lock_single_threaded(pthread_mutex_t* mutex)
+{
+	thread_id thisThread = find_thread(NULL);
+	if (mutex->owner == thisThread) {
+		mutex->owner_count++;
+		return;
+	}
+
+	mutex->lock |= B_USER_MUTEX_LOCKED;
+	mutex->owner = thisThread;
+	mutex->owner_count = 1;
+}
+
+
+/*!	Counterpart of __pthread_mutex_lock_single_threaded(). */
+void
+__pthread_mutex_unlock_single_threaded(pthread_mutex_t* mutex)
+{
+	if (mutex->owner != find_thread(NULL) || --mutex->owner_count > 0)
+		return;
+
+	mutex->owner = -1;
+	mutex->lock &= ~B_USER_MUTEX_LOCKED;
+}
+
+
 int
 pthread_mutex_getprioceiling(pthread_mutex_t* mutex, int* _prioCeiling)
 {
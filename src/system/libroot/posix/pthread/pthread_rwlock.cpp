@@ -5,278 +5,149 @@
 
 #include <pthread.h>
 
-#include <new>
-
 #include <Debug.h>
 
-#include <AutoLocker.h>
-#include <libroot_lock.h>
 #include <syscalls.h>
-#include <user_thread.h>
-#include <util/DoublyLinkedList.h>
 
 #include "pthread_private.h"
 
 
-#define MAX_READER_COUNT	1000000
-
 #define RWLOCK_FLAG_SHARED	0x01
 
-
-struct Waiter : DoublyLinkedListLinkImpl<Waiter> {
-	Waiter(bool writer)
-		:
-		userThread(get_user_thread()),
-		thread(find_thread(NULL)),
-		writer(writer),
-		queued(false)
-	{
-	}
-
-	user_thread*	userThread;
-	thread_id		thread;
-	status_t		status;
-	bool			writer;
-	bool			queued;
-};
-
-typedef DoublyLinkedList<Waiter> WaiterList;
+#define RWLOCK_WRITE_LOCKED	-1
 
 
-struct SharedRWLock {
+/*!	A reader/writer lock that is entirely maintained in userland as long as
+	there is no contention. Waiting threads block on the sequence number,
+	which is changed whenever the lock is released, or a waiting writer gives
+	up. Since the kernel identifies the address by its physical location,
+	the same implementation serves process-shared locks as well.
+*/
+struct RWLock {
 	uint32_t	flags;
 	int32_t		owner;
-	int32_t		sem;
-
-	status_t Init()
+	int32		state;
+		// number of read lock owners, or RWLOCK_WRITE_LOCKED
+	int32		sequence;
+	int32		waiter_count;
+		// threads that are waiting or about to wait for sequence to change
+	int32		writer_count;
+		// waiting writers -- new readers wait as long as there are any
+
+	status_t Init(bool shared)
 	{
-		flags = RWLOCK_FLAG_SHARED;
+		flags = shared ? RWLOCK_FLAG_SHARED : 0;
 		owner = -1;
-		sem = create_sem(MAX_READER_COUNT, "pthread rwlock");
+		state = 0;
+		sequence = 0;
+		waiter_count = 0;
+		writer_count = 0;
 
-		return sem >= 0 ? B_OK : EAGAIN;
+		return B_OK;
 	}
 
 	status_t Destroy()
 	{
-		if (sem < 0)
-			return B_BAD_VALUE;
-		return delete_sem(sem) == B_OK ? B_OK : B_BAD_VALUE;
+		return state == 0 ? B_OK : B_BUSY;
 	}
 
 	status_t ReadLock(bigtime_t timeout)
 	{
-		return acquire_sem_etc(sem, 1,
-			timeout >= 0 ? B_ABSOLUTE_REAL_TIME_TIMEOUT : 0, timeout);
-	}
-
-	status_t WriteLock(bigtime_t timeout)
-	{
-		status_t error = acquire_sem_etc(sem, MAX_READER_COUNT,
-			timeout >= 0 ? B_ABSOLUTE_REAL_TIME_TIMEOUT : 0, timeout);
-		if (error == B_OK)
-			owner = find_thread(NULL);
-		return error;
-	}
-
-	status_t Unlock()
-	{
-		if (find_thread(NULL) == owner) {
-			owner = -1;
-			return release_sem_etc(sem, MAX_READER_COUNT, 0);
-		} else
-			return release_sem(sem);
-	}
-};
-
-
-struct LocalRWLock {
-	uint32_t	flags;
-	int32_t		owner;
-	int32_t		lock_sem;
-	int32_t		lock_count;
-	int32_t		reader_count;
-	int32_t		writer_count;
-		// Note, that reader_count and writer_count are not used the same way.
-		// writer_count includes the write lock owner as well as waiting
-		// writers. reader_count includes read lock owners only.
-	WaiterList	waiters;
-
-	status_t Init()
-	{
-		flags = 0;
-		owner = -1;
-		lock_sem = create_sem(0, "pthread rwlock");
-		lock_count = 1;
-		reader_count = 0;
-		writer_count = 0;
-		new(&waiters) WaiterList;
-
-		return lock_sem >= 0 ? B_OK : EAGAIN;
-	}
-
-	status_t Destroy()
-	{
-		if (lock_sem < 0)
-			return B_BAD_VALUE;
-		return delete_sem(lock_sem) == B_OK ? B_OK : B_BAD_VALUE;
-	}
+		while (true) {
+			int32 waitSequence = atomic_get(&sequence);
+			int32 value = atomic_get(&state);
+
+			if (value >= 0 && atomic_get(&writer_count) == 0) {
+				if (atomic_test_and_set(&state, value + 1, value) == value)
+					return B_OK;
+				continue;
+			}
 
-	bool StructureLock()
-	{
-		if (atomic_add((int32*)&lock_count, -1) <= 0)
-			acquire_sem(lock_sem);
-		return true;
+			status_t error = _Wait(waitSequence, timeout);
+			if (error != B_OK)
+				return error;
+		}
 	}
 
-	void StructureUnlock()
+	status_t WriteLock(bigtime_t timeout)
 	{
-		if (atomic_add((int32*)&lock_count, 1) < 0)
-			release_sem(lock_sem);
-	}
+		bool waiting = false;
 
-	status_t ReadLock(bigtime_t timeout)
-	{
-		Locker locker(this);
+		while (true) {
+			int32 waitSequence = atomic_get(&sequence);
 
-		if (writer_count == 0) {
-			reader_count++;
-			return B_OK;
-		}
+			if (atomic_test_and_set(&state, RWLOCK_WRITE_LOCKED, 0) == 0) {
+				if (waiting)
+					atomic_add(&writer_count, -1);
+				owner = find_thread(NULL);
+				return B_OK;
+			}
 
-		return _Wait(false, timeout);
-	}
+			if (timeout == 0)
+				return B_TIMED_OUT;
 
-	status_t WriteLock(bigtime_t timeout)
-	{
-		Locker locker(this);
+			if (!waiting) {
+				atomic_add(&writer_count, 1);
+				waiting = true;
+			}
 
-		if (reader_count == 0 && writer_count == 0) {
-			writer_count++;
-			owner = find_thread(NULL);
-			return B_OK;
+			status_t error = _Wait(waitSequence, timeout);
+			if (error != B_OK) {
+				// readers might only be waiting for us
+				atomic_add(&writer_count, -1);
+				_Wake();
+				return error;
+			}
 		}
-
-		return _Wait(true, timeout);
 	}
 
 	status_t Unlock()
 	{
-		Locker locker(this);
-
 		if (find_thread(NULL) == owner) {
-			writer_count--;
 			owner = -1;
-		} else
-			reader_count--;
-
-		_Unblock();
+			atomic_set(&state, 0);
+		} else if (atomic_add(&state, -1) > 1) {
+			// there are still other readers, no-one can get the lock yet
+			return B_OK;
+		}
 
+		_Wake();
 		return B_OK;
 	}
 
 private:
-	status_t _Wait(bool writer, bigtime_t timeout)
+	status_t _Wait(int32 waitSequence, bigtime_t timeout)
 	{
 		if (timeout == 0)
 			return B_TIMED_OUT;
 
-		Waiter waiter(writer);
-		waiters.Add(&waiter);
-		waiter.queued = true;
-		waiter.userThread->wait_status = 1;
-
-		if (writer)
-			writer_count++;
-
-		StructureUnlock();
-		status_t error = _kern_block_thread(
-			timeout >= 0 ? B_ABSOLUTE_REAL_TIME_TIMEOUT : 0, timeout);
-		StructureLock();
-
-		if (!waiter.queued)
-			return waiter.status;
-
-		// we're still queued, which means an error (timeout, interrupt)
-		// occurred
-		waiters.Remove(&waiter);
-
-		if (writer)
-			writer_count--;
-
-		_Unblock();
+		atomic_add(&waiter_count, 1);
+		status_t error = _kern_futex_wait(&sequence, waitSequence,
+			timeout == B_INFINITE_TIMEOUT ? 0 : B_ABSOLUTE_REAL_TIME_TIMEOUT,
+			timeout);
+		atomic_add(&waiter_count, -1);
 
+		// the lock has been released, or is about to be -- check again
+		if (error == B_WOULD_BLOCK || error == B_INTERRUPTED)
+			return B_OK;
 		return error;
 	}
 
-	void _Unblock()
+	void _Wake()
 	{
-		// Check whether there any waiting threads at all and whether anyone
-		// has the write lock
-		Waiter* waiter = waiters.Head();
-		if (waiter == NULL || owner >= 0)
-			return;
-
-		// writer at head of queue?
-		if (waiter->writer) {
-			if (reader_count == 0) {
-				waiter->status = B_OK;
-				waiter->queued = false;
-				waiters.Remove(waiter);
-				owner = waiter->thread;
-
-				if (waiter->userThread->wait_status > 0)
-					_kern_unblock_thread(waiter->thread, B_OK);
-			}
-			return;
-		}
-
-		// wake up one or more readers -- we unblock more than one reader at
-		// a time to save trips to the kernel
-		while (!waiters.IsEmpty() && !waiters.Head()->writer) {
-			static const int kMaxReaderUnblockCount = 128;
-			thread_id readers[kMaxReaderUnblockCount];
-			int readerCount = 0;
-
-			while (readerCount < kMaxReaderUnblockCount
-					&& (waiter = waiters.Head()) != NULL
-					&& !waiter->writer) {
-				waiter->status = B_OK;
-				waiter->queued = false;
-				waiters.Remove(waiter);
-
-				if (waiter->userThread->wait_status > 0) {
-					readers[readerCount++] = waiter->thread;
-					reader_count++;
-				}
-			}
-
-			if (readerCount > 0)
-				_kern_unblock_threads(readers, readerCount, B_OK);
-		}
+		// A thread that has not yet started to wait will notice the change
+		// of the sequence number, so we only need to wake up the others.
+		atomic_add(&sequence, 1);
+		if (atomic_get(&waiter_count) > 0)
+			_kern_futex_wake(&sequence, INT32_MAX);
 	}
-
-
-	struct Locking {
-		inline bool Lock(LocalRWLock* lockable)
-		{
-			return lockable->StructureLock();
-		}
-
-		inline void Unlock(LocalRWLock* lockable)
-		{
-			lockable->StructureUnlock();
-		}
-	};
-	typedef AutoLocker<LocalRWLock, Locking> Locker;
 };
 
 
 static void inline
 assert_dummy()
 {
-	STATIC_ASSERT(sizeof(pthread_rwlock_t) >= sizeof(SharedRWLock));
-	STATIC_ASSERT(sizeof(pthread_rwlock_t) >= sizeof(LocalRWLock));
+	STATIC_ASSERT(sizeof(pthread_rwlock_t) >= sizeof(RWLock));
 }
 
 
@@ -289,42 +160,28 @@ pthread_rwlock_init(pthread_rwlock_t* lock, const pthread_rwlockattr_t* _attr)
 	pthread_rwlockattr* attr = _attr != NULL ? *_attr : NULL;
 	bool shared = attr != NULL && (attr->flags & RWLOCK_FLAG_SHARED) != 0;
 
-	if (shared)
-		return ((SharedRWLock*)lock)->Init();
-	else
-		return ((LocalRWLock*)lock)->Init();
+	return ((RWLock*)lock)->Init(shared);
 }
 
 
 int
 pthread_rwlock_destroy(pthread_rwlock_t* lock)
 {
-	if ((lock->flags & RWLOCK_FLAG_SHARED) != 0)
-		return ((SharedRWLock*)lock)->Destroy();
-	else
-		return ((LocalRWLock*)lock)->Destroy();
+	return ((RWLock*)lock)->Destroy();
 }
 
 
 int
 pthread_rwlock_rdlock(pthread_rwlock_t* lock)
 {
-	if ((lock->flags & RWLOCK_FLAG_SHARED) != 0)
-		return ((SharedRWLock*)lock)->ReadLock(B_INFINITE_TIMEOUT);
-	else
-		return ((LocalRWLock*)lock)->ReadLock(B_INFINITE_TIMEOUT);
+	return ((RWLock*)lock)->ReadLock(B_INFINITE_TIMEOUT);
 }
 
 
 int
 pthread_rwlock_tryrdlock(pthread_rwlock_t* lock)
 {
-	status_t error;
-	if ((lock->flags & RWLOCK_FLAG_SHARED) != 0)
-		error = ((SharedRWLock*)lock)->ReadLock(0);
-	else
-		error = ((LocalRWLock*)lock)->ReadLock(0);
-
+	status_t error = ((RWLock*)lock)->ReadLock(0);
 	return error == B_TIMED_OUT ? EBUSY : error;
 }
 
@@ -335,12 +192,7 @@ int pthread_rwlock_timedrdlock(pthread_rwlock_t* lock,
 	bigtime_t timeoutMicros = timeout->tv_sec * 1000000LL
 		+ timeout->tv_nsec / 1000LL;
 
-	status_t error;
-	if ((lock->flags & RWLOCK_FLAG_SHARED) != 0)
-		error = ((SharedRWLock*)lock)->ReadLock(timeoutMicros);
-	else
-		error = ((LocalRWLock*)lock)->ReadLock(timeoutMicros);
-
+	status_t error = ((RWLock*)lock)->ReadLock(timeoutMicros);
 	return error == B_TIMED_OUT ? EBUSY : error;
 }
 
@@ -348,22 +200,14 @@ int pthread_rwlock_timedrdlock(pthread_rwlock_t* lock,
 int
 pthread_rwlock_wrlock(pthread_rwlock_t* lock)
 {
-	if ((lock->flags & RWLOCK_FLAG_SHARED) != 0)
-		return ((SharedRWLock*)lock)->WriteLock(B_INFINITE_TIMEOUT);
-	else
-		return ((LocalRWLock*)lock)->WriteLock(B_INFINITE_TIMEOUT);
+	return ((RWLock*)lock)->WriteLock(B_INFINITE_TIMEOUT);
 }
 
 
 int
 pthread_rwlock_trywrlock(pthread_rwlock_t* lock)
 {
-	status_t error;
-	if ((lock->flags & RWLOCK_FLAG_SHARED) != 0)
-		error = ((SharedRWLock*)lock)->WriteLock(0);
-	else
-		error = ((LocalRWLock*)lock)->WriteLock(0);
-
+	status_t error = ((RWLock*)lock)->WriteLock(0);
 	return error == B_TIMED_OUT ? EBUSY : error;
 }
 
@@ -375,12 +219,7 @@ pthread_rwlock_timedwrlock(pthread_rwlock_t* lock,
 	bigtime_t timeoutMicros = timeout->tv_sec * 1000000LL
 		+ timeout->tv_nsec / 1000LL;
 
-	status_t error;
-	if ((lock->flags & RWLOCK_FLAG_SHARED) != 0)
-		error = ((SharedRWLock*)lock)->WriteLock(timeoutMicros);
-	else
-		error = ((LocalRWLock*)lock)->WriteLock(timeoutMicros);
-
+	status_t error = ((RWLock*)lock)->WriteLock(timeoutMicros);
 	return error == B_TIMED_OUT ? EBUSY : error;
 }
 
@@ -388,10 +227,7 @@ pthread_rwlock_timedwrlock(pthread_rwlock_t* lock,
 int
 pthread_rwlock_unlock(pthread_rwlock_t* lock)
 {
-	if ((lock->flags & RWLOCK_FLAG_SHARED) != 0)
-		return ((SharedRWLock*)lock)->Unlock();
-	else
-		return ((LocalRWLock*)lock)->Unlock();
+	return ((RWLock*)lock)->Unlock();
 }
 
 
@@ -18,7 +18,6 @@
 #include <posix/realtime_sem_defs.h>
 #include <syscall_utils.h>
 #include <syscalls.h>
-#include <user_mutex_defs.h>
 
 
 #define SEM_TYPE_NAMED		1
@@ -115,6 +114,8 @@ sem_init(sem_t* semaphore, int shared, unsigned value)
 {
 	semaphore->type = SEM_TYPE_UNNAMED;
 	semaphore->u.unnamed_sem = value;
+	semaphore->padding[0] = 0;
+		// the number of waiters
 	return 0;
 }
 
@@ -129,14 +130,40 @@ sem_destroy(sem_t* semaphore)
 }
 
 
+/*!	The value of an unnamed semaphore is -1 while it is 0 and threads might
+	be waiting for it, so that sem_post() knows it has to wake one up. Since
+	a woken waiter cannot tell whether others are still waiting, waiters
+	are also counted, and sem_post() wakes one as long as there are any,
+	even if the value is positive. Otherwise a post that finds the value
+	already raised by a concurrent post would not wake anyone.
+*/
+static int32*
+unnamed_sem_waiters(sem_t* semaphore)
+{
+	return (int32*)&semaphore->padding[0];
+}
+
+
 static int
 unnamed_sem_post(sem_t* semaphore) {
 	int32* sem = (int32*)&semaphore->u.unnamed_sem;
-	int32 oldValue = atomic_add_if_greater(sem, 1, -1);
-	if (oldValue > -1)
-		return 0;
+	int32* waiters = unnamed_sem_waiters(semaphore);
+
+	int32 oldValue = atomic_get(sem);
+	int32 waiterCount;
+	while (true) {
+		waiterCount = atomic_get(waiters);
+		int32 value = atomic_test_and_set(sem,
+			oldValue < 0 ? 1 : oldValue + 1, oldValue);
+		if (value == oldValue)
+			break;
+		oldValue = value;
+	}
 
-	return _kern_mutex_sem_release(sem);
+	if (oldValue < 0 || waiterCount > 0)
+		_kern_futex_wake(sem, 1);
+
+	return 0;
 }
 
 
@@ -154,6 +181,7 @@ unnamed_sem_trywait(sem_t* semaphore) {
 static int
 unnamed_sem_timedwait(sem_t* semaphore, const struct timespec* timeout) {
 	int32* sem = (int32*)&semaphore->u.unnamed_sem;
+	int32* waiters = unnamed_sem_waiters(semaphore);
 
 	bigtime_t timeoutMicros = B_INFINITE_TIMEOUT;
 	if (timeout != NULL) {
@@ -165,9 +193,29 @@ unnamed_sem_timedwait(sem_t* semaphore, const struct timespec* timeout) {
 	if (result == 0)
 		return 0;
 
-	return _kern_mutex_sem_acquire(sem,	NULL,
-		timeoutMicros == B_INFINITE_TIMEOUT ? 0 : B_ABSOLUTE_REAL_TIME_TIMEOUT,
-		timeoutMicros);
+	atomic_add(waiters, 1);
+
+	while (true) {
+		// mark the semaphore contended, unless it has become available
+		atomic_test_and_set(sem, -1, 0);
+
+		status_t error = _kern_futex_wait(sem, -1,
+			timeoutMicros == B_INFINITE_TIMEOUT
+				? 0 : B_ABSOLUTE_REAL_TIME_TIMEOUT,
+			timeoutMicros);
+
+		result = unnamed_sem_trywait(semaphore);
+		if (result == 0)
+			break;
+
+		if (error != B_OK && error != B_WOULD_BLOCK) {
+			result = error;
+			break;
+		}
+	}
+
+	atomic_add(waiters, -1);
+	return result;
 }
 
 
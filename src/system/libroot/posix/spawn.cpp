@@ -0,0 +1,443 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <spawn.h>
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libroot_private.h>
+#include <spawn_defs.h>
+#include <syscalls.h>
+#include <umask.h>
+
+
+#define VALID_SPAWN_FLAGS	(POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP \
+	| POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSID)
+
+
+struct _posix_spawnattr {
+	short		flags;
+	pid_t		process_group;
+	sigset_t	signal_mask;
+	sigset_t	default_signals;
+};
+
+struct _posix_spawn_file_actions {
+	int32				count;
+	int32				capacity;
+	spawn_file_action*	actions;
+};
+
+
+static status_t
+add_file_action(posix_spawn_file_actions_t* _fileActions, uint32 type, int fd,
+	spawn_file_action*& _action)
+{
+	_posix_spawn_file_actions* fileActions;
+	if (_fileActions == NULL || (fileActions = *_fileActions) == NULL
+		|| fd < 0) {
+		return B_BAD_VALUE;
+	}
+
+	if (fileActions->count == fileActions->capacity) {
+		int32 capacity = fileActions->capacity == 0
+			? 4 : fileActions->capacity * 2;
+		if (capacity > B_SPAWN_MAX_FILE_ACTIONS)
+			return B_NO_MEMORY;
+
+		spawn_file_action* actions = (spawn_file_action*)realloc(
+			fileActions->actions, capacity * sizeof(spawn_file_action));
+		if (actions == NULL)
+			return B_NO_MEMORY;
+
+		fileActions->actions = actions;
+		fileActions->capacity = capacity;
+	}
+
+	spawn_file_action* action = &fileActions->actions[fileActions->count++];
+	memset(action, 0, sizeof(spawn_file_action));
+	action->type = type;
+	action->fd = fd;
+
+	_action = action;
+	return B_OK;
+}
+
+
+static int
+do_posix_spawn(pid_t* _pid, const char* path,
+	const posix_spawn_file_actions_t* _fileActions,
+	const posix_spawnattr_t* _attributes, char* const argv[],
+	char* const environment[], bool useDefaultInterpreter)
+{
+	if (path == NULL || argv == NULL || argv[0] == NULL
+		|| environment == NULL) {
+		return B_BAD_VALUE;
+	}
+
+	spawn_attributes attributes;
+	memset(&attributes, 0, sizeof(attributes));
+	attributes.umask = __gUmask;
+
+	if (_attributes != NULL && *_attributes != NULL) {
+		const _posix_spawnattr* spawnAttributes = *_attributes;
+		attributes.flags = spawnAttributes->flags;
+		attributes.process_group = spawnAttributes->process_group;
+		attributes.signal_mask = spawnAttributes->signal_mask;
+		attributes.default_signals = spawnAttributes->default_signals;
+	}
+
+	// the child inherits our signal mask, unless told otherwise
+	if ((attributes.flags & POSIX_SPAWN_SETSIGMASK) == 0)
+		sigprocmask(SIG_BLOCK, NULL, &attributes.signal_mask);
+
+	if (_fileActions != NULL && *_fileActions != NULL) {
+		attributes.file_action_count = (*_fileActions)->count;
+		attributes.file_actions = (*_fileActions)->actions;
+	}
+
+	int32 argCount = 0;
+	while (argv[argCount] != NULL)
+		argCount++;
+
+	int32 envCount = 0;
+	while (environment[envCount] != NULL)
+		envCount++;
+
+	// test validity of executable + support for scripts
+	char invoker[B_FILE_NAME_LENGTH];
+	status_t status = __test_executable(path, invoker);
+	if (status < B_OK) {
+		if (status != B_NOT_AN_EXECUTABLE || !useDefaultInterpreter)
+			return status;
+
+		strcpy(invoker, "/bin/sh");
+	}
+
+	char** newArgs = NULL;
+	if (invoker[0] != '\0') {
+		status = __parse_invoke_line(invoker, &newArgs, &argv, &argCount,
+			path);
+		if (status < B_OK)
+			return status;
+
+		path = newArgs[0];
+	}
+
+	char** flatArgs = NULL;
+	size_t flatArgsSize;
+	status = __flatten_process_args(argv, argCount, environment, &envCount,
+		path, &flatArgs, &flatArgsSize);
+
+	if (status == B_OK) {
+		thread_id thread = _kern_spawn(path, flatArgs, flatArgsSize, argCount,
+			envCount, &attributes);
+		if (thread >= 0) {
+			if (_pid != NULL)
+				*_pid = thread;
+		} else
+			status = thread;
+
+		free(flatArgs);
+	}
+
+	free(newArgs);
+	return status;
+}
+
+
+int
+posix_spawn(pid_t* pid, const char* path,
+	const posix_spawn_file_actions_t* fileActions,
+	const posix_spawnattr_t* attributes, char* const argv[],
+	char* const environment[])
+{
+	return do_posix_spawn(pid, path, fileActions, attributes, argv,
+		environment, false);
+}
+
+
+int
+posix_spawnp(pid_t* pid, const char* file,
+	const posix_spawn_file_actions_t* fileActions,
+	const posix_spawnattr_t* attributes, char* const argv[],
+	char* const environment[])
+{
+	// let do_posix_spawn() handle cases where file is a path (or invalid)
+	if (file == NULL || strchr(file, '/') != NULL) {
+		return do_posix_spawn(pid, file, fileActions, attributes, argv,
+			environment, true);
+	}
+
+	// file is just a leaf name, so we have to look it up in the path
+	const char* paths = getenv("PATH");
+	if (paths == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	int fileNameLength = strlen(file);
+
+	// iterate through the paths
+	const char* pathEnd = paths - 1;
+	while (pathEnd != NULL) {
+		paths = pathEnd + 1;
+		pathEnd = strchr(paths, ':');
+		int pathLength = pathEnd != NULL ? pathEnd - paths : strlen(paths);
+
+		// We skip empty paths and those that would become too long.
+		if (pathLength == 0
+			|| pathLength + 1 + fileNameLength >= B_PATH_NAME_LENGTH) {
+			continue;
+		}
+
+		char path[B_PATH_NAME_LENGTH];
+		memcpy(path, paths, pathLength);
+		path[pathLength] = '\0';
+
+		if (path[pathLength - 1] != '/')
+			strcat(path, "/");
+		strcat(path, file);
+
+		struct stat st;
+		if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)
+			|| access(path, X_OK) != 0) {
+			continue;
+		}
+
+		return do_posix_spawn(pid, path, fileActions, attributes, argv,
+			environment, true);
+	}
+
+	return B_ENTRY_NOT_FOUND;
+}
+
+
+// #pragma mark - file actions
+
+
+int
+posix_spawn_file_actions_init(posix_spawn_file_actions_t* _fileActions)
+{
+	if (_fileActions == NULL)
+		return B_BAD_VALUE;
+
+	_posix_spawn_file_actions* fileActions
+		= (_posix_spawn_file_actions*)malloc(
+			sizeof(_posix_spawn_file_actions));
+	if (fileActions == NULL)
+		return B_NO_MEMORY;
+
+	fileActions->count = 0;
+	fileActions->capacity = 0;
+	fileActions->actions = NULL;
+
+	*_fileActions = fileActions;
+	return B_OK;
+}
+
+
+int
+posix_spawn_file_actions_destroy(posix_spawn_file_actions_t* _fileActions)
+{
+	_posix_spawn_file_actions* fileActions;
+	if (_fileActions == NULL || (fileActions = *_fileActions) == NULL)
+		return B_BAD_VALUE;
+
+	for (int32 i = 0; i < fileActions->count; i++)
+		free(fileActions->actions[i].path);
+
+	free(fileActions->actions);
+	free(fileActions);
+	*_fileActions = NULL;
+
+	return B_OK;
+}
+
+
+int
+posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* fileActions,
+	int fd, const char* path, int openFlags, mode_t mode)
+{
+	if (path == NULL)
+		return B_BAD_VALUE;
+
+	char* pathCopy = strdup(path);
+	if (pathCopy == NULL)
+		return B_NO_MEMORY;
+
+	spawn_file_action* action;
+	status_t status = add_file_action(fileActions, B_SPAWN_FILE_ACTION_OPEN,
+		fd, action);
+	if (status != B_OK) {
+		free(pathCopy);
+		return status;
+	}
+
+	action->open_flags = openFlags;
+	action->open_mode = mode;
+	action->path = pathCopy;
+
+	return B_OK;
+}
+
+
+int
+posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* fileActions,
+	int fd)
+{
+	spawn_file_action* action;
+	return add_file_action(fileActions, B_SPAWN_FILE_ACTION_CLOSE, fd, action);
+}
+
+
+int
+posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* fileActions,
+	int fd, int newFD)
+{
+	if (fd < 0)
+		return B_BAD_VALUE;
+
+	spawn_file_action* action;
+	status_t status = add_file_action(fileActions, B_SPAWN_FILE_ACTION_DUP2,
+		newFD, action);
+	if (status != B_OK)
+		return status;
+
+	action->source_fd = fd;
+	return B_OK;
+}
+
+
+// #pragma mark - spawn attributes
+
+
+int
+posix_spawnattr_init(posix_spawnattr_t* _attributes)
+{
+	if (_attributes == NULL)
+		return B_BAD_VALUE;
+
+	_posix_spawnattr* attributes
+		= (_posix_spawnattr*)malloc(sizeof(_posix_spawnattr));
+	if (attributes == NULL)
+		return B_NO_MEMORY;
+
+	memset(attributes, 0, sizeof(_posix_spawnattr));
+	*_attributes = attributes;
+
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_destroy(posix_spawnattr_t* _attributes)
+{
+	if (_attributes == NULL || *_attributes == NULL)
+		return B_BAD_VALUE;
+
+	free(*_attributes);
+	*_attributes = NULL;
+
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_getflags(const posix_spawnattr_t* attributes, short* flags)
+{
+	if (attributes == NULL || *attributes == NULL || flags == NULL)
+		return B_BAD_VALUE;
+
+	*flags = (*attributes)->flags;
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_setflags(posix_spawnattr_t* attributes, short flags)
+{
+	if (attributes == NULL || *attributes == NULL
+		|| (flags & ~VALID_SPAWN_FLAGS) != 0) {
+		return B_BAD_VALUE;
+	}
+
+	(*attributes)->flags = flags;
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_getpgroup(const posix_spawnattr_t* attributes,
+	pid_t* processGroup)
+{
+	if (attributes == NULL || *attributes == NULL || processGroup == NULL)
+		return B_BAD_VALUE;
+
+	*processGroup = (*attributes)->process_group;
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_setpgroup(posix_spawnattr_t* attributes, pid_t processGroup)
+{
+	if (attributes == NULL || *attributes == NULL || processGroup < 0)
+		return B_BAD_VALUE;
+
+	(*attributes)->process_group = processGroup;
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_getsigdefault(const posix_spawnattr_t* attributes,
+	sigset_t* signals)
+{
+	if (attributes == NULL || *attributes == NULL || signals == NULL)
+		return B_BAD_VALUE;
+
+	*signals = (*attributes)->default_signals;
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_setsigdefault(posix_spawnattr_t* attributes,
+	const sigset_t* signals)
+{
+	if (attributes == NULL || *attributes == NULL || signals == NULL)
+		return B_BAD_VALUE;
+
+	(*attributes)->default_signals = *signals;
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_getsigmask(const posix_spawnattr_t* attributes,
+	sigset_t* signals)
+{
+	if (attributes == NULL || *attributes == NULL || signals == NULL)
+		return B_BAD_VALUE;
+
+	*signals = (*attributes)->signal_mask;
+	return B_OK;
+}
+
+
+int
+posix_spawnattr_setsigmask(posix_spawnattr_t* attributes,
+	const sigset_t* signals)
+{
+	if (attributes == NULL || *attributes == NULL || signals == NULL)
+		return B_BAD_VALUE;
+
+	(*attributes)->signal_mask = *signals;
+	return B_OK;
+}
@@ -0,0 +1,317 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	SSE2 versions of the string functions that show up in the profiles of
+	text processing tools. SSE2 is part of the x86_64 baseline, so they can
+	be used unconditionally.
+
+	Functions that don't know the length of their input up front only ever
+	load aligned 16 byte blocks: such a block never crosses a page boundary,
+	so if one of its bytes belongs to the string, the whole block can be read.
+	Bytes in front of the string are masked out. strcmp() is the exception,
+	as its arguments are usually not aligned to each other; it switches to
+	comparing single bytes when a load would cross a page boundary.
+*/
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <x86intrin.h>
+
+#include <OS.h>
+
+
+namespace {
+
+
+static inline const __m128i*
+aligned_block(const void* address)
+{
+	return reinterpret_cast<const __m128i*>(
+		reinterpret_cast<uintptr_t>(address) & ~uintptr_t(15));
+}
+
+
+static inline unsigned
+block_offset(const void* address)
+{
+	return reinterpret_cast<uintptr_t>(address) % 16;
+}
+
+
+static inline unsigned
+match_mask(__m128i data, __m128i needle)
+{
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(data, needle));
+}
+
+
+static inline unsigned
+zero_mask(__m128i data)
+{
+	return match_mask(data, _mm_setzero_si128());
+}
+
+
+static inline bool
+load_crosses_page(const void* address)
+{
+	return reinterpret_cast<uintptr_t>(address) % B_PAGE_SIZE
+		> B_PAGE_SIZE - 16;
+}
+
+
+/*!	Returns the index of the first byte equal to \a needle within the first
+	\a length bytes of \a buffer, or \a length if there is none.
+*/
+static inline size_t
+find_byte(const void* buffer, __m128i needle, size_t length)
+{
+	if (length == 0)
+		return 0;
+
+	auto block = aligned_block(buffer);
+	unsigned offset = block_offset(buffer);
+
+	unsigned mask = match_mask(_mm_load_si128(block), needle) >> offset;
+	size_t position = 16 - offset;
+	if (mask != 0) {
+		size_t index = __builtin_ctz(mask);
+		return index < length ? index : length;
+	}
+
+	while (position < length) {
+		mask = match_mask(_mm_load_si128(++block), needle);
+		if (mask != 0) {
+			size_t index = position + __builtin_ctz(mask);
+			return index < length ? index : length;
+		}
+		position += 16;
+	}
+
+	return length;
+}
+
+
+}
+
+
+extern "C" size_t
+strlen(const char* string)
+{
+	auto block = aligned_block(string);
+	unsigned mask = zero_mask(_mm_load_si128(block)) >> block_offset(string);
+	if (mask != 0)
+		return __builtin_ctz(mask);
+
+	// check single blocks up to the next 64 byte boundary, then four blocks
+	// at a time
+	while (reinterpret_cast<uintptr_t>(++block) % 64 != 0) {
+		mask = zero_mask(_mm_load_si128(block));
+		if (mask != 0) {
+			return reinterpret_cast<const char*>(block) + __builtin_ctz(mask)
+				- string;
+		}
+	}
+
+	while (true) {
+		__m128i minimum = _mm_min_epu8(
+			_mm_min_epu8(_mm_load_si128(block), _mm_load_si128(block + 1)),
+			_mm_min_epu8(_mm_load_si128(block + 2), _mm_load_si128(block + 3)));
+		if (zero_mask(minimum) != 0)
+			break;
+		block += 4;
+	}
+
+	while (true) {
+		mask = zero_mask(_mm_load_si128(block));
+		if (mask != 0) {
+			return reinterpret_cast<const char*>(block) + __builtin_ctz(mask)
+				- string;
+		}
+		block++;
+	}
+}
+
+
+extern "C" size_t
+strnlen(const char* string, size_t count)
+{
+	return find_byte(string, _mm_setzero_si128(), count);
+}
+
+
+extern "C" void*
+memchr(const void* buffer, int c, size_t length)
+{
+	size_t index = find_byte(buffer,
+		_mm_set1_epi8(static_cast<char>(c)), length);
+	if (index == length)
+		return NULL;
+
+	return const_cast<uint8_t*>(static_cast<const uint8_t*>(buffer) + index);
+}
+
+
+extern "C" char*
+strchrnul(const char* string, int c)
+{
+	__m128i needle = _mm_set1_epi8(static_cast<char>(c));
+	auto block = aligned_block(string);
+
+	__m128i data = _mm_load_si128(block);
+	unsigned mask = (match_mask(data, needle) | zero_mask(data))
+		>> block_offset(string);
+	if (mask != 0)
+		return const_cast<char*>(string) + __builtin_ctz(mask);
+
+	while (true) {
+		data = _mm_load_si128(++block);
+		mask = match_mask(data, needle) | zero_mask(data);
+		if (mask != 0) {
+			return reinterpret_cast<char*>(const_cast<__m128i*>(block))
+				+ __builtin_ctz(mask);
+		}
+	}
+}
+
+
+extern "C" char*
+strchr(const char* string, int c)
+{
+	char* position = strchrnul(string, c);
+	return *position == static_cast<char>(c) ? position : NULL;
+}
+
+
+extern "C" char*
+index(const char* string, int c)
+{
+	return strchr(string, c);
+}
+
+
+extern "C" char*
+strrchr(const char* string, int c)
+{
+	if (static_cast<char>(c) == '\0')
+		return const_cast<char*>(string) + strlen(string);
+
+	__m128i needle = _mm_set1_epi8(static_cast<char>(c));
+	auto block = aligned_block(string);
+	unsigned valid = ~0u << block_offset(string);
+	const char* last = NULL;
+
+	while (true) {
+		__m128i data = _mm_load_si128(block);
+		unsigned zeros = zero_mask(data) & valid;
+		unsigned matches = match_mask(data, needle) & valid;
+		if (zeros != 0) {
+			// ignore everything behind the terminating null
+			matches &= (zeros & -zeros) - 1;
+		}
+		if (matches != 0) {
+			last = reinterpret_cast<const char*>(block) + 31
+				- __builtin_clz(matches);
+		}
+		if (zeros != 0)
+			return const_cast<char*>(last);
+
+		valid = ~0u;
+		block++;
+	}
+}
+
+
+extern "C" char*
+rindex(const char* string, int c)
+{
+	return strrchr(string, c);
+}
+
+
+extern "C" int
+memcmp(const void* _a, const void* _b, size_t length)
+{
+	auto a = static_cast<const uint8_t*>(_a);
+	auto b = static_cast<const uint8_t*>(_b);
+
+	if (length >= 16) {
+		auto aEnd = a + length - 16;
+		auto bEnd = b + length - 16;
+		while (true) {
+			unsigned mask = match_mask(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+			if (mask != 0xffff) {
+				unsigned index = __builtin_ctz(~mask);
+				return a[index] - b[index];
+			}
+			if (a == aEnd)
+				return 0;
+
+			length -= 16;
+			if (length < 16) {
+				// the last block overlaps with the previous one
+				a = aEnd;
+				b = bEnd;
+			} else {
+				a += 16;
+				b += 16;
+			}
+		}
+	}
+
+	if (length >= 8) {
+		uint64_t x = *reinterpret_cast<const uint64_t*>(a);
+		uint64_t y = *reinterpret_cast<const uint64_t*>(b);
+		if (x == y) {
+			x = *reinterpret_cast<const uint64_t*>(a + length - 8);
+			y = *reinterpret_cast<const uint64_t*>(b + length - 8);
+			if (x == y)
+				return 0;
+		}
+		return __builtin_bswap64(x) < __builtin_bswap64(y) ? -1 : 1;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		int cmp = a[i] - b[i];
+		if (cmp != 0)
+			return cmp;
+	}
+
+	return 0;
+}
+
+
+extern "C" int
+strcmp(const char* _a, const char* _b)
+{
+	auto a = reinterpret_cast<const uint8_t*>(_a);
+	auto b = reinterpret_cast<const uint8_t*>(_b);
+
+	while (true) {
+		if (load_crosses_page(a) || load_crosses_page(b)) {
+			int cmp = *a - *b;
+			if (cmp != 0 || *a == '\0')
+				return cmp;
+			a++;
+			b++;
+			continue;
+		}
+
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+		__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+		unsigned mask = (match_mask(x, y) ^ 0xffff) | zero_mask(x);
+		if (mask != 0) {
+			unsigned index = __builtin_ctz(mask);
+			return a[index] - b[index];
+		}
+		a += 16;
+		b += 16;
+	}
+}
@@ -100,30 +100,9 @@ __sysconf(int name)
 		case _SC_IOV_MAX:
 			return IOV_MAX;
 		case _SC_NPROCESSORS_CONF:
-		{
-			system_info info;
-			err = get_system_info(&info);
-			if (err < B_OK) {
-				__set_errno(err);
-				return -1;
-			}
-			return info.cpu_count;
-		}
+			return __get_cpu_count(false);
 		case _SC_NPROCESSORS_ONLN:
-		{
-			system_info info;
-			unsigned int i;
-			int count = 0;
-			err = get_system_info(&info);
-			if (err < B_OK) {
-				__set_errno(err);
-				return -1;
-			}
-			for (i = 0; i < info.cpu_count; i++)
-				if (_kern_cpu_enabled(i))
-					count++;
-			return count;
-		}
+			return __get_cpu_count(true);
 		case _SC_ATEXIT_MAX:
 			return ATEXIT_MAX;
 		case _SC_PASS_MAX:
@@ -156,6 +156,7 @@ fork(void)
 			// calling the kernel.
 		__gRuntimeLoader->reinit_after_fork();
 		__reinit_pwd_backend_after_fork();
+		__heap_after_fork_child();
 
 		call_fork_hooks(sChildHooks);
 	} else {
@@ -171,6 +172,24 @@ fork(void)
 pid_t
 vfork(void)
 {
-	return fork();
+	// Unlike fork(), this doesn't call the fork hooks: the child may only
+	// exec*() or _exit(), and the kernel won't let us continue before it did.
+	// The allocator has to be prepared, though, as exec*() uses malloc().
+	thread_id thread = _kern_vfork();
+	if (thread < 0) {
+		__set_errno(thread);
+		return -1;
+	}
+
+	if (thread == 0) {
+		// we are the child
+		__main_thread_id = find_thread(NULL);
+		pthread_self()->id = __main_thread_id;
+
+		__gRuntimeLoader->reinit_after_fork();
+		__heap_after_fork_child();
+	}
+
+	return thread;
 }
 
@@ -779,6 +779,7 @@ void __gconv_transform_wchar_multibyte() {}
 void __gen_tempname() {}
 void __get_architecture() {}
 void __get_architectures() {}
+void __get_cpu_count() {}
 void __get_cpu_info() {}
 void __get_cpu_topology_info() {}
 void __get_current_time_locale() {}
@@ -891,6 +892,7 @@ void __ieee754_ynl() {}
 void __ilogb() {}
 void __ilogbf() {}
 void __ilogbl() {}
+void __init_cpu_data() {}
 void __init_env() {}
 void __init_heap() {}
 void __init_heap_post_env() {}
@@ -1035,6 +1037,14 @@ void __nrand48_r() {}
 void __overflow() {}
 void __parse_invoke_line() {}
 void __path_search() {}
+void __per_cpu_counter_add() {}
+void __per_cpu_counter_destroy() {}
+void __per_cpu_counter_init() {}
+void __per_cpu_counter_sum() {}
+void __per_cpu_list_destroy() {}
+void __per_cpu_list_init() {}
+void __per_cpu_list_pop() {}
+void __per_cpu_list_push() {}
 void __pow() {}
 void __pow10() {}
 void __pow10f() {}
@@ -1050,6 +1060,8 @@ void __pthread_cleanup_push_handler() {}
 void __pthread_destroy_thread() {}
 void __pthread_init_creation_attributes() {}
 void __pthread_key_call_destructors() {}
+void __pthread_mutex_lock_single_threaded() {}
+void __pthread_mutex_unlock_single_threaded() {}
 void __pthread_sigmask() {}
 void __pthread_sigmask_beos() {}
 void __random_r() {}
@@ -1335,6 +1347,9 @@ void _kern_dup() {}
 void _kern_dup2() {}
 void _kern_entry_ref_to_path() {}
 void _kern_estimate_max_scheduling_latency() {}
+void _kern_event_queue_create() {}
+void _kern_event_queue_select() {}
+void _kern_event_queue_wait() {}
 void _kern_exec() {}
 void _kern_exit_team() {}
 void _kern_exit_thread() {}
@@ -1350,6 +1365,9 @@ void _kern_flock() {}
 void _kern_fork() {}
 void _kern_frame_buffer_update() {}
 void _kern_fsync() {}
+void _kern_futex_requeue() {}
+void _kern_futex_wait() {}
+void _kern_futex_wake() {}
 void _kern_generic_syscall() {}
 void _kern_get_area_info() {}
 void _kern_get_clock() {}
@@ -1399,6 +1417,8 @@ void _kern_image_relocated() {}
 void _kern_initialize_partition() {}
 void _kern_install_default_debugger() {}
 void _kern_install_team_debugger() {}
+void _kern_io_ring_create() {}
+void _kern_io_ring_enter() {}
 void _kern_ioctl() {}
 void _kern_is_computer_on() {}
 void _kern_kernel_debugger() {}
@@ -1438,6 +1458,7 @@ void _kern_read_fs_info() {}
 void _kern_read_index_stat() {}
 void _kern_read_kernel_image_symbols() {}
 void _kern_read_link() {}
+void _kern_read_port_batch() {}
 void _kern_read_port_etc() {}
 void _kern_read_stat() {}
 void _kern_readv() {}
@@ -1454,6 +1475,7 @@ void _kern_recvmsg() {}
 void _kern_register_file_device() {}
 void _kern_register_image() {}
 void _kern_register_messaging_service() {}
+void _kern_register_rseq() {}
 void _kern_release_sem() {}
 void _kern_release_sem_etc() {}
 void _kern_remove_attr() {}
@@ -1475,6 +1497,7 @@ void _kern_select() {}
 void _kern_send() {}
 void _kern_send_data() {}
 void _kern_send_signal() {}
+void _kern_sendfile() {}
 void _kern_sendmsg() {}
 void _kern_sendto() {}
 void _kern_set_area_protection() {}
@@ -1515,6 +1538,7 @@ void _kern_snooze_etc() {}
 void _kern_sockatmark() {}
 void _kern_socket() {}
 void _kern_socketpair() {}
+void _kern_spawn() {}
 void _kern_spawn_thread() {}
 void _kern_start_watching() {}
 void _kern_start_watching_disks() {}
@@ -1547,6 +1571,7 @@ void _kern_unregister_file_device() {}
 void _kern_unregister_image() {}
 void _kern_unregister_messaging_service() {}
 void _kern_unreserve_address_range() {}
+void _kern_vfork() {}
 void _kern_wait_for_child() {}
 void _kern_wait_for_debugger() {}
 void _kern_wait_for_objects() {}
@@ -1555,6 +1580,7 @@ void _kern_wait_for_thread() {}
 void _kern_write() {}
 void _kern_write_attr() {}
 void _kern_write_fs_info() {}
+void _kern_write_port_batch() {}
 void _kern_write_port_etc() {}
 void _kern_write_stat() {}
 void _kern_writev() {}
@@ -2309,6 +2335,23 @@ void port_count() {}
 void posix_madvise() {}
 void posix_memalign() {}
 void posix_openpt() {}
+void posix_spawn() {}
+void posix_spawn_file_actions_addclose() {}
+void posix_spawn_file_actions_adddup2() {}
+void posix_spawn_file_actions_addopen() {}
+void posix_spawn_file_actions_destroy() {}
+void posix_spawn_file_actions_init() {}
+void posix_spawnattr_destroy() {}
+void posix_spawnattr_getflags() {}
+void posix_spawnattr_getpgroup() {}
+void posix_spawnattr_getsigdefault() {}
+void posix_spawnattr_getsigmask() {}
+void posix_spawnattr_init() {}
+void posix_spawnattr_setflags() {}
+void posix_spawnattr_setpgroup() {}
+void posix_spawnattr_setsigdefault() {}
+void posix_spawnattr_setsigmask() {}
+void posix_spawnp() {}
 void pow() {}
 void pow10() {}
 void pow10f() {}
@@ -2334,6 +2377,13 @@ void pthread_attr_setguardsize() {}
 void pthread_attr_setschedparam() {}
 void pthread_attr_setscope() {}
 void pthread_attr_setstacksize() {}
+void pthread_barrier_destroy() {}
+void pthread_barrier_init() {}
+void pthread_barrier_wait() {}
+void pthread_barrierattr_destroy() {}
+void pthread_barrierattr_getpshared() {}
+void pthread_barrierattr_init() {}
+void pthread_barrierattr_setpshared() {}
 void pthread_cancel() {}
 void pthread_cond_broadcast() {}
 void pthread_cond_destroy() {}
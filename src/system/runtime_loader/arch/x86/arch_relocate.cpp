@@ -16,6 +16,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "images.h"
+
+
+extern "C" void arch_lazy_bind_trampoline();
+extern "C" addr_t arch_resolve_lazy_symbol(image_t* image,
+	addr_t relocationOffset);
+
 
 static int
 relocate_rel(image_t *rootImage, image_t *image, struct Elf32_Rel *rel,
@@ -107,6 +114,51 @@ relocate_rel(image_t *rootImage, image_t *image, struct Elf32_Rel *rel,
 }
 
 
+/*!	Prepares the PLT of \a image for lazy binding. Instead of the symbol
+	address, each GOT entry used by the PLT keeps pointing to the PLT code that
+	pushes the relocation offset and jumps to the first PLT entry, which in
+	turn pushes GOT[1] and jumps to GOT[2]. Returns \c false, if there are
+	other PLT relocations, and the PLT has to be bound immediately.
+*/
+static bool
+prepare_lazy_binding(image_t* image)
+{
+	struct Elf32_Rel* rel = image->pltrel;
+	int count = image->pltrel_len / (int)sizeof(struct Elf32_Rel);
+
+	for (int i = 0; i < count; i++) {
+		if (ELF32_R_TYPE(rel[i].r_info) != R_386_JMP_SLOT)
+			return false;
+	}
+
+	// the GOT entries contain link time addresses
+	for (int i = 0; i < count; i++) {
+		*(addr_t*)(image->regions[0].delta + rel[i].r_offset)
+			+= image->regions[0].delta;
+	}
+
+	image->pltgot[1] = (addr_t)image;
+	image->pltgot[2] = (addr_t)&arch_lazy_bind_trampoline;
+	return true;
+}
+
+
+/*!	Called by arch_lazy_bind_trampoline() on the first call of a PLT entry.
+	Binds the entry, and returns the address of the function to call.
+*/
+addr_t
+arch_resolve_lazy_symbol(image_t* image, addr_t relocationOffset)
+{
+	struct Elf32_Rel* rel
+		= (struct Elf32_Rel*)((addr_t)image->pltrel + relocationOffset);
+
+	addr_t address = resolve_lazy_symbol(image, ELF32_R_SYM(rel->r_info));
+	*(addr_t*)(image->regions[0].delta + rel->r_offset) = address;
+
+	return address;
+}
+
+
 status_t
 arch_relocate_image(image_t* rootImage, image_t* image,
 	SymbolLookupCache* cache)
@@ -121,7 +173,8 @@ arch_relocate_image(image_t* rootImage, image_t* image,
 			return status;
 	}
 
-	if (image->pltrel) {
+	if (image->pltrel && ((image->flags & RFLAG_BIND_LAZILY) == 0
+			|| image->pltgot == NULL || !prepare_lazy_binding(image))) {
 		status = relocate_rel(rootImage, image, image->pltrel,
 			image->pltrel_len, cache);
 		if (status < B_OK)
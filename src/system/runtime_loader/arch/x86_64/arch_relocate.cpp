@@ -12,6 +12,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "images.h"
+
+
+extern "C" void arch_lazy_bind_trampoline();
+extern "C" addr_t arch_resolve_lazy_symbol(image_t* image,
+	addr_t relocationIndex);
+
 
 static status_t
 relocate_rela(image_t* rootImage, image_t* image, Elf64_Rela* rel,
@@ -77,6 +84,51 @@ relocate_rela(image_t* rootImage, image_t* image, Elf64_Rela* rel,
 }
 
 
+/*!	Prepares the PLT of \a image for lazy binding. Instead of the symbol
+	address, each GOT entry used by the PLT keeps pointing to the PLT code that
+	pushes the relocation index and jumps to the first PLT entry, which in turn
+	pushes GOT[1] and jumps to GOT[2]. Returns \c false, if there are other
+	PLT relocations, and the PLT has to be bound immediately.
+*/
+static bool
+prepare_lazy_binding(image_t* image)
+{
+	Elf64_Rela* rel = (Elf64_Rela*)image->pltrel;
+	size_t count = image->pltrel_len / sizeof(Elf64_Rela);
+
+	for (size_t i = 0; i < count; i++) {
+		if (ELF64_R_TYPE(rel[i].r_info) != R_X86_64_JUMP_SLOT)
+			return false;
+	}
+
+	// the GOT entries contain link time addresses
+	for (size_t i = 0; i < count; i++) {
+		*(Elf64_Addr*)(image->regions[0].delta + rel[i].r_offset)
+			+= image->regions[0].delta;
+	}
+
+	image->pltgot[1] = (addr_t)image;
+	image->pltgot[2] = (addr_t)&arch_lazy_bind_trampoline;
+	return true;
+}
+
+
+/*!	Called by arch_lazy_bind_trampoline() on the first call of a PLT entry.
+	Binds the entry, and returns the address of the function to call.
+*/
+addr_t
+arch_resolve_lazy_symbol(image_t* image, addr_t relocationIndex)
+{
+	Elf64_Rela* rel = (Elf64_Rela*)image->pltrel + relocationIndex;
+
+	addr_t address = resolve_lazy_symbol(image, ELF64_R_SYM(rel->r_info))
+		+ rel->r_addend;
+	*(Elf64_Addr*)(image->regions[0].delta + rel->r_offset) = address;
+
+	return address;
+}
+
+
 status_t
 arch_relocate_image(image_t* rootImage, image_t* image,
 	SymbolLookupCache* cache)
@@ -94,6 +146,11 @@ arch_relocate_image(image_t* rootImage, image_t* image,
 	}
 
 	// PLT relocations (they are RELA on x86_64).
+	if (image->pltrel && (image->flags & RFLAG_BIND_LAZILY) != 0
+		&& image->pltgot != NULL && prepare_lazy_binding(image)) {
+		return B_OK;
+	}
+
 	if (image->pltrel) {
 		status = relocate_rela(rootImage, image, (Elf64_Rela*)image->pltrel,
 			image->pltrel_len, cache);
@@ -30,10 +30,10 @@
 #include "elf_versioning.h"
 #include "errors.h"
 #include "images.h"
+#include "prelink_cache.h"
 
 
 // TODO: implement better locking strategy
-// TODO: implement lazy binding
 
 // a handle returned by load_library() (dlopen())
 #define RLD_GLOBAL_SCOPE	((void*)-2l)
@@ -222,16 +222,39 @@ relocate_dependencies(image_t *image)
 		return count;
 
 	// relocate
+	status_t status = B_OK;
+	begin_symbol_resolution();
+
 	for (ssize_t i = 0; i < count; i++) {
-		status_t status = relocate_image(image, list[i]);
-		if (status < B_OK) {
-			free(list);
-			return status;
-		}
+		status = relocate_image(image, list[i]);
+		if (status < B_OK)
+			break;
 	}
 
+	end_symbol_resolution();
 	free(list);
-	return B_OK;
+	return status;
+}
+
+
+/*!	Marks the not yet relocated images loaded with the program for lazy
+	binding of their PLT entries, unless the LD_BIND_NOW environment variable
+	is set, or the image asks for immediate binding itself.
+	Only the program's images are bound lazily, since they are never
+	unloaded, and are all resolved with the program as root image.
+*/
+static void
+enable_lazy_binding()
+{
+	const char* bindNow = getenv("LD_BIND_NOW");
+	if (bindNow != NULL && bindNow[0] != '\0')
+		return;
+
+	for (image_t* image = get_loaded_images().head; image != NULL;
+			image = image->next) {
+		if ((image->flags & (RFLAG_RELOCATED | RTLD_NOW)) == 0)
+			image->flags |= RFLAG_BIND_LAZILY;
+	}
 }
 
 
@@ -426,7 +449,11 @@ load_program(char const *path, void **_entry)
 	// This results in the desired symbol resolution for dlopen()ed libraries.
 	set_image_flags_recursively(gProgramImage, RTLD_GLOBAL);
 
+	enable_lazy_binding();
+
+	prelink_cache_init(gProgramImage);
 	status = relocate_dependencies(gProgramImage);
+	prelink_cache_finish(status == B_OK);
 	if (status < B_OK)
 		goto err;
 
@@ -994,6 +1021,31 @@ elf_verify_header(void *header, size_t length)
 }
 
 
+/*!	Resolves the symbol with index \a symbolIndex that \a image references,
+	on behalf of the architecture specific lazy binding code. If the symbol
+	cannot be resolved, the team is terminated.
+*/
+addr_t
+resolve_lazy_symbol(image_t* image, uint32 symbolIndex)
+{
+	rld_lock();
+
+	addr_t address;
+	status_t status = resolve_symbol(gProgramImage, image,
+		SYMBOL(image, symbolIndex), NULL, &address);
+
+	rld_unlock();
+
+	if (status != B_OK) {
+		FATAL("%s: Could not bind symbol '%s' lazily: %s\n", image->path,
+			SYMNAME(image, SYMBOL(image, symbolIndex)), strerror(status));
+		_kern_exit_team(status);
+	}
+
+	return address;
+}
+
+
 void
 terminate_program(void)
 {
@@ -10,6 +10,7 @@
 
 #include "elf_load_image.h"
 
+#include <dlfcn.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -242,12 +243,38 @@ assert_dynamic_loadable(image_t* image)
 }
 
 
+static void
+init_gnu_hash_table(image_t* image, uint32* table)
+{
+	// The table consists of a header with the bucket count, the index of the
+	// first hashed symbol, the bloom filter size in words, and the bloom
+	// filter shift count, followed by the bloom filter words, the buckets,
+	// and one hash value for each hashed symbol.
+	uint32 bucketCount = table[0];
+	uint32 bloomSize = table[2];
+	if (bucketCount == 0 || bloomSize == 0
+		|| (bloomSize & (bloomSize - 1)) != 0) {
+		FATAL("%s: Ignoring invalid GNU hash table\n", image->path);
+		return;
+	}
+
+	image->gnu_hash_bucket_count = bucketCount;
+	image->gnu_hash_symbol_offset = table[1];
+	image->gnu_hash_bloom_mask = bloomSize - 1;
+	image->gnu_hash_bloom_shift = table[3];
+	image->gnu_hash_bloom = (addr_t*)(table + 4);
+	image->gnu_hash_buckets = (uint32*)(image->gnu_hash_bloom + bloomSize);
+	image->gnu_hash_chains = image->gnu_hash_buckets + bucketCount;
+}
+
+
 static bool
 parse_dynamic_segment(image_t* image)
 {
 	elf_dyn* d;
 	int i;
 	int sonameOffset = -1;
+	uint32* gnuHashTable = NULL;
 
 	image->symhash = 0;
 	image->syms = 0;
@@ -266,6 +293,10 @@ parse_dynamic_segment(image_t* image)
 				image->symhash
 					= (uint32*)(d[i].d_un.d_ptr + image->regions[0].delta);
 				break;
+			case DT_GNU_HASH:
+				gnuHashTable
+					= (uint32*)(d[i].d_un.d_ptr + image->regions[0].delta);
+				break;
 			case DT_STRTAB:
 				image->strtab
 					= (char*)(d[i].d_un.d_ptr + image->regions[0].delta);
@@ -296,6 +327,13 @@ parse_dynamic_segment(image_t* image)
 			case DT_PLTRELSZ:
 				image->pltrel_len = d[i].d_un.d_val;
 				break;
+			case DT_PLTGOT:
+				image->pltgot = (addr_t*)
+					(d[i].d_un.d_ptr + image->regions[0].delta);
+				break;
+			case DT_BIND_NOW:
+				image->flags |= RTLD_NOW;
+				break;
 			case DT_INIT:
 				image->init_routine
 					= (d[i].d_un.d_ptr + image->regions[0].delta);
@@ -333,6 +371,8 @@ parse_dynamic_segment(image_t* image)
 				uint32 flags = d[i].d_un.d_val;
 				if ((flags & DF_SYMBOLIC) != 0)
 					image->flags |= RFLAG_SYMBOLIC;
+				if ((flags & DF_BIND_NOW) != 0)
+					image->flags |= RTLD_NOW;
 				if ((flags & DF_STATIC_TLS) != 0) {
 					FATAL("Static TLS model is not supported.\n");
 					return false;
@@ -347,7 +387,6 @@ parse_dynamic_segment(image_t* image)
 			// DT_RELAENT: The size of a DT_RELA entry.
 			// DT_SYMENT: The size of a symbol table entry.
 			// DT_PLTREL: The type of the PLT relocation entries (DT_JMPREL).
-			// DT_BIND_NOW/DF_BIND_NOW: No lazy binding allowed.
 			// DT_INIT_ARRAY[SZ], DT_FINI_ARRAY[SZ]: Initialization/termination
 			//		function arrays.
 			// DT_PREINIT_ARRAY[SZ]: Preinitialization function array.
@@ -361,6 +400,9 @@ parse_dynamic_segment(image_t* image)
 	if (!image->symhash || !image->syms || !image->strtab)
 		return false;
 
+	if (gnuHashTable != NULL)
+		init_gnu_hash_table(image, gnuHashTable);
+
 	if (sonameOffset >= 0)
 		strlcpy(image->name, STRING(image, sonameOffset), sizeof(image->name));
 
@@ -12,11 +12,13 @@
 
 #include <dlfcn.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "add_ons.h"
 #include "errors.h"
 #include "images.h"
+#include "prelink_cache.h"
 #include "runtime_loader_private.h"
 
 
@@ -63,6 +65,230 @@ elf_hash(const char* _name)
 }
 
 
+uint32
+elf_gnu_hash(const char* _name)
+{
+	const uint8* name = (const uint8*)_name;
+
+	uint32 hash = 5381;
+	while (*name != '\0')
+		hash = hash * 33 + *name++;
+
+	return hash;
+}
+
+
+/*!	Returns the first symbol index in the GNU hash chain starting at \a index
+	whose hash matches \a hash, or \c STN_UNDEF, if there is none.
+*/
+static inline uint32
+next_gnu_hash_candidate(image_t* image, uint32 hash, uint32 index)
+{
+	while (true) {
+		uint32 chainHash
+			= image->gnu_hash_chains[index - image->gnu_hash_symbol_offset];
+		if (((chainHash ^ hash) >> 1) == 0)
+			return index;
+
+		// the lowest bit marks the end of the chain
+		if ((chainHash & 1) != 0)
+			return STN_UNDEF;
+
+		index++;
+	}
+}
+
+
+/*!	Returns the index of the first symbol of \a image that might be the one
+	described by \a lookupInfo, or \c STN_UNDEF, if the image doesn't
+	contain it for sure.
+*/
+static inline uint32
+first_symbol_candidate(image_t* image, const SymbolLookupInfo& lookupInfo)
+{
+	if (image->gnu_hash_buckets == NULL)
+		return HASHBUCKETS(image)[lookupInfo.hash % HASHTABSIZE(image)];
+
+	// check the bloom filter first -- it rejects most symbols that are not
+	// defined in the image without touching the buckets or the chains
+	const uint32 wordBits = sizeof(addr_t) * 8;
+	uint32 hash = lookupInfo.gnuHash;
+	addr_t word = image->gnu_hash_bloom[
+		(hash / wordBits) & image->gnu_hash_bloom_mask];
+	addr_t mask = ((addr_t)1 << (hash % wordBits))
+		| ((addr_t)1 << ((hash >> image->gnu_hash_bloom_shift) % wordBits));
+	if ((word & mask) != mask)
+		return STN_UNDEF;
+
+	uint32 index = image->gnu_hash_buckets[
+		hash % image->gnu_hash_bucket_count];
+	if (index < image->gnu_hash_symbol_offset)
+		return STN_UNDEF;
+
+	return next_gnu_hash_candidate(image, hash, index);
+}
+
+
+static inline uint32
+next_symbol_candidate(image_t* image, const SymbolLookupInfo& lookupInfo,
+	uint32 index)
+{
+	if (image->gnu_hash_buckets == NULL)
+		return HASHCHAINS(image)[index];
+
+	if ((image->gnu_hash_chains[index - image->gnu_hash_symbol_offset] & 1)
+			!= 0) {
+		return STN_UNDEF;
+	}
+
+	return next_gnu_hash_candidate(image, lookupInfo.gnuHash, index + 1);
+}
+
+
+// #pragma mark - resolved symbol cache
+
+
+/*!	While a set of images is relocated, many of them reference the same
+	symbols -- every C++ library references the same libroot and libstdc++
+	symbols, for example. The global symbol resolution only depends on the
+	root image and the symbol to look for (unless the requesting image is
+	linked symbolically), so its results are remembered here until
+	end_symbol_resolution() is called.
+*/
+struct ResolvedSymbol {
+	const char*				name;
+	uint32					hash;
+	int32					type;
+	uint32					flags;
+	const elf_version_info*	version;
+	image_t*				rootImage;
+	image_t*				image;
+	elf_sym*				symbol;
+};
+
+
+static const uint32 kInitialResolvedSymbolCapacity = 1024;
+
+static bool sCacheResolvedSymbols = false;
+static ResolvedSymbol* sResolvedSymbols;
+static uint32 sResolvedSymbolCapacity;
+static uint32 sResolvedSymbolCount;
+
+
+static inline bool
+equals_version(const elf_version_info* a, const elf_version_info* b)
+{
+	if (a == b)
+		return true;
+	if (a == NULL || b == NULL || a->hash != b->hash
+		|| strcmp(a->name, b->name) != 0) {
+		return false;
+	}
+
+	return a->file_name == b->file_name
+		|| (a->file_name != NULL && b->file_name != NULL
+			&& strcmp(a->file_name, b->file_name) == 0);
+}
+
+
+static ResolvedSymbol*
+find_resolved_symbol(image_t* rootImage, const SymbolLookupInfo& lookupInfo)
+{
+	if (sResolvedSymbolCount == 0)
+		return NULL;
+
+	uint32 mask = sResolvedSymbolCapacity - 1;
+	for (uint32 i = lookupInfo.gnuHash & mask;
+			sResolvedSymbols[i].name != NULL; i = (i + 1) & mask) {
+		ResolvedSymbol& resolved = sResolvedSymbols[i];
+		if (resolved.hash == lookupInfo.gnuHash
+			&& resolved.rootImage == rootImage
+			&& resolved.type == lookupInfo.type
+			&& resolved.flags == lookupInfo.flags
+			&& strcmp(resolved.name, lookupInfo.name) == 0
+			&& equals_version(resolved.version, lookupInfo.version)) {
+			return &resolved;
+		}
+	}
+
+	return NULL;
+}
+
+
+static void
+add_resolved_symbol(image_t* rootImage, const SymbolLookupInfo& lookupInfo,
+	image_t* image, elf_sym* symbol)
+{
+	if (!sCacheResolvedSymbols)
+		return;
+
+	// keep the table at most half full
+	if ((sResolvedSymbolCount + 1) * 2 > sResolvedSymbolCapacity) {
+		uint32 capacity = sResolvedSymbolCapacity == 0
+			? kInitialResolvedSymbolCapacity : sResolvedSymbolCapacity * 2;
+		ResolvedSymbol* symbols
+			= (ResolvedSymbol*)calloc(capacity, sizeof(ResolvedSymbol));
+		if (symbols == NULL)
+			return;
+
+		for (uint32 i = 0; i < sResolvedSymbolCapacity; i++) {
+			if (sResolvedSymbols[i].name == NULL)
+				continue;
+
+			uint32 index = sResolvedSymbols[i].hash & (capacity - 1);
+			while (symbols[index].name != NULL)
+				index = (index + 1) & (capacity - 1);
+			symbols[index] = sResolvedSymbols[i];
+		}
+
+		free(sResolvedSymbols);
+		sResolvedSymbols = symbols;
+		sResolvedSymbolCapacity = capacity;
+	}
+
+	uint32 mask = sResolvedSymbolCapacity - 1;
+	uint32 index = lookupInfo.gnuHash & mask;
+	while (sResolvedSymbols[index].name != NULL)
+		index = (index + 1) & mask;
+
+	ResolvedSymbol& resolved = sResolvedSymbols[index];
+	resolved.name = lookupInfo.name;
+	resolved.hash = lookupInfo.gnuHash;
+	resolved.type = lookupInfo.type;
+	resolved.flags = lookupInfo.flags;
+	resolved.version = lookupInfo.version;
+	resolved.rootImage = rootImage;
+	resolved.image = image;
+	resolved.symbol = symbol;
+	sResolvedSymbolCount++;
+}
+
+
+/*!	Starts remembering the results of global symbol lookups. Must only be
+	called while no images are loaded or unloaded, and must be followed by
+	end_symbol_resolution() before that happens again.
+*/
+void
+begin_symbol_resolution()
+{
+	sCacheResolvedSymbols = true;
+}
+
+
+void
+end_symbol_resolution()
+{
+	free(sResolvedSymbols);
+	sResolvedSymbols = NULL;
+	sResolvedSymbolCapacity = 0;
+	sResolvedSymbolCount = 0;
+	sCacheResolvedSymbols = false;
+}
+
+
+// #pragma mark -
+
+
 void
 patch_defined_symbol(image_t* image, const char* name, void** symbol,
 	int32* type)
@@ -102,10 +328,8 @@ find_symbol(image_t* image, const SymbolLookupInfo& lookupInfo)
 	elf_sym* versionedSymbol = NULL;
 	uint32 versionedSymbolCount = 0;
 
-	uint32 bucket = lookupInfo.hash % HASHTABSIZE(image);
-
-	for (uint32 i = HASHBUCKETS(image)[bucket]; i != STN_UNDEF;
-			i = HASHCHAINS(image)[i]) {
+	for (uint32 i = first_symbol_candidate(image, lookupInfo); i != STN_UNDEF;
+			i = next_symbol_candidate(image, lookupInfo, i)) {
 		elf_sym* symbol = &image->syms[i];
 
 		if (symbol->st_shndx != SHN_UNDEF
@@ -345,7 +569,8 @@ find_undefined_symbol_global(image_t* rootImage, image_t* image,
 	elf_sym* candidateSymbol = NULL;
 
 	// If the requesting image is linked symbolically, look up the symbol there
-	// first.
+	// first. Otherwise the result doesn't depend on the requesting image, and
+	// the symbol might have been resolved before.
 	bool symbolic = (image->flags & RFLAG_SYMBOLIC) != 0;
 	if (symbolic) {
 		candidateSymbol = find_symbol(image, lookupInfo);
@@ -357,6 +582,10 @@ find_undefined_symbol_global(image_t* rootImage, image_t* image,
 
 			candidateImage = image;
 		}
+	} else if (ResolvedSymbol* resolved
+			= find_resolved_symbol(rootImage, lookupInfo)) {
+		*_foundInImage = resolved->image;
+		return resolved->symbol;
 	}
 
 	image_t* otherImage = get_loaded_images().head;
@@ -368,8 +597,9 @@ find_undefined_symbol_global(image_t* rootImage, image_t* image,
 						& (RTLD_GLOBAL | RFLAG_USE_FOR_RESOLVING)) != 0)) {
 			if (elf_sym* symbol = find_symbol(otherImage, lookupInfo)) {
 				if (symbol->Bind() != STB_WEAK) {
-					*_foundInImage = otherImage;
-					return symbol;
+					candidateSymbol = symbol;
+					candidateImage = otherImage;
+					break;
 				}
 
 				if (candidateSymbol == NULL) {
@@ -381,9 +611,15 @@ find_undefined_symbol_global(image_t* rootImage, image_t* image,
 		otherImage = otherImage->next;
 	}
 
-	if (candidateSymbol != NULL)
+	if (candidateSymbol != NULL) {
 		*_foundInImage = candidateImage;
 
+		if (!symbolic) {
+			add_resolved_symbol(rootImage, lookupInfo, candidateImage,
+				candidateSymbol);
+		}
+	}
+
 	return candidateSymbol;
 }
 
@@ -479,7 +715,7 @@ resolve_symbol(image_t* rootImage, image_t* image, elf_sym* sym,
 	uint32 index = sym - image->syms;
 
 	// check the cache first
-	if (cache->IsSymbolValueCached(index)) {
+	if (cache != NULL && cache->IsSymbolValueCached(index)) {
 		*symAddress = cache->SymbolValueAt(index, symbolImage);
 		return B_OK;
 	}
@@ -499,7 +735,8 @@ resolve_symbol(image_t* rootImage, image_t* image, elf_sym* sym,
 		// Local symbols references are always resolved to the given symbol.
 		sharedImage = image;
 		sharedSym = sym;
-	} else {
+	} else if ((sharedSym = prelink_cache_lookup(image, index, &sharedImage))
+			== NULL) {
 		// get the version info
 		const elf_version_info* versionInfo = NULL;
 		if (image->symbol_versions != NULL) {
@@ -511,6 +748,8 @@ resolve_symbol(image_t* rootImage, image_t* image, elf_sym* sym,
 		// search the symbol
 		sharedSym = rootImage->find_undefined_symbol(rootImage, image,
 			SymbolLookupInfo(symName, type, versionInfo, 0, sym), &sharedImage);
+		if (sharedSym != NULL)
+			prelink_cache_add(image, index, sharedImage, sharedSym);
 	}
 
 	enum {
@@ -579,7 +818,8 @@ resolve_symbol(image_t* rootImage, image_t* image, elf_sym* sym,
 		return B_MISSING_SYMBOL;
 	}
 
-	cache->SetSymbolValueAt(index, (addr_t)location, sharedImage);
+	if (cache != NULL)
+		cache->SetSymbolValueAt(index, (addr_t)location, sharedImage);
 
 	if (symbolImage)
 		*symbolImage = sharedImage;
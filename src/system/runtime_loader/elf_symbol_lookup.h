@@ -17,12 +17,14 @@
 
 
 uint32 elf_hash(const char* name);
+uint32 elf_gnu_hash(const char* name);
 
 
 struct SymbolLookupInfo {
 	const char*				name;
 	int32					type;
 	uint32					hash;
+	uint32					gnuHash;
 	uint32					flags;
 	const elf_version_info*	version;
 	elf_sym*				requestingSymbol;
@@ -34,6 +36,7 @@ struct SymbolLookupInfo {
 		name(name),
 		type(type),
 		hash(hash),
+		gnuHash(elf_gnu_hash(name)),
 		flags(flags),
 		version(version),
 		requestingSymbol(requestingSymbol)
@@ -47,6 +50,7 @@ struct SymbolLookupInfo {
 		name(name),
 		type(type),
 		hash(elf_hash(name)),
+		gnuHash(elf_gnu_hash(name)),
 		flags(flags),
 		version(version),
 		requestingSymbol(requestingSymbol)
@@ -122,6 +126,9 @@ private:
 };
 
 
+void		begin_symbol_resolution();
+void		end_symbol_resolution();
+
 void		patch_defined_symbol(image_t* image, const char* name,
 				void** symbol, int32* type);
 void		patch_undefined_symbol(image_t* rootImage, image_t* image,
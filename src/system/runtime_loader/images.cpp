@@ -473,11 +473,16 @@ register_image(image_t* image, int fd, const char* path)
 	if (_kern_read_stat(fd, NULL, false, &stat, sizeof(struct stat)) == B_OK) {
 		info.device = stat.st_dev;
 		info.node = stat.st_ino;
+		image->modification_time = (bigtime_t)stat.st_mtim.tv_sec * 1000000
+			+ stat.st_mtim.tv_nsec / 1000;
 	} else {
 		info.device = -1;
 		info.node = -1;
 	}
 
+	image->device = info.device;
+	image->node = info.node;
+
 	// We may have split segments into separate regions. Compute the correct
 	// segments for the image info.
 	addr_t textBase = 0;
@@ -18,6 +18,8 @@ enum {
 
 	RFLAG_RW					= 0x0010,
 	RFLAG_ANON					= 0x0020,
+	RFLAG_BIND_LAZILY			= 0x0040,
+		// the PLT entries are resolved on their first call
 
 	RFLAG_TERMINATED			= 0x0200,
 	RFLAG_INITIALIZED			= 0x0400,
@@ -0,0 +1,498 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	The prelink cache remembers where the symbols referenced by the images of
+	a program have been found, so that later starts of the same program don't
+	have to search the loaded images for them again.
+
+	There is one cache file per program in a directory of the user in the
+	system cache directory. Since a cache file decides which symbols a
+	program uses, it is only trusted if neither it nor its directory can be
+	written by anyone but the user (or root). The directory is kept below
+	kMaxCacheFiles files and kMaxCacheSize bytes by removing the files that
+	have been written least recently.
+
+	Since the images are mapped at random addresses, the cache does not store
+	addresses, but the index of the image (in load order) and the index of
+	the symbol in that image's symbol table. A cache file is only used when
+	the program loaded exactly the same image files as when it was written;
+	when a package changes, the files it contains are different, and the
+	cache file is replaced on the next start.
+
+	The cache file is mapped read-only and shared by all teams using it.
+*/
+
+
+#include "prelink_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <FindDirectory.h>
+
+#include <find_directory_private.h>
+#include <syscalls.h>
+#include <vm_defs.h>
+
+#include "elf_symbol_lookup.h"
+#include "images.h"
+#include "runtime_loader_private.h"
+
+
+#define PRELINK_CACHE_MAGIC			'RLpc'
+#define PRELINK_CACHE_VERSION		1
+
+static const uint32 kMaxImages = 255;
+static const uint32 kMaxSymbols = 1 << 24;
+static const uint32 kMaxCacheFiles = 256;
+static const off_t kMaxCacheSize = 32 * 1024 * 1024;
+static const char* const kCacheDirectoryName = "runtime_loader";
+
+
+struct prelink_cache_header {
+	uint32		magic;
+	uint32		version;
+	uint32		image_count;
+	uint32		entry_count;
+	char		program_path[B_PATH_NAME_LENGTH];
+};
+
+struct prelink_cache_image {
+	dev_t		device;
+	uint32		symbol_count;
+	ino_t		node;
+	bigtime_t	modification_time;
+};
+
+// The header and the image table are followed by one uint32 entry for each
+// symbol of each image, in image order. An entry is either 0 (not resolved),
+// or the index of the defining image plus one in the upper 8 bits, and the
+// index of the defining symbol in the lower 24 bits.
+
+
+struct CachedImage {
+	image_t*	image;
+	uint32		first_entry;
+	uint32		symbol_count;
+};
+
+
+static image_t* sProgramImage;
+static CachedImage* sImages;
+static uint32 sImageCount;
+static uint32 sLastImage;
+static uint32* sEntries;
+static uint32 sEntryCount;
+static bool sRecording;
+static area_id sCacheArea = -1;
+
+
+/*!	Returns whether a cache file or directory described by \a stat can only
+	be changed by the current user, or root.
+*/
+static bool
+is_trusted(const struct stat& stat)
+{
+	return (stat.st_uid == _kern_getuid(true) || stat.st_uid == 0)
+		&& (stat.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+
+/*!	Opens the current user's cache directory, and optionally creates it.
+	Returns a file descriptor, or an error if the directory could not be
+	opened or cannot be trusted.
+*/
+static int
+open_cache_directory(bool create)
+{
+	char path[B_PATH_NAME_LENGTH];
+	status_t status = __find_directory(B_SYSTEM_CACHE_DIRECTORY, -1, create,
+		path, sizeof(path));
+	if (status != B_OK)
+		return status;
+
+	if (strlcat(path, "/", sizeof(path)) >= sizeof(path)
+		|| strlcat(path, kCacheDirectoryName, sizeof(path)) >= sizeof(path)) {
+		return B_NAME_TOO_LONG;
+	}
+
+	if (create) {
+		status = _kern_create_dir(-1, path, 0755);
+		if (status != B_OK && status != B_FILE_EXISTS)
+			return status;
+	}
+
+	char name[16];
+	snprintf(name, sizeof(name), "/%" B_PRIu32, (uint32)_kern_getuid(true));
+	if (strlcat(path, name, sizeof(path)) >= sizeof(path))
+		return B_NAME_TOO_LONG;
+
+	if (create) {
+		status = _kern_create_dir(-1, path, 0700);
+		if (status != B_OK && status != B_FILE_EXISTS)
+			return status;
+	}
+
+	// check the directory we actually opened, so that it can't be replaced
+	// in the meantime
+	int directory = _kern_open_dir(-1, path);
+	if (directory < 0)
+		return directory;
+
+	struct stat stat;
+	if (_kern_read_stat(directory, NULL, false, &stat, sizeof(struct stat))
+			!= B_OK
+		|| !is_trusted(stat)) {
+		_kern_close(directory);
+		return B_NOT_ALLOWED;
+	}
+
+	return directory;
+}
+
+
+static void
+get_cache_file_name(char* name, size_t size)
+{
+	snprintf(name, size, "%08" B_PRIx32, elf_hash(sProgramImage->path));
+}
+
+
+/*!	Removes the least recently written files from the cache \a directory
+	until a new file of \a size bytes fits into it.
+*/
+static void
+trim_cache_directory(int directory, size_t size)
+{
+	char buffer[sizeof(struct dirent) + B_FILE_NAME_LENGTH];
+	struct dirent* entry = (struct dirent*)buffer;
+
+	// we only remove a few files at a time, the directory will shrink further
+	// the next time a file is written
+	for (int32 attempt = 0; attempt < 4; attempt++) {
+		uint32 count = 0;
+		off_t totalSize = size;
+		char oldestName[B_FILE_NAME_LENGTH];
+		time_t oldestTime = 0;
+		oldestName[0] = '\0';
+
+		_kern_rewind_dir(directory);
+		while (_kern_read_dir(directory, entry, sizeof(buffer), 1) == 1) {
+			if (strcmp(entry->d_name, ".") == 0
+				|| strcmp(entry->d_name, "..") == 0) {
+				continue;
+			}
+
+			struct stat stat;
+			if (_kern_read_stat(directory, entry->d_name, false, &stat,
+					sizeof(struct stat)) != B_OK) {
+				continue;
+			}
+
+			count++;
+			totalSize += stat.st_size;
+
+			if (oldestName[0] == '\0' || stat.st_mtime < oldestTime) {
+				strlcpy(oldestName, entry->d_name, sizeof(oldestName));
+				oldestTime = stat.st_mtime;
+			}
+		}
+
+		if ((count < kMaxCacheFiles && totalSize <= kMaxCacheSize)
+			|| oldestName[0] == '\0'
+			|| _kern_unlink(directory, oldestName) != B_OK) {
+			return;
+		}
+	}
+}
+
+
+static inline CachedImage*
+find_cached_image(image_t* image)
+{
+	// relocations are done one image at a time
+	if (sLastImage < sImageCount && sImages[sLastImage].image == image)
+		return &sImages[sLastImage];
+
+	for (uint32 i = 0; i < sImageCount; i++) {
+		if (sImages[i].image == image) {
+			sLastImage = i;
+			return &sImages[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+static bool
+map_cache_file()
+{
+	int directory = open_cache_directory(false);
+	if (directory < 0)
+		return false;
+
+	char name[16];
+	get_cache_file_name(name, sizeof(name));
+
+	int fd = _kern_open(directory, name, O_RDONLY, 0);
+	_kern_close(directory);
+	if (fd < 0)
+		return false;
+
+	size_t size = sizeof(prelink_cache_header)
+		+ sImageCount * sizeof(prelink_cache_image)
+		+ sEntryCount * sizeof(uint32);
+
+	struct stat stat;
+	if (_kern_read_stat(fd, NULL, false, &stat, sizeof(struct stat)) != B_OK
+		|| !S_ISREG(stat.st_mode) || !is_trusted(stat)
+		|| stat.st_size != (off_t)size) {
+		_kern_close(fd);
+		return false;
+	}
+
+	void* address;
+	sCacheArea = _kern_map_file("prelink cache", &address,
+		B_RANDOMIZED_ANY_ADDRESS, size, B_READ_AREA, REGION_NO_PRIVATE_MAP,
+		false, fd, 0);
+	_kern_close(fd);
+	if (sCacheArea < 0)
+		return false;
+
+	// check that the cache was written for the images we loaded
+
+	prelink_cache_header* header = (prelink_cache_header*)address;
+	prelink_cache_image* images = (prelink_cache_image*)(header + 1);
+
+	bool valid = header->magic == PRELINK_CACHE_MAGIC
+		&& header->version == PRELINK_CACHE_VERSION
+		&& header->image_count == sImageCount
+		&& header->entry_count == sEntryCount
+		&& strncmp(header->program_path, sProgramImage->path,
+			sizeof(header->program_path)) == 0;
+
+	for (uint32 i = 0; valid && i < sImageCount; i++) {
+		image_t* image = sImages[i].image;
+		valid = images[i].device == image->device
+			&& images[i].node == image->node
+			&& images[i].modification_time == image->modification_time
+			&& images[i].symbol_count == sImages[i].symbol_count;
+	}
+
+	if (!valid) {
+		_kern_delete_area(sCacheArea);
+		sCacheArea = -1;
+		return false;
+	}
+
+	sEntries = (uint32*)(images + sImageCount);
+	return true;
+}
+
+
+static void
+write_cache_file()
+{
+	size_t tableSize = sizeof(prelink_cache_header)
+		+ sImageCount * sizeof(prelink_cache_image);
+	size_t entriesSize = sEntryCount * sizeof(uint32);
+	if (tableSize + entriesSize > kMaxCacheSize / 4)
+		return;
+
+	int directory = open_cache_directory(true);
+	if (directory < 0)
+		return;
+
+	char name[16];
+	char tempName[32];
+	get_cache_file_name(name, sizeof(name));
+	snprintf(tempName, sizeof(tempName), "%s.%" B_PRId32, name,
+		find_thread(NULL));
+
+	trim_cache_directory(directory, tableSize + entriesSize);
+
+	prelink_cache_header* header = (prelink_cache_header*)malloc(tableSize);
+	if (header == NULL) {
+		_kern_close(directory);
+		return;
+	}
+
+	memset(header, 0, tableSize);
+	header->magic = PRELINK_CACHE_MAGIC;
+	header->version = PRELINK_CACHE_VERSION;
+	header->image_count = sImageCount;
+	header->entry_count = sEntryCount;
+	strlcpy(header->program_path, sProgramImage->path,
+		sizeof(header->program_path));
+
+	prelink_cache_image* images = (prelink_cache_image*)(header + 1);
+	for (uint32 i = 0; i < sImageCount; i++) {
+		images[i].device = sImages[i].image->device;
+		images[i].node = sImages[i].image->node;
+		images[i].modification_time = sImages[i].image->modification_time;
+		images[i].symbol_count = sImages[i].symbol_count;
+	}
+
+	// write to a temporary file first, so that no team ever sees a partially
+	// written cache
+	int fd = _kern_open(directory, tempName, O_WRONLY | O_CREAT | O_TRUNC,
+		0600);
+	if (fd >= 0) {
+		bool written = _kern_write(fd, 0, header, tableSize)
+				== (ssize_t)tableSize
+			&& _kern_write(fd, tableSize, sEntries, entriesSize)
+				== (ssize_t)entriesSize;
+		_kern_close(fd);
+
+		if (!written
+			|| _kern_rename(directory, tempName, directory, name) != B_OK) {
+			_kern_unlink(directory, tempName);
+		}
+	}
+
+	_kern_close(directory);
+	free(header);
+}
+
+
+// #pragma mark -
+
+
+/*!	Prepares the cache for relocating the images of \a programImage, which
+	must have been loaded together with all of its dependencies. If there is
+	a valid cache file for the program, it is used to resolve symbols,
+	otherwise the resolved symbols are recorded.
+*/
+void
+prelink_cache_init(image_t* programImage)
+{
+	if (getenv("DISABLE_PRELINK_CACHE") != NULL)
+		return;
+
+	// Don't trust a cache file to redirect symbols of a set-id program.
+	if (_kern_getuid(false) != _kern_getuid(true)
+		|| _kern_getgid(false) != _kern_getgid(true)) {
+		return;
+	}
+
+	uint32 imageCount = count_loaded_images();
+	if (imageCount > kMaxImages)
+		return;
+
+	sImages = (CachedImage*)malloc(imageCount * sizeof(CachedImage));
+	if (sImages == NULL)
+		return;
+
+	uint32 entryCount = 0;
+	for (image_t* image = get_loaded_images().head; image != NULL;
+			image = image->next) {
+		uint32 symbolCount = image->symhash != NULL ? image->symhash[1] : 0;
+		if (symbolCount >= kMaxSymbols || image->device < 0) {
+			free(sImages);
+			sImages = NULL;
+			return;
+		}
+
+		sImages[sImageCount].image = image;
+		sImages[sImageCount].first_entry = entryCount;
+		sImages[sImageCount].symbol_count = symbolCount;
+		sImageCount++;
+		entryCount += symbolCount;
+	}
+
+	sProgramImage = programImage;
+	sEntryCount = entryCount;
+	sLastImage = 0;
+
+	if (map_cache_file())
+		return;
+
+	sEntries = (uint32*)calloc(entryCount, sizeof(uint32));
+	if (sEntries == NULL) {
+		free(sImages);
+		sImages = NULL;
+		sImageCount = 0;
+		return;
+	}
+
+	sRecording = true;
+}
+
+
+/*!	Writes the recorded symbols to the cache file, if the program has been
+	relocated successfully, and releases all resources of the cache.
+*/
+void
+prelink_cache_finish(bool success)
+{
+	if (sImages == NULL)
+		return;
+
+	if (sRecording) {
+		if (success)
+			write_cache_file();
+		free(sEntries);
+	} else
+		_kern_delete_area(sCacheArea);
+
+	free(sImages);
+	sImages = NULL;
+	sImageCount = 0;
+	sEntries = NULL;
+	sRecording = false;
+	sCacheArea = -1;
+}
+
+
+elf_sym*
+prelink_cache_lookup(image_t* image, uint32 symbolIndex,
+	image_t** _foundInImage)
+{
+	if (sEntries == NULL || sRecording)
+		return NULL;
+
+	CachedImage* cachedImage = find_cached_image(image);
+	if (cachedImage == NULL || symbolIndex >= cachedImage->symbol_count)
+		return NULL;
+
+	uint32 entry = sEntries[cachedImage->first_entry + symbolIndex];
+	uint32 imageIndex = (entry >> 24) - 1;
+	uint32 foundIndex = entry & (kMaxSymbols - 1);
+	if (entry == 0 || imageIndex >= sImageCount
+		|| foundIndex >= sImages[imageIndex].symbol_count) {
+		return NULL;
+	}
+
+	image_t* foundInImage = sImages[imageIndex].image;
+	*_foundInImage = foundInImage;
+	return &foundInImage->syms[foundIndex];
+}
+
+
+void
+prelink_cache_add(image_t* image, uint32 symbolIndex, image_t* foundInImage,
+	elf_sym* foundSymbol)
+{
+	if (!sRecording)
+		return;
+
+	CachedImage* cachedImage = find_cached_image(image);
+	if (cachedImage == NULL || symbolIndex >= cachedImage->symbol_count)
+		return;
+
+	for (uint32 i = 0; i < sImageCount; i++) {
+		if (sImages[i].image == foundInImage) {
+			sEntries[cachedImage->first_entry + symbolIndex]
+				= ((i + 1) << 24) | (foundSymbol - foundInImage->syms);
+			return;
+		}
+	}
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef PRELINK_CACHE_H
+#define PRELINK_CACHE_H
+
+
+#include <runtime_loader.h>
+
+
+void		prelink_cache_init(image_t* programImage);
+void		prelink_cache_finish(bool success);
+
+elf_sym*	prelink_cache_lookup(image_t* image, uint32 symbolIndex,
+				image_t** _foundInImage);
+void		prelink_cache_add(image_t* image, uint32 symbolIndex,
+				image_t* foundInImage, elf_sym* foundSymbol);
+
+
+#endif	// PRELINK_CACHE_H
@@ -0,0 +1,368 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Tests packagefs's PackageTOCCache in userland: that a recorded package
+	is replayed with the same callbacks, that a record is invalidated when
+	the package file changes, and that a damaged cache file is ignored
+	instead of being replayed.
+*/
+
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <package/hpkg/PackageEntry.h>
+#include <package/hpkg/PackageEntryAttribute.h>
+#include <package/hpkg/PackageInfoAttributeValue.h>
+#include <TypeConstants.h>
+
+#include <PackagesDirectoryDefs.h>
+
+#include "PackageTOCCache.h"
+
+
+using BPackageKit::BHPKG::BPackageEntry;
+using BPackageKit::BHPKG::BPackageEntryAttribute;
+using BPackageKit::BHPKG::BPackageInfoAttributeValue;
+
+
+static const char* const kPackageFileName = "test-1.0-1-x86_64.hpkg";
+static const char* const kCacheFileName
+	= PACKAGES_DIRECTORY_ADMIN_DIRECTORY "/packagefs_toc_cache";
+
+
+static int sFailures;
+
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+				#condition); \
+			sFailures++; \
+		} \
+	} while (false)
+
+
+/*!	Logs all callbacks into a string, so that two runs can be compared. */
+class LoggingContentHandler : public BPackageContentHandler {
+public:
+	LoggingContentHandler()
+		:
+		fLength(0),
+		fErrorOccurred(false)
+	{
+		fLog[0] = '\0';
+	}
+
+	const char* Log() const
+	{
+		return fLog;
+	}
+
+	bool ErrorOccurred() const
+	{
+		return fErrorOccurred;
+	}
+
+	virtual status_t HandleEntry(BPackageEntry* entry)
+	{
+		_Log("entry %s %#" B_PRIx32 " %ld.%ld %" B_PRIu64 " %s\n",
+			entry->Name(), entry->Mode(), (long)entry->ModifiedTime().tv_sec,
+			(long)entry->ModifiedTime().tv_nsec, entry->Data().Size(),
+			entry->SymlinkPath() != NULL ? entry->SymlinkPath() : "-");
+		return B_OK;
+	}
+
+	virtual status_t HandleEntryAttribute(BPackageEntry* entry,
+		BPackageEntryAttribute* attribute)
+	{
+		_Log("attribute %s %s %#" B_PRIx32 " %" B_PRIu64 "\n", entry->Name(),
+			attribute->Name(), attribute->Type(), attribute->Data().Size());
+		return B_OK;
+	}
+
+	virtual status_t HandleEntryDone(BPackageEntry* entry)
+	{
+		_Log("done %s\n", entry->Name());
+		return B_OK;
+	}
+
+	virtual status_t HandlePackageAttribute(
+		const BPackageInfoAttributeValue& value)
+	{
+		if (value.attributeID == BPackageKit::B_PACKAGE_INFO_NAME)
+			_Log("package name %s\n", value.string);
+		else
+			_Log("package attribute %d\n", (int)value.attributeID);
+		return B_OK;
+	}
+
+	virtual void HandleErrorOccurred()
+	{
+		fErrorOccurred = true;
+	}
+
+private:
+	void _Log(const char* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		int length = vsnprintf(fLog + fLength, sizeof(fLog) - fLength,
+			format, args);
+		va_end(args);
+
+		if (length > 0)
+			fLength = std::min(fLength + length, sizeof(fLog) - 1);
+	}
+
+private:
+	char	fLog[4096];
+	size_t	fLength;
+	bool	fErrorOccurred;
+};
+
+
+/*!	Makes the callbacks the package reader would make for a small package. */
+static void
+parse_package(BPackageContentHandler* handler)
+{
+	BPackageInfoAttributeValue name;
+	name.attributeID = BPackageKit::B_PACKAGE_INFO_NAME;
+	name.string = "test";
+	handler->HandlePackageAttribute(name);
+
+	BPackageEntry directory(NULL, "data");
+	directory.SetType(S_IFDIR);
+	directory.SetPermissions(0755);
+	directory.SetModifiedTime(0xfffffff0);
+	handler->HandleEntry(&directory);
+
+	BPackageEntry file(&directory, "file");
+	file.SetType(S_IFREG);
+	file.SetPermissions(0644);
+	file.SetModifiedTime(1234567890);
+	file.SetModifiedTimeNanos(42);
+	file.Data().SetData((uint8)3, "abc");
+	handler->HandleEntry(&file);
+
+	BPackageEntryAttribute attribute("BEOS:TYPE");
+	attribute.SetType(B_MIME_STRING_TYPE);
+	attribute.Data().SetData((uint64)4096, (uint64)8192);
+	handler->HandleEntryAttribute(&file, &attribute);
+	handler->HandleEntryDone(&file);
+
+	BPackageEntry link(&directory, "link");
+	link.SetType(S_IFLNK);
+	link.SetPermissions(0777);
+	link.SetSymlinkPath("file");
+	handler->HandleEntry(&link);
+	handler->HandleEntryDone(&link);
+
+	handler->HandleEntryDone(&directory);
+}
+
+
+static void
+write_package_file(int directoryFD, size_t size)
+{
+	int fd = openat(directoryFD, kPackageFileName,
+		O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror("creating package file");
+		exit(1);
+	}
+
+	char buffer[1024];
+	for (size_t i = 0; i < sizeof(buffer); i++)
+		buffer[i] = (char)i;
+
+	for (size_t written = 0; written < size; written += sizeof(buffer))
+		write(fd, buffer, std::min(sizeof(buffer), size - written));
+
+	close(fd);
+}
+
+
+static bool
+get_key(int directoryFD, PackageTOCCache::Key& key)
+{
+	int fd = openat(directoryFD, kPackageFileName, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	status_t error = PackageTOCCache::GetKey(fd, key);
+	close(fd);
+	return error == B_OK;
+}
+
+
+/*!	Records the package into a fresh cache and writes the cache file. */
+static void
+record_package(int directoryFD, LoggingContentHandler& handler)
+{
+	PackageTOCCache::Key key;
+	CHECK(get_key(directoryFD, key));
+
+	PackageTOCCache cache;
+	cache.Init(directoryFD);
+
+	CHECK(cache.Replay(kPackageFileName, key, &handler) == B_ENTRY_NOT_FOUND);
+
+	PackageTOCCache::Recorder recorder(&handler);
+	parse_package(&recorder);
+	CHECK(recorder.IsValid());
+
+	cache.AddRecord(kPackageFileName, key, recorder);
+	cache.Flush();
+}
+
+
+static status_t
+replay_package(int directoryFD, LoggingContentHandler& handler)
+{
+	PackageTOCCache::Key key;
+	CHECK(get_key(directoryFD, key));
+
+	PackageTOCCache cache;
+	cache.Init(directoryFD);
+	return cache.Replay(kPackageFileName, key, &handler);
+}
+
+
+static void
+test_replay(int directoryFD)
+{
+	write_package_file(directoryFD, 64 * 1024);
+
+	LoggingContentHandler parsed;
+	record_package(directoryFD, parsed);
+
+	LoggingContentHandler replayed;
+	CHECK(replay_package(directoryFD, replayed) == B_OK);
+	CHECK(!replayed.ErrorOccurred());
+	CHECK(strcmp(parsed.Log(), replayed.Log()) == 0);
+}
+
+
+static void
+test_invalidation(int directoryFD)
+{
+	write_package_file(directoryFD, 64 * 1024);
+
+	LoggingContentHandler parsed;
+	record_package(directoryFD, parsed);
+
+	// a package file of a different size is another package
+	write_package_file(directoryFD, 65 * 1024);
+
+	LoggingContentHandler replayed;
+	CHECK(replay_package(directoryFD, replayed) == B_ENTRY_NOT_FOUND);
+	CHECK(replayed.Log()[0] == '\0');
+
+	// so is one with the same size, but a changed header
+	write_package_file(directoryFD, 64 * 1024);
+	record_package(directoryFD, parsed);
+
+	int fd = openat(directoryFD, kPackageFileName, O_WRONLY);
+	CHECK(fd >= 0);
+	pwrite(fd, "x", 1, 8);
+	close(fd);
+
+	CHECK(replay_package(directoryFD, replayed) == B_ENTRY_NOT_FOUND);
+	CHECK(replayed.Log()[0] == '\0');
+}
+
+
+static void
+test_corrupt_cache(int directoryFD)
+{
+	write_package_file(directoryFD, 64 * 1024);
+
+	LoggingContentHandler parsed;
+	record_package(directoryFD, parsed);
+
+	struct stat st;
+	CHECK(fstatat(directoryFD, kCacheFileName, &st, 0) == 0);
+
+	// flip a byte in the record data -- the record's checksum must catch it
+	int fd = openat(directoryFD, kCacheFileName, O_RDWR);
+	CHECK(fd >= 0);
+	char byte;
+	pread(fd, &byte, 1, st.st_size - 16);
+	byte ^= 0x55;
+	pwrite(fd, &byte, 1, st.st_size - 16);
+	close(fd);
+
+	LoggingContentHandler replayed;
+	CHECK(replay_package(directoryFD, replayed) == B_ENTRY_NOT_FOUND);
+	CHECK(replayed.Log()[0] == '\0');
+
+	// a truncated cache file
+	record_package(directoryFD, parsed);
+	fd = openat(directoryFD, kCacheFileName, O_RDWR);
+	CHECK(fd >= 0);
+	CHECK(ftruncate(fd, st.st_size / 2) == 0);
+	close(fd);
+
+	CHECK(replay_package(directoryFD, replayed) == B_ENTRY_NOT_FOUND);
+	CHECK(replayed.Log()[0] == '\0');
+
+	// garbage
+	fd = openat(directoryFD, kCacheFileName, O_WRONLY | O_TRUNC);
+	CHECK(fd >= 0);
+	char garbage[512];
+	memset(garbage, 0xa5, sizeof(garbage));
+	write(fd, garbage, sizeof(garbage));
+	close(fd);
+
+	CHECK(replay_package(directoryFD, replayed) == B_ENTRY_NOT_FOUND);
+	CHECK(replayed.Log()[0] == '\0');
+}
+
+
+int
+main(int argc, char** argv)
+{
+	char path[] = "/tmp/package_toc_cache_test-XXXXXX";
+	if (mkdtemp(path) == NULL) {
+		perror("creating test directory");
+		return 1;
+	}
+
+	int directoryFD = open(path, O_RDONLY);
+	if (directoryFD < 0
+		|| mkdirat(directoryFD, PACKAGES_DIRECTORY_ADMIN_DIRECTORY, 0755)
+			!= 0) {
+		perror("creating administrative directory");
+		return 1;
+	}
+
+	test_replay(directoryFD);
+	test_invalidation(directoryFD);
+	test_corrupt_cache(directoryFD);
+
+	unlinkat(directoryFD, kCacheFileName, 0);
+	unlinkat(directoryFD, kPackageFileName, 0);
+	unlinkat(directoryFD, PACKAGES_DIRECTORY_ADMIN_DIRECTORY, AT_REMOVEDIR);
+	close(directoryFD);
+	rmdir(path);
+
+	if (sFailures > 0) {
+		printf("%d checks failed\n", sFailures);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Sends UDP datagrams over many flows via the loopback interface, and
+	checks that they are processed by more than one of the "loop consumer"
+	threads of the network stack, by comparing the CPU time the consumers
+	used.
+*/
+
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const int32 kFlowCount = 16;
+static const int32 kPacketsPerFlow = 20000;
+static const int32 kMaxConsumers = 8;
+
+
+struct consumer {
+	thread_id	thread;
+	bigtime_t	time;
+};
+
+
+static int32
+get_consumers(consumer* consumers)
+{
+	int32 count = 0;
+	int32 cookie = 0;
+	thread_info info;
+	while (count < kMaxConsumers
+		&& get_next_thread_info(B_SYSTEM_TEAM, &cookie, &info) == B_OK) {
+		if (strncmp(info.name, "loop", 4) != 0
+			|| strstr(info.name, " consumer ") == NULL) {
+			continue;
+		}
+
+		consumers[count].thread = info.thread;
+		consumers[count].time = info.kernel_time;
+		count++;
+	}
+
+	return count;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	consumer consumers[kMaxConsumers];
+	int32 consumerCount = get_consumers(consumers);
+	if (consumerCount < 2) {
+		printf("The loopback interface has %" B_PRId32 " consumer(s), "
+			"nothing to test.\n", consumerCount);
+		return 0;
+	}
+
+	int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	socklen_t addressLength = sizeof(address);
+	if (receiver < 0
+		|| bind(receiver, (sockaddr*)&address, sizeof(address)) != 0
+		|| getsockname(receiver, (sockaddr*)&address, &addressLength) != 0) {
+		perror("creating receiver socket");
+		return 1;
+	}
+
+	// every sender has its own port, and is therefore a flow of its own
+	int senders[kFlowCount];
+	for (int32 i = 0; i < kFlowCount; i++) {
+		senders[i] = socket(AF_INET, SOCK_DGRAM, 0);
+		if (senders[i] < 0
+			|| connect(senders[i], (sockaddr*)&address, sizeof(address))
+				!= 0) {
+			perror("creating sender socket");
+			return 1;
+		}
+	}
+
+	char buffer[64];
+	memset(buffer, 0, sizeof(buffer));
+
+	for (int32 i = 0; i < kPacketsPerFlow; i++) {
+		for (int32 j = 0; j < kFlowCount; j++)
+			send(senders[j], buffer, sizeof(buffer), 0);
+
+		// the datagrams are dropped once the receive buffer is full, but
+		// they have been processed by a consumer before
+		while (recv(receiver, buffer, sizeof(buffer), MSG_DONTWAIT) > 0)
+			;
+	}
+
+	for (int32 i = 0; i < kFlowCount; i++)
+		close(senders[i]);
+	close(receiver);
+
+	// give the consumers some time to process what is still queued
+	snooze(500000);
+
+	bigtime_t total = 0;
+	for (int32 i = 0; i < consumerCount; i++) {
+		thread_info info;
+		if (get_thread_info(consumers[i].thread, &info) != B_OK) {
+			fprintf(stderr, "consumer thread %" B_PRId32 " is gone\n",
+				consumers[i].thread);
+			return 1;
+		}
+
+		consumers[i].time = info.kernel_time - consumers[i].time;
+		total += consumers[i].time;
+	}
+
+	// count the consumers that got a fair share of the work
+	int32 busyCount = 0;
+	for (int32 i = 0; i < consumerCount; i++) {
+		printf("consumer %" B_PRId32 ": %" B_PRIdBIGTIME " usecs\n",
+			consumers[i].thread, consumers[i].time);
+		if (consumers[i].time * 4 * consumerCount >= total)
+			busyCount++;
+	}
+
+	if (busyCount < 2) {
+		printf("All %" B_PRId32 " flows were processed by a single "
+			"consumer.\n", kFlowCount);
+		return 1;
+	}
+
+	printf("%" B_PRId32 " flows were processed by %" B_PRId32 " of %" B_PRId32
+		" consumers.\n", kFlowCount, busyCount, consumerCount);
+	return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Serves a file over a local TCP connection, once by reading it into a
+	buffer and writing that to the socket, and once using sendfile(), and
+	reports throughput and CPU time per megabyte of both.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const size_t kDefaultFileSize = 64 * 1024 * 1024;
+static const int kDefaultIterations = 8;
+static const size_t kBufferSize = 64 * 1024;
+
+
+static void
+die(const char* message)
+{
+	fprintf(stderr, "sendfile_bench: %s: %s\n", message, strerror(errno));
+	exit(1);
+}
+
+
+static bigtime_t
+cpu_time()
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		die("getrusage() failed");
+
+	return (bigtime_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+			* 1000000
+		+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+
+static void
+create_file(const char* path, size_t size)
+{
+	int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	if (fd < 0)
+		die("could not create test file");
+
+	char buffer[kBufferSize];
+	for (size_t i = 0; i < sizeof(buffer); i++)
+		buffer[i] = (char)i;
+
+	while (size > 0) {
+		size_t bytes = size < sizeof(buffer) ? size : sizeof(buffer);
+		if (write(fd, buffer, bytes) != (ssize_t)bytes)
+			die("could not write test file");
+		size -= bytes;
+	}
+
+	close(fd);
+}
+
+
+static void
+drain(int socket)
+{
+	char buffer[kBufferSize];
+	while (true) {
+		ssize_t bytesRead = recv(socket, buffer, sizeof(buffer), 0);
+		if (bytesRead < 0)
+			die("recv() failed");
+		if (bytesRead == 0)
+			break;
+	}
+}
+
+
+static int
+connect_to(const sockaddr_in& address)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		die("could not create client socket");
+
+	if (connect(fd, (const sockaddr*)&address, sizeof(address)) != 0)
+		die("connect() failed");
+
+	return fd;
+}
+
+
+static void
+serve_copy(int socket, int fd, off_t size)
+{
+	char buffer[kBufferSize];
+	off_t offset = 0;
+
+	while (offset < size) {
+		ssize_t bytesRead = pread(fd, buffer, sizeof(buffer), offset);
+		if (bytesRead <= 0)
+			die("read() failed");
+
+		for (ssize_t written = 0; written < bytesRead;) {
+			ssize_t bytes = send(socket, buffer + written, bytesRead - written,
+				0);
+			if (bytes < 0)
+				die("send() failed");
+			written += bytes;
+		}
+
+		offset += bytesRead;
+	}
+}
+
+
+static void
+serve_sendfile(int socket, int fd, off_t size)
+{
+	off_t offset = 0;
+
+	while (offset < size) {
+		ssize_t bytes = sendfile(socket, fd, &offset, size - offset);
+		if (bytes <= 0)
+			die("sendfile() failed");
+	}
+}
+
+
+static void
+run(const char* name, int listener, const sockaddr_in& address,
+	const char* path, off_t size, int iterations,
+	void (*serve)(int socket, int fd, off_t size))
+{
+	pid_t child = fork();
+	if (child < 0)
+		die("fork() failed");
+
+	if (child == 0) {
+		for (int i = 0; i < iterations; i++) {
+			int fd = connect_to(address);
+			drain(fd);
+			close(fd);
+		}
+		exit(0);
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		die("could not open test file");
+
+	// warm up the file cache
+	char buffer[kBufferSize];
+	while (read(fd, buffer, sizeof(buffer)) > 0)
+		;
+
+	bigtime_t startTime = system_time();
+	bigtime_t startCPU = cpu_time();
+
+	for (int i = 0; i < iterations; i++) {
+		int socket = accept(listener, NULL, NULL);
+		if (socket < 0)
+			die("accept() failed");
+
+		serve(socket, fd, size);
+		close(socket);
+	}
+
+	bigtime_t elapsed = system_time() - startTime;
+	bigtime_t cpu = cpu_time() - startCPU;
+
+	int childStatus;
+	waitpid(child, &childStatus, 0);
+	close(fd);
+
+	double megabytes = (double)size * iterations / (1024 * 1024);
+	printf("%-10s %8.1f MB/s, %8.1f us CPU/MB\n", name,
+		megabytes / ((double)elapsed / 1000000), (double)cpu / megabytes);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const char* path = "/tmp/sendfile_bench.data";
+	size_t fileSize = kDefaultFileSize;
+	int iterations = kDefaultIterations;
+	bool createFile = true;
+
+	if (argc > 1) {
+		path = argv[1];
+		createFile = false;
+	}
+	if (argc > 2)
+		iterations = atoi(argv[2]);
+
+	if (createFile)
+		create_file(path, fileSize);
+	else {
+		struct stat stat;
+		if (::stat(path, &stat) != 0)
+			die("could not stat file");
+		fileSize = stat.st_size;
+	}
+
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0)
+		die("could not create listener socket");
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	socklen_t addressLength = sizeof(address);
+	if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0
+		|| getsockname(listener, (sockaddr*)&address, &addressLength) != 0
+		|| listen(listener, 1) != 0) {
+		die("could not set up listener socket");
+	}
+
+	printf("serving %s (%zu bytes) %d times over %s:%d\n", path, fileSize,
+		iterations, "localhost", ntohs(address.sin_port));
+
+	run("read/send", listener, address, path, fileSize, iterations,
+		&serve_copy);
+	run("sendfile", listener, address, path, fileSize, iterations,
+		&serve_sendfile);
+
+	close(listener);
+	if (createFile)
+		unlink(path);
+
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Tests the TCP congestion control algorithms: the window changes of Reno
+	in slow start, congestion avoidance and recovery, and the reduction and
+	concave growth of CUBIC.
+	The CUBIC window depends on the time since the last congestion event;
+	the checks are made right after it, and leave enough room for a slow
+	machine.
+*/
+
+
+#include "CongestionControl.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+static const uint32 kMaxSegmentSize = 1000;
+static const bigtime_t kRoundTripTime = 100000;
+
+
+static int sFailures;
+
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+				#condition); \
+			sFailures++; \
+		} \
+	} while (false)
+
+
+static void
+test_create()
+{
+	TCPCongestionControl* control = create_congestion_control("cubic");
+	CHECK(control != NULL && strcmp(control->Name(), "cubic") == 0);
+	delete control;
+
+	control = create_congestion_control("reno");
+	CHECK(control != NULL && strcmp(control->Name(), "reno") == 0);
+	delete control;
+
+	control = create_congestion_control("newreno");
+	CHECK(control != NULL && strcmp(control->Name(), "reno") == 0);
+	delete control;
+
+	control = create_congestion_control(kDefaultCongestionControl);
+	CHECK(control != NULL);
+	delete control;
+
+	CHECK(create_congestion_control("unknown") == NULL);
+}
+
+
+static void
+test_reno()
+{
+	RenoCongestionControl reno;
+	reno.Init(kMaxSegmentSize, 2 * kMaxSegmentSize, 10 * kMaxSegmentSize);
+	CHECK(reno.InSlowStart());
+
+	// slow start grows by at most one segment per acknowledgement
+	reno.Acknowledged(500, 2000, kRoundTripTime);
+	CHECK(reno.Window() == 2500);
+	reno.Acknowledged(5000, 2000, kRoundTripTime);
+	CHECK(reno.Window() == 3500);
+
+	while (reno.InSlowStart())
+		reno.Acknowledged(kMaxSegmentSize, 0, kRoundTripTime);
+	CHECK(reno.Window() == 10500);
+
+	// congestion avoidance grows by one segment per window
+	uint32 window = reno.Window();
+	for (uint32 acked = 0; acked < window; acked += kMaxSegmentSize)
+		reno.Acknowledged(kMaxSegmentSize, window, kRoundTripTime);
+	CHECK(reno.Window() > window + kMaxSegmentSize * 9 / 10);
+	CHECK(reno.Window() <= window + kMaxSegmentSize);
+
+	reno.EnterRecovery(20000);
+	CHECK(reno.SlowStartThreshold() == 10000);
+	CHECK(reno.Window() == 10000);
+
+	// NewReno window inflation during recovery
+	reno.InflateWindow(3 * kMaxSegmentSize);
+	CHECK(reno.Window() == 13000);
+	reno.DeflateWindow(2 * kMaxSegmentSize);
+	CHECK(reno.Window() == 11000);
+	reno.DeflateWindow(20000);
+	CHECK(reno.Window() == kMaxSegmentSize);
+
+	reno.ExitRecovery();
+	CHECK(reno.Window() == 10000);
+	CHECK(!reno.InSlowStart());
+
+	// the slow start threshold never drops below two segments
+	reno.RetransmitTimeout(kMaxSegmentSize);
+	CHECK(reno.SlowStartThreshold() == 2 * kMaxSegmentSize);
+	CHECK(reno.Window() == kMaxSegmentSize);
+	CHECK(reno.InSlowStart());
+}
+
+
+static void
+test_cubic_reduction()
+{
+	CubicCongestionControl cubic;
+	cubic.Init(kMaxSegmentSize, 100 * kMaxSegmentSize, 50 * kMaxSegmentSize);
+	CHECK(!cubic.InSlowStart());
+
+	// beta is 0.7, independent of the flight size
+	cubic.EnterRecovery(10 * kMaxSegmentSize);
+	CHECK(cubic.SlowStartThreshold() == 70000);
+	CHECK(cubic.Window() == 70000);
+
+	cubic.ExitRecovery();
+	CHECK(cubic.Window() == 70000);
+
+	cubic.RetransmitTimeout(70000);
+	CHECK(cubic.SlowStartThreshold() == 49000);
+	CHECK(cubic.Window() == kMaxSegmentSize);
+	CHECK(cubic.InSlowStart());
+
+	cubic.Init(kMaxSegmentSize, 2 * kMaxSegmentSize, 50 * kMaxSegmentSize);
+	cubic.EnterRecovery(2 * kMaxSegmentSize);
+	CHECK(cubic.SlowStartThreshold() == 2 * kMaxSegmentSize);
+}
+
+
+static void
+test_cubic_growth()
+{
+	CubicCongestionControl cubic;
+	cubic.Init(kMaxSegmentSize, 100 * kMaxSegmentSize, 50 * kMaxSegmentSize);
+
+	cubic.EnterRecovery(100 * kMaxSegmentSize);
+	CHECK(cubic.Window() == 70000);
+
+	// W_cubic(RTT) is about 72 segments: right after the reduction, the
+	// window grows quickly towards W_max, but stays well below it
+	cubic.Acknowledged(cubic.Window(), cubic.Window(), kRoundTripTime);
+	CHECK(cubic.Window() > 71500);
+	CHECK(cubic.Window() < 75000);
+
+	uint32 window = cubic.Window();
+	for (int32 i = 0; i < 10; i++) {
+		cubic.Acknowledged(cubic.Window(), cubic.Window(), kRoundTripTime);
+		CHECK(cubic.Window() >= window);
+		CHECK(cubic.Window() <= window + window / 2);
+		window = cubic.Window();
+	}
+	CHECK(window < 100 * kMaxSegmentSize);
+}
+
+
+static void
+test_cubic_fast_convergence()
+{
+	CubicCongestionControl cubic;
+	cubic.Init(kMaxSegmentSize, 100 * kMaxSegmentSize, 50 * kMaxSegmentSize);
+
+	cubic.EnterRecovery(100 * kMaxSegmentSize);
+	CHECK(cubic.Window() == 70000);
+
+	// a second loss below the previous W_max lowers W_max to
+	// 70 * 0.85 = 59.5 segments, and W_cubic(RTT) to about 50.0 segments;
+	// without fast convergence, it would be at 70, and 50.6 segments
+	cubic.EnterRecovery(70 * kMaxSegmentSize);
+	CHECK(cubic.Window() == 49000);
+
+	cubic.Acknowledged(cubic.Window(), cubic.Window(), kRoundTripTime);
+	CHECK(cubic.Window() > 49500);
+	CHECK(cubic.Window() < 50300);
+}
+
+
+int
+main()
+{
+	test_create();
+	test_reno();
+	test_cubic_reduction();
+	test_cubic_growth();
+	test_cubic_fast_convergence();
+
+	if (sFailures > 0) {
+		printf("%d checks failed\n", sFailures);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
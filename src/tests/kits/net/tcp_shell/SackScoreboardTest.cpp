@@ -0,0 +1,216 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Tests the TCP SackScoreboard: merging of SACK blocks, cumulative
+	acknowledgements, hole detection, and the RFC 6675 loss detection.
+*/
+
+
+#include "SackScoreboard.h"
+
+#include <stdio.h>
+
+
+static const uint32 kMaxSegmentSize = 1000;
+
+
+static int sFailures;
+
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+				#condition); \
+			sFailures++; \
+		} \
+	} while (false)
+
+
+static void
+test_add()
+{
+	SackScoreboard scoreboard;
+	CHECK(scoreboard.IsEmpty());
+
+	scoreboard.Add(100, 200);
+	scoreboard.Add(300, 400);
+	CHECK(scoreboard.SackedBytes() == 200);
+	CHECK(!scoreboard.IsSacked(250));
+
+	// fills the gap, and merges all into a single block
+	scoreboard.Add(200, 300);
+	CHECK(scoreboard.SackedBytes() == 300);
+	CHECK(scoreboard.IsSacked(250));
+	CHECK(scoreboard.HighestSacked() == 400);
+
+	// already known
+	scoreboard.Add(150, 350);
+	CHECK(scoreboard.SackedBytes() == 300);
+
+	// overlaps both ends
+	scoreboard.Add(50, 450);
+	CHECK(scoreboard.SackedBytes() == 400);
+	CHECK(scoreboard.HighestSacked() == 450);
+	CHECK(!scoreboard.IsSacked(49));
+	CHECK(scoreboard.IsSacked(50));
+	CHECK(!scoreboard.IsSacked(450));
+
+	// empty blocks are ignored
+	scoreboard.Add(500, 500);
+	CHECK(scoreboard.SackedBytes() == 400);
+
+	scoreboard.Reset();
+	CHECK(scoreboard.IsEmpty());
+	CHECK(scoreboard.SackedBytes() == 0);
+}
+
+
+static void
+test_full()
+{
+	SackScoreboard scoreboard;
+
+	for (uint32 i = 0; i < TCP_SACK_SCOREBOARD_SIZE; i++)
+		scoreboard.Add(i * 200 + 100, i * 200 + 200);
+
+	CHECK(scoreboard.SackedBytes() == TCP_SACK_SCOREBOARD_SIZE * 100);
+
+	// a block above all others is dropped
+	uint32 highest = TCP_SACK_SCOREBOARD_SIZE * 200;
+	scoreboard.Add(highest + 100, highest + 200);
+	CHECK(scoreboard.SackedBytes() == TCP_SACK_SCOREBOARD_SIZE * 100);
+	CHECK(scoreboard.HighestSacked() == highest);
+
+	// a lower one replaces the highest block
+	scoreboard.Add(0, 50);
+	CHECK(scoreboard.SackedBytes() == TCP_SACK_SCOREBOARD_SIZE * 100 - 50);
+	CHECK(scoreboard.HighestSacked() == highest - 200);
+	CHECK(scoreboard.IsSacked(0));
+}
+
+
+static void
+test_remove_until()
+{
+	SackScoreboard scoreboard;
+	scoreboard.Add(100, 200);
+	scoreboard.Add(300, 400);
+
+	scoreboard.RemoveUntil(150);
+	CHECK(scoreboard.SackedBytes() == 150);
+	CHECK(!scoreboard.IsSacked(149));
+	CHECK(scoreboard.IsSacked(150));
+
+	scoreboard.RemoveUntil(300);
+	CHECK(scoreboard.SackedBytes() == 100);
+	CHECK(!scoreboard.IsSacked(150));
+
+	scoreboard.RemoveUntil(400);
+	CHECK(scoreboard.IsEmpty());
+	CHECK(scoreboard.SackedBytes() == 0);
+}
+
+
+static void
+test_next_hole()
+{
+	SackScoreboard scoreboard;
+	tcp_sequence start, end;
+
+	CHECK(!scoreboard.NextHole(1000, start, end));
+
+	scoreboard.Add(2000, 3000);
+	scoreboard.Add(4000, 5000);
+
+	CHECK(scoreboard.NextHole(1000, start, end));
+	CHECK(start == 1000 && end == 2000);
+
+	CHECK(scoreboard.NextHole(1500, start, end));
+	CHECK(start == 1500 && end == 2000);
+
+	// starting within a block skips it
+	CHECK(scoreboard.NextHole(2500, start, end));
+	CHECK(start == 3000 && end == 4000);
+
+	CHECK(scoreboard.NextHole(3000, start, end));
+	CHECK(start == 3000 && end == 4000);
+
+	// nothing has been SACKed above the last block
+	CHECK(!scoreboard.NextHole(4500, start, end));
+	CHECK(!scoreboard.NextHole(5000, start, end));
+}
+
+
+static void
+test_sacked_bytes_above()
+{
+	SackScoreboard scoreboard;
+	scoreboard.Add(2000, 3000);
+	scoreboard.Add(4000, 5000);
+
+	CHECK(scoreboard.SackedBytesAbove(1000) == 2000);
+	CHECK(scoreboard.SackedBytesAbove(2499) == 1500);
+	CHECK(scoreboard.SackedBytesAbove(3500) == 1000);
+	CHECK(scoreboard.SackedBytesAbove(5000) == 0);
+}
+
+
+static void
+test_is_lost()
+{
+	SackScoreboard scoreboard;
+	CHECK(!scoreboard.IsLost(1000, kMaxSegmentSize));
+
+	// two segments in one block are not enough
+	scoreboard.Add(2000, 4000);
+	CHECK(!scoreboard.IsLost(1000, kMaxSegmentSize));
+
+	// but three are
+	scoreboard.Add(4000, 5000);
+	CHECK(scoreboard.IsLost(1000, kMaxSegmentSize));
+
+	// only what is above the sequence counts
+	CHECK(!scoreboard.IsLost(3000, kMaxSegmentSize));
+	CHECK(!scoreboard.IsLost(5000, kMaxSegmentSize));
+
+	// three small segments, each in its own block, are enough
+	scoreboard.Reset();
+	scoreboard.Add(2000, 2100);
+	scoreboard.Add(3000, 3100);
+	CHECK(!scoreboard.IsLost(1000, kMaxSegmentSize));
+	scoreboard.Add(4000, 4100);
+	CHECK(scoreboard.IsLost(1000, kMaxSegmentSize));
+	CHECK(!scoreboard.IsLost(2100, kMaxSegmentSize));
+
+	// a partial segment counts as a segment of its own, even if it is
+	// contiguous to a full one
+	scoreboard.Reset();
+	scoreboard.Add(2000, 3500);
+	CHECK(!scoreboard.IsLost(1000, kMaxSegmentSize));
+	scoreboard.Add(4000, 4100);
+	CHECK(scoreboard.IsLost(1000, kMaxSegmentSize));
+}
+
+
+int
+main()
+{
+	test_add();
+	test_full();
+	test_remove_until();
+	test_next_hole();
+	test_sacked_bytes_above();
+	test_is_lost();
+
+	if (sFailures > 0) {
+		printf("%d checks failed\n", sFailures);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -226,6 +226,7 @@ static net_stack_module_info gNetStackModule = {
 	NULL, // device_link_changed,
 	NULL, // device_removed,
 	NULL, // device_enqueue_buffer,
+	NULL, // device_flow_hash,
 
 	notify_socket,
 
@@ -671,6 +672,7 @@ net_socket_module_info gNetSocketModule = {
 	NULL, // listen,
 	NULL, // receive,
 	NULL, // send,
+	NULL, // send_external,
 	NULL, // setsockopt,
 	NULL, // shutdown,
 	NULL, // socketpair
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how long it takes to launch a program and wait for it to exit,
+	with immediate and lazy binding, and with and without the runtime loader's
+	prelink cache. Pass a program that
+	links against many (C++) libraries and exits right away, for example
+	"launchbench /bin/pkgman".
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+extern char** environ;
+
+
+static const int32 kIterations = 50;
+
+
+static void
+die(const char* message, int error)
+{
+	fprintf(stderr, "launchbench: %s: %s\n", message, strerror(error));
+	exit(1);
+}
+
+
+static void
+set_variable(const char* name, bool set)
+{
+	if (set)
+		setenv(name, "1", 1);
+	else
+		unsetenv(name);
+}
+
+
+static bigtime_t
+measure(char* const* argv, bool bindNow, bool useCache)
+{
+	set_variable("LD_BIND_NOW", bindNow);
+	set_variable("DISABLE_PRELINK_CACHE", !useCache);
+
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init(&fileActions);
+	posix_spawn_file_actions_addopen(&fileActions, STDOUT_FILENO, "/dev/null",
+		O_WRONLY, 0);
+	posix_spawn_file_actions_addopen(&fileActions, STDERR_FILENO, "/dev/null",
+		O_WRONLY, 0);
+
+	bigtime_t total = 0;
+
+	// the first launch creates the cache, and is not counted
+	for (int32 i = -1; i < kIterations; i++) {
+		bigtime_t startTime = system_time();
+
+		pid_t child;
+		int error = posix_spawn(&child, argv[0], &fileActions, NULL, argv,
+			environ);
+		if (error != 0)
+			die("could not launch program", error);
+
+		int status;
+		if (waitpid(child, &status, 0) != child)
+			die("waitpid() failed", errno);
+
+		if (i >= 0)
+			total += system_time() - startTime;
+	}
+
+	posix_spawn_file_actions_destroy(&fileActions);
+	return total / kIterations;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <program> [<arguments> ...]\n", argv[0]);
+		return 1;
+	}
+
+	bigtime_t bindNow = measure(argv + 1, true, false);
+	bigtime_t lazy = measure(argv + 1, false, false);
+	bigtime_t cached = measure(argv + 1, false, true);
+
+	printf("%s:\n", argv[1]);
+	printf("  immediate binding:         %8" B_PRId64 " us\n", bindNow);
+	printf("  lazy binding:              %8" B_PRId64 " us\n", lazy);
+	printf("  lazy binding, with cache:  %8" B_PRId64 " us\n", cached);
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the throughput of malloc() and free() with a growing number of
+	threads, and the memory the team uses afterwards. Most allocations are
+	small and short-lived, and some are freed by another thread than the one
+	that allocated them, like in a compiler or a web browser. Run it once with
+	each libroot allocator (see HAIKU_LIBROOT_MALLOC) to compare them.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const int32 kMaxThreads = 16;
+static const int32 kIterations = 1000000;
+static const int32 kSlotCount = 1024;
+static const int32 kHandOffSlotCount = 256;
+
+
+static void* sHandOffSlots[kHandOffSlotCount];
+
+
+static inline uint32
+next_random(uint32& state)
+{
+	state = state * 1103515245 + 12345;
+	return state >> 8;
+}
+
+
+static inline void*
+exchange_pointer(void** pointer, void* newValue)
+{
+#if B_HAIKU_64_BIT
+	return (void*)atomic_get_and_set64((int64*)pointer, (int64)newValue);
+#else
+	return (void*)atomic_get_and_set((int32*)pointer, (int32)newValue);
+#endif
+}
+
+
+static size_t
+random_size(uint32& state)
+{
+	uint32 kind = next_random(state) % 100;
+	if (kind < 75)
+		return next_random(state) % 128 + 1;
+	if (kind < 95)
+		return next_random(state) % 4096 + 1;
+	if (kind < 99)
+		return next_random(state) % 65536 + 1;
+	return next_random(state) % (1024 * 1024) + 1;
+}
+
+
+static status_t
+worker(void* data)
+{
+	uint32 state = (uint32)(addr_t)data;
+	void* slots[kSlotCount];
+	memset(slots, 0, sizeof(slots));
+
+	for (int32 i = 0; i < kIterations; i++) {
+		int32 index = next_random(state) % kSlotCount;
+		if (slots[index] == NULL) {
+			size_t size = random_size(state);
+			slots[index] = malloc(size);
+			if (slots[index] == NULL) {
+				fprintf(stderr, "mallocbench: out of memory\n");
+				exit(1);
+			}
+			// touch the memory like a real application would
+			memset(slots[index], 0, size < 64 ? size : 64);
+		} else if (next_random(state) % 16 == 0) {
+			// pass it to another thread, which frees it
+			int32 handOff = next_random(state) % kHandOffSlotCount;
+			free(exchange_pointer(&sHandOffSlots[handOff], slots[index]));
+			slots[index] = NULL;
+		} else {
+			free(slots[index]);
+			slots[index] = NULL;
+		}
+	}
+
+	for (int32 i = 0; i < kSlotCount; i++)
+		free(slots[i]);
+
+	return 0;
+}
+
+
+static size_t
+team_memory()
+{
+	size_t size = 0;
+	ssize_t cookie = 0;
+	area_info info;
+	while (get_next_area_info(B_CURRENT_TEAM, &cookie, &info) == B_OK) {
+		if ((info.protection & B_STACK_AREA) == 0)
+			size += info.ram_size;
+	}
+
+	return size;
+}
+
+
+static bigtime_t
+measure(int32 threadCount)
+{
+	thread_id threads[kMaxThreads];
+
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < threadCount; i++) {
+		threads[i] = spawn_thread(&worker, "malloc worker", B_NORMAL_PRIORITY,
+			(void*)(addr_t)(i + 1));
+		if (threads[i] < 0) {
+			fprintf(stderr, "mallocbench: could not spawn thread: %s\n",
+				strerror(threads[i]));
+			exit(1);
+		}
+		resume_thread(threads[i]);
+	}
+
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	bigtime_t time = system_time() - startTime;
+
+	for (int32 i = 0; i < kHandOffSlotCount; i++) {
+		free(sHandOffSlots[i]);
+		sHandOffSlots[i] = NULL;
+	}
+
+	return time;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 maxThreads = argc > 1 ? atoi(argv[1]) : 8;
+	if (maxThreads < 1 || maxThreads > kMaxThreads) {
+		fprintf(stderr, "usage: %s [<max threads>]\n", argv[0]);
+		return 1;
+	}
+
+	printf("threads      time   ops/thread/ms   memory after\n");
+
+	for (int32 threadCount = 1; threadCount <= maxThreads;
+			threadCount *= 2) {
+		bigtime_t time = measure(threadCount);
+		printf("%7" B_PRId32 " %7" B_PRId64 " ms %15" B_PRId64 " %11"
+			B_PRIuSIZE " KB\n", threadCount, time / 1000,
+			(int64)kIterations * 1000 / time,
+			team_memory() / 1024);
+	}
+
+	return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures buffered stdio with the workloads of a typical command line
+	tool: writing a log file with fprintf(), and parsing a text file line by
+	line and character by character. Every workload runs twice: once while
+	the team has only a single thread, and once after a second thread has
+	been spawned, which forces the streams to be locked for real.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const int32 kLogLines = 1000000;
+
+
+static const char* sPath;
+static volatile long sSink;
+
+
+static void
+write_log()
+{
+	FILE* file = fopen(sPath, "w");
+	if (file == NULL) {
+		fprintf(stderr, "stdiobench: could not create %s\n", sPath);
+		exit(1);
+	}
+
+	for (int32 i = 0; i < kLogLines; i++) {
+		fprintf(file, "%" B_PRId32 " %s: request %" B_PRId32 " took %d us, "
+			"status %#x\n", i, i % 7 == 0 ? "warning" : "info", i * 31,
+			(int)(i % 1000), i % 3 == 0 ? 0 : 0x80000001);
+	}
+
+	fclose(file);
+}
+
+
+static void
+parse_lines()
+{
+	FILE* file = fopen(sPath, "r");
+	if (file == NULL) {
+		fprintf(stderr, "stdiobench: could not open %s\n", sPath);
+		exit(1);
+	}
+
+	char line[256];
+	long sum = 0;
+	while (fgets(line, sizeof(line), file) != NULL) {
+		char* end;
+		sum += strtol(line, &end, 10);
+		sum += strlen(end);
+	}
+
+	fclose(file);
+	sSink = sum;
+}
+
+
+static void
+count_words()
+{
+	FILE* file = fopen(sPath, "r");
+	if (file == NULL) {
+		fprintf(stderr, "stdiobench: could not open %s\n", sPath);
+		exit(1);
+	}
+
+	long words = 0;
+	bool inWord = false;
+	int c;
+	while ((c = getc(file)) != EOF) {
+		bool space = c == ' ' || c == '\n';
+		if (inWord && space)
+			words++;
+		inWord = !space;
+	}
+
+	fclose(file);
+	sSink = words;
+}
+
+
+static const struct {
+	const char*	name;
+	void		(*function)();
+} kTests[] = {
+	{ "fprintf log", &write_log },
+	{ "fgets/strtol", &parse_lines },
+	{ "getc words", &count_words },
+};
+
+
+static void
+run_tests(const char* mode)
+{
+	for (size_t i = 0; i < B_COUNT_OF(kTests); i++) {
+		bigtime_t startTime = system_time();
+		kTests[i].function();
+		bigtime_t time = system_time() - startTime;
+
+		printf("%-14s %-16s %7" B_PRId64 " ms %9" B_PRId64 " lines/ms\n",
+			kTests[i].name, mode, time / 1000,
+			time > 0 ? (int64)kLogLines * 1000 / time : 0);
+	}
+}
+
+
+static status_t
+idle_thread(void* data)
+{
+	while (true) {
+		thread_id sender;
+		if (receive_data(&sender, NULL, 0) >= 0)
+			return B_OK;
+	}
+}
+
+
+int
+main(int argc, char** argv)
+{
+	sPath = argc > 1 ? argv[1] : "/tmp/stdiobench.log";
+
+	printf("workload       threads             time\n");
+
+	run_tests("single thread");
+
+	thread_id thread = spawn_thread(&idle_thread, "idle", B_NORMAL_PRIORITY,
+		NULL);
+	if (thread < 0) {
+		fprintf(stderr, "stdiobench: could not spawn thread: %s\n",
+			strerror(thread));
+		return 1;
+	}
+	resume_thread(thread);
+
+	run_tests("multiple threads");
+
+	send_data(thread, 0, NULL, 0);
+	status_t result;
+	wait_for_thread(thread, &result);
+
+	unlink(sPath);
+	return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the throughput of the libroot string functions for short,
+	medium and long strings. The strings are not aligned, like most strings
+	a text processing tool deals with.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const size_t kBufferSize = 256 * 1024;
+static const size_t kTotalBytes = 256 * 1024 * 1024;
+static const size_t kLengths[] = { 8, 32, 128, 1024, 16384 };
+
+
+static char* sBuffer;
+static char* sOther;
+static volatile size_t sSink;
+
+
+static void
+prepare(size_t length)
+{
+	for (size_t i = 0; i < kBufferSize; i++)
+		sBuffer[i] = 'a' + i % 26;
+
+	// terminate a string every length bytes
+	for (size_t i = length; i < kBufferSize; i += length + 1)
+		sBuffer[i] = '\0';
+	sBuffer[kBufferSize - 1] = '\0';
+
+	memcpy(sOther, sBuffer, kBufferSize);
+}
+
+
+typedef size_t (*test_function)(size_t offset, size_t length);
+
+
+static size_t
+test_strlen(size_t offset, size_t length)
+{
+	return strlen(sBuffer + offset);
+}
+
+
+static size_t
+test_strnlen(size_t offset, size_t length)
+{
+	return strnlen(sBuffer + offset, length);
+}
+
+
+static size_t
+test_strchr(size_t offset, size_t length)
+{
+	return (addr_t)strchr(sBuffer + offset, '!');
+}
+
+
+static size_t
+test_strrchr(size_t offset, size_t length)
+{
+	return (addr_t)strrchr(sBuffer + offset, 'a');
+}
+
+
+static size_t
+test_memchr(size_t offset, size_t length)
+{
+	return (addr_t)memchr(sBuffer + offset, '!', length);
+}
+
+
+static size_t
+test_memcmp(size_t offset, size_t length)
+{
+	return memcmp(sBuffer + offset, sOther + offset, length);
+}
+
+
+static size_t
+test_strcmp(size_t offset, size_t length)
+{
+	return strcmp(sBuffer + offset, sOther + offset);
+}
+
+
+static const struct {
+	const char*		name;
+	test_function	function;
+} kTests[] = {
+	{ "strlen", &test_strlen },
+	{ "strnlen", &test_strnlen },
+	{ "strchr", &test_strchr },
+	{ "strrchr", &test_strrchr },
+	{ "memchr", &test_memchr },
+	{ "memcmp", &test_memcmp },
+	{ "strcmp", &test_strcmp },
+};
+
+
+static void
+measure(const char* name, size_t length, test_function function)
+{
+	// the strings are length + 1 bytes apart, so that their alignment varies
+	size_t stride = length + 1;
+	size_t strings = (kBufferSize - 1) / stride;
+	size_t rounds = kTotalBytes / (strings * stride) + 1;
+
+	bigtime_t startTime = system_time();
+
+	size_t result = 0;
+	for (size_t round = 0; round < rounds; round++) {
+		for (size_t i = 0; i < strings; i++)
+			result += function(i * stride, length);
+	}
+
+	bigtime_t time = system_time() - startTime;
+	sSink = result;
+
+	printf("%-10s %7lu %10" B_PRId64 " MB/s\n", name, (unsigned long)length,
+		time > 0 ? (int64)(rounds * strings * length / time) : 0);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	sBuffer = (char*)malloc(kBufferSize);
+	sOther = (char*)malloc(kBufferSize);
+	if (sBuffer == NULL || sOther == NULL) {
+		fprintf(stderr, "stringbench: out of memory\n");
+		return 1;
+	}
+
+	printf("function    length   throughput\n");
+
+	for (size_t i = 0; i < B_COUNT_OF(kLengths); i++) {
+		prepare(kLengths[i]);
+		for (size_t j = 0; j < B_COUNT_OF(kTests); j++)
+			measure(kTests[j].name, kLengths[i], kTests[j].function);
+	}
+
+	free(sBuffer);
+	free(sOther);
+	return 0;
+}
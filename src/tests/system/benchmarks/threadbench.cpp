@@ -0,0 +1,141 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the latency of creating and joining short lived threads, the way
+	task spawning code does. Threads created with the default attributes get
+	the stacks of exited threads from the team's cache; a custom stack size
+	bypasses the cache, and shows what creating a fresh stack costs.
+*/
+
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const int32 kIterations = 20000;
+static const int32 kBatchSize = 8;
+static const size_t kTouchedStackSize = 16 * 1024;
+static const size_t kCustomStackSize = 512 * 1024;
+
+
+static void*
+pthread_entry(void* data)
+{
+	// use some stack, as real work would
+	volatile char buffer[kTouchedStackSize];
+	for (size_t i = 0; i < sizeof(buffer); i += B_PAGE_SIZE)
+		buffer[i] = (char)i;
+
+	return data;
+}
+
+
+static status_t
+bench_thread(void* data)
+{
+	pthread_entry(data);
+	return B_OK;
+}
+
+
+static void
+create_pthreads(const pthread_attr_t* attributes, int32 count)
+{
+	pthread_t threads[kBatchSize];
+
+	for (int32 i = 0; i < count; i++) {
+		if (pthread_create(&threads[i], attributes, &pthread_entry, NULL)
+				!= 0) {
+			fprintf(stderr, "threadbench: pthread_create() failed\n");
+			exit(1);
+		}
+	}
+
+	for (int32 i = 0; i < count; i++)
+		pthread_join(threads[i], NULL);
+}
+
+
+static void
+pthread_default()
+{
+	create_pthreads(NULL, 1);
+}
+
+
+static void
+pthread_custom_stack()
+{
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	pthread_attr_setstacksize(&attributes, kCustomStackSize);
+
+	create_pthreads(&attributes, 1);
+
+	pthread_attr_destroy(&attributes);
+}
+
+
+static void
+pthread_batch()
+{
+	create_pthreads(NULL, kBatchSize);
+}
+
+
+static void
+spawn_and_wait()
+{
+	thread_id thread = spawn_thread(&bench_thread, "bench",
+		B_NORMAL_PRIORITY, NULL);
+	if (thread < 0) {
+		fprintf(stderr, "threadbench: spawn_thread() failed: %s\n",
+			strerror(thread));
+		exit(1);
+	}
+
+	resume_thread(thread);
+
+	status_t result;
+	wait_for_thread(thread, &result);
+}
+
+
+static const struct {
+	const char*	name;
+	void		(*function)();
+	int32		threads;
+} kTests[] = {
+	{ "pthread_create/join", &pthread_default, 1 },
+	{ "custom stack size", &pthread_custom_stack, 1 },
+	{ "batch of 8", &pthread_batch, kBatchSize },
+	{ "spawn_thread/wait", &spawn_and_wait, 1 },
+};
+
+
+int
+main(int argc, char** argv)
+{
+	printf("test                        usecs/thread\n");
+
+	for (size_t i = 0; i < B_COUNT_OF(kTests); i++) {
+		int32 iterations = kIterations / kTests[i].threads;
+
+		bigtime_t startTime = system_time();
+		for (int32 j = 0; j < iterations; j++)
+			kTests[i].function();
+		bigtime_t time = system_time() - startTime;
+
+		printf("%-27s %12.2f\n", kTests[i].name,
+			1.0 * time / (iterations * kTests[i].threads));
+	}
+
+	return 0;
+}
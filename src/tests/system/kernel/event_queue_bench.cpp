@@ -0,0 +1,190 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how the cost of waiting for a single ready FD scales with the
+	number of FDs waited on, for poll() and for a persistent event queue.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <event_queue_defs.h>
+#include <syscalls.h>
+
+
+static const int kFDCounts[] = { 16, 64, 256, 1024, 4096 };
+static const int kIterations = 10000;
+
+
+static void
+die(const char* message)
+{
+	fprintf(stderr, "event_queue_bench: %s: %s\n", message, strerror(errno));
+	exit(1);
+}
+
+
+static void
+create_pipes(int count, int* readFDs, int* writeFDs)
+{
+	for (int i = 0; i < count; i++) {
+		int fds[2];
+		if (pipe(fds) != 0)
+			die("could not create pipe");
+
+		readFDs[i] = fds[0];
+		writeFDs[i] = fds[1];
+	}
+}
+
+
+static void
+close_pipes(int count, int* readFDs, int* writeFDs)
+{
+	for (int i = 0; i < count; i++) {
+		close(readFDs[i]);
+		close(writeFDs[i]);
+	}
+}
+
+
+static void
+consume(int fd)
+{
+	char buffer;
+	if (read(fd, &buffer, 1) != 1)
+		die("read() failed");
+}
+
+
+static double
+bench_poll(int count, int* readFDs, int* writeFDs)
+{
+	pollfd* fds = new pollfd[count];
+	for (int i = 0; i < count; i++) {
+		fds[i].fd = readFDs[i];
+		fds[i].events = POLLIN;
+	}
+
+	bigtime_t startTime = system_time();
+
+	for (int i = 0; i < kIterations; i++) {
+		int index = rand() % count;
+		if (write(writeFDs[index], "x", 1) != 1)
+			die("write() failed");
+
+		if (poll(fds, count, -1) != 1)
+			die("poll() failed");
+
+		if ((fds[index].revents & POLLIN) == 0) {
+			errno = B_ERROR;
+			die("poll() reported the wrong FD");
+		}
+
+		consume(readFDs[index]);
+	}
+
+	bigtime_t elapsed = system_time() - startTime;
+
+	delete[] fds;
+	return (double)elapsed / kIterations;
+}
+
+
+static double
+bench_event_queue(int count, int* readFDs, int* writeFDs)
+{
+	int queue = _kern_event_queue_create(0);
+	if (queue < 0) {
+		errno = queue;
+		die("could not create event queue");
+	}
+
+	event_wait_info* infos = new event_wait_info[count];
+	for (int i = 0; i < count; i++) {
+		infos[i].object = readFDs[i];
+		infos[i].type = B_OBJECT_TYPE_FD;
+		infos[i].events = B_EVENT_READ;
+		infos[i].user_data = (void*)(addr_t)i;
+	}
+
+	status_t status = _kern_event_queue_select(queue, infos, count);
+	if (status != B_OK) {
+		errno = status;
+		die("could not select FDs");
+	}
+
+	bigtime_t startTime = system_time();
+
+	for (int i = 0; i < kIterations; i++) {
+		int index = rand() % count;
+		if (write(writeFDs[index], "x", 1) != 1)
+			die("write() failed");
+
+		event_wait_info info;
+		ssize_t result = _kern_event_queue_wait(queue, &info, 1, 0,
+			B_INFINITE_TIMEOUT);
+		if (result != 1) {
+			errno = result;
+			die("waiting on the event queue failed");
+		}
+
+		if ((int)(addr_t)info.user_data != index) {
+			errno = B_ERROR;
+			die("the event queue reported the wrong FD");
+		}
+
+		consume(readFDs[index]);
+	}
+
+	bigtime_t elapsed = system_time() - startTime;
+
+	delete[] infos;
+	close(queue);
+	return (double)elapsed / kIterations;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int maxFDs = kFDCounts[sizeof(kFDCounts) / sizeof(kFDCounts[0]) - 1];
+
+	struct rlimit limit;
+	limit.rlim_cur = limit.rlim_max = 2 * maxFDs + 32;
+	if (setrlimit(RLIMIT_NOFILE, &limit) != 0)
+		die("could not raise the FD limit");
+
+	int* readFDs = new int[maxFDs];
+	int* writeFDs = new int[maxFDs];
+
+	printf("%8s %16s %16s\n", "FDs", "poll() us/wait", "queue us/wait");
+
+	for (size_t i = 0; i < sizeof(kFDCounts) / sizeof(kFDCounts[0]); i++) {
+		int count = kFDCounts[i];
+		create_pipes(count, readFDs, writeFDs);
+
+		double pollTime = bench_poll(count, readFDs, writeFDs);
+		double queueTime = bench_event_queue(count, readFDs, writeFDs);
+
+		printf("%8d %16.2f %16.2f\n", count, pollTime, queueTime);
+
+		close_pipes(count, readFDs, writeFDs);
+	}
+
+	delete[] readFDs;
+	delete[] writeFDs;
+	return 0;
+}
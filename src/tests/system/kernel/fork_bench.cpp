@@ -0,0 +1,149 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how long fork() and vfork() take for a team with many populated
+	areas, both when the child exits right away and when it executes another
+	program. It also checks that a vfork() child cannot change the memory of
+	its parent.
+*/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const int32 kAreaCounts[] = { 0, 64, 512 };
+static const int32 kMaxAreas = 512;
+static const size_t kAreaSize = 64 * B_PAGE_SIZE;
+static const int32 kIterations = 200;
+
+
+static area_id sAreas[kMaxAreas];
+static int32 sAreaCount;
+
+
+static void
+die(const char* message, status_t error)
+{
+	fprintf(stderr, "fork_bench: %s: %s\n", message, strerror(error));
+	exit(1);
+}
+
+
+static void
+set_area_count(int32 count)
+{
+	while (sAreaCount > count)
+		delete_area(sAreas[--sAreaCount]);
+
+	while (sAreaCount < count) {
+		char* address;
+		area_id area = create_area("fork bench", (void**)&address,
+			B_ANY_ADDRESS, kAreaSize, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+		if (area < 0)
+			die("could not create area", area);
+
+		for (size_t offset = 0; offset < kAreaSize; offset += B_PAGE_SIZE)
+			address[offset] = 1;
+
+		sAreas[sAreaCount++] = area;
+	}
+}
+
+
+static void
+wait_for(pid_t child)
+{
+	int status;
+	if (waitpid(child, &status, 0) != child)
+		die("waitpid() failed", errno);
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		die("child failed", B_ERROR);
+}
+
+
+static bigtime_t
+run(pid_t (*forkFunction)(), bool exec)
+{
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < kIterations; i++) {
+		pid_t child = forkFunction();
+		if (child < 0)
+			die("could not fork", errno);
+
+		if (child == 0) {
+			if (exec)
+				execl("/bin/true", "true", (char*)NULL);
+			_exit(exec ? 1 : 0);
+		}
+
+		wait_for(child);
+	}
+
+	return (system_time() - startTime) / kIterations;
+}
+
+
+static void
+check_vfork_isolation()
+{
+	char* address;
+	area_id area = create_area("vfork check", (void**)&address,
+		B_ANY_ADDRESS, B_PAGE_SIZE, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+	if (area < 0)
+		die("could not create area", area);
+
+	address[0] = 'p';
+
+	pid_t child = vfork();
+	if (child < 0)
+		die("vfork() failed", errno);
+	if (child == 0) {
+		address[0] = 'c';
+		_exit(0);
+	}
+
+	wait_for(child);
+
+	if (address[0] != 'p')
+		die("vfork() child changed our memory", B_ERROR);
+
+	delete_area(area);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	check_vfork_isolation();
+
+	printf("%8s %14s %14s %14s %14s\n", "areas", "fork us",
+		"vfork us", "fork+exec us", "vfork+exec us");
+
+	for (size_t i = 0; i < sizeof(kAreaCounts) / sizeof(kAreaCounts[0]);
+			i++) {
+		set_area_count(kAreaCounts[i]);
+
+		bigtime_t forked = run(&fork, false);
+		bigtime_t vforked = run(&vfork, false);
+		bigtime_t forkExeced = run(&fork, true);
+		bigtime_t vforkExeced = run(&vfork, true);
+
+		printf("%8" B_PRId32 " %14" B_PRId64 " %14" B_PRId64 " %14" B_PRId64
+			" %14" B_PRId64 "\n", kAreaCounts[i], forked, vforked, forkExeced,
+			vforkExeced);
+	}
+
+	set_area_count(0);
+	return 0;
+}
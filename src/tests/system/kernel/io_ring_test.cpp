@@ -0,0 +1,243 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Writes a file through an I/O ring with a deep queue, reads it back, and
+	compares the contents. Also checks that a ring is not inherited by a
+	forked child, and that closing a ring stops workers that are blocked in
+	a request.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+#include <io_ring_defs.h>
+#include <syscalls.h>
+
+
+static const uint32 kRingEntries = 64;
+static const uint32 kBlockSize = 4096;
+static const uint32 kBlockCount = 1024;
+
+
+struct Ring {
+	int				fd;
+	io_ring_info*	info;
+	io_ring_sqe*	sqes;
+	io_ring_cqe*	cqes;
+};
+
+
+static void
+die(const char* message, status_t error)
+{
+	fprintf(stderr, "io_ring_test: %s: %s\n", message, strerror(error));
+	exit(1);
+}
+
+
+static void
+submit(Ring& ring, uint8 opcode, int fd, off_t offset, void* buffer,
+	uint32 length, uint64 userData)
+{
+	uint32 tail = ring.info->sq_tail;
+	io_ring_sqe& sqe = ring.sqes[tail & ring.info->sq_mask];
+	memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = opcode;
+	sqe.fd = fd;
+	sqe.offset = offset;
+	sqe.address = (addr_t)buffer;
+	sqe.length = length;
+	sqe.user_data = userData;
+
+	__sync_synchronize();
+	ring.info->sq_tail = tail + 1;
+}
+
+
+/*!	Runs a request of the given \a opcode for every block, keeping the ring
+	as full as possible.
+*/
+static void
+run(Ring& ring, uint8 opcode, int fd, uint8* data)
+{
+	uint32 queued = 0;
+	uint32 completed = 0;
+
+	while (completed < kBlockCount) {
+		uint32 toSubmit = 0;
+		while (queued < kBlockCount
+			&& ring.info->sq_tail - ring.info->sq_head
+				< ring.info->sq_entries
+			&& queued - completed < ring.info->sq_entries) {
+			submit(ring, opcode, fd, (off_t)queued * kBlockSize,
+				data + queued * kBlockSize, kBlockSize, queued);
+			queued++;
+			toSubmit++;
+		}
+
+		ssize_t result = _kern_io_ring_enter(ring.fd, toSubmit, 1, 0, 0);
+		if (result < 0)
+			die("entering the ring failed", result);
+
+		// reap all completions that are available
+		uint32 head = ring.info->cq_head;
+		__sync_synchronize();
+		while (head != ring.info->cq_tail) {
+			io_ring_cqe& cqe = ring.cqes[head & ring.info->cq_mask];
+			if (cqe.result != (int64)kBlockSize)
+				die("request failed", (status_t)cqe.result);
+			if (cqe.user_data >= kBlockCount)
+				die("bogus user data", B_BAD_DATA);
+
+			head++;
+			completed++;
+		}
+		ring.info->cq_head = head;
+	}
+}
+
+
+static void
+create_ring(Ring& ring)
+{
+	ring.fd = _kern_io_ring_create(kRingEntries, 0, &ring.info);
+	if (ring.fd < 0)
+		die("could not create ring", ring.fd);
+
+	ring.sqes = (io_ring_sqe*)((uint8*)ring.info + ring.info->sqes_offset);
+	ring.cqes = (io_ring_cqe*)((uint8*)ring.info + ring.info->cqes_offset);
+}
+
+
+static int32
+count_workers()
+{
+	int32 count = 0;
+	int32 cookie = 0;
+	thread_info info;
+	while (get_next_thread_info(B_CURRENT_TEAM, &cookie, &info) == B_OK) {
+		if (strcmp(info.name, "io ring worker") == 0)
+			count++;
+	}
+
+	return count;
+}
+
+
+static void
+test_fork(Ring& ring)
+{
+	pid_t child = fork();
+	if (child < 0)
+		die("fork() failed", errno);
+
+	if (child == 0) {
+		// the ring must not have been inherited
+		_exit(fcntl(ring.fd, F_GETFD) < 0 && errno == EBADF ? 0 : 1);
+	}
+
+	int status;
+	if (waitpid(child, &status, 0) != child || !WIFEXITED(status)
+		|| WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "io_ring_test: ring was inherited by child!\n");
+		exit(1);
+	}
+}
+
+
+static void
+test_close_blocked()
+{
+	Ring ring;
+	create_ring(ring);
+
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+		die("could not create sockets", errno);
+
+	// nothing is ever sent, so the worker blocks in recv()
+	char buffer[16];
+	submit(ring, B_IO_RING_OP_RECV, sockets[0], 0, buffer, sizeof(buffer),
+		0);
+	ssize_t result = _kern_io_ring_enter(ring.fd, 1, 0, 0, 0);
+	if (result != 1)
+		die("entering the ring failed", result);
+
+	snooze(100000);
+	if (count_workers() == 0)
+		die("no worker is running", B_ERROR);
+
+	close(ring.fd);
+
+	for (int32 i = 0; count_workers() > 0; i++) {
+		if (i == 100) {
+			fprintf(stderr, "io_ring_test: blocked worker did not exit!\n");
+			exit(1);
+		}
+		snooze(10000);
+	}
+
+	close(sockets[0]);
+	close(sockets[1]);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const char* path = "/tmp/io_ring_test.data";
+
+	Ring ring;
+	create_ring(ring);
+
+	uint8* source = (uint8*)malloc(kBlockSize * kBlockCount);
+	uint8* target = (uint8*)malloc(kBlockSize * kBlockCount);
+	if (source == NULL || target == NULL)
+		die("out of memory", B_NO_MEMORY);
+
+	for (uint32 i = 0; i < kBlockSize * kBlockCount; i++)
+		source[i] = (uint8)(i * 7 + i / kBlockSize);
+	memset(target, 0, kBlockSize * kBlockCount);
+
+	int fd = open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+	if (fd < 0)
+		die("could not create file", errno);
+
+	bigtime_t startTime = system_time();
+	run(ring, B_IO_RING_OP_WRITE, fd, source);
+	bigtime_t writeTime = system_time() - startTime;
+
+	startTime = system_time();
+	run(ring, B_IO_RING_OP_READ, fd, target);
+	bigtime_t readTime = system_time() - startTime;
+
+	if (memcmp(source, target, kBlockSize * kBlockCount) != 0) {
+		fprintf(stderr, "io_ring_test: data read back differs!\n");
+		return 1;
+	}
+
+	printf("wrote %" B_PRIu32 " blocks in %" B_PRId64 " us, read them in %"
+		B_PRId64 " us\n", kBlockCount, writeTime, readTime);
+
+	close(fd);
+	unlink(path);
+
+	test_fork(ring);
+	close(ring.fd);
+
+	test_close_blocked();
+
+	return 0;
+}
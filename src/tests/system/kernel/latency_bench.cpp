@@ -0,0 +1,709 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the latency of creating threads and teams, and of switching
+	between threads, and reports percentiles for every phase of an
+	operation: for spawning a thread, for example, the spawn_thread() call
+	itself, the time until the new thread runs, and the time from its exit
+	until wait_for_thread() returns. Child teams are this program itself,
+	run with "--child"; they report when they started through a port.
+
+	With -p, every test is run another time with the system profiler
+	recording scheduling events. The events show how much of an iteration
+	the benchmark thread and the other threads involved spent on a CPU, and
+	how long they waited in a run queue. Teams created while a test runs are
+	assumed to be its children.
+*/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <image.h>
+#include <OS.h>
+
+#include <syscalls.h>
+#include <system_profiler_defs.h>
+
+
+static const int32 kMaxPhases = 3;
+static const int32 kProfileIterationDivisor = 10;
+static const size_t kProfileBufferSize = 16 * 1024 * 1024;
+static const int32 kMaxProfiledThreads = 16384;
+
+
+struct child_report {
+	bigtime_t	exec_time;
+	bigtime_t	started;
+};
+
+struct test {
+	const char*	name;
+	void		(*function)(bigtime_t* phases);
+	int32		iterations;
+	const char*	phases[kMaxPhases];
+	void		(*setup)();
+	void		(*cleanup)();
+};
+
+struct profiled_thread {
+	thread_id	id;
+	bool		ours;
+	bool		child_team;
+	nanotime_t	running_since;
+	nanotime_t	enqueued_at;
+};
+
+struct profile_result {
+	nanotime_t	benchmark_time;
+	nanotime_t	others_time;
+	nanotime_t	run_queue_time;
+	int64		wakeups;
+	bool		overflow;
+};
+
+
+static const char* sPath;
+static port_id sReplyPort;
+static team_id sTeam;
+static thread_id sBenchmarkThread;
+
+static volatile bigtime_t sThreadStarted;
+
+static sem_id sPingSem;
+static sem_id sPongSem;
+static port_id sPingPort;
+static port_id sPongPort;
+static thread_id sPartner;
+
+static profiled_thread sProfiledThreads[kMaxProfiledThreads];
+
+
+static void
+die(const char* message, status_t error)
+{
+	fprintf(stderr, "latency_bench: %s: %s\n", message, strerror(error));
+	exit(1);
+}
+
+
+static child_report
+read_report()
+{
+	child_report report;
+	int32 code;
+	ssize_t bytesRead = read_port(sReplyPort, &code, &report, sizeof(report));
+	if (bytesRead != (ssize_t)sizeof(report))
+		die("could not read the child's report", bytesRead);
+
+	return report;
+}
+
+
+static void
+wait_for_child(pid_t child)
+{
+	int status;
+	if (waitpid(child, &status, 0) != child)
+		die("waitpid() failed", errno);
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		die("child failed", B_ERROR);
+}
+
+
+// #pragma mark - tests
+
+
+static status_t
+timed_thread(void* data)
+{
+	sThreadStarted = system_time();
+	return B_OK;
+}
+
+
+static void
+spawn_thread_test(bigtime_t* phases)
+{
+	bigtime_t start = system_time();
+	thread_id thread = spawn_thread(&timed_thread, "latency child",
+		B_NORMAL_PRIORITY, NULL);
+	if (thread < 0)
+		die("spawn_thread() failed", thread);
+	bigtime_t spawned = system_time();
+
+	resume_thread(thread);
+
+	status_t result;
+	wait_for_thread(thread, &result);
+	bigtime_t end = system_time();
+
+	phases[0] = spawned - start;
+	phases[1] = sThreadStarted - spawned;
+	phases[2] = end - sThreadStarted;
+}
+
+
+static void
+fork_test(bigtime_t* phases)
+{
+	bigtime_t start = system_time();
+	pid_t child = fork();
+	if (child == 0) {
+		child_report report = { 0, system_time() };
+		write_port(sReplyPort, 0, &report, sizeof(report));
+		_exit(0);
+	}
+	if (child < 0)
+		die("fork() failed", errno);
+
+	wait_for_child(child);
+	bigtime_t end = system_time();
+
+	child_report report = read_report();
+	phases[0] = report.started - start;
+	phases[1] = end - report.started;
+}
+
+
+static void
+load_image_test(bigtime_t* phases)
+{
+	char port[16];
+	snprintf(port, sizeof(port), "%" B_PRId32, sReplyPort);
+	const char* args[] = { sPath, "--child", port, "0", NULL };
+
+	bigtime_t start = system_time();
+	thread_id child = load_image(4, args, (const char**)environ);
+	if (child < 0)
+		die("load_image() failed", child);
+	bigtime_t loaded = system_time();
+
+	resume_thread(child);
+
+	status_t result;
+	wait_for_thread(child, &result);
+	if (result != 0)
+		die("child failed", B_ERROR);
+	bigtime_t end = system_time();
+
+	child_report report = read_report();
+	phases[0] = loaded - start;
+	phases[1] = report.started - loaded;
+	phases[2] = end - report.started;
+}
+
+
+static void
+exec_test(bigtime_t* phases)
+{
+	bigtime_t start = system_time();
+	pid_t child = fork();
+	if (child == 0) {
+		char port[16];
+		char execTime[32];
+		snprintf(port, sizeof(port), "%" B_PRId32, sReplyPort);
+		snprintf(execTime, sizeof(execTime), "%" B_PRId64, system_time());
+
+		const char* args[] = { sPath, "--child", port, execTime, NULL };
+		execv(sPath, (char* const*)args);
+		_exit(1);
+	}
+	if (child < 0)
+		die("fork() failed", errno);
+
+	wait_for_child(child);
+	bigtime_t end = system_time();
+
+	child_report report = read_report();
+	phases[0] = report.exec_time - start;
+	phases[1] = report.started - report.exec_time;
+	phases[2] = end - report.started;
+}
+
+
+static status_t
+sem_partner(void* data)
+{
+	while (acquire_sem(sPingSem) == B_OK)
+		release_sem(sPongSem);
+
+	return B_OK;
+}
+
+
+static void
+sem_setup()
+{
+	sPingSem = create_sem(0, "ping");
+	sPongSem = create_sem(0, "pong");
+	if (sPingSem < 0 || sPongSem < 0)
+		die("could not create semaphores", B_NO_MORE_SEMS);
+
+	sPartner = spawn_thread(&sem_partner, "sem partner", B_NORMAL_PRIORITY,
+		NULL);
+	if (sPartner < 0)
+		die("spawn_thread() failed", sPartner);
+	resume_thread(sPartner);
+}
+
+
+static void
+sem_cleanup()
+{
+	delete_sem(sPingSem);
+	delete_sem(sPongSem);
+
+	status_t result;
+	wait_for_thread(sPartner, &result);
+}
+
+
+static void
+sem_ping_pong_test(bigtime_t* phases)
+{
+	bigtime_t start = system_time();
+	release_sem(sPingSem);
+	acquire_sem(sPongSem);
+	phases[0] = system_time() - start;
+}
+
+
+static status_t
+port_partner(void* data)
+{
+	int32 code;
+	while (read_port(sPingPort, &code, NULL, 0) >= 0)
+		write_port(sPongPort, code, NULL, 0);
+
+	return B_OK;
+}
+
+
+static void
+port_setup()
+{
+	sPingPort = create_port(1, "ping");
+	sPongPort = create_port(1, "pong");
+	if (sPingPort < 0 || sPongPort < 0)
+		die("could not create ports", B_NO_MORE_PORTS);
+
+	sPartner = spawn_thread(&port_partner, "port partner", B_NORMAL_PRIORITY,
+		NULL);
+	if (sPartner < 0)
+		die("spawn_thread() failed", sPartner);
+	resume_thread(sPartner);
+}
+
+
+static void
+port_cleanup()
+{
+	delete_port(sPingPort);
+	delete_port(sPongPort);
+
+	status_t result;
+	wait_for_thread(sPartner, &result);
+}
+
+
+static void
+port_ping_pong_test(bigtime_t* phases)
+{
+	bigtime_t start = system_time();
+	write_port(sPingPort, 0, NULL, 0);
+
+	int32 code;
+	read_port(sPongPort, &code, NULL, 0);
+	phases[0] = system_time() - start;
+}
+
+
+static const test kTests[] = {
+	{ "spawn_thread", &spawn_thread_test, 5000,
+		{ "spawn_thread()", "until it runs", "exit and wait" } },
+	{ "fork", &fork_test, 1000,
+		{ "until child runs", "exit and waitpid" } },
+	{ "load_image", &load_image_test, 300,
+		{ "load_image()", "until main()", "exit and wait" } },
+	{ "exec", &exec_test, 300,
+		{ "fork", "exec until main()", "exit and waitpid" } },
+	{ "sem ping-pong", &sem_ping_pong_test, 20000,
+		{ "round trip" }, &sem_setup, &sem_cleanup },
+	{ "port ping-pong", &port_ping_pong_test, 20000,
+		{ "round trip" }, &port_setup, &port_cleanup },
+};
+
+
+// #pragma mark - system profiler
+
+
+static profiled_thread*
+lookup_thread(thread_id id, bool create)
+{
+	uint32 index = (uint32)id % kMaxProfiledThreads;
+	for (int32 i = 0; i < kMaxProfiledThreads; i++) {
+		profiled_thread* thread = &sProfiledThreads[index];
+		if (thread->id == id)
+			return thread;
+
+		if (thread->id < 0) {
+			if (!create)
+				return NULL;
+
+			thread->id = id;
+			thread->ours = false;
+			thread->child_team = false;
+			thread->running_since = -1;
+			thread->enqueued_at = -1;
+			return thread;
+		}
+
+		index = (index + 1) % kMaxProfiledThreads;
+	}
+
+	return NULL;
+}
+
+
+static void
+account_run_time(profiled_thread* thread, nanotime_t time,
+	profile_result& result)
+{
+	if (thread->running_since < 0)
+		return;
+
+	if (thread->id == sBenchmarkThread)
+		result.benchmark_time += time - thread->running_since;
+	else
+		result.others_time += time - thread->running_since;
+
+	thread->running_since = -1;
+}
+
+
+/*!	Goes through the events the system profiler recorded. The events up to
+	\a windowStart describe the teams and threads that existed before.
+*/
+static void
+analyze_events(const uint8* buffer, size_t size, size_t windowStart,
+	nanotime_t startTime, nanotime_t endTime, profile_result& result)
+{
+	for (int32 i = 0; i < kMaxProfiledThreads; i++)
+		sProfiledThreads[i].id = -1;
+
+	size_t offset = 0;
+	while (offset + sizeof(system_profiler_event_header) <= size) {
+		const system_profiler_event_header* header
+			= (const system_profiler_event_header*)(buffer + offset);
+		const void* event = header + 1;
+
+		if (header->event == B_SYSTEM_PROFILER_BUFFER_END) {
+			result.overflow = true;
+			break;
+		}
+
+		switch (header->event) {
+			case B_SYSTEM_PROFILER_TEAM_ADDED:
+			{
+				if (offset < windowStart)
+					break;
+
+				const system_profiler_team_added* added
+					= (const system_profiler_team_added*)event;
+				if (profiled_thread* team = lookup_thread(added->team, true))
+					team->child_team = true;
+				break;
+			}
+
+			case B_SYSTEM_PROFILER_THREAD_ADDED:
+			{
+				const system_profiler_thread_added* added
+					= (const system_profiler_thread_added*)event;
+				profiled_thread* team = lookup_thread(added->team, false);
+				if (added->team != sTeam
+					&& (team == NULL || !team->child_team)) {
+					break;
+				}
+
+				profiled_thread* thread = lookup_thread(added->thread, true);
+				if (thread == NULL)
+					break;
+
+				thread->ours = true;
+				if (thread->id == sBenchmarkThread)
+					thread->running_since = startTime;
+				break;
+			}
+
+			case B_SYSTEM_PROFILER_THREAD_ENQUEUED_IN_RUN_QUEUE:
+			{
+				const system_profiler_thread_enqueued_in_run_queue* enqueued
+					= (const system_profiler_thread_enqueued_in_run_queue*)
+						event;
+				profiled_thread* thread = lookup_thread(enqueued->thread,
+					false);
+				if (thread != NULL && thread->ours)
+					thread->enqueued_at = enqueued->time;
+				break;
+			}
+
+			case B_SYSTEM_PROFILER_THREAD_REMOVED_FROM_RUN_QUEUE:
+			{
+				const system_profiler_thread_removed_from_run_queue* removed
+					= (const system_profiler_thread_removed_from_run_queue*)
+						event;
+				profiled_thread* thread = lookup_thread(removed->thread, false);
+				if (thread != NULL)
+					thread->enqueued_at = -1;
+				break;
+			}
+
+			case B_SYSTEM_PROFILER_THREAD_SCHEDULED:
+			{
+				const system_profiler_thread_scheduled* scheduled
+					= (const system_profiler_thread_scheduled*)event;
+
+				profiled_thread* previous
+					= lookup_thread(scheduled->previous_thread, false);
+				if (previous != NULL)
+					account_run_time(previous, scheduled->time, result);
+
+				profiled_thread* thread = lookup_thread(scheduled->thread,
+					false);
+				if (thread == NULL || !thread->ours)
+					break;
+
+				if (thread->enqueued_at >= 0) {
+					result.run_queue_time
+						+= scheduled->time - thread->enqueued_at;
+					result.wakeups++;
+					thread->enqueued_at = -1;
+				}
+				thread->running_since = scheduled->time;
+				break;
+			}
+		}
+
+		offset += sizeof(system_profiler_event_header) + header->size;
+	}
+
+	if (profiled_thread* thread = lookup_thread(sBenchmarkThread, false))
+		account_run_time(thread, endTime, result);
+}
+
+
+/*!	Runs the test with the system profiler recording scheduling events, and
+	prints where the time of an iteration went.
+*/
+static void
+profile_test(const test& test)
+{
+	system_profiler_buffer_header* header;
+	area_id area = create_area("profiling buffer", (void**)&header,
+		B_ANY_ADDRESS, kProfileBufferSize, B_NO_LOCK,
+		B_READ_AREA | B_WRITE_AREA);
+	if (area < 0)
+		die("could not create profiling buffer", area);
+
+	system_profiler_parameters parameters;
+	parameters.buffer_area = area;
+	parameters.flags = B_SYSTEM_PROFILER_TEAM_EVENTS
+		| B_SYSTEM_PROFILER_THREAD_EVENTS
+		| B_SYSTEM_PROFILER_SCHEDULING_EVENTS;
+	parameters.locking_lookup_size = 64 * 1024;
+	parameters.interval = 0;
+	parameters.stack_depth = 0;
+
+	int32 iterations = test.iterations / kProfileIterationDivisor;
+	if (iterations < 10)
+		iterations = 10;
+
+	if (test.setup != NULL)
+		test.setup();
+
+	nanotime_t startTime = system_time() * 1000;
+	status_t status = _kern_system_profiler_start(&parameters);
+	if (status != B_OK) {
+		printf("  could not start the system profiler: %s\n",
+			strerror(status));
+		if (test.cleanup != NULL)
+			test.cleanup();
+		delete_area(area);
+		return;
+	}
+
+	// the buffer holds the initial state of the system so far
+	size_t windowStart = header->size;
+
+	bigtime_t phases[kMaxPhases];
+	for (int32 i = 0; i < iterations; i++)
+		test.function(phases);
+
+	nanotime_t endTime = system_time() * 1000;
+	_kern_system_profiler_stop();
+
+	if (test.cleanup != NULL)
+		test.cleanup();
+
+	profile_result result = {};
+	analyze_events((const uint8*)(header + 1) + header->start, header->size,
+		windowStart, startTime, endTime, result);
+
+	printf("  profiled %" B_PRId32 " iterations, per iteration:\n",
+		iterations);
+	printf("    benchmark thread on CPU %10.2f usecs\n",
+		result.benchmark_time / 1000.0 / iterations);
+	printf("    other threads on CPU    %10.2f usecs\n",
+		result.others_time / 1000.0 / iterations);
+	printf("    waiting in run queue    %10.2f usecs (%.1f times)\n",
+		result.run_queue_time / 1000.0 / iterations,
+		1.0 * result.wakeups / iterations);
+	if (result.overflow)
+		printf("    (profiling buffer overflowed, results are incomplete)\n");
+
+	delete_area(area);
+}
+
+
+// #pragma mark -
+
+
+static int
+compare_times(const void* _a, const void* _b)
+{
+	bigtime_t a = *(const bigtime_t*)_a;
+	bigtime_t b = *(const bigtime_t*)_b;
+	return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+
+static void
+print_percentiles(const char* name, bigtime_t* samples, int32 count)
+{
+	qsort(samples, count, sizeof(bigtime_t), &compare_times);
+
+	printf("  %-20s %8" B_PRId64 " %8" B_PRId64 " %8" B_PRId64 " %8" B_PRId64
+		"\n", name, samples[count / 2], samples[count * 90 / 100],
+		samples[count * 99 / 100], samples[count - 1]);
+}
+
+
+static void
+run_test(const test& test)
+{
+	int32 phaseCount = 0;
+	while (phaseCount < kMaxPhases && test.phases[phaseCount] != NULL)
+		phaseCount++;
+
+	bigtime_t* samples = (bigtime_t*)malloc(
+		(phaseCount + 1) * test.iterations * sizeof(bigtime_t));
+	if (samples == NULL)
+		die("could not allocate samples", B_NO_MEMORY);
+	bigtime_t* totals = samples + phaseCount * test.iterations;
+
+	if (test.setup != NULL)
+		test.setup();
+
+	for (int32 i = 0; i < test.iterations; i++) {
+		bigtime_t phases[kMaxPhases];
+		test.function(phases);
+
+		totals[i] = 0;
+		for (int32 phase = 0; phase < phaseCount; phase++) {
+			samples[phase * test.iterations + i] = phases[phase];
+			totals[i] += phases[phase];
+		}
+	}
+
+	if (test.cleanup != NULL)
+		test.cleanup();
+
+	printf("%-22s %8s %8s %8s %8s  (usecs, %" B_PRId32 " iterations)\n",
+		test.name, "p50", "p90", "p99", "max", test.iterations);
+
+	for (int32 phase = 0; phase < phaseCount; phase++) {
+		print_percentiles(test.phases[phase],
+			samples + phase * test.iterations, test.iterations);
+	}
+	if (phaseCount > 1)
+		print_percentiles("total", totals, test.iterations);
+
+	free(samples);
+}
+
+
+static void
+usage()
+{
+	fprintf(stderr, "usage: latency_bench [-p] [<test> ...]\n"
+		"  -p  also break down the time with the system profiler\n"
+		"tests:");
+	for (size_t i = 0; i < B_COUNT_OF(kTests); i++)
+		fprintf(stderr, " \"%s\"", kTests[i].name);
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (argc == 4 && strcmp(argv[1], "--child") == 0) {
+		child_report report;
+		report.started = system_time();
+		report.exec_time = strtoll(argv[3], NULL, 10);
+		write_port(strtol(argv[2], NULL, 10), 0, &report, sizeof(report));
+		return 0;
+	}
+
+	bool profile = false;
+	int firstTest = 1;
+	if (argc > 1 && argv[1][0] == '-') {
+		if (strcmp(argv[1], "-p") != 0)
+			usage();
+		profile = true;
+		firstTest = 2;
+	}
+
+	// the child teams run this program
+	image_info info;
+	int32 cookie = 0;
+	while (get_next_image_info(B_CURRENT_TEAM, &cookie, &info) == B_OK) {
+		if (info.type == B_APP_IMAGE)
+			break;
+	}
+	sPath = info.name;
+
+	sTeam = getpid();
+	sBenchmarkThread = find_thread(NULL);
+	sReplyPort = create_port(16, "latency_bench reply");
+	if (sReplyPort < 0)
+		die("could not create port", sReplyPort);
+
+	for (size_t i = 0; i < B_COUNT_OF(kTests); i++) {
+		if (argc > firstTest) {
+			bool selected = false;
+			for (int arg = firstTest; arg < argc; arg++) {
+				if (strcmp(argv[arg], kTests[i].name) == 0)
+					selected = true;
+			}
+			if (!selected)
+				continue;
+		}
+
+		run_test(kTests[i]);
+		if (profile)
+			profile_test(kTests[i]);
+	}
+
+	delete_port(sReplyPort);
+	return 0;
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares the throughput of small port messages written and read one per
+	syscall with batches of them, and that of large messages copied through
+	the port with area messages that transfer their pages instead.
+*/
+
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+#include <port_defs.h>
+#include <syscalls.h>
+
+
+static const int32 kSmallMessageCount = 200000;
+static const size_t kSmallMessageSize = 64;
+static const int32 kBatchSize = 32;
+
+static const int32 kLargeMessageCount = 500;
+static const size_t kLargeMessageSize = 256 * 1024;
+
+
+static port_id sPort;
+
+
+static void
+die(const char* message, status_t error)
+{
+	fprintf(stderr, "port_batch_bench: %s: %s\n", message, strerror(error));
+	exit(1);
+}
+
+
+static void
+check_message(int32 code, int32 expected)
+{
+	if (code != expected) {
+		fprintf(stderr, "port_batch_bench: got message %" B_PRId32
+			" instead of %" B_PRId32 "\n", code, expected);
+		exit(1);
+	}
+}
+
+
+static status_t
+single_writer(void*)
+{
+	char buffer[kSmallMessageSize];
+	memset(buffer, 'x', sizeof(buffer));
+
+	for (int32 i = 0; i < kSmallMessageCount; i++) {
+		status_t status = write_port(sPort, i, buffer, sizeof(buffer));
+		if (status != B_OK)
+			die("write_port() failed", status);
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+batch_writer(void*)
+{
+	char buffer[kSmallMessageSize];
+	memset(buffer, 'x', sizeof(buffer));
+
+	port_batch_message messages[kBatchSize];
+	int32 next = 0;
+
+	while (next < kSmallMessageCount) {
+		int32 count = std::min(kBatchSize, kSmallMessageCount - next);
+		for (int32 i = 0; i < count; i++) {
+			messages[i].code = next + i;
+			messages[i].flags = 0;
+			messages[i].buffer = buffer;
+			messages[i].size = sizeof(buffer);
+		}
+
+		ssize_t written = _kern_write_port_batch(sPort, messages, count, 0, 0);
+		if (written < 0)
+			die("_kern_write_port_batch() failed", written);
+
+		next += written;
+	}
+
+	return B_OK;
+}
+
+
+static void
+single_reader()
+{
+	char buffer[kSmallMessageSize];
+
+	for (int32 i = 0; i < kSmallMessageCount; i++) {
+		int32 code;
+		ssize_t size = read_port(sPort, &code, buffer, sizeof(buffer));
+		if (size < 0)
+			die("read_port() failed", size);
+
+		check_message(code, i);
+	}
+}
+
+
+static void
+batch_reader()
+{
+	static char buffers[kBatchSize][kSmallMessageSize];
+	port_batch_message messages[kBatchSize];
+
+	for (int32 next = 0; next < kSmallMessageCount;) {
+		for (int32 i = 0; i < kBatchSize; i++) {
+			messages[i].flags = 0;
+			messages[i].buffer = buffers[i];
+			messages[i].size = kSmallMessageSize;
+		}
+
+		ssize_t read = _kern_read_port_batch(sPort, messages, kBatchSize, 0,
+			0);
+		if (read < 0)
+			die("_kern_read_port_batch() failed", read);
+
+		for (ssize_t i = 0; i < read; i++)
+			check_message(messages[i].code, next++);
+	}
+}
+
+
+static status_t
+copy_writer(void*)
+{
+	char* buffer = (char*)malloc(kLargeMessageSize);
+	if (buffer == NULL)
+		die("out of memory", B_NO_MEMORY);
+
+	for (int32 i = 0; i < kLargeMessageCount; i++) {
+		// touch every page, as area_writer() has to do it, too
+		for (size_t offset = 0; offset < kLargeMessageSize;
+				offset += B_PAGE_SIZE) {
+			buffer[offset] = (char)i;
+		}
+
+		status_t status = write_port(sPort, i, buffer, kLargeMessageSize);
+		if (status != B_OK)
+			die("write_port() failed", status);
+	}
+
+	free(buffer);
+	return B_OK;
+}
+
+
+static status_t
+area_writer(void*)
+{
+	for (int32 i = 0; i < kLargeMessageCount; i++) {
+		char* buffer;
+		area_id area = create_area("port message", (void**)&buffer,
+			B_ANY_ADDRESS, kLargeMessageSize, B_NO_LOCK,
+			B_READ_AREA | B_WRITE_AREA);
+		if (area < 0)
+			die("could not create area", area);
+
+		for (size_t offset = 0; offset < kLargeMessageSize;
+				offset += B_PAGE_SIZE) {
+			buffer[offset] = (char)i;
+		}
+
+		port_batch_message message;
+		message.code = i;
+		message.flags = B_PORT_MESSAGE_AREA;
+		message.buffer = NULL;
+		message.size = kLargeMessageSize;
+		message.area = area;
+
+		ssize_t written = _kern_write_port_batch(sPort, &message, 1, 0, 0);
+		if (written != 1)
+			die("_kern_write_port_batch() failed", written);
+	}
+
+	return B_OK;
+}
+
+
+static void
+copy_reader()
+{
+	char* buffer = (char*)malloc(kLargeMessageSize);
+	if (buffer == NULL)
+		die("out of memory", B_NO_MEMORY);
+
+	for (int32 i = 0; i < kLargeMessageCount; i++) {
+		int32 code;
+		ssize_t size = read_port(sPort, &code, buffer, kLargeMessageSize);
+		if (size != (ssize_t)kLargeMessageSize)
+			die("read_port() failed", size < 0 ? size : B_ERROR);
+
+		check_message(code, i);
+		check_message(buffer[B_PAGE_SIZE], (char)i);
+	}
+
+	free(buffer);
+}
+
+
+static void
+area_reader()
+{
+	for (int32 i = 0; i < kLargeMessageCount; i++) {
+		port_batch_message message;
+		message.flags = B_PORT_MESSAGE_AREA;
+		message.buffer = NULL;
+		message.size = 0;
+
+		ssize_t read = _kern_read_port_batch(sPort, &message, 1, 0, 0);
+		if (read != 1)
+			die("_kern_read_port_batch() failed", read);
+		if ((message.flags & B_PORT_MESSAGE_AREA) == 0
+			|| message.size != kLargeMessageSize) {
+			die("did not receive an area", B_ERROR);
+		}
+
+		check_message(message.code, i);
+		check_message(((char*)message.buffer)[B_PAGE_SIZE], (char)i);
+
+		delete_area(message.area);
+	}
+}
+
+
+static bigtime_t
+run(thread_func writer, void (*reader)())
+{
+	sPort = create_port(kBatchSize * 4, "port batch bench");
+	if (sPort < 0)
+		die("could not create port", sPort);
+
+	bigtime_t startTime = system_time();
+
+	thread_id thread = spawn_thread(writer, "writer", B_NORMAL_PRIORITY,
+		NULL);
+	if (thread < 0)
+		die("could not spawn writer", thread);
+	resume_thread(thread);
+
+	reader();
+
+	bigtime_t elapsed = system_time() - startTime;
+
+	status_t result;
+	wait_for_thread(thread, &result);
+	delete_port(sPort);
+
+	return elapsed;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	bigtime_t single = run(&single_writer, &single_reader);
+	bigtime_t batched = run(&batch_writer, &batch_reader);
+
+	printf("%" B_PRId32 " messages of %zu bytes:\n", kSmallMessageCount,
+		kSmallMessageSize);
+	printf("  one per syscall:  %8.0f messages/s, %6.2f us/message\n",
+		kSmallMessageCount * 1000000.0 / single,
+		(double)single / kSmallMessageCount);
+	printf("  batches of %-4" B_PRId32 "  %8.0f messages/s, %6.2f us/message\n",
+		kBatchSize, kSmallMessageCount * 1000000.0 / batched,
+		(double)batched / kSmallMessageCount);
+
+	bigtime_t copied = run(&copy_writer, &copy_reader);
+	bigtime_t transferred = run(&area_writer, &area_reader);
+
+	double megabytes = (double)kLargeMessageCount * kLargeMessageSize
+		/ (1024 * 1024);
+	printf("%" B_PRId32 " messages of %zu bytes:\n", kLargeMessageCount,
+		kLargeMessageSize);
+	printf("  copied:           %8.1f MB/s, %6.2f us/message\n",
+		megabytes * 1000000 / copied, (double)copied / kLargeMessageCount);
+	printf("  area transfer:    %8.1f MB/s, %6.2f us/message\n",
+		megabytes * 1000000 / transferred,
+		(double)transferred / kLargeMessageCount);
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how port and semaphore operations scale with the number of
+	threads using them concurrently. Every thread uses its own port and
+	semaphore, so the only shared state is the kernel's ID lookup.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const int32 kThreadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+static const int32 kMaxThreads = 64;
+static const bigtime_t kRunTime = 1000000;
+
+
+struct thread_data {
+	port_id		port;
+	sem_id		sem;
+	int64		operations;
+};
+
+
+static int32 sMode;
+static volatile bool sStart;
+static volatile bool sStop;
+
+
+static void
+die(const char* message, status_t error)
+{
+	fprintf(stderr, "port_sem_lookup_contention: %s: %s\n", message,
+		strerror(error));
+	exit(1);
+}
+
+
+static status_t
+worker(void* _data)
+{
+	thread_data* data = (thread_data*)_data;
+	char buffer[16];
+	int32 code;
+
+	while (!sStart)
+		;
+
+	int64 operations = 0;
+	while (!sStop) {
+		if (sMode == 0) {
+			write_port(data->port, 1, buffer, sizeof(buffer));
+			read_port(data->port, &code, buffer, sizeof(buffer));
+		} else {
+			release_sem_etc(data->sem, 1, B_DO_NOT_RESCHEDULE);
+			acquire_sem(data->sem);
+		}
+		operations++;
+	}
+
+	data->operations = operations;
+	return B_OK;
+}
+
+
+static double
+run(int32 mode, int32 threadCount)
+{
+	thread_data data[kMaxThreads];
+	thread_id threads[kMaxThreads];
+
+	sMode = mode;
+	sStart = false;
+	sStop = false;
+
+	for (int32 i = 0; i < threadCount; i++) {
+		data[i].port = create_port(1, "contention port");
+		data[i].sem = create_sem(0, "contention sem");
+		data[i].operations = 0;
+		if (data[i].port < 0)
+			die("could not create port", data[i].port);
+		if (data[i].sem < 0)
+			die("could not create semaphore", data[i].sem);
+
+		threads[i] = spawn_thread(&worker, "worker", B_NORMAL_PRIORITY,
+			&data[i]);
+		if (threads[i] < 0)
+			die("could not spawn thread", threads[i]);
+		resume_thread(threads[i]);
+	}
+
+	sStart = true;
+	snooze(kRunTime);
+	sStop = true;
+
+	int64 operations = 0;
+	for (int32 i = 0; i < threadCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+		operations += data[i].operations;
+
+		delete_port(data[i].port);
+		delete_sem(data[i].sem);
+	}
+
+	return operations * 1000000.0 / kRunTime;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	system_info info;
+	get_system_info(&info);
+	printf("%" B_PRIu32 " CPUs\n", info.cpu_count);
+
+	printf("%8s %18s %18s\n", "threads", "port ops/s", "sem ops/s");
+
+	for (size_t i = 0; i < sizeof(kThreadCounts) / sizeof(kThreadCounts[0]);
+			i++) {
+		int32 threadCount = kThreadCounts[i];
+		double portOperations = run(0, threadCount);
+		double semOperations = run(1, threadCount);
+
+		printf("%8" B_PRId32 " %18.0f %18.0f\n", threadCount, portOperations,
+			semOperations);
+	}
+
+	return 0;
+}
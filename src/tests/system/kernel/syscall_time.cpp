@@ -6,37 +6,94 @@
 
 #include <OS.h>
 #include <stdio.h>
+#include <unistd.h>
 
 #ifdef __HAIKU__
 #	include <syscalls.h>
 #endif
 
 
-int
-main(int argc, char **argv)
+static const int32 kLoops = 100000;
+
+
+static void
+empty_call()
 {
-	const int32 loops = 100000;
-	bigtime_t startTime = system_time();
+}
+
 
-	for (int32 i = 0; i < loops; i++) {
+static void
+syscall_call()
+{
 #ifdef __HAIKU__
-		_kern_is_computer_on();
+	_kern_is_computer_on();
 #else
-		is_computer_on();
+	is_computer_on();
 #endif
-	}
+}
+
+
+static void
+system_time_call()
+{
+	system_time();
+}
+
+
+static void
+real_time_clock_call()
+{
+	real_time_clock_usecs();
+}
 
-	bigtime_t runTime = system_time() - startTime;
 
-	// empty loop time
+static void
+find_thread_call()
+{
+	find_thread(NULL);
+}
+
+
+static void
+cpu_count_call()
+{
+	sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+
+static bigtime_t
+measure(void (*function)())
+{
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < kLoops; i++)
+		function();
 
-	startTime = system_time();
+	return system_time() - startTime;
+}
 
-	for (int32 i = 0; i < loops; i++)
-		;
 
-	runTime -= system_time() - startTime;
+int
+main(int argc, char **argv)
+{
+	static const struct {
+		const char*	name;
+		void		(*function)();
+	} kCalls[] = {
+		{ "syscall", &syscall_call },
+		{ "system_time()", &system_time_call },
+		{ "real_time_clock_usecs()", &real_time_clock_call },
+		{ "find_thread(NULL)", &find_thread_call },
+		{ "sysconf(_SC_NPROCESSORS_ONLN)", &cpu_count_call },
+	};
+
+	// the time of the loop itself is subtracted from all results
+	bigtime_t emptyTime = measure(&empty_call);
+
+	for (size_t i = 0; i < sizeof(kCalls) / sizeof(kCalls[0]); i++) {
+		bigtime_t runTime = measure(kCalls[i].function) - emptyTime;
+		printf("%-30s %f usecs/call\n", kCalls[i].name, 1.0 * runTime / kLoops);
+	}
 
-	printf("%f usecs/syscall\n", 1.0 * runTime / loops);
 	return 0;
 }
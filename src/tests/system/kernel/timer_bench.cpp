@@ -0,0 +1,144 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how the cost of arming and canceling a kernel timer scales with
+	the number of timers already pending. Every background thread blocks
+	with a long timeout, while two threads ping-pong through semaphores with
+	even longer timeouts, so that each round trip adds and cancels two timers
+	behind all pending ones.
+*/
+
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const int kTimerCounts[] = { 0, 64, 256, 1024, 2048 };
+static const int kRoundTrips = 20000;
+static const bigtime_t kBackgroundTimeout = 3600000000LL;
+static const bigtime_t kPingPongTimeout = 2 * kBackgroundTimeout;
+
+
+struct ping_pong {
+	sem_id	ping;
+	sem_id	pong;
+};
+
+
+static sem_id sBackgroundSem;
+
+
+static void
+die(const char* message, status_t error)
+{
+	fprintf(stderr, "timer_bench: %s: %s\n", message, strerror(error));
+	exit(1);
+}
+
+
+static void*
+background_thread(void* data)
+{
+	// Spread the timers out over the wheel; they are never meant to fire.
+	bigtime_t timeout = kBackgroundTimeout + (addr_t)data * 1000;
+	acquire_sem_etc(sBackgroundSem, 1, B_RELATIVE_TIMEOUT, timeout);
+	return NULL;
+}
+
+
+static void*
+pong_thread(void* data)
+{
+	ping_pong* pingPong = (ping_pong*)data;
+
+	for (int i = 0; i < kRoundTrips; i++) {
+		status_t status = acquire_sem_etc(pingPong->ping, 1,
+			B_RELATIVE_TIMEOUT, kPingPongTimeout);
+		if (status != B_OK)
+			die("pong thread could not acquire semaphore", status);
+
+		release_sem(pingPong->pong);
+	}
+
+	return NULL;
+}
+
+
+static double
+bench_round_trips()
+{
+	ping_pong pingPong;
+	pingPong.ping = create_sem(0, "ping");
+	pingPong.pong = create_sem(0, "pong");
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, &pong_thread, &pingPong) != 0)
+		die("could not create pong thread", B_NO_MORE_THREADS);
+
+	bigtime_t startTime = system_time();
+
+	for (int i = 0; i < kRoundTrips; i++) {
+		release_sem(pingPong.ping);
+
+		status_t status = acquire_sem_etc(pingPong.pong, 1,
+			B_RELATIVE_TIMEOUT, kPingPongTimeout);
+		if (status != B_OK)
+			die("ping thread could not acquire semaphore", status);
+	}
+
+	bigtime_t elapsed = system_time() - startTime;
+
+	pthread_join(thread, NULL);
+	delete_sem(pingPong.ping);
+	delete_sem(pingPong.pong);
+
+	return (double)elapsed / kRoundTrips;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int maxTimers = kTimerCounts[sizeof(kTimerCounts)
+		/ sizeof(kTimerCounts[0]) - 1];
+	pthread_t* threads = new pthread_t[maxTimers];
+
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	pthread_attr_setstacksize(&attributes, 16 * 1024);
+
+	printf("%16s %20s\n", "pending timers", "us/round trip");
+
+	for (size_t i = 0; i < sizeof(kTimerCounts) / sizeof(kTimerCounts[0]);
+			i++) {
+		int count = kTimerCounts[i];
+
+		sBackgroundSem = create_sem(0, "background");
+		for (int j = 0; j < count; j++) {
+			if (pthread_create(&threads[j], &attributes, &background_thread,
+					(void*)(addr_t)j) != 0) {
+				die("could not create background thread", B_NO_MORE_THREADS);
+			}
+		}
+
+		// give the background threads time to block
+		snooze(100000);
+
+		printf("%16d %20.2f\n", count, bench_round_trips());
+
+		delete_sem(sBackgroundSem);
+		for (int j = 0; j < count; j++)
+			pthread_join(threads[j], NULL);
+	}
+
+	pthread_attr_destroy(&attributes);
+	delete[] threads;
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Hammers a per-CPU counter and a per-CPU list from more threads than
+	there are CPUs, so that the threads are preempted and migrated in the
+	middle of the operations, and checks that no update got lost.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+#include <per_cpu.h>
+
+
+static const int32 kThreadCount = 16;
+static const int32 kIterations = 2000000;
+static const int32 kElementsPerThread = 64;
+
+
+struct element {
+	element*	next;
+	int32		owner;
+};
+
+
+static per_cpu_counter sCounter;
+static per_cpu_list sList;
+static element sElements[kThreadCount * kElementsPerThread];
+
+
+static status_t
+worker(void* data)
+{
+	int32 index = (int32)(addr_t)data;
+
+	for (int32 i = 0; i < kElementsPerThread; i++)
+		per_cpu_list_push(&sList, &sElements[index * kElementsPerThread + i]);
+
+	element* held[kElementsPerThread];
+	int32 heldCount = 0;
+
+	for (int32 i = 0; i < kIterations; i++) {
+		per_cpu_counter_add(&sCounter, 1);
+
+		// take an element out every now and then, and put it back later,
+		// maybe on another CPU
+		if (i % 3 == 0 && heldCount < kElementsPerThread) {
+			element* item = (element*)per_cpu_list_pop(&sList);
+			if (item != NULL)
+				held[heldCount++] = item;
+		} else if (i % 3 == 1 && heldCount > 0)
+			per_cpu_list_push(&sList, held[--heldCount]);
+	}
+
+	while (heldCount > 0)
+		per_cpu_list_push(&sList, held[--heldCount]);
+
+	return B_OK;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (per_cpu_counter_init(&sCounter) != B_OK
+		|| per_cpu_list_init(&sList) != B_OK) {
+		fprintf(stderr, "per_cpu_test: out of memory\n");
+		return 1;
+	}
+
+	thread_id threads[kThreadCount];
+	for (int32 i = 0; i < kThreadCount; i++) {
+		threads[i] = spawn_thread(&worker, "per-CPU worker",
+			B_NORMAL_PRIORITY, (void*)(addr_t)i);
+		resume_thread(threads[i]);
+	}
+
+	for (int32 i = 0; i < kThreadCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	int failures = 0;
+
+	int64 sum = per_cpu_counter_sum(&sCounter);
+	if (sum != (int64)kThreadCount * kIterations) {
+		printf("counter is %" B_PRId64 ", expected %" B_PRId64 "\n", sum,
+			(int64)kThreadCount * kIterations);
+		failures++;
+	}
+
+	// The elements are spread over the lists of all CPUs now. Collect them
+	// by popping from all of them, and make sure each one is there once.
+	int32 elementCount = kThreadCount * kElementsPerThread;
+	for (int32 i = 0; i < elementCount; i++)
+		sElements[i].owner = -1;
+
+	system_info info;
+	get_system_info(&info);
+
+	int32 found = 0;
+	for (uint32 cpu = 0; cpu < info.cpu_count; cpu++) {
+		for (void* item = sList.heads[cpu * 64 / sizeof(void*)]; item != NULL;
+				item = ((element*)item)->next) {
+			element* entry = (element*)item;
+			if (entry < sElements || entry >= sElements + elementCount
+				|| entry->owner != -1) {
+				printf("bogus or duplicate element %p\n", entry);
+				failures++;
+				break;
+			}
+			entry->owner = cpu;
+			found++;
+		}
+	}
+
+	if (found != elementCount) {
+		printf("found %" B_PRId32 " list elements, expected %" B_PRId32 "\n",
+			found, elementCount);
+		failures++;
+	}
+
+	per_cpu_list_destroy(&sList);
+	per_cpu_counter_destroy(&sCounter);
+
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
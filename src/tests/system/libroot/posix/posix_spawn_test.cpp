@@ -0,0 +1,187 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Checks that posix_spawn() applies its file actions and attributes, and
+	compares how long it takes to start a program with posix_spawn() and with
+	fork() and exec() from a team with a lot of memory.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+extern char** environ;
+
+
+static const int32 kIterations = 200;
+static const size_t kMemorySize = 256 * 1024 * 1024;
+
+
+static void
+die(const char* message, int error)
+{
+	fprintf(stderr, "posix_spawn_test: %s: %s\n", message, strerror(error));
+	exit(1);
+}
+
+
+static int
+wait_for(pid_t child)
+{
+	int status;
+	if (waitpid(child, &status, 0) != child)
+		die("waitpid() failed", errno);
+	if (!WIFEXITED(status))
+		die("child did not exit", B_ERROR);
+
+	return WEXITSTATUS(status);
+}
+
+
+static void
+test_file_actions()
+{
+	// the child's output goes through a close-on-exec pipe
+	int pipeFDs[2];
+	if (pipe(pipeFDs) != 0)
+		die("pipe() failed", errno);
+	fcntl(pipeFDs[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipeFDs[1], F_SETFD, FD_CLOEXEC);
+
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init(&fileActions);
+	posix_spawn_file_actions_adddup2(&fileActions, pipeFDs[1], STDOUT_FILENO);
+	posix_spawn_file_actions_addopen(&fileActions, STDIN_FILENO, "/dev/null",
+		O_RDONLY, 0);
+
+	const char* argv[] = { "sh", "-c", "echo spawned; cat", NULL };
+	pid_t child;
+	int error = posix_spawn(&child, "/bin/sh", &fileActions, NULL,
+		(char* const*)argv, environ);
+	if (error != 0)
+		die("posix_spawn() failed", error);
+
+	posix_spawn_file_actions_destroy(&fileActions);
+	close(pipeFDs[1]);
+
+	char buffer[64];
+	ssize_t bytesRead = read(pipeFDs[0], buffer, sizeof(buffer) - 1);
+	close(pipeFDs[0]);
+
+	if (wait_for(child) != 0)
+		die("child failed", B_ERROR);
+	if (bytesRead != 8 || strncmp(buffer, "spawned\n", 8) != 0)
+		die("child output got lost", B_ERROR);
+}
+
+
+static void
+test_attributes()
+{
+	// the child waits for its input to be closed
+	int pipeFDs[2];
+	if (pipe(pipeFDs) != 0)
+		die("pipe() failed", errno);
+	fcntl(pipeFDs[1], F_SETFD, FD_CLOEXEC);
+
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init(&fileActions);
+	posix_spawn_file_actions_adddup2(&fileActions, pipeFDs[0], STDIN_FILENO);
+	posix_spawn_file_actions_addclose(&fileActions, pipeFDs[0]);
+
+	posix_spawnattr_t attributes;
+	posix_spawnattr_init(&attributes);
+	posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+	posix_spawnattr_setpgroup(&attributes, 0);
+
+	const char* argv[] = { "sh", "-c", "read line", NULL };
+	pid_t child;
+	int error = posix_spawn(&child, "/bin/sh", &fileActions, &attributes,
+		(char* const*)argv, environ);
+	if (error != 0)
+		die("posix_spawn() failed", error);
+
+	posix_spawn_file_actions_destroy(&fileActions);
+	posix_spawnattr_destroy(&attributes);
+	close(pipeFDs[0]);
+
+	// posix_spawn() only returns once the attributes have been applied
+	if (getpgid(child) != child)
+		die("child is not in its own process group", B_ERROR);
+
+	close(pipeFDs[1]);
+	wait_for(child);
+
+	const char* missingArgv[] = { "missing", NULL };
+	if (posix_spawn(&child, "/does/not/exist", NULL, NULL,
+			(char* const*)missingArgv, environ) == 0) {
+		die("spawning a missing executable succeeded", B_ERROR);
+	}
+}
+
+
+static bigtime_t
+measure(bool spawn)
+{
+	const char* argv[] = { "true", NULL };
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < kIterations; i++) {
+		pid_t child;
+		if (spawn) {
+			int error = posix_spawn(&child, "/bin/true", NULL, NULL,
+				(char* const*)argv, environ);
+			if (error != 0)
+				die("posix_spawn() failed", error);
+		} else {
+			child = fork();
+			if (child < 0)
+				die("fork() failed", errno);
+			if (child == 0) {
+				execv("/bin/true", (char* const*)argv);
+				_exit(1);
+			}
+		}
+
+		if (wait_for(child) != 0)
+			die("child failed", B_ERROR);
+	}
+
+	return (system_time() - startTime) / kIterations;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	test_file_actions();
+	test_attributes();
+
+	// make fork() pay for a big address space
+	char* memory = (char*)malloc(kMemorySize);
+	if (memory == NULL)
+		die("out of memory", B_NO_MEMORY);
+	for (size_t offset = 0; offset < kMemorySize; offset += B_PAGE_SIZE)
+		memory[offset] = 1;
+
+	bigtime_t forked = measure(false);
+	bigtime_t spawned = measure(true);
+
+	printf("fork() + exec(): %8" B_PRId64 " us\n", forked);
+	printf("posix_spawn():   %8" B_PRId64 " us\n", spawned);
+
+	free(memory);
+	return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the throughput of a pthread mutex guarding a short critical
+	section when an increasing number of threads compete for it, and checks
+	that no increment of the protected counter gets lost.
+*/
+
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const int32 kThreadCounts[] = { 1, 2, 4, 8, 16 };
+static const int32 kMaxThreads = 16;
+static const int32 kIterations = 200000;
+
+
+static pthread_mutex_t sMutex = PTHREAD_MUTEX_INITIALIZER;
+static int64 sCounter;
+
+
+static void
+die(const char* message, int error)
+{
+	fprintf(stderr, "pthread_mutex_contention: %s: %s\n", message,
+		strerror(error));
+	exit(1);
+}
+
+
+static void*
+worker(void*)
+{
+	for (int32 i = 0; i < kIterations; i++) {
+		pthread_mutex_lock(&sMutex);
+
+		// a critical section that is a lot shorter than a context switch
+		for (int32 j = 0; j < 20; j++)
+			sCounter++;
+		sCounter -= 19;
+
+		pthread_mutex_unlock(&sMutex);
+	}
+
+	return NULL;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	pthread_t threads[kMaxThreads];
+
+	printf("%8s %16s %14s\n", "threads", "locks/s", "ns/lock");
+
+	for (size_t i = 0; i < sizeof(kThreadCounts) / sizeof(kThreadCounts[0]);
+			i++) {
+		int32 threadCount = kThreadCounts[i];
+		sCounter = 0;
+
+		bigtime_t startTime = system_time();
+
+		for (int32 j = 0; j < threadCount; j++) {
+			int error = pthread_create(&threads[j], NULL, &worker, NULL);
+			if (error != 0)
+				die("could not create thread", error);
+		}
+		for (int32 j = 0; j < threadCount; j++)
+			pthread_join(threads[j], NULL);
+
+		bigtime_t elapsed = system_time() - startTime;
+
+		int64 locks = (int64)threadCount * kIterations;
+		if (sCounter != locks) {
+			fprintf(stderr, "pthread_mutex_contention: counter is %" B_PRId64
+				" instead of %" B_PRId64 "\n", sCounter, locks);
+			return 1;
+		}
+
+		printf("%8" B_PRId32 " %16.0f %14.1f\n", threadCount,
+			locks * 1000000.0 / elapsed, elapsed * 1000.0 / locks);
+	}
+
+	return 0;
+}
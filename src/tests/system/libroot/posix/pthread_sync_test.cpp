@@ -0,0 +1,215 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Exercises the futex based synchronization primitives: a producer/consumer
+	queue using condition variables and broadcasts, reader/writer locks,
+	barriers, and unnamed semaphores. Every part checks that no update gets
+	lost, and prints how long it took.
+*/
+
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+static const int kThreadCount = 8;
+static const int kIterations = 100000;
+static const int kBarrierRounds = 10000;
+
+
+static pthread_mutex_t sMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sCondition = PTHREAD_COND_INITIALIZER;
+static int sQueued;
+static int sConsumed;
+
+static pthread_rwlock_t sRWLock;
+static int sValues[2];
+
+static pthread_barrier_t sBarrier;
+static int sRound;
+
+static sem_t sSemaphore;
+static int sSemCounter;
+static int32 sSemConsumed;
+
+
+static void
+die(const char* message)
+{
+	fprintf(stderr, "pthread_sync_test: %s\n", message);
+	exit(1);
+}
+
+
+static void*
+producer(void*)
+{
+	for (int i = 0; i < kIterations; i++) {
+		pthread_mutex_lock(&sMutex);
+		sQueued++;
+		pthread_cond_signal(&sCondition);
+		pthread_mutex_unlock(&sMutex);
+	}
+
+	return NULL;
+}
+
+
+static void*
+consumer(void*)
+{
+	pthread_mutex_lock(&sMutex);
+	while (true) {
+		while (sQueued == 0 && sConsumed < kIterations)
+			pthread_cond_wait(&sCondition, &sMutex);
+		if (sConsumed == kIterations)
+			break;
+
+		sQueued--;
+		sConsumed++;
+		if (sConsumed == kIterations)
+			pthread_cond_broadcast(&sCondition);
+	}
+	pthread_mutex_unlock(&sMutex);
+
+	return NULL;
+}
+
+
+static void*
+rwlock_worker(void* data)
+{
+	bool writer = (addr_t)data % 2 == 0;
+
+	for (int i = 0; i < kIterations / 10; i++) {
+		if (writer) {
+			pthread_rwlock_wrlock(&sRWLock);
+			sValues[0]++;
+			sValues[1]++;
+		} else {
+			pthread_rwlock_rdlock(&sRWLock);
+			if (sValues[0] != sValues[1])
+				die("reader saw an inconsistent state");
+		}
+		pthread_rwlock_unlock(&sRWLock);
+	}
+
+	return NULL;
+}
+
+
+static void*
+barrier_worker(void*)
+{
+	for (int i = 0; i < kBarrierRounds; i++) {
+		if (pthread_barrier_wait(&sBarrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+			sRound++;
+
+		// everyone must see the round the serial thread counted
+		pthread_barrier_wait(&sBarrier);
+		if (sRound != i + 1)
+			die("barrier let a thread pass early");
+		pthread_barrier_wait(&sBarrier);
+	}
+
+	return NULL;
+}
+
+
+static void*
+sem_worker(void*)
+{
+	for (int i = 0; i < kIterations / 10; i++) {
+		sem_wait(&sSemaphore);
+		sSemCounter++;
+		sem_post(&sSemaphore);
+	}
+
+	return NULL;
+}
+
+
+static void*
+sem_handoff_worker(void* data)
+{
+	// Half of the threads post, the other half waits. Concurrent posts to a
+	// semaphore with several waiters must wake all of them; if a wake-up got
+	// lost, this would hang.
+	bool poster = ((addr_t)data & 1) != 0;
+	for (int i = 0; i < kIterations / 10; i++) {
+		if (poster)
+			sem_post(&sSemaphore);
+		else {
+			sem_wait(&sSemaphore);
+			atomic_add(&sSemConsumed, 1);
+		}
+	}
+
+	return NULL;
+}
+
+
+static void
+run(const char* name, void* (*function)(void*))
+{
+	pthread_t threads[kThreadCount];
+	bigtime_t startTime = system_time();
+
+	for (int i = 0; i < kThreadCount; i++) {
+		if (pthread_create(&threads[i], NULL, function, (void*)(addr_t)i) != 0)
+			die("could not create thread");
+	}
+	for (int i = 0; i < kThreadCount; i++)
+		pthread_join(threads[i], NULL);
+
+	printf("%-24s %10" B_PRId64 " us\n", name, system_time() - startTime);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	pthread_t producerThread;
+	if (pthread_create(&producerThread, NULL, &producer, NULL) != 0)
+		die("could not create producer");
+	run("condition variables", &consumer);
+	pthread_join(producerThread, NULL);
+	if (sConsumed != kIterations || sQueued != 0)
+		die("items got lost");
+
+	pthread_rwlock_init(&sRWLock, NULL);
+	run("rwlocks", &rwlock_worker);
+	if (sValues[0] != kThreadCount / 2 * (kIterations / 10))
+		die("writer updates got lost");
+	pthread_rwlock_destroy(&sRWLock);
+
+	pthread_barrier_init(&sBarrier, NULL, kThreadCount);
+	run("barriers", &barrier_worker);
+	if (sRound != kBarrierRounds)
+		die("barrier rounds got lost");
+	pthread_barrier_destroy(&sBarrier);
+
+	sem_init(&sSemaphore, 0, 1);
+	run("semaphores", &sem_worker);
+	if (sSemCounter != kThreadCount * (kIterations / 10))
+		die("semaphore updates got lost");
+	sem_destroy(&sSemaphore);
+
+	sem_init(&sSemaphore, 0, 0);
+	run("semaphore handoff", &sem_handoff_worker);
+	int value;
+	sem_getvalue(&sSemaphore, &value);
+	if (sSemConsumed != kThreadCount / 2 * (kIterations / 10) || value != 0)
+		die("semaphore units got lost");
+	sem_destroy(&sSemaphore);
+
+	return 0;
+}
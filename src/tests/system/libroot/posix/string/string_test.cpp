@@ -0,0 +1,212 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Compares the libroot string functions against simple reference
+	implementations, for all lengths up to a few hundred bytes and all
+	alignments. The strings are also placed right in front of an unmapped
+	page, so that reading past their end crashes the test.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <OS.h>
+
+
+static const size_t kMaxLength = 300;
+static const size_t kMaxOffset = 64;
+
+static int sFailures = 0;
+
+
+#define CHECK(condition, function, length, offset) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s() failed, length %lu, offset %lu\n", \
+				function, (unsigned long)(length), (unsigned long)(offset)); \
+			sFailures++; \
+		} \
+	} while (false)
+
+
+static size_t
+reference_strlen(const char* string)
+{
+	size_t length = 0;
+	while (string[length] != '\0')
+		length++;
+	return length;
+}
+
+
+static const char*
+reference_strchrnul(const char* string, int c)
+{
+	while (*string != (char)c && *string != '\0')
+		string++;
+	return string;
+}
+
+
+static const char*
+reference_strrchr(const char* string, int c)
+{
+	const char* last = NULL;
+	do {
+		if (*string == (char)c)
+			last = string;
+	} while (*string++ != '\0');
+	return last;
+}
+
+
+static const void*
+reference_memchr(const void* buffer, int c, size_t length)
+{
+	const unsigned char* bytes = (const unsigned char*)buffer;
+	for (size_t i = 0; i < length; i++) {
+		if (bytes[i] == (unsigned char)c)
+			return bytes + i;
+	}
+	return NULL;
+}
+
+
+static int
+reference_memcmp(const void* _a, const void* _b, size_t length)
+{
+	const unsigned char* a = (const unsigned char*)_a;
+	const unsigned char* b = (const unsigned char*)_b;
+	for (size_t i = 0; i < length; i++) {
+		if (a[i] != b[i])
+			return a[i] - b[i];
+	}
+	return 0;
+}
+
+
+static int
+reference_strcmp(const char* a, const char* b)
+{
+	return reference_memcmp(a, b,
+		min_c(reference_strlen(a), reference_strlen(b)) + 1);
+}
+
+
+static int
+sign(int value)
+{
+	return value < 0 ? -1 : value > 0 ? 1 : 0;
+}
+
+
+/*!	Returns a buffer of two pages that is followed by an unmapped page. */
+static char*
+allocate_guarded_buffer()
+{
+	char* buffer = (char*)mmap(NULL, 3 * B_PAGE_SIZE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buffer == MAP_FAILED) {
+		fprintf(stderr, "string_test: could not map buffer\n");
+		exit(1);
+	}
+
+	mprotect(buffer + 2 * B_PAGE_SIZE, B_PAGE_SIZE, PROT_NONE);
+	return buffer;
+}
+
+
+static void
+test_string(char* string, char* other, size_t length, size_t offset)
+{
+	CHECK(strlen(string) == length, "strlen", length, offset);
+
+	for (size_t count = 0; count < length + 3; count++) {
+		CHECK(strnlen(string, count) == min_c(count, length), "strnlen",
+			length, offset);
+	}
+
+	for (int c = 0; c < 8; c++) {
+		const char* position = reference_strchrnul(string, c);
+		CHECK(strchrnul(string, c) == position, "strchrnul", length, offset);
+		CHECK(strchr(string, c) == (*position == c ? position : NULL),
+			"strchr", length, offset);
+		CHECK(strchr(string, c + 256) == strchr(string, c), "strchr", length,
+			offset);
+		CHECK(strrchr(string, c) == reference_strrchr(string, c), "strrchr",
+			length, offset);
+		CHECK(memchr(string, c, length) == reference_memchr(string, c, length),
+			"memchr", length, offset);
+	}
+
+	memcpy(other, string, length + 1);
+	CHECK(strcmp(string, other) == 0, "strcmp", length, offset);
+	CHECK(memcmp(string, other, length) == 0, "memcmp", length, offset);
+	if (length == 0)
+		return;
+
+	// change a single byte, which might also end the string early
+	size_t position = rand() % length;
+	other[position] = rand() % 4 == 0 ? '\0' : (char)rand();
+
+	CHECK(sign(strcmp(string, other))
+			== sign(reference_strcmp(string, other)), "strcmp", length,
+		offset);
+	CHECK(sign(strcmp(other, string))
+			== sign(reference_strcmp(other, string)), "strcmp", length,
+		offset);
+	CHECK(sign(memcmp(string, other, length))
+			== sign(reference_memcmp(string, other, length)), "memcmp",
+		length, offset);
+	CHECK(sign(memcmp(other, string, length))
+			== sign(reference_memcmp(other, string, length)), "memcmp",
+		length, offset);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	char* buffer = allocate_guarded_buffer();
+	char* otherBuffer = allocate_guarded_buffer();
+	char* bufferEnd = buffer + 2 * B_PAGE_SIZE;
+	char* otherBufferEnd = otherBuffer + 2 * B_PAGE_SIZE;
+
+	srand(42);
+
+	for (size_t length = 0; length < kMaxLength; length++) {
+		for (size_t offset = 0; offset < kMaxOffset; offset++) {
+			// use a different alignment for the other string
+			size_t otherOffset = (offset * 7) % kMaxOffset;
+
+			for (int atPageEnd = 0; atPageEnd < 2; atPageEnd++) {
+				char* string = atPageEnd
+					? bufferEnd - length - 1 - offset % 2 : buffer + offset;
+				char* other = atPageEnd
+					? otherBufferEnd - length - 1 : otherBuffer + otherOffset;
+
+				// few different characters, so that they repeat often; some
+				// of them have the high bit set
+				for (size_t i = 0; i < length; i++)
+					string[i] = "\x01\x02\x03\x04\x05\x06\x07\xe6"[rand() % 8];
+				string[length] = '\0';
+
+				test_string(string, other, length, offset);
+			}
+		}
+	}
+
+	if (sFailures > 0) {
+		printf("%d checks failed\n", sFailures);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}